@@ -0,0 +1,1071 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// A synthetic load for measuring how the server copes with many surfaces.
+//
+// Opens --surfaces toplevels (each optionally with a chain of subsurfaces) and
+// redraws them at a mix of rates, recording for every surface the interval
+// between frame callbacks and the latency from wl_surface.commit to the frame
+// callback. Mir has no wp_presentation, but sends frame callbacks when the
+// compositor first uses the committed buffer, so that is the latency reported.
+
+#include "make_shm_pool.h"
+#include "xdg-shell.h"
+#include "linux-dmabuf-unstable-v1.h"
+
+#include <wayland-client.h>
+
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+#include <gbm.h>
+#include <fcntl.h>
+#endif
+
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+enum class damage_pattern { full, partial, sparse };
+enum class buffer_type { shm, dmabuf };
+
+struct options
+{
+    int surfaces = 50;
+    int32_t width = 64;
+    int32_t height = 64;
+    std::vector<int> rates{60, 30, 10};
+    damage_pattern damage = damage_pattern::full;
+    int subsurface_depth = 0;
+    bool alpha = false;
+    buffer_type buffers = buffer_type::shm;
+    std::chrono::milliseconds warmup = 1s;
+    std::chrono::milliseconds duration = 10s;
+    char const* render_node = "/dev/dri/renderD128";
+    char const* output = nullptr;
+};
+
+options opts;
+
+/// A surface that has seen no frame callback for this long is counted as stalled
+auto const stall_threshold = 1s;
+
+/// Each subsurface is inset this far into its parent
+int32_t const subsurface_inset = 8;
+
+void usage(char const* argv0)
+{
+    printf(
+        "Usage: %s [options]\n"
+        "  --surfaces N            number of toplevel surfaces [%d]\n"
+        "  --size WxH              size of each toplevel [%dx%d]\n"
+        "  --rates HZ[,HZ...]      update rates, given to the surfaces in turn; 0 redraws on every frame callback [60,30,10]\n"
+        "  --damage PATTERN        full, partial (a moving band) or sparse (a few small squares) [full]\n"
+        "  --subsurface-depth N    chain of N subsurfaces under each toplevel [%d]\n"
+        "  --alpha                 draw translucent content with no opaque region\n"
+        "  --buffers TYPE          shm or dmabuf [shm]\n"
+        "  --render-node PATH      device to allocate dmabufs from [%s]\n"
+        "  --warmup SECONDS        time to run before measuring [1]\n"
+        "  --duration SECONDS      time to measure for [10]\n"
+        "  --output FILE           write the results to FILE as JSON\n",
+        argv0, opts.surfaces, opts.width, opts.height, opts.subsurface_depth, opts.render_node);
+}
+
+auto parse_seconds(char const* arg) -> std::chrono::milliseconds
+{
+    return std::chrono::milliseconds{static_cast<long>(std::round(atof(arg) * 1000))};
+}
+
+void parse_options(int argc, char* argv[])
+{
+    enum { surfaces = 1, size, rates, damage, depth, alpha, buffers, render_node, warmup, duration, output, help };
+
+    struct option const long_options[] = {
+        {"surfaces",         required_argument, nullptr, surfaces},
+        {"size",             required_argument, nullptr, size},
+        {"rates",            required_argument, nullptr, rates},
+        {"damage",           required_argument, nullptr, damage},
+        {"subsurface-depth", required_argument, nullptr, depth},
+        {"alpha",            no_argument,       nullptr, alpha},
+        {"buffers",          required_argument, nullptr, buffers},
+        {"render-node",      required_argument, nullptr, render_node},
+        {"warmup",           required_argument, nullptr, warmup},
+        {"duration",         required_argument, nullptr, duration},
+        {"output",           required_argument, nullptr, output},
+        {"help",             no_argument,       nullptr, help},
+        {nullptr,            0,                 nullptr, 0}
+    };
+
+    auto const invalid = [&](char const* what)
+        {
+            fprintf(stderr, "Invalid %s: %s\n", what, optarg);
+            exit(EXIT_FAILURE);
+        };
+
+    for (int c; (c = getopt_long(argc, argv, "", long_options, nullptr)) != -1;)
+    {
+        switch (c)
+        {
+        case surfaces:
+            if ((opts.surfaces = atoi(optarg)) < 1) invalid("surface count");
+            break;
+
+        case size:
+            if (sscanf(optarg, "%dx%d", &opts.width, &opts.height) != 2 || opts.width < 1 || opts.height < 1)
+                invalid("size");
+            break;
+
+        case rates:
+        {
+            opts.rates.clear();
+            for (char const* rate = optarg; rate;)
+            {
+                opts.rates.push_back(atoi(rate));
+                if (opts.rates.back() < 0) invalid("rate");
+                if ((rate = strchr(rate, ','))) ++rate;
+            }
+            break;
+        }
+
+        case damage:
+            if (strcmp(optarg, "full") == 0) opts.damage = damage_pattern::full;
+            else if (strcmp(optarg, "partial") == 0) opts.damage = damage_pattern::partial;
+            else if (strcmp(optarg, "sparse") == 0) opts.damage = damage_pattern::sparse;
+            else invalid("damage pattern");
+            break;
+
+        case depth:
+            if ((opts.subsurface_depth = atoi(optarg)) < 0) invalid("subsurface depth");
+            break;
+
+        case alpha:
+            opts.alpha = true;
+            break;
+
+        case buffers:
+            if (strcmp(optarg, "shm") == 0) opts.buffers = buffer_type::shm;
+            else if (strcmp(optarg, "dmabuf") == 0) opts.buffers = buffer_type::dmabuf;
+            else invalid("buffer type");
+            break;
+
+        case render_node:
+            opts.render_node = optarg;
+            break;
+
+        case warmup:
+            opts.warmup = parse_seconds(optarg);
+            break;
+
+        case duration:
+            if ((opts.duration = parse_seconds(optarg)) <= 0s) invalid("duration");
+            break;
+
+        case output:
+            opts.output = optarg;
+            break;
+
+        case help:
+            usage(argv[0]);
+            exit(EXIT_SUCCESS);
+
+        default:
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+namespace globals
+{
+wl_display* display;
+wl_compositor* compositor;
+wl_subcompositor* subcompositor;
+wl_shm* shm;
+xdg_wm_base* wm_base;
+zwp_linux_dmabuf_v1* linux_dmabuf;
+
+void init();
+}
+
+void handle_registry_global(wl_registry* registry, uint32_t id, char const* interface, uint32_t version)
+{
+    if (strcmp(interface, wl_compositor_interface.name) == 0)
+    {
+        globals::compositor = static_cast<wl_compositor*>(wl_registry_bind(
+            registry, id, &wl_compositor_interface, std::min(version, 4u)));
+    }
+    else if (strcmp(interface, wl_subcompositor_interface.name) == 0)
+    {
+        globals::subcompositor = static_cast<wl_subcompositor*>(wl_registry_bind(
+            registry, id, &wl_subcompositor_interface, std::min(version, 1u)));
+    }
+    else if (strcmp(interface, wl_shm_interface.name) == 0)
+    {
+        globals::shm = static_cast<wl_shm*>(wl_registry_bind(registry, id, &wl_shm_interface, std::min(version, 1u)));
+    }
+    else if (strcmp(interface, xdg_wm_base_interface.name) == 0)
+    {
+        globals::wm_base = static_cast<xdg_wm_base*>(wl_registry_bind(
+            registry, id, &xdg_wm_base_interface, std::min(version, 1u)));
+    }
+    else if (strcmp(interface, zwp_linux_dmabuf_v1_interface.name) == 0 && version >= 2)
+    {
+        globals::linux_dmabuf = static_cast<zwp_linux_dmabuf_v1*>(wl_registry_bind(
+            registry, id, &zwp_linux_dmabuf_v1_interface, std::min(version, 3u)));
+    }
+}
+
+void globals::init()
+{
+    static wl_registry_listener const registry_listener =
+        {
+            .global = [](void*, auto... args) { handle_registry_global(args...); },
+            .global_remove = [](auto...) {},
+        };
+
+    static xdg_wm_base_listener const shell_listener =
+        {
+            .ping = [](void*, xdg_wm_base* shell, uint32_t serial) { xdg_wm_base_pong(shell, serial); }
+        };
+
+    display = wl_display_connect(nullptr);
+    if (!display)
+    {
+        fprintf(stderr, "Failed to connect to a Wayland server\n");
+        exit(EXIT_FAILURE);
+    }
+
+    auto const registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registry_listener, nullptr);
+    wl_display_roundtrip(display);
+
+    bool fail = false;
+    if (!compositor)
+    {
+        fprintf(stderr, "No wl_compositor global\n");
+        fail = true;
+    }
+
+    if (!subcompositor && opts.subsurface_depth > 0)
+    {
+        fprintf(stderr, "No wl_subcompositor global\n");
+        fail = true;
+    }
+
+    if (!shm)
+    {
+        fprintf(stderr, "No wl_shm global\n");
+        fail = true;
+    }
+
+    if (!wm_base)
+    {
+        fprintf(stderr, "No xdg_wm_base global\n");
+        fail = true;
+    }
+
+    if (fail) exit(EXIT_FAILURE);
+
+    xdg_wm_base_add_listener(wm_base, &shell_listener, nullptr);
+}
+
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+class gbm_allocator
+{
+public:
+    explicit gbm_allocator(char const* render_node)
+        : fd{open(render_node, O_RDWR | O_CLOEXEC)},
+          device{fd >= 0 ? gbm_create_device(fd) : nullptr}
+    {
+    }
+
+    ~gbm_allocator()
+    {
+        if (device) gbm_device_destroy(device);
+        if (fd >= 0) close(fd);
+    }
+
+    explicit operator bool() const { return device; }
+    operator gbm_device*() const { return device; }
+
+private:
+    int const fd;
+    gbm_device* const device;
+
+    gbm_allocator(gbm_allocator const&) = delete;
+    gbm_allocator& operator=(gbm_allocator const&) = delete;
+};
+
+std::unique_ptr<gbm_allocator> gbm;
+#endif
+
+/// Returns false, having said why, if dmabufs cannot be used
+bool open_dmabuf_allocator()
+{
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+    if (!globals::linux_dmabuf)
+    {
+        fprintf(stderr, "Server does not support zwp_linux_dmabuf_v1\n");
+        return false;
+    }
+
+    gbm = std::make_unique<gbm_allocator>(opts.render_node);
+    if (!*gbm)
+    {
+        fprintf(stderr, "Failed to open a GBM device on %s\n", opts.render_node);
+        gbm.reset();
+        return false;
+    }
+
+    return true;
+#else
+    fprintf(stderr, "Built without dmabuf support\n");
+    return false;
+#endif
+}
+
+/// One client buffer, drawn to by the CPU
+class buffer
+{
+public:
+    static auto make_shm(int32_t width, int32_t height) -> std::unique_ptr<buffer>;
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+    static auto make_dmabuf(int32_t width, int32_t height) -> std::unique_ptr<buffer>;
+#endif
+    ~buffer();
+
+    operator wl_buffer*() const { return wlbuffer; }
+
+    bool busy = false;
+
+    /// Call \p draw with the pixels of the buffer and the stride (in pixels) between rows
+    template<typename Draw>
+    void write(Draw&& draw);
+
+private:
+    buffer() = default;
+
+    wl_buffer* wlbuffer = nullptr;
+    void* shm_data = nullptr;
+    size_t shm_size = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+    gbm_bo* bo = nullptr;
+#endif
+
+    static wl_buffer_listener const buffer_listener;
+
+    buffer(buffer const&) = delete;
+    buffer& operator=(buffer const&) = delete;
+};
+
+wl_buffer_listener const buffer::buffer_listener =
+    {
+        .release = [](void* self, wl_buffer*) { static_cast<buffer*>(self)->busy = false; },
+    };
+
+auto buffer::make_shm(int32_t width, int32_t height) -> std::unique_ptr<buffer>
+{
+    std::unique_ptr<buffer> result{new buffer};
+    auto const stride = width * 4;
+    result->shm_size = stride * height;
+    result->width = width;
+    result->height = height;
+
+    auto const pool = make_shm_pool(globals::shm, result->shm_size, &result->shm_data);
+    if (!pool)
+    {
+        fprintf(stderr, "Failed to create a shm pool\n");
+        exit(EXIT_FAILURE);
+    }
+
+    result->wlbuffer = wl_shm_pool_create_buffer(
+        pool, 0, width, height, stride, opts.alpha ? WL_SHM_FORMAT_ARGB8888 : WL_SHM_FORMAT_XRGB8888);
+    wl_shm_pool_destroy(pool);
+
+    wl_buffer_add_listener(result->wlbuffer, &buffer_listener, result.get());
+    return result;
+}
+
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+auto buffer::make_dmabuf(int32_t width, int32_t height) -> std::unique_ptr<buffer>
+{
+    auto const format = opts.alpha ? GBM_FORMAT_ARGB8888 : GBM_FORMAT_XRGB8888;
+
+    auto const bo = gbm_bo_create(*gbm, width, height, format, GBM_BO_USE_LINEAR | GBM_BO_USE_RENDERING);
+    if (!bo)
+    {
+        fprintf(stderr, "Failed to allocate a %dx%d dmabuf\n", width, height);
+        exit(EXIT_FAILURE);
+    }
+
+    std::unique_ptr<buffer> result{new buffer};
+    result->bo = bo;
+    result->width = width;
+    result->height = height;
+
+    auto const modifier = gbm_bo_get_modifier(bo);
+    auto const fd = gbm_bo_get_fd(bo);
+    auto const params = zwp_linux_dmabuf_v1_create_params(globals::linux_dmabuf);
+    zwp_linux_buffer_params_v1_add(
+        params, fd, 0, gbm_bo_get_offset(bo, 0), gbm_bo_get_stride(bo), modifier >> 32, modifier & 0xffffffff);
+    result->wlbuffer = zwp_linux_buffer_params_v1_create_immed(params, width, height, format, 0);
+    zwp_linux_buffer_params_v1_destroy(params);
+    close(fd);
+
+    wl_buffer_add_listener(result->wlbuffer, &buffer_listener, result.get());
+    return result;
+}
+#endif
+
+buffer::~buffer()
+{
+    wl_buffer_destroy(wlbuffer);
+    if (shm_data) munmap(shm_data, shm_size);
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+    if (bo) gbm_bo_destroy(bo);
+#endif
+}
+
+template<typename Draw>
+void buffer::write(Draw&& draw)
+{
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+    if (bo)
+    {
+        uint32_t stride;
+        void* map_data = nullptr;
+        if (auto const pixels = gbm_bo_map(bo, 0, 0, width, height, GBM_BO_TRANSFER_WRITE, &stride, &map_data))
+        {
+            draw(static_cast<uint32_t*>(pixels), static_cast<int32_t>(stride / 4));
+            gbm_bo_unmap(bo, map_data);
+        }
+        return;
+    }
+#endif
+    draw(static_cast<uint32_t*>(shm_data), width);
+}
+
+struct rectangle
+{
+    int32_t x, y, width, height;
+};
+
+/// One wl_surface and the buffers drawn into it
+class layer
+{
+public:
+    layer(int32_t width, int32_t height, uint32_t seed);
+    ~layer();
+
+    operator wl_surface*() const { return surface; }
+
+    auto size() const { return std::pair{width, height}; }
+    bool has_free_buffer() const;
+
+    /// Draw frame number \p frame into a free buffer and attach it, without committing
+    void draw(uint32_t frame);
+
+private:
+    wl_surface* const surface;
+    int32_t const width;
+    int32_t const height;
+    uint32_t random;
+    std::vector<std::unique_ptr<buffer>> buffers;
+
+    auto damage_for(uint32_t frame) -> std::vector<rectangle>;
+    auto next_random() -> uint32_t;
+
+    layer(layer const&) = delete;
+    layer& operator=(layer const&) = delete;
+};
+
+layer::layer(int32_t width, int32_t height, uint32_t seed)
+    : surface{wl_compositor_create_surface(globals::compositor)},
+      width{width},
+      height{height},
+      random{seed * 2654435761u + 1}
+{
+    // Three buffers, so a surface need never wait for a release while the
+    // server holds one for scanout and one for the next frame.
+    for (auto i = 0; i != 3; ++i)
+    {
+#ifdef MIR_LOAD_GENERATOR_DMABUF
+        if (gbm)
+        {
+            buffers.push_back(buffer::make_dmabuf(width, height));
+            continue;
+        }
+#endif
+        buffers.push_back(buffer::make_shm(width, height));
+    }
+
+    if (!opts.alpha)
+    {
+        auto const region = wl_compositor_create_region(globals::compositor);
+        wl_region_add(region, 0, 0, width, height);
+        wl_surface_set_opaque_region(surface, region);
+        wl_region_destroy(region);
+    }
+}
+
+layer::~layer()
+{
+    buffers.clear();
+    wl_surface_destroy(surface);
+}
+
+bool layer::has_free_buffer() const
+{
+    return std::any_of(begin(buffers), end(buffers), [](auto const& b) { return !b->busy; });
+}
+
+auto layer::next_random() -> uint32_t
+{
+    random = random * 1664525u + 1013904223u;
+    return random >> 8;
+}
+
+auto layer::damage_for(uint32_t frame) -> std::vector<rectangle>
+{
+    switch (opts.damage)
+    {
+    case damage_pattern::full:
+        break;
+
+    case damage_pattern::partial:
+    {
+        auto const band = std::max(height / 8, 1);
+        auto const y = static_cast<int32_t>(frame * band % height);
+        return {{0, y, width, std::min(band, height - y)}};
+    }
+
+    case damage_pattern::sparse:
+    {
+        auto const side = std::max(std::min(width, height) / 8, 1);
+        std::vector<rectangle> squares;
+        for (auto i = 0; i != 4; ++i)
+        {
+            squares.push_back({
+                static_cast<int32_t>(next_random() % (width - side + 1)),
+                static_cast<int32_t>(next_random() % (height - side + 1)),
+                side,
+                side});
+        }
+        return squares;
+    }
+    }
+
+    return {{0, 0, width, height}};
+}
+
+void layer::draw(uint32_t frame)
+{
+    auto const free = std::find_if(begin(buffers), end(buffers), [](auto const& b) { return !b->busy; });
+    auto& b = **free;
+
+    // Only the damaged area is redrawn, so the rest of each buffer holds
+    // whatever it held last; that is of no consequence to the server's load.
+    uint8_t const alpha = opts.alpha ? 0xc0 : 0xff;
+    auto const shade = [alpha](uint32_t value) { return (value & 0xff) * alpha / 0xff; };
+    uint32_t const colour =
+        alpha << 24 | shade(frame * 3) << 16 | shade(frame * 5 + 85) << 8 | shade(frame * 7 + 170);
+
+    auto const damage = damage_for(frame);
+    b.write([&](uint32_t* pixels, int32_t stride)
+        {
+            for (auto const& rect : damage)
+            {
+                for (auto y = rect.y; y != rect.y + rect.height; ++y)
+                {
+                    std::fill_n(pixels + y * stride + rect.x, rect.width, colour);
+                }
+            }
+        });
+
+    b.busy = true;
+    wl_surface_attach(surface, b, 0, 0);
+    for (auto const& rect : damage)
+    {
+        wl_surface_damage_buffer(surface, rect.x, rect.y, rect.width, rect.height);
+    }
+}
+
+/// Durations collected over the run, in milliseconds
+class samples
+{
+public:
+    void add(Clock::duration sample)
+    {
+        values.push_back(std::chrono::duration<double, std::milli>{sample}.count());
+        sorted = false;
+    }
+
+    auto count() const { return values.size(); }
+
+    auto percentile(double fraction) -> double
+    {
+        if (values.empty())
+            return 0;
+
+        if (!sorted)
+        {
+            std::sort(begin(values), end(values));
+            sorted = true;
+        }
+        return values[static_cast<size_t>(std::round(fraction * (values.size() - 1)))];
+    }
+
+    void append(samples const& other)
+    {
+        values.insert(end(values), begin(other.values), end(other.values));
+        sorted = false;
+    }
+
+private:
+    std::vector<double> values;
+    bool sorted = true;
+};
+
+/// Only frames committed after this time are measured
+Clock::time_point measure_from;
+
+/// A toplevel and the chain of subsurfaces beneath it, all redrawn together
+class window
+{
+public:
+    window(int index, int rate);
+    ~window();
+
+    /// When this next wants to draw, or nullopt if it is waiting on the server
+    auto next_due() const -> std::optional<Clock::time_point>;
+    void commit(Clock::time_point now);
+    void check_for_stall(Clock::time_point now);
+
+    int const rate;
+    unsigned commits = 0;
+    unsigned frames = 0;
+    bool stalled = false;
+    samples intervals;
+    samples latencies;
+
+private:
+    std::vector<std::unique_ptr<layer>> layers;
+    std::vector<wl_subsurface*> subsurfaces;
+    xdg_surface* const xdgsurface;
+    xdg_toplevel* const xdgtoplevel;
+
+    bool configured = false;
+    wl_callback* pending_frame = nullptr;
+    uint32_t frame_number = 0;
+    Clock::time_point due;
+    Clock::time_point committed_at;
+    std::optional<Clock::time_point> last_frame;
+
+    void handle_frame_done(wl_callback* callback);
+
+    static wl_callback_listener const frame_listener;
+    static xdg_surface_listener const shell_surface_listener;
+    static xdg_toplevel_listener const shell_toplevel_listener;
+
+    window(window const&) = delete;
+    window& operator=(window const&) = delete;
+};
+
+wl_callback_listener const window::frame_listener =
+    {
+        .done = [](void* self, wl_callback* callback, uint32_t) { static_cast<window*>(self)->handle_frame_done(callback); },
+    };
+
+xdg_surface_listener const window::shell_surface_listener =
+    {
+        .configure = [](void* self, xdg_surface* surface, uint32_t serial)
+            {
+                xdg_surface_ack_configure(surface, serial);
+                auto const w = static_cast<window*>(self);
+                if (!w->configured)
+                {
+                    w->configured = true;
+                    w->due = Clock::now();
+                }
+            },
+    };
+
+xdg_toplevel_listener const window::shell_toplevel_listener =
+    {
+        // The size is fixed by the options; any size the server suggests is ignored
+        .configure = [](auto...) {},
+        .close = [](auto...) {},
+        .configure_bounds = [](auto...) {},
+        .wm_capabilities = [](auto...) {},
+    };
+
+window::window(int index, int rate)
+    : rate{rate},
+      layers{[index]
+          {
+              std::vector<std::unique_ptr<layer>> result;
+              result.push_back(std::make_unique<layer>(opts.width, opts.height, index));
+              return result;
+          }()},
+      xdgsurface{xdg_wm_base_get_xdg_surface(globals::wm_base, *layers.front())},
+      xdgtoplevel{xdg_surface_get_toplevel(xdgsurface)}
+{
+    for (auto depth = 1; depth <= opts.subsurface_depth; ++depth)
+    {
+        auto const [width, height] = layers.back()->size();
+        if (width <= 2 * subsurface_inset || height <= 2 * subsurface_inset)
+            break;
+
+        layers.push_back(std::make_unique<layer>(
+            width - 2 * subsurface_inset, height - 2 * subsurface_inset, index * 64 + depth));
+        subsurfaces.push_back(wl_subcompositor_get_subsurface(
+            globals::subcompositor, *layers.back(), *layers[layers.size() - 2]));
+        wl_subsurface_set_position(subsurfaces.back(), subsurface_inset, subsurface_inset);
+    }
+
+    xdg_surface_add_listener(xdgsurface, &shell_surface_listener, this);
+    xdg_toplevel_add_listener(xdgtoplevel, &shell_toplevel_listener, this);
+
+    auto const title = "load " + std::to_string(index);
+    xdg_toplevel_set_title(xdgtoplevel, title.c_str());
+    wl_surface_commit(*layers.front());
+}
+
+window::~window()
+{
+    if (pending_frame) wl_callback_destroy(pending_frame);
+    for (auto const subsurface : subsurfaces)
+        wl_subsurface_destroy(subsurface);
+    xdg_toplevel_destroy(xdgtoplevel);
+    xdg_surface_destroy(xdgsurface);
+
+    // Subsurfaces before their parents
+    while (!layers.empty())
+        layers.pop_back();
+}
+
+auto window::next_due() const -> std::optional<Clock::time_point>
+{
+    if (!configured || pending_frame)
+        return std::nullopt;
+
+    for (auto const& l : layers)
+    {
+        if (!l->has_free_buffer())
+            return std::nullopt;
+    }
+
+    return due;
+}
+
+void window::commit(Clock::time_point now)
+{
+    ++frame_number;
+
+    // Subsurfaces are synchronised, so each takes effect when its parent commits
+    for (auto l = layers.rbegin(); l != layers.rend(); ++l)
+    {
+        (*l)->draw(frame_number);
+        if (l != layers.rend() - 1)
+            wl_surface_commit(**l);
+    }
+
+    pending_frame = wl_surface_frame(*layers.front());
+    wl_callback_add_listener(pending_frame, &frame_listener, this);
+    wl_surface_commit(*layers.front());
+
+    committed_at = now;
+    if (now >= measure_from)
+        ++commits;
+
+    if (rate > 0)
+    {
+        // Keep to the rate, but don't try to catch up on frames already missed
+        due = std::max(due + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{1.0 / rate}), now);
+    }
+    else
+    {
+        due = now;
+    }
+}
+
+void window::handle_frame_done(wl_callback* callback)
+{
+    auto const now = Clock::now();
+    wl_callback_destroy(callback);
+    pending_frame = nullptr;
+
+    if (committed_at >= measure_from)
+    {
+        ++frames;
+        latencies.add(now - committed_at);
+        if (last_frame)
+            intervals.add(now - *last_frame);
+    }
+
+    last_frame = now;
+}
+
+void window::check_for_stall(Clock::time_point now)
+{
+    if (pending_frame && committed_at >= measure_from && now - committed_at > stall_threshold)
+        stalled = true;
+}
+
+volatile sig_atomic_t stop_requested = false;
+
+/// Dispatch Wayland events, waiting for them until \p deadline at the latest
+void dispatch_until(Clock::time_point deadline)
+{
+    auto const display = globals::display;
+
+    while (wl_display_prepare_read(display) != 0)
+    {
+        if (wl_display_dispatch_pending(display) < 0)
+        {
+            fprintf(stderr, "Failed to dispatch Wayland events\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    wl_display_flush(display);
+
+    auto const timeout = std::max(deadline - Clock::now(), Clock::duration::zero());
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timespec const wait{seconds.count(), std::chrono::nanoseconds{timeout - seconds}.count()};
+
+    pollfd fd{wl_display_get_fd(display), POLLIN, 0};
+    if (ppoll(&fd, 1, &wait, nullptr) > 0 && (fd.revents & (POLLIN | POLLERR)))
+    {
+        if (wl_display_read_events(display) < 0)
+        {
+            fprintf(stderr, "Failed to read Wayland events\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        wl_display_cancel_read(display);
+    }
+
+    if (wl_display_dispatch_pending(display) < 0)
+    {
+        fprintf(stderr, "Failed to dispatch Wayland events\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void run(std::vector<std::unique_ptr<window>>& windows, Clock::time_point end)
+{
+    while (!stop_requested)
+    {
+        auto const now = Clock::now();
+        if (now >= end)
+            break;
+
+        auto wake = end;
+        for (auto const& w : windows)
+        {
+            if (auto const due = w->next_due(); due && *due <= now)
+                w->commit(now);
+
+            if (auto const due = w->next_due())
+                wake = std::min(wake, *due);
+
+            w->check_for_stall(now);
+        }
+
+        dispatch_until(wake);
+    }
+
+    auto const now = Clock::now();
+    for (auto const& w : windows)
+        w->check_for_stall(now);
+}
+
+struct summary
+{
+    explicit summary(char const* label) : label{label} {}
+
+    char const* label;
+    unsigned surfaces = 0;
+    unsigned commits = 0;
+    unsigned frames = 0;
+    unsigned stalled = 0;
+    samples intervals;
+    samples latencies;
+
+    void add(window const& w)
+    {
+        ++surfaces;
+        commits += w.commits;
+        frames += w.frames;
+        stalled += w.stalled;
+        intervals.append(w.intervals);
+        latencies.append(w.latencies);
+    }
+};
+
+void print_summary(summary& s, double seconds)
+{
+    printf("%s: %u surfaces, %.1f frames/s, %.1f commits/s, %u stalled\n",
+           s.label, s.surfaces, s.frames / seconds, s.commits / seconds, s.stalled);
+    printf("  frame interval ms:  p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f\n",
+           s.intervals.percentile(0.5), s.intervals.percentile(0.9),
+           s.intervals.percentile(0.99), s.intervals.percentile(1));
+    printf("  commit-to-frame ms: p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f\n",
+           s.latencies.percentile(0.5), s.latencies.percentile(0.9),
+           s.latencies.percentile(0.99), s.latencies.percentile(1));
+}
+
+void write_percentiles(FILE* out, char const* name, samples& s)
+{
+    fprintf(out, "\"%s\": {\"count\": %zu, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+            name, s.count(), s.percentile(0.5), s.percentile(0.9), s.percentile(0.99), s.percentile(1));
+}
+
+void write_json(
+    char const* filename,
+    summary& total,
+    std::vector<std::unique_ptr<window>> const& windows,
+    int layers_per_window,
+    double seconds)
+{
+    // Written under a temporary name, so a watcher never sees a partial file
+    auto const temporary = std::string{filename} + ".tmp";
+    auto const out = fopen(temporary.c_str(), "w");
+    if (!out)
+    {
+        perror("Failed to open output file");
+        return;
+    }
+
+    fprintf(out, "{\n  \"surfaces\": %u,\n  \"layers_per_surface\": %d,\n", total.surfaces, layers_per_window);
+    fprintf(out, "  \"size\": [%d, %d],\n", opts.width, opts.height);
+    fprintf(out, "  \"buffers\": \"%s\",\n", opts.buffers == buffer_type::dmabuf ? "dmabuf" : "shm");
+    fprintf(out, "  \"alpha\": %s,\n", opts.alpha ? "true" : "false");
+    fprintf(out, "  \"duration_s\": %.3f,\n", seconds);
+    fprintf(out, "  \"frames_per_second\": %.3f,\n", total.frames / seconds);
+    fprintf(out, "  \"commits_per_second\": %.3f,\n", total.commits / seconds);
+    fprintf(out, "  \"stalled_surfaces\": %u,\n  ", total.stalled);
+    write_percentiles(out, "frame_interval_ms", total.intervals);
+    fprintf(out, ",\n  ");
+    write_percentiles(out, "latency_ms", total.latencies);
+    fprintf(out, ",\n  \"per_surface\": [\n");
+
+    for (auto i = 0u; i != windows.size(); ++i)
+    {
+        auto& w = *windows[i];
+        fprintf(out, "    {\"rate_hz\": %d, \"commits\": %u, \"frames\": %u, \"stalled\": %s, ",
+                w.rate, w.commits, w.frames, w.stalled ? "true" : "false");
+        write_percentiles(out, "frame_interval_ms", w.intervals);
+        fprintf(out, ", ");
+        write_percentiles(out, "latency_ms", w.latencies);
+        fprintf(out, "}%s\n", i + 1 == windows.size() ? "" : ",");
+    }
+
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+
+    if (rename(temporary.c_str(), filename) < 0)
+        perror("Failed to write output file");
+}
+}
+
+int main(int argc, char* argv[])
+{
+    parse_options(argc, argv);
+    globals::init();
+
+    if (opts.buffers == buffer_type::dmabuf && !open_dmabuf_allocator())
+    {
+        fprintf(stderr, "Falling back to shm buffers\n");
+        opts.buffers = buffer_type::shm;
+    }
+
+    struct sigaction stop_handler{};
+    stop_handler.sa_handler = [](int) { stop_requested = true; };
+    sigaction(SIGINT, &stop_handler, nullptr);
+    sigaction(SIGTERM, &stop_handler, nullptr);
+
+    std::vector<std::unique_ptr<window>> windows;
+    for (auto i = 0; i != opts.surfaces; ++i)
+    {
+        windows.push_back(std::make_unique<window>(i, opts.rates.empty() ? 0 : opts.rates[i % opts.rates.size()]));
+    }
+    wl_display_roundtrip(globals::display);
+
+    auto const start = Clock::now();
+    measure_from = start + opts.warmup;
+    run(windows, measure_from + opts.duration);
+
+    auto const measured = std::chrono::duration<double>{Clock::now() - measure_from}.count();
+    if (measured <= 0)
+    {
+        fprintf(stderr, "Stopped before measuring began\n");
+        return EXIT_FAILURE;
+    }
+
+    summary total{"total"};
+    std::map<int, summary> by_rate;
+    for (auto const& w : windows)
+    {
+        total.add(*w);
+        by_rate.try_emplace(w->rate, "").first->second.add(*w);
+    }
+
+    int const layers_per_window = 1 + std::min(
+        opts.subsurface_depth,
+        std::max((std::min(opts.width, opts.height) - 1) / (2 * subsurface_inset), 0));
+
+    printf("%d surfaces of %dx%d (%d layers each), %s buffers%s, measured over %.1fs\n",
+           opts.surfaces, opts.width, opts.height, layers_per_window,
+           opts.buffers == buffer_type::dmabuf ? "dmabuf" : "shm",
+           opts.alpha ? ", translucent" : "", measured);
+    print_summary(total, measured);
+    for (auto& [rate, s] : by_rate)
+    {
+        auto const label = rate ? std::to_string(rate) + " Hz" : "unthrottled"s;
+        s.label = label.c_str();
+        print_summary(s, measured);
+    }
+
+    if (opts.output)
+        write_json(opts.output, total, windows, layers_per_window, measured);
+
+    windows.clear();
+    wl_display_roundtrip(globals::display);
+    wl_display_disconnect(globals::display);
+    return EXIT_SUCCESS;
+}
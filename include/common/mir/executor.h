@@ -57,11 +57,39 @@ class NonBlockingExecutor: public Executor
 {
 };
 
+/**
+ * A pool of a fixed number of worker threads (sized to the number of CPU cores).
+ *
+ * Work spawned from a worker thread is queued on that worker; idle workers steal
+ * queued work from busy ones. Work may block, but work that blocks for a long
+ * time (or forever) should use \ref spawn_blocking so it does not tie up a worker.
+ * Should all workers block anyway, extra threads are started so that queued work
+ * still makes progress.
+ */
 class ThreadPoolExecutor : public NonBlockingExecutor
 {
 public:
+    enum class Priority
+    {
+        normal,
+        high,   ///< Run before any normal priority work that is not yet running
+    };
+
     void spawn(std::function<void()>&& work) override;
 
+    /**
+     * Schedule work on the thread pool with the given priority
+     */
+    static void spawn_with_priority(std::function<void()>&& work, Priority priority);
+
+    /**
+     * Run work that is expected to block for a long time on a dedicated thread
+     *
+     * This does not occupy a worker, and so does not delay other work.
+     * The thread is still owned by the pool, and so is waited for by \ref quiesce.
+     */
+    static void spawn_blocking(std::function<void()>&& work);
+
     /**
      * Set a handler to be called should an unhandled exception occur on the ThreadPoolExecutor
      *
@@ -0,0 +1,345 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_MPSC_WORK_QUEUE_H_
+#define MIR_MPSC_WORK_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mir
+{
+/**
+ * A move-only void() callable which stores small callables (including std::function)
+ * inline rather than allocating.
+ */
+class InlineTask
+{
+public:
+    static constexpr std::size_t inline_size = 48;
+
+    InlineTask() noexcept = default;
+
+    template<typename Callable,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, InlineTask>>>
+    InlineTask(Callable&& callable)
+    {
+        using Stored = std::decay_t<Callable>;
+        if constexpr (fits_inline<Stored>)
+        {
+            new (storage) Stored{std::forward<Callable>(callable)};
+            ops = &inline_ops<Stored>;
+        }
+        else
+        {
+            new (storage) Stored*{new Stored{std::forward<Callable>(callable)}};
+            ops = &heap_ops<Stored>;
+        }
+    }
+
+    InlineTask(InlineTask&& from) noexcept
+        : ops{from.ops}
+    {
+        if (ops)
+        {
+            ops->relocate(from.storage, storage);
+            from.ops = nullptr;
+        }
+    }
+
+    auto operator=(InlineTask&& from) noexcept -> InlineTask&
+    {
+        if (this != &from)
+        {
+            reset();
+            if ((ops = from.ops))
+            {
+                ops->relocate(from.storage, storage);
+                from.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~InlineTask()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return ops != nullptr;
+    }
+
+    void operator()()
+    {
+        ops->invoke(storage);
+    }
+
+    void reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* from, void* to) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Stored>
+    static constexpr bool fits_inline =
+        sizeof(Stored) <= inline_size &&
+        alignof(Stored) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<Stored>;
+
+    template<typename Stored>
+    static constexpr Ops inline_ops{
+        [](void* storage) { (*static_cast<Stored*>(storage))(); },
+        [](void* from, void* to) noexcept
+        {
+            new (to) Stored{std::move(*static_cast<Stored*>(from))};
+            static_cast<Stored*>(from)->~Stored();
+        },
+        [](void* storage) noexcept { static_cast<Stored*>(storage)->~Stored(); }};
+
+    template<typename Stored>
+    static constexpr Ops heap_ops{
+        [](void* storage) { (**static_cast<Stored**>(storage))(); },
+        [](void* from, void* to) noexcept { new (to) Stored*{*static_cast<Stored**>(from)}; },
+        [](void* storage) noexcept { delete *static_cast<Stored**>(storage); }};
+
+    alignas(std::max_align_t) std::byte storage[inline_size];
+    Ops const* ops{nullptr};
+};
+
+/**
+ * A lock-free queue of work with many producers and a single consumer.
+ *
+ * This is an intrusive linked list (after Dmitry Vyukov's MPSC queue); push() never
+ * blocks on the consumer or on other producers.
+ *
+ * Wakeups are coalesced: push() returns true only when the consumer may have found
+ * the queue empty and so needs waking. The consumer must keep calling try_pop() until
+ * it returns false before waiting again.
+ *
+ * Nodes the consumer has finished with are kept (up to \ref max_spare_nodes) for
+ * producers to reuse, so a queue in steady state does not allocate per work item.
+ */
+class MPSCWorkQueue
+{
+public:
+    static constexpr std::size_t max_spare_nodes = 256;
+
+    MPSCWorkQueue() noexcept
+        : head{&stub},
+          tail{&stub}
+    {
+    }
+
+    ~MPSCWorkQueue()
+    {
+        InlineTask discard;
+        while (try_pop(discard))
+        {
+        }
+
+        for (auto node = spare.load(std::memory_order_acquire); node;)
+        {
+            auto const next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    MPSCWorkQueue(MPSCWorkQueue const&) = delete;
+    auto operator=(MPSCWorkQueue const&) -> MPSCWorkQueue& = delete;
+
+    /**
+     * Add work to the queue; may be called from any thread
+     *
+     * \return  true if the consumer needs to be woken to process the work
+     */
+    auto push(InlineTask&& task) -> bool
+    {
+        auto node = take_spare();
+        if (node)
+        {
+            node->task = std::move(task);
+        }
+        else
+        {
+            node = new Node{std::move(task)};
+        }
+        link(node);
+
+        return consumer_idle.exchange(false, std::memory_order_seq_cst);
+    }
+
+    /**
+     * Take the oldest work from the queue; only to be called from the consumer
+     *
+     * \return  false (and marks the consumer idle) if there is no work to take
+     */
+    auto try_pop(InlineTask& task) -> bool
+    {
+        if (auto const node = pop_node())
+        {
+            take(node, task);
+            return true;
+        }
+
+        consumer_idle.store(true, std::memory_order_seq_cst);
+
+        // A producer may have finished pushing before seeing the consumer idle
+        if (auto const node = pop_node())
+        {
+            take(node, task);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Node
+    {
+        explicit Node(InlineTask&& task) noexcept
+            : task{std::move(task)}
+        {
+        }
+
+        std::atomic<Node*> next{nullptr};
+        InlineTask task;
+    };
+
+    void link(Node* node)
+    {
+        auto const prev = head.exchange(node, std::memory_order_acq_rel);
+        // Between the exchange and here the queue is in a "pushing" state; pop_node() sees it as empty
+        prev->next.store(node, std::memory_order_seq_cst);
+    }
+
+    auto pop_node() -> Node*
+    {
+        auto node = tail;
+        auto next = node->next.load(std::memory_order_seq_cst);
+
+        if (node == &stub)
+        {
+            if (!next)
+                return nullptr;
+
+            tail = node = next;
+            next = node->next.load(std::memory_order_seq_cst);
+        }
+
+        if (next)
+        {
+            tail = next;
+            return node;
+        }
+
+        if (node != head.load(std::memory_order_acquire))
+        {
+            // A push is in progress; its producer will wake us if needed
+            return nullptr;
+        }
+
+        // node is the last in the queue; put the stub behind it so that it can be taken
+        stub.next.store(nullptr, std::memory_order_relaxed);
+        link(&stub);
+
+        next = node->next.load(std::memory_order_seq_cst);
+        if (next)
+        {
+            tail = next;
+            return node;
+        }
+        return nullptr;
+    }
+
+    void take(Node* node, InlineTask& task)
+    {
+        task = std::move(node->task);
+        recycle(node);
+    }
+
+    /*
+     * The spare list is a stack that only the consumer pushes to. Producers pop one
+     * at a time, which rules out ABA: no node can leave the stack while a popper is
+     * looking at it. A producer that finds another popping just allocates.
+     */
+    void recycle(Node* node) noexcept
+    {
+        if (spare_count.load(std::memory_order_relaxed) >= max_spare_nodes)
+        {
+            delete node;
+            return;
+        }
+
+        spare_count.fetch_add(1, std::memory_order_relaxed);
+        auto top = spare.load(std::memory_order_relaxed);
+        do
+        {
+            node->next.store(top, std::memory_order_relaxed);
+        }
+        while (!spare.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    auto take_spare() noexcept -> Node*
+    {
+        if (!spare.load(std::memory_order_relaxed) || spare_popping.test_and_set(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        auto top = spare.load(std::memory_order_acquire);
+        while (top && !spare.compare_exchange_weak(
+            top, top->next.load(std::memory_order_relaxed), std::memory_order_acquire, std::memory_order_acquire))
+        {
+        }
+        spare_popping.clear(std::memory_order_release);
+
+        if (top)
+        {
+            spare_count.fetch_sub(1, std::memory_order_relaxed);
+            top->next.store(nullptr, std::memory_order_relaxed);
+        }
+        return top;
+    }
+
+    std::atomic<Node*> head;    ///< Most recently pushed; written by producers
+    Node* tail;                 ///< Next to pop; only touched by the consumer
+    Node stub{InlineTask{}};
+    std::atomic<bool> consumer_idle{true};
+
+    std::atomic<Node*> spare{nullptr};             ///< Nodes free for producers to reuse
+    std::atomic<std::size_t> spare_count{0};
+    std::atomic_flag spare_popping = ATOMIC_FLAG_INIT;
+};
+}
+
+#endif // MIR_MPSC_WORK_QUEUE_H_
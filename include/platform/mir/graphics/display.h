@@ -134,6 +134,22 @@ public:
      */
     virtual void configure(DisplayConfiguration const& conf) = 0;
 
+    /**
+     * Sets a new output configuration, preserving the DisplaySyncGroups it does not affect.
+     *
+     * Before a DisplaySyncGroup is invalidated \p retire is called with it, and the caller
+     * must have stopped using the group by the time \p retire returns. DisplaySyncGroups
+     * that are not retired remain valid, and may continue to be used while this call is in
+     * progress. Any new DisplaySyncGroups are available from for_each_display_sync_group()
+     * once this returns.
+     *
+     * An implementation that cannot preserve DisplaySyncGroups may retire all of them and
+     * then configure().
+     */
+    virtual void configure_incrementally(
+        DisplayConfiguration const& conf,
+        std::function<void(DisplaySyncGroup&)> const& retire) = 0;
+
     /**
      * Registers a handler for display configuration changes.
      *
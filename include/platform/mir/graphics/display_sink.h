@@ -47,6 +47,11 @@ struct DisplayElement
      */
     geometry::RectangleF source_position;
     std::shared_ptr<Framebuffer> buffer;
+    /**
+     * The client would rather this element reach the screen immediately than wait
+     * for vblank. A sink that scans the buffer out directly may flip asynchronously.
+     */
+    bool tearing_allowed{false};
 };
 /**
  * Interface to an output sink.
@@ -87,6 +92,22 @@ public:
      */
     virtual void set_next_image(std::unique_ptr<Framebuffer> content) = 0;
 
+    /**
+     * Describe which parts of the image given to the last set_next_image() differ
+     * from the image before it
+     *
+     * Sinks that present by copying the image elsewhere (such as to a host compositor)
+     * can limit the copy to these areas; other sinks can ignore this.
+     *
+     * \param damage   Areas in the same coordinates as view_area(). An empty list means
+     *                  the whole image may have changed, which is also what sinks must
+     *                  assume when this isn't called after set_next_image().
+     */
+    virtual void set_next_image_damage(std::vector<geometry::Rectangle> const& damage)
+    {
+        (void)damage;
+    }
+
     /**
      * Returns a transformation that the renderer must apply to all rendering.
      * There is usually no transformation required (just the identity matrix)
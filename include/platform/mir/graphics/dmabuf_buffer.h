@@ -63,6 +63,25 @@ public:
 
     virtual auto size() const -> geometry::Size = 0;
 };
+
+/**
+ * A buffer whose client is told when its content has been used
+ *
+ * This normally happens when the renderer textures from the buffer. Anything that uses the
+ * dmabufs another way, such as handing them to a host compositor, must call notify_consumed().
+ */
+class ConsumableBuffer
+{
+public:
+    virtual ~ConsumableBuffer() = default;
+
+    virtual void notify_consumed() = 0;
+
+protected:
+    ConsumableBuffer() = default;
+    ConsumableBuffer(ConsumableBuffer const&) = delete;
+    ConsumableBuffer& operator=(ConsumableBuffer const&) = delete;
+};
 }
 }
 
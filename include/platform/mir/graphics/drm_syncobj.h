@@ -0,0 +1,100 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_DRM_SYNCOBJ_H_
+#define MIR_GRAPHICS_DRM_SYNCOBJ_H_
+
+#include "mir/fd.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+namespace drm
+{
+/**
+ * A DRM timeline synchronisation object
+ *
+ * Each point on the timeline is a fence that is signalled by whoever produced it; waiters
+ * can ask to be notified when a point is signalled without blocking on it.
+ */
+class Syncobj
+{
+public:
+    /**
+     * Import a timeline that has been exported as a file descriptor (for example, by a client)
+     *
+     * \throws std::system_error if the timeline cannot be imported into drm_fd
+     */
+    Syncobj(mir::Fd drm_fd, mir::Fd const& timeline);
+    ~Syncobj();
+
+    Syncobj(Syncobj const&) = delete;
+    Syncobj& operator=(Syncobj const&) = delete;
+
+    /**
+     * Whether drm_fd supports timeline syncobjs and waiting on them asynchronously
+     */
+    static auto supported(mir::Fd const& drm_fd) -> bool;
+
+    /**
+     * An eventfd that becomes readable once point has been signalled
+     *
+     * This does not block; it is intended to be added to an event loop.
+     */
+    auto signalled_eventfd(uint64_t point) const -> mir::Fd;
+
+    /**
+     * Signal point immediately
+     */
+    void signal(uint64_t point) const;
+
+    /**
+     * Signal point once the fence represented by sync_file has signalled
+     */
+    void signal_after(uint64_t point, mir::Fd const& sync_file) const;
+
+private:
+    mir::Fd const drm_fd;
+    uint32_t const handle;
+};
+}
+
+/**
+ * A buffer that can signal a timeline point itself once it is no longer being read
+ *
+ * This lets the renderer signal release from the GPU fence of the last frame that sampled
+ * the buffer, rather than the client relying on implicit synchronisation.
+ */
+class ExplicitSyncBuffer
+{
+public:
+    virtual ~ExplicitSyncBuffer() = default;
+
+    virtual void set_release_point(std::shared_ptr<drm::Syncobj const> timeline, uint64_t point) = 0;
+
+protected:
+    ExplicitSyncBuffer() = default;
+    ExplicitSyncBuffer(ExplicitSyncBuffer const&) = delete;
+    ExplicitSyncBuffer& operator=(ExplicitSyncBuffer const&) = delete;
+};
+}
+}
+
+#endif // MIR_GRAPHICS_DRM_SYNCOBJ_H_
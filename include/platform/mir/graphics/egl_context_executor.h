@@ -18,13 +18,13 @@
 #define MIR_EGL_CONTEXT_EXECUTOR_H
 
 #include "mir/executor.h"
+#include "mir/mpsc_work_queue.h"
 
 #include <memory>
 #include <future>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
-#include <vector>
 
 namespace mir
 {
@@ -54,9 +54,10 @@ private:
     static void process_loop(EGLContextExecutor* const me);
 
     std::unique_ptr<renderer::gl::Context> const ctx;
+    MPSCWorkQueue work_queue;
     std::mutex mutex;
     std::condition_variable new_work;
-    std::vector<std::function<void()>> work_queue;
+    bool wakeup_pending{false};
     bool shutdown_requested{false};
 
     std::thread egl_thread;
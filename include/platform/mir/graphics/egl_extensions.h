@@ -326,6 +326,27 @@ struct EGLExtensions
         PFNEGLEXPORTDMABUFIMAGEMESAPROC const eglExportDMABUFImageMESA;
         PFNEGLEXPORTDMABUFIMAGEQUERYMESAPROC const eglExportDMABUFImageQueryMESA;
     };
+
+    struct ANDROIDNativeFenceSync
+    {
+        ANDROIDNativeFenceSync(EGLDisplay dpy);
+
+        static auto extension_if_supported(EGLDisplay dpy) -> std::optional<ANDROIDNativeFenceSync>;
+
+        PFNEGLCREATESYNCKHRPROC const eglCreateSyncKHR;
+        PFNEGLDESTROYSYNCKHRPROC const eglDestroySyncKHR;
+        PFNEGLDUPNATIVEFENCEFDANDROIDPROC const eglDupNativeFenceFDANDROID;
+    };
+
+    /// EGL_KHR_swap_buffers_with_damage, or the identical EGL_EXT_swap_buffers_with_damage
+    struct SwapBuffersWithDamage
+    {
+        SwapBuffersWithDamage(EGLDisplay dpy);
+
+        static auto extension_if_supported(EGLDisplay dpy) -> std::optional<SwapBuffersWithDamage>;
+
+        PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC const eglSwapBuffersWithDamage;
+    };
 };
 }
 }
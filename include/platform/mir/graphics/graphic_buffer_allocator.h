@@ -18,10 +18,12 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include "mir/graphics/buffer.h"
+#include "mir/fd.h"
 
 #include <vector>
 #include <memory>
 #include <functional>
+#include <optional>
 
 struct wl_display;
 struct wl_resource;
@@ -91,6 +93,16 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> = 0;
 
+    /**
+     * The DRM device to use for explicit synchronisation of client buffers
+     *
+     * Client-supplied DRM syncobj timelines are imported on this device. Buffers returned
+     * from buffer_from_resource() on such an allocator may implement ExplicitSyncBuffer.
+     *
+     * \return The DRM device, or std::nullopt if explicit synchronisation is not supported
+     */
+    virtual auto drm_syncobj_device() -> std::optional<Fd> = 0;
+
 protected:
     GraphicBufferAllocator() = default;
     GraphicBufferAllocator(const GraphicBufferAllocator&) = delete;
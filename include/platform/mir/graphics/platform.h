@@ -401,6 +401,28 @@ public:
         -> std::unique_ptr<Framebuffer> = 0;
 };
 
+/**
+ * A DisplayAllocator that can show client buffers as they are, without them being rendered
+ *
+ * This is for sinks that are themselves clients of another display server, which can
+ * composite the buffers for us.
+ */
+class PassthroughDisplayAllocator : public DisplayAllocator
+{
+public:
+    class Tag : public DisplayAllocator::Tag
+    {
+    };
+
+    /**
+     * Wrap \p buffer so that it can be passed to DisplaySink::overlay()
+     *
+     * \return  The Framebuffer, or nullptr if this buffer cannot be passed through
+     */
+    virtual auto framebuffer_for(std::shared_ptr<Buffer> buffer)
+        -> std::unique_ptr<Framebuffer> = 0;
+};
+
 #ifndef EGLStreamKHR
 typedef void* EGLStreamKHR;
 #endif
@@ -73,6 +73,12 @@ public:
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
+    /**
+     * Whether the client prefers this content presented as soon as possible,
+     * even if that means tearing.
+     */
+    virtual bool tearing_allowed() const { return false; }
+
     virtual auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> = 0;
 protected:
@@ -0,0 +1,72 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_UPLOADED_BUFFER_H_
+#define MIR_GRAPHICS_UPLOADED_BUFFER_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * A CPU buffer whose content is copied into a texture when it is drawn
+ *
+ * The texture is only created if the buffer is drawn by a renderer that needs one, and
+ * may be released (to stay within a texture budget, say) and created again later. Its
+ * memory therefore comes and goes independently of the buffer's.
+ */
+class UploadedBuffer
+{
+public:
+    virtual ~UploadedBuffer() = default;
+
+    /**
+     * Call on_texture_resized with the size in bytes of the texture each time it is
+     * created, and with 0 each time it is released
+     *
+     * It is not called when the buffer itself is destroyed.
+     *
+     * \note on_texture_resized is called on a rendering thread
+     */
+    virtual void on_texture_resized(std::function<void(std::size_t bytes)> on_texture_resized) = 0;
+
+    /**
+     * Whether the buffer is on screen
+     *
+     * Only the textures of buffers that are not visible are released. Buffers start out visible.
+     */
+    virtual void set_visible(bool visible) = 0;
+
+    /**
+     * Release the texture now, unless the buffer is visible
+     *
+     * It is created again if the buffer is drawn. Buffers whose texture the GPU may
+     * draw into keep it.
+     */
+    virtual void release_texture() = 0;
+
+protected:
+    UploadedBuffer() = default;
+    UploadedBuffer(UploadedBuffer const&) = delete;
+    UploadedBuffer& operator=(UploadedBuffer const&) = delete;
+};
+}
+}
+
+#endif // MIR_GRAPHICS_UPLOADED_BUFFER_H_
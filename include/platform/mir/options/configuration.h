@@ -30,6 +30,7 @@ extern char const* const enable_input_opt;
 extern char const* const shared_library_prober_report_opt;
 extern char const* const shell_report_opt;
 extern char const* const compositor_report_opt;
+extern char const* const compositor_metrics_file_opt;
 extern char const* const display_report_opt;
 extern char const* const scene_report_opt;
 extern char const* const input_report_opt;
@@ -39,6 +40,7 @@ extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
 extern char const* const composite_delay_opt;
+extern char const* const renderer_opt;
 extern char const* const enable_key_repeat_opt;
 extern char const* const x11_display_opt;
 extern char const* const x11_scale_opt;
@@ -46,6 +48,14 @@ extern char const* const wayland_extensions_opt;
 extern char const* const add_wayland_extensions_opt;
 extern char const* const drop_wayland_extensions_opt;
 extern char const* const idle_timeout_opt;
+extern char const* const compositor_thread_policy_opt;
+extern char const* const input_thread_policy_opt;
+extern char const* const page_flip_thread_policy_opt;
+extern char const* const workqueue_thread_policy_opt;
+extern char const* const client_memory_soft_limit_opt;
+extern char const* const client_memory_hard_limit_opt;
+extern char const* const texture_memory_budget_opt;
+extern char const* const shm_udmabuf_opt;
 
 extern char const* const enable_key_repeat_opt;
 
@@ -20,10 +20,12 @@
 #include <stddef.h>
 #include <functional>
 #include <memory>
+#include <optional>
 
 #include "mir/geometry/dimensions.h"
 #include "mir/geometry/size.h"
 #include "mir/graphics/buffer.h"
+#include "mir/fd.h"
 #include "mir_toolkit/common.h"
 
 namespace mir
@@ -142,6 +144,30 @@ public:
     virtual void transfer_into_buffer(unsigned char const* source) = 0;
 };
 
+/**
+ * A buffer whose pixels live in a memfd that is sealed against shrinking
+ *
+ * The GPU can sample such a buffer in place (for example, through /dev/udmabuf)
+ * rather than it being copied into a texture.
+ */
+class MemfdBackedBuffer : public virtual BufferDescriptor
+{
+public:
+    struct Range
+    {
+        mir::Fd memfd;
+        size_t offset;  ///< Offset of the first pixel in memfd
+        size_t len;
+        /// The same for every view of a client's buffer, and destroyed with the last of them
+        std::shared_ptr<void const> owner;
+    };
+
+    virtual ~MemfdBackedBuffer() = default;
+
+    /// The range of the memfd holding the pixels, or nothing if the memfd is no longer suitable
+    virtual auto memfd_range() const -> std::optional<Range> = 0;
+};
+
 auto as_read_mappable_buffer(
     std::shared_ptr<graphics::Buffer> const& buffer) -> std::shared_ptr<ReadMappableBuffer>;
 
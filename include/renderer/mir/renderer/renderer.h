@@ -22,15 +22,24 @@
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
 {
+class Buffer;
 class Framebuffer;
 }
 
 namespace renderer
 {
+namespace software
+{
+class WriteMappableBuffer;
+}
 
 class Renderer
 {
@@ -42,6 +51,36 @@ public:
     virtual auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /// A copy of part of a frame, taken after it is drawn and before it goes to the output
+    struct FrameCapture
+    {
+        /// The part of the frame to copy, in the same coordinates as the viewport
+        geometry::Rectangle area;
+        /// The part of area that needs writing; the rest of the target already holds it
+        geometry::Rectangle damage;
+        /// Exactly one of cpu_target and gpu_target is set. Both must be the size of area.
+        std::shared_ptr<software::WriteMappableBuffer> cpu_target;
+        std::shared_ptr<graphics::Buffer> gpu_target;
+        /// Called once the copy has been made, or with false if this frame couldn't be copied
+        std::function<void(bool copied)> done;
+    };
+
+    /**
+     * Copy the next frame render() draws into each of \p captures
+     *
+     * This avoids drawing the frame a second time just to capture it. Captures the renderer
+     * can't satisfy (for example, because the output is rotated or scaled) complete with false.
+     * Renderers that can't capture at all need not override this; by default every capture
+     * completes with false.
+     */
+    virtual void capture_next_frame(std::vector<FrameCapture>&& captures)
+    {
+        for (auto& capture : captures)
+        {
+            capture.done(false);
+        }
+    }
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
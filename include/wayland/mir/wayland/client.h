@@ -19,6 +19,7 @@
 
 struct wl_client;
 
+#include <functional>
 #include <memory>
 #include <optional>
 
@@ -72,6 +73,14 @@ public:
     virtual auto output_geometry_scale() -> float = 0;
     /// @}
 
+    /// True if the client has fallen behind reading the events sent to it. Work that only updates the client's view
+    /// of state (rather than being a reply) can be deferred with when_uncongested() to apply back-pressure.
+    virtual auto is_congested() const -> bool = 0;
+
+    /// Run work (on the Wayland thread) once the client is not congested; immediately if it is not now. Work is
+    /// dropped if the client is destroyed first.
+    virtual void when_uncongested(std::function<void()>&& work) = 0;
+
 protected:
     static void register_client(wl_client* raw, std::shared_ptr<Client> const& shared);
     static void unregister_client(wl_client* raw);
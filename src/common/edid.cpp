@@ -47,6 +47,23 @@ uint16_t Edid::product_code() const
     return le16toh(product_code_le);
 }
 
+bool Edid::get_vertical_refresh_range(int& min_hz, int& max_hz) const
+{
+    for (int d = 0; d < 4; ++d)
+    {
+        auto& desc = descriptor[d];
+        if (!desc.other.zero0 && desc.other.type == range_limits_descriptor)
+        {
+            // EDID 1.4 stores rate offsets of 255Hz in the otherwise reserved byte
+            auto const offsets = desc.other.zero4;
+            min_hz = desc.other.text[0] + ((offsets & 0x3) == 0x3 ? 255 : 0);
+            max_hz = desc.other.text[1] + ((offsets & 0x2) ? 255 : 0);
+            return true;
+        }
+    }
+    return false;
+}
+
 size_t Edid::get_string(StringDescriptorType type, char str[14]) const
 {
     size_t len = 0;
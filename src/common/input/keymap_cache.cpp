@@ -0,0 +1,181 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/keymap_cache.h"
+#include "mir/input/keymap.h"
+#include "mir/input/xkb_mapper.h"
+#include "mir/anonymous_shm_file.h"
+
+#include <boost/throw_exception.hpp>
+#include <xkbcommon/xkbcommon.h>
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace mi = mir::input;
+
+namespace
+{
+/// Reopening through /proc gives a new open file description that can't be
+/// written through, so clients can map it MAP_SHARED without being able to
+/// modify what every other client sees.
+auto reopen_read_only(mir::Fd const& fd) -> mir::Fd
+{
+    auto const path = "/proc/self/fd/" + std::to_string(fd);
+    auto const raw_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (raw_fd == -1)
+    {
+        // Without /proc the seals still stop anyone changing the contents
+        return fd;
+    }
+    return mir::Fd{raw_fd};
+}
+
+auto write_all(mir::Fd const& fd, char const* data, size_t size) -> bool
+{
+    while (size > 0)
+    {
+        auto const written = write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+auto make_keymap_fd(char const* text, size_t size) -> mir::Fd
+{
+    auto const raw_fd = memfd_create("mir-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (raw_fd == -1 && errno == ENOSYS)
+    {
+        // No memfd: fall back to an unsealed file that nobody keeps writable
+        mir::AnonymousShmFile shm_buffer{size};
+        memcpy(shm_buffer.base_ptr(), text, size);
+
+        // shm_buffer closes its own fd, so the keymap needs one of its own
+        mir::Fd const fd{fcntl(shm_buffer.fd(), F_DUPFD_CLOEXEC, 0)};
+        if (fd == mir::Fd::invalid)
+        {
+            BOOST_THROW_EXCEPTION(
+                std::system_error(errno, std::system_category(), "Failed to duplicate keymap file"));
+        }
+        return reopen_read_only(fd);
+    }
+    if (raw_fd == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create keymap memfd"));
+    }
+
+    mir::Fd const fd{raw_fd};
+
+    // Written rather than mapped: F_SEAL_WRITE is refused while writable mappings exist
+    if (!write_all(fd, text, size))
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to write keymap memfd"));
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to seal keymap memfd"));
+    }
+
+    return reopen_read_only(fd);
+}
+
+class KeymapCache
+{
+public:
+    auto compile(std::shared_ptr<mi::Keymap> const& keymap) -> std::shared_ptr<mi::CompiledKeymap const>
+    {
+        std::lock_guard lock{mutex};
+
+        std::shared_ptr<mi::CompiledKeymap const> result;
+        std::erase_if(entries, [&](auto const& entry)
+            {
+                auto const compiled = entry.lock();
+                if (!compiled)
+                {
+                    return true;
+                }
+                if (!result && (compiled->keymap() == keymap || compiled->keymap()->matches(*keymap)))
+                {
+                    result = compiled;
+                }
+                return false;
+            });
+
+        if (result)
+        {
+            return result;
+        }
+
+        std::shared_ptr<xkb_keymap> const compiled{keymap->make_unique_xkb_keymap(context.get())};
+
+        std::unique_ptr<char, void(*)(void*)> const text{
+            xkb_keymap_get_as_string(compiled.get(), XKB_KEYMAP_FORMAT_TEXT_V1),
+            free};
+        if (!text)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to serialize keymap"));
+        }
+        // so the null terminator is included
+        auto const size = strlen(text.get()) + 1;
+
+        result = std::make_shared<mi::CompiledKeymap const>(keymap, compiled, make_keymap_fd(text.get(), size), size);
+        entries.push_back(result);
+        return result;
+    }
+
+private:
+    std::mutex mutex;
+    mi::XKBContextPtr const context{mi::make_unique_context()};
+    /// Few distinct keymaps are ever alive at once, so a linear search is fine
+    std::vector<std::weak_ptr<mi::CompiledKeymap const>> entries;
+};
+}
+
+mi::CompiledKeymap::CompiledKeymap(
+    std::shared_ptr<Keymap> keymap,
+    std::shared_ptr<::xkb_keymap> compiled,
+    Fd fd,
+    size_t size)
+    : keymap_{std::move(keymap)},
+      compiled{std::move(compiled)},
+      fd_{std::move(fd)},
+      size_{size}
+{
+}
+
+auto mi::compile_keymap(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<CompiledKeymap const>
+{
+    static KeymapCache cache;
+    return cache.compile(keymap);
+}
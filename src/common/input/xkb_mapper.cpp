@@ -16,6 +16,7 @@
 
 #include "mir/input/xkb_mapper.h"
 #include "mir/input/keymap.h"
+#include "mir/input/keymap_cache.h"
 #include "mir/events/event_private.h"
 #include "mir/events/event_builders.h"
 
@@ -231,7 +232,7 @@ void mircv::XKBMapper::set_keymap(std::shared_ptr<Keymap> new_keymap)
 {
     std::lock_guard lg(guard);
     default_keymap = std::move(new_keymap);
-    default_compiled_keymap = default_keymap->make_unique_xkb_keymap(context.get());
+    default_compiled_keymap = compile_keymap(default_keymap)->xkb_keymap();
     device_mapping.clear();
 }
 
@@ -244,8 +245,8 @@ void mircv::XKBMapper::set_keymap(MirInputDeviceId id, std::shared_ptr<Keymap> n
 {
     std::lock_guard lg(guard);
 
-    auto compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
-    auto mapping_state = std::make_unique<XkbMappingState>(std::move(new_keymap), std::move(compiled_keymap));
+    auto compiled_keymap = compile_keymap(new_keymap)->xkb_keymap();
+    auto mapping_state = std::make_unique<XkbMappingState>(std::move(new_keymap), compiled_keymap);
 
     device_mapping.erase(id);
     device_mapping.emplace(
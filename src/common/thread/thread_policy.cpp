@@ -0,0 +1,222 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/thread_policy.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace
+{
+auto const role_count = static_cast<size_t>(mir::ThreadRole::workqueue) + 1;
+
+auto role_name(mir::ThreadRole role) -> char const*
+{
+    switch (role)
+    {
+    case mir::ThreadRole::compositor: return "compositor";
+    case mir::ThreadRole::input: return "input";
+    case mir::ThreadRole::page_flip: return "page-flip";
+    case mir::ThreadRole::workqueue: return "workqueue";
+    }
+    return "unknown";
+}
+
+auto parse_int(std::string const& text, std::string const& spec) -> int
+{
+    try
+    {
+        size_t used{0};
+        auto const value = std::stoi(text, &used);
+        if (used == text.size())
+            return value;
+    }
+    catch (std::logic_error const&)
+    {
+    }
+    BOOST_THROW_EXCEPTION(std::invalid_argument{"Invalid thread policy \"" + spec + "\": bad number \"" + text + "\""});
+}
+
+auto parse_cpus(std::string const& list, std::string const& spec) -> std::vector<int>
+{
+    std::vector<int> cpus;
+
+    size_t start{0};
+    while (start <= list.size())
+    {
+        auto const end = std::min(list.find(',', start), list.size());
+        auto const item = list.substr(start, end - start);
+        auto const dash = item.find('-');
+
+        auto const first = parse_int(item.substr(0, dash), spec);
+        auto const last = dash == std::string::npos ? first : parse_int(item.substr(dash + 1), spec);
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+        {
+            BOOST_THROW_EXCEPTION(std::invalid_argument{"Invalid thread policy \"" + spec + "\": bad CPU range \"" + item + "\""});
+        }
+
+        for (auto cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+
+        start = end + 1;
+    }
+
+    return cpus;
+}
+
+struct Registry
+{
+    std::mutex mutex;
+    std::array<std::optional<mir::ThreadPolicy>, role_count> policies;
+    std::array<bool, role_count> warned{};
+};
+
+auto registry() -> Registry&
+{
+    static Registry instance;
+    return instance;
+}
+
+void warn_once(mir::ThreadRole role, char const* what, int error)
+{
+    auto& reg = registry();
+    {
+        std::lock_guard lock{reg.mutex};
+        auto& warned = reg.warned[static_cast<size_t>(role)];
+        if (warned)
+            return;
+        warned = true;
+    }
+
+    mir::log_warning(
+        "Failed to %s for %s threads (%s); continuing with default scheduling",
+        what, role_name(role), strerror(error));
+}
+}
+
+auto mir::parse_thread_policy(std::string const& spec) -> ThreadPolicy
+{
+    ThreadPolicy policy;
+
+    auto const at = spec.find('@');
+    auto const scheduling = spec.substr(0, at);
+
+    if (!scheduling.empty())
+    {
+        auto const colon = scheduling.find(':');
+        if (colon == std::string::npos)
+        {
+            BOOST_THROW_EXCEPTION(std::invalid_argument{"Invalid thread policy \"" + spec + "\": expected <scheduler>:<value>"});
+        }
+
+        auto const scheduler = scheduling.substr(0, colon);
+        auto const value = parse_int(scheduling.substr(colon + 1), spec);
+
+        if (scheduler == "fifo" || scheduler == "rr")
+        {
+            if (value < sched_get_priority_min(SCHED_FIFO) || value > sched_get_priority_max(SCHED_FIFO))
+            {
+                BOOST_THROW_EXCEPTION(std::invalid_argument{"Invalid thread policy \"" + spec + "\": priority out of range"});
+            }
+            policy.scheduler = scheduler == "fifo" ? ThreadPolicy::Scheduler::fifo : ThreadPolicy::Scheduler::round_robin;
+            policy.priority = value;
+        }
+        else if (scheduler == "nice")
+        {
+            if (value < -20 || value > 19)
+            {
+                BOOST_THROW_EXCEPTION(std::invalid_argument{"Invalid thread policy \"" + spec + "\": nice value out of range"});
+            }
+            policy.nice = value;
+        }
+        else
+        {
+            BOOST_THROW_EXCEPTION(std::invalid_argument{"Invalid thread policy \"" + spec + "\": unknown scheduler \"" + scheduler + "\""});
+        }
+    }
+
+    if (at != std::string::npos)
+    {
+        policy.cpus = parse_cpus(spec.substr(at + 1), spec);
+    }
+
+    return policy;
+}
+
+void mir::set_thread_policy(ThreadRole role, ThreadPolicy const& policy)
+{
+    auto& reg = registry();
+    std::lock_guard lock{reg.mutex};
+    reg.policies[static_cast<size_t>(role)] = policy;
+}
+
+void mir::apply_thread_policy(ThreadRole role)
+{
+    std::optional<ThreadPolicy> policy;
+    {
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        policy = reg.policies[static_cast<size_t>(role)];
+    }
+
+    if (!policy)
+        return;
+
+    if (!policy->cpus.empty())
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (auto const cpu : policy->cpus)
+            CPU_SET(cpu, &cpus);
+
+        if (auto const error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus))
+            warn_once(role, "set CPU affinity", error);
+    }
+
+    switch (policy->scheduler)
+    {
+    case ThreadPolicy::Scheduler::fifo:
+    case ThreadPolicy::Scheduler::round_robin:
+    {
+        sched_param param;
+        ::memset(&param, 0, sizeof(param));
+        param.sched_priority = policy->priority;
+        auto const sched = policy->scheduler == ThreadPolicy::Scheduler::fifo ? SCHED_FIFO : SCHED_RR;
+
+        if (auto const error = pthread_setschedparam(pthread_self(), sched, &param))
+            warn_once(role, "set real-time priority", error);
+        break;
+    }
+
+    case ThreadPolicy::Scheduler::normal:
+        // On Linux the nice value is per-thread when addressed by thread id
+        if (policy->nice && setpriority(PRIO_PROCESS, gettid(), *policy->nice))
+            warn_once(role, "set nice value", errno);
+        break;
+    }
+}
@@ -15,148 +15,155 @@
  */
 
 #include "mir/executor.h"
-#include "mir/signal.h"
 
 #include "mir/thread_name.h"
+#include "mir/thread_policy.h"
 
-#include <thread>
-#include <memory>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <list>
-#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace
 {
 constexpr int const min_threadpool_threads = 4;
 
+/// How long queued work may wait, with every worker busy and none finishing, before we assume
+/// they are all blocked and start an extra thread
+constexpr auto const starvation_threshold = std::chrono::milliseconds{2};
+
+/// How long an extra thread waits for more work before exiting
+constexpr auto const extra_thread_idle_timeout = std::chrono::seconds{1};
+
 /* We use an atomic void(*)() rather than a std::function to avoid needing to take a mutex
  * in exception context, as taking a mutex can itself throw an exception!
  */
 std::atomic<void(*)()> exception_handler{[] { std::rethrow_exception(std::current_exception()); }};
 
-class Worker
+using Work = std::function<void()>;
+
+void run(Work& work)
 {
-public:
-    Worker()
-        : work{[](){}}
+    try
     {
-        std::promise<std::atomic<bool>*> shutdown_channel;
-        auto resolved_shutdown_location = shutdown_channel.get_future();
-
-        thread = std::thread{
-            &work_loop,
-            this,
-            std::move(shutdown_channel)};
-
-        shutdown = resolved_shutdown_location.get();
+        work();
     }
-
-    ~Worker() noexcept
+    catch (...)
     {
-        if (thread.joinable())
-        {
-            /* Safety: stop() is the only other callsite of signal_work_thread_to_halt()
-             * If stop() has been called then it has already called thread.join(), so
-             * thread.joinable() will be false and we can't get here.
-             */
-            signal_work_thread_to_halt();
-            if (thread.get_id() == std::this_thread::get_id())
-            {
-                /* We're being destroyed from our own work thread.
-                 * This can only happen when destroying the work functor at me->work = [](){}
-                 * in work_loop results in destroying the last shared pointer to *this.
-                 *
-                 * At this point, work_loop will exit without touching anything
-                 */
-                thread.detach();
-            }
-            else
-            {
-                thread.join();
-            }
-        }
+        (*exception_handler)();
     }
+}
 
-    void set_work(std::function<void()>&& to_do)
+/**
+ * A queue of work that can be pushed to and taken from by multiple threads
+ *
+ * The size is tracked atomically so that the (common) empty case can be checked
+ * without taking the lock.
+ */
+class WorkQueue
+{
+public:
+    void push(Work&& work)
     {
-        // Precondition: this Worker is idle (work_available is unraised, work = [](){})
-        work = std::move(to_do);
-        work_available.raise();
+        std::lock_guard lock{mutex};
+        queue.push_back(std::move(work));
+        size.store(queue.size(), std::memory_order_release);
     }
 
-    /**
-     * Halt the worker, dropping any work scheduled but not yet executing, and wait for completion.
-     */
-    void stop()
-    {
-        signal_work_thread_to_halt();
-        thread.join();
-    }
-private:
-    void signal_work_thread_to_halt()
+    auto try_pop(Work& work) -> bool
     {
-        /* Precondition: *shutdown == false
-         * If *shutdown has become true, then we are unsynchronised with the termination of
-         * the worker thread, and so we can not guarantee that shutdown points to valid memory.
-         *
-         * This implies that signal_work_thread_to_halt() must be called exactly once.
-         */
-        *shutdown = true;
-        /* We need to release the workloop thread by raising the signal.
-         */
-        work_available.raise();
+        if (size.load(std::memory_order_acquire) == 0)
+            return false;
+
+        std::lock_guard lock{mutex};
+        if (queue.empty())
+            return false;
+
+        work = std::move(queue.front());
+        queue.pop_front();
+        size.store(queue.size(), std::memory_order_release);
+        return true;
     }
 
-    static void work_loop(Worker* me, std::promise<std::atomic<bool>*>&& shutdown_channel)
-    {
-        mir::set_thread_name("Mir/Workqueue");
+private:
+    std::mutex mutex;
+    std::deque<Work> queue;
+    std::atomic<size_t> size{0};
+};
 
-        std::atomic<bool> shutdown{false};
-        shutdown_channel.set_value(&shutdown);
+class ThreadPool;
+struct Threads;
 
-        while (!shutdown)
-        {
-            me->work_available.wait();
-            auto work = std::move(me->work);
-            me->work = [](){};
-            work();
-        }
+struct Worker
+{
+    explicit Worker(Threads const& owner)
+        : owner{owner}
+    {
     }
 
-    std::function<void()> work;
-    /**
-     * Pointer to an atomic<bool> on the thread's stack (in work_loop).
-     *
-     * Being on the thread's stack means that the thread is allowed to outlive the Worker
-     * (as long as the thread does not access anything from the Worker), but also means that
-     * after setting *shutdown to true it is no longer safe to access.
-     */
-    std::atomic<bool>* shutdown;
-    mir::Signal work_available;
+    Threads const& owner;
+    WorkQueue queue;
     std::thread thread;
 };
 
+struct ExtraThread
+{
+    std::thread thread;
+    bool finished{false};
+};
+
+/**
+ * The threads started by one ThreadPool::ensure_started_locked(), until the matching stop_threads()
+ *
+ * Every thread holds a reference, so that a thread that stops the pool from its own work (and
+ * so can only be detached, not joined) can still safely finish with its Worker, and the others
+ * it steals from, after the pool has moved on.
+ */
+struct Threads
+{
+    std::atomic<bool> stopping{false};
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::thread monitor;
+    std::list<ExtraThread> extra_threads;   ///< Protected by the ThreadPool's mutex
+};
+
+/// The worker (if any) that the current thread is running as
+thread_local Worker* current_worker = nullptr;
+
+/// Work (normal or blocking) this thread is running, so waiting for idle from within work doesn't wait for itself
+thread_local int running_on_this_thread = 0;
+thread_local int blocking_on_this_thread = 0;
+
 /**
- * A self-managing ThreadPool
+ * A work-stealing ThreadPool
  *
  * Theory of operation:
- * The ThreadPool executes each item of work on an independent thread; each call to spawn() is
- * guaranteed to be on a different thread to the caller.
+ * The ThreadPool has a fixed number of Worker threads (one per CPU core, but at least
+ * min_threadpool_threads), created on first use. Each Worker has its own queue.
  *
- * To reduce the overhead of spawning threads, the ThreadPool attempts to maintain
- * min_threadpool_threads of free worker threads.
+ * Work spawned from a Worker is pushed to that Worker's queue, so the common case of work
+ * spawning more work does not contend on a shared lock. Work spawned from any other thread,
+ * and all high priority work, goes to shared queues.
  *
- * The ThreadPool maintains two linked-lists of Worker threads; a list of all Workers, and a list of
- * (Worker, position-in-all-workers-list) containing idle Worker threads.
+ * A Worker looks for work, in order, in the high priority queue, its own queue, the shared
+ * queue, and finally by stealing from other Workers' queues. Queues are FIFO throughout, so
+ * work that keeps respawning itself can not starve older work. If no work is found the Worker
+ * sleeps until spawn() signals that there is more.
  *
- * When a work item is received through spawn() the ThreadPool first checks to see if there's a
- * free Worker thread in the idle list; if so, it takes it off the free list and dispatches the work.
- * If there are no free Workers, it creates a new Worker, adds it to the all-workers list, and dispatches
- * the work to the new Worker.
+ * Work is allowed to block, which the old one-thread-per-item pool permitted; to guarantee
+ * queued work still makes progress a monitor thread polls, while there is queued work, for
+ * every thread being busy and none finishing any work for starvation_threshold. When that happens
+ * it starts an extra thread, which behaves as a Worker without a queue of its own, and exits once it has
+ * been idle for extra_thread_idle_timeout.
  *
- * When a Worker finishes an item of work, it calls recycle(). If there are fewer than
- * min_threadpool_threads in the free list, the Worker is added to the free list. Otherwise, the
- * Worker is removed from the all-workers list and is destroyed.
+ * Work known to block for a long time should use spawn_blocking(), which runs it on a thread
+ * of its own without involving the Workers at all.
  */
 class ThreadPool : public mir::NonBlockingExecutor
 {
@@ -168,98 +175,367 @@ public:
     ~ThreadPool() noexcept
     {
         wait_for_idle();
+        stop_threads();
     }
 
     void quiesce()
     {
         wait_for_idle();
-        std::lock_guard lock{workers_mutex};
-        free_workers.clear();
-        workers.clear();
-        num_workers_free = 0;
+        stop_threads();
+    }
+
+    void spawn(Work&& work) override
+    {
+        spawn(std::move(work), mir::ThreadPoolExecutor::Priority::normal);
     }
 
-    void spawn(std::function<void()>&& work)
+    void spawn(Work&& work, mir::ThreadPoolExecutor::Priority priority)
     {
-        WorkerHandle worker;
+        auto const was_idle = pending.fetch_add(1, std::memory_order_acq_rel) == 0;
+        if (priority == mir::ThreadPoolExecutor::Priority::high)
         {
-            std::lock_guard lock{workers_mutex};
-            if (num_workers_free > 0)
-            {
-                worker = free_workers.front();
-                free_workers.pop_front();
-                num_workers_free--;
-            }
-            else
-            {
-                worker.worker = std::make_shared<Worker>();
-                worker.pos = workers.insert(workers.cend(), worker.worker);
-            }
+            urgent_queue.push(std::move(work));
         }
-        worker.worker->set_work(
-            [this, worker, work = std::move(work)]() mutable
+        else if (current_worker && !current_worker->owner.stopping.load(std::memory_order_acquire))
+        {
+            current_worker->queue.push(std::move(work));
+        }
+        else
+        {
+            shared_queue.push(std::move(work));
+        }
+
+        std::lock_guard lock{mutex};
+        ensure_started_locked();
+        if (sleeping > 0)
+        {
+            work_available.notify_one();
+        }
+        if (was_idle)
+        {
+            // Let the monitor start watching for the work being stuck behind blocked threads
+            monitor_wakeup.notify_one();
+        }
+    }
+
+    void spawn_blocking(Work&& work)
+    {
+        std::lock_guard lock{mutex};
+        ensure_started_locked();
+        reap_finished_threads_locked(*threads);
+        ++blocking;
+        start_extra_thread_locked(
+            threads,
+            [this, work = std::move(work)](std::shared_ptr<Threads> const&) mutable
             {
-                try
-                {
-                    work();
-                }
-                catch (...)
-                {
-                    (*exception_handler)();
-                }
-                recycle(std::move(worker));
+                ++blocking_on_this_thread;
+                run(work);
+                work = nullptr;
+                --blocking_on_this_thread;
+
+                std::lock_guard lock{mutex};
+                --blocking;
+                state_changed.notify_all();
             });
     }
+
 private:
-    struct WorkerHandle
+    void ensure_started_locked()
     {
-        std::list<std::shared_ptr<Worker>>::const_iterator pos;
-        std::shared_ptr<Worker> worker;
-    };
+        if (threads)
+            return;
 
-    void wait_for_idle()
+        threads = std::make_shared<Threads>();
+
+        auto const worker_count = std::max<unsigned>(min_threadpool_threads, std::thread::hardware_concurrency());
+        threads->workers.reserve(worker_count);
+        for (auto i = 0u; i != worker_count; ++i)
+        {
+            threads->workers.push_back(std::make_unique<Worker>(*threads));
+        }
+        for (auto& worker : threads->workers)
+        {
+            worker->thread = std::thread{[this, owner = threads, worker = worker.get()] { worker_loop(*owner, worker); }};
+        }
+        threads->monitor = std::thread{[this, owner = threads] { monitor_loop(owner); }};
+    }
+
+    /// Take the next piece of work; on behalf of self, or of an extra thread if self is null
+    auto try_take_work(Threads const& owner, Worker* self, Work& work) -> bool
+    {
+        auto const& workers = owner.workers;
+
+        if (urgent_queue.try_pop(work))
+            return true;
+
+        if (self && self->queue.try_pop(work))
+            return true;
+
+        if (shared_queue.try_pop(work))
+            return true;
+
+        // Steal, starting just after ourself so thieves spread across the victims
+        auto const count = workers.size();
+        auto const start = self ? static_cast<size_t>(self - workers.front().get()) : 0;
+        for (auto i = 1u; i <= count; ++i)
+        {
+            auto& victim = *workers[(start + i) % count];
+            if (&victim != self && victim.queue.try_pop(work))
+                return true;
+        }
+
+        return false;
+    }
+
+    void execute(Work& work)
     {
-        std::unique_lock lock{workers_mutex};
-        // We need to wait for any active workers to finish.
-        bool idle = workers.size() == free_workers.size();
-        while (!idle)
+        // Count the work as running before it stops being pending, so it's never seen as neither
+        running.fetch_add(1, std::memory_order_acq_rel);
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        ++running_on_this_thread;
+        run(work);
+        work = nullptr;
+        --running_on_this_thread;
+        completed.fetch_add(1, std::memory_order_release);
+
+        /* A waiter may be waiting from within work of its own, so it's not only the last work
+         * finishing that can make us idle. Only those waiters need us to take the lock, though.
+         */
+        running.fetch_sub(1);
+        if (idle_waiters.load() > 0 && pending.load(std::memory_order_acquire) == 0)
         {
-            workers_changed.wait(lock);
+            std::lock_guard lock{mutex};
+            state_changed.notify_all();
+        }
+    }
 
-            /* When a worker finishes it either adds itself to the free_workers list
-             * or removes itself from the workers list.
-             *
-             * This means that we're idle once all the workers are free_workers
-             * - that is, the free_workers list is the same size as workers.
-             */
-            idle = workers.size() == free_workers.size();
+    void worker_loop(Threads const& owner, Worker* self)
+    {
+        mir::set_thread_name("Mir/Workqueue");
+        mir::apply_thread_policy(mir::ThreadRole::workqueue);
+        current_worker = self;
+
+        Work work;
+        while (!owner.stopping.load(std::memory_order_acquire))
+        {
+            if (try_take_work(owner, self, work))
+            {
+                execute(work);
+                continue;
+            }
+
+            std::unique_lock lock{mutex};
+            if (owner.stopping)
+                break;
+
+            if (pending.load(std::memory_order_acquire) > 0)
+                continue;
+
+            ++sleeping;
+            work_available.wait(lock);
+            --sleeping;
+        }
+
+        current_worker = nullptr;
+    }
+
+    void extra_thread_loop(Threads const& owner)
+    {
+        // Only here: the work spawn_blocking() runs applies whatever policy suits it
+        mir::apply_thread_policy(mir::ThreadRole::workqueue);
+
+        Work work;
+        while (!owner.stopping.load(std::memory_order_acquire))
+        {
+            if (try_take_work(owner, nullptr, work))
+            {
+                execute(work);
+                continue;
+            }
+
+            std::unique_lock lock{mutex};
+            if (owner.stopping)
+                break;
+
+            if (pending.load(std::memory_order_acquire) > 0)
+                continue;
+
+            ++sleeping;
+            auto const status = work_available.wait_for(lock, extra_thread_idle_timeout);
+            --sleeping;
+
+            if (status == std::cv_status::timeout && pending.load(std::memory_order_acquire) == 0)
+                break;
+        }
+    }
+
+    void monitor_loop(std::shared_ptr<Threads> const& owner)
+    {
+        mir::set_thread_name("Mir/Workmon");
+
+        auto const stopping = [&owner] { return owner->stopping.load(std::memory_order_acquire); };
+
+        std::unique_lock lock{mutex};
+        while (!stopping())
+        {
+            // Nothing can be stuck while nothing is queued
+            monitor_wakeup.wait(lock, [&] { return stopping() || pending.load(std::memory_order_acquire) > 0; });
+            if (stopping())
+                break;
+
+            auto const completed_before = completed.load(std::memory_order_acquire);
+            monitor_wakeup.wait_for(lock, starvation_threshold, stopping);
+
+            auto const starving =
+                sleeping == 0 &&
+                pending.load(std::memory_order_acquire) > 0 &&
+                completed.load(std::memory_order_acquire) == completed_before;
+
+            if (!stopping() && starving)
+            {
+                reap_finished_threads_locked(*owner);
+                start_extra_thread_locked(
+                    owner,
+                    [this](std::shared_ptr<Threads> const& owner) { extra_thread_loop(*owner); });
+            }
         }
     }
 
-    void recycle(WorkerHandle&& worker)
+    void start_extra_thread_locked(
+        std::shared_ptr<Threads> const& owner,
+        std::function<void(std::shared_ptr<Threads> const&)>&& body)
     {
+        auto& extra_threads = owner->extra_threads;
+        extra_threads.emplace_back();
+        auto const self = std::prev(extra_threads.end());
+        self->thread = std::thread{
+            [this, owner, self, body = std::move(body)]
+            {
+                mir::set_thread_name("Mir/Workqueue");
+                body(owner);
+
+                // owner keeps *self alive, even if the pool was stopped from this thread
+                std::lock_guard lock{mutex};
+                self->finished = true;
+            }};
+    }
+
+    void reap_finished_threads_locked(Threads& owner)
+    {
+        auto& extra_threads = owner.extra_threads;
+        for (auto i = extra_threads.begin(); i != extra_threads.end();)
         {
-            std::lock_guard lock{workers_mutex};
-            if (num_workers_free < min_threadpool_threads)
+            if (i->finished)
             {
-                // If we're below our free-thread minimum, recycle this thread back into the pool…
-                free_workers.emplace_front(std::move(worker));
-                num_workers_free++;
+                i->thread.join();
+                i = extra_threads.erase(i);
             }
             else
             {
-                // …otherwise, let it die.
-                workers.erase(worker.pos);
+                ++i;
             }
         }
-        workers_changed.notify_all();
     }
 
-    std::mutex workers_mutex;
-    std::condition_variable workers_changed;
-    int num_workers_free{0};
-    std::list<WorkerHandle> free_workers;
-    std::list<std::shared_ptr<Worker>> workers;
+    void wait_for_idle()
+    {
+        // If we're called from work, that work can't finish until we return
+        auto const running_here = running_on_this_thread;
+        auto const blocking_here = blocking_on_this_thread;
+
+        ++idle_waiters;
+        {
+            std::unique_lock lock{mutex};
+            state_changed.wait(
+                lock,
+                [&]
+                {
+                    return pending.load(std::memory_order_acquire) == 0 &&
+                           running.load() == running_here &&
+                           blocking == blocking_here;
+                });
+        }
+        --idle_waiters;
+    }
+
+    void stop_threads()
+    {
+        std::shared_ptr<Threads> stopped;
+        {
+            std::lock_guard lock{mutex};
+            if (!threads)
+                return;
+
+            /* From here on, spawn() starts a fresh set of threads; nothing but the threads
+             * we're stopping touches these any more (and they only remove themselves).
+             */
+            stopped = std::move(threads);
+            stopped->stopping = true;
+            work_available.notify_all();
+            monitor_wakeup.notify_all();
+        }
+
+        auto const join = [](std::thread& thread)
+            {
+                if (thread.get_id() == std::this_thread::get_id())
+                {
+                    /* We're being stopped from one of our own threads (e.g. quiesce() called
+                     * from work). That thread holds its own reference to the Threads it belongs
+                     * to, so everything it touches once we return stays valid until it exits.
+                     */
+                    thread.detach();
+                }
+                else
+                {
+                    thread.join();
+                }
+            };
+
+        for (auto& worker : stopped->workers)
+            join(worker->thread);
+        join(stopped->monitor);
+
+        // The monitor has stopped, so no more extra threads will be added
+        std::list<ExtraThread> extra_threads;
+        {
+            std::lock_guard lock{mutex};
+            extra_threads.splice(extra_threads.end(), stopped->extra_threads);
+        }
+        for (auto& extra : extra_threads)
+            join(extra.thread);
+        {
+            // Any detached extra thread marks itself finished in a list that's still alive
+            std::lock_guard lock{mutex};
+            stopped->extra_threads.splice(stopped->extra_threads.end(), extra_threads);
+        }
+
+        // Work spawned onto a Worker's own queue after we last waited for idle must not be lost
+        Work work;
+        for (auto& worker : stopped->workers)
+        {
+            while (worker->queue.try_pop(work))
+            {
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+                spawn(std::move(work));
+            }
+        }
+    }
+
+    WorkQueue urgent_queue;
+    WorkQueue shared_queue;
+
+    std::atomic<int> pending{0};            ///< Work queued but not yet running
+    std::atomic<int> running{0};            ///< Work running on a Worker or extra thread
+    std::atomic<int> idle_waiters{0};       ///< Threads in wait_for_idle()
+    std::atomic<unsigned long> completed{0};
+
+    std::mutex mutex;   // Protects the following...
+    std::condition_variable work_available;
+    std::condition_variable monitor_wakeup;
+    std::condition_variable state_changed;
+    int sleeping{0};
+    int blocking{0};
+    std::shared_ptr<Threads> threads;      ///< Those currently running; null while stopped
 };
 
 ThreadPool thread_pool;
@@ -273,6 +549,16 @@ void mir::ThreadPoolExecutor::spawn(std::function<void()>&& work)
     thread_pool.spawn(std::move(work));
 }
 
+void mir::ThreadPoolExecutor::spawn_with_priority(std::function<void()>&& work, Priority priority)
+{
+    thread_pool.spawn(std::move(work), priority);
+}
+
+void mir::ThreadPoolExecutor::spawn_blocking(std::function<void()>&& work)
+{
+    thread_pool.spawn_blocking(std::move(work));
+}
+
 void mir::ThreadPoolExecutor::set_unhandled_exception_handler(void (*handler)())
 {
     exception_handler = handler;
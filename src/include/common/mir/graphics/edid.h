@@ -36,6 +36,12 @@ struct Edid
     size_t get_manufacturer(Manufacturer str) const;
     uint16_t product_code() const;
 
+    /**
+     * Vertical refresh range from the monitor range limits descriptor.
+     * \returns false if the EDID carries no range limits
+     */
+    bool get_vertical_refresh_range(int& min_hz, int& max_hz) const;
+
 private:
     /* Pretty much every field in an EDID requires some kind of conversion
        and reinterpretation. So keep those details private... */
@@ -47,6 +53,8 @@ private:
         string_monitor_name = 0xfc,
     };
 
+    enum { range_limits_descriptor = 0xfd };
+
     size_t get_string(StringDescriptorType type, char str[14]) const;
 
     union Descriptor
@@ -0,0 +1,72 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_KEYMAP_CACHE_H_
+#define MIR_INPUT_KEYMAP_CACHE_H_
+
+#include "mir/fd.h"
+
+#include <cstddef>
+#include <memory>
+
+struct xkb_keymap;
+
+namespace mir
+{
+namespace input
+{
+class Keymap;
+
+/// A keymap compiled once for the whole process.
+///
+/// Everything that needs an xkb_keymap or a wl_keyboard keymap fd for a given
+/// Keymap shares one of these, so a keymap is compiled and serialized once no
+/// matter how many devices and clients use it.
+class CompiledKeymap
+{
+public:
+    CompiledKeymap(std::shared_ptr<Keymap> keymap, std::shared_ptr<xkb_keymap> compiled, Fd fd, size_t size);
+
+    auto keymap() const -> std::shared_ptr<Keymap> const& { return keymap_; }
+
+    /// The compiled keymap. It is immutable, but libxkbcommon's reference
+    /// count is not atomic, so states created from it must be created and
+    /// destroyed under the caller's own lock (as XKBMapper already does).
+    auto xkb_keymap() const -> std::shared_ptr<::xkb_keymap> const& { return compiled; }
+
+    /// A sealed, read-only fd holding the keymap as XKB_KEYMAP_FORMAT_TEXT_V1.
+    /// It is safe to hand the same fd to every client.
+    auto fd() const -> Fd const& { return fd_; }
+
+    /// Size of the keymap text in fd(), including the null terminator
+    auto size() const -> size_t { return size_; }
+
+private:
+    std::shared_ptr<Keymap> const keymap_;
+    std::shared_ptr<::xkb_keymap> const compiled;
+    Fd const fd_;
+    size_t const size_;
+};
+
+/// Returns the cached compilation of any keymap that matches() keymap,
+/// compiling it if nothing alive matches.
+///
+/// Entries are dropped once the last user of a compiled keymap lets go of it.
+auto compile_keymap(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<CompiledKeymap const>;
+}
+}
+
+#endif // MIR_INPUT_KEYMAP_CACHE_H_
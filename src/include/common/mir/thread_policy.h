@@ -0,0 +1,74 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_THREAD_POLICY_H_
+#define MIR_THREAD_POLICY_H_
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+/// The threads whose scheduling can be configured
+enum class ThreadRole
+{
+    compositor,
+    input,
+    page_flip,      ///< eglstream-kms only: gbm-kms dispatches flip events on compositor threads
+    workqueue
+};
+
+/// How the threads of a role are scheduled
+struct ThreadPolicy
+{
+    enum class Scheduler
+    {
+        normal,
+        fifo,
+        round_robin
+    };
+
+    Scheduler scheduler{Scheduler::normal};
+    int priority{0};            ///< Real-time priority (1-99) for fifo and round_robin
+    std::optional<int> nice;    ///< Nice value; only used with normal scheduling
+    std::vector<int> cpus;      ///< CPUs the threads may run on; empty for any
+};
+
+/**
+ * Parse a policy of the form "[<scheduler>:<value>][@<cpus>]"
+ *
+ * \param [in] spec <scheduler> is "fifo" or "rr" followed by a priority, or
+ *                  "nice" followed by a nice value. <cpus> is a list such as
+ *                  "0-3,6". For example "fifo:10@2-3" or "nice:-5".
+ * \throws std::invalid_argument if spec is malformed
+ */
+auto parse_thread_policy(std::string const& spec) -> ThreadPolicy;
+
+/// Set the policy for threads of role that start from now on
+void set_thread_policy(ThreadRole role, ThreadPolicy const& policy);
+
+/**
+ * Apply the policy for role to the calling thread
+ *
+ * Failures (typically a missing CAP_SYS_NICE or RLIMIT_RTPRIO) are logged
+ * once per role and otherwise ignored: the thread keeps running with the
+ * default scheduling.
+ */
+void apply_thread_policy(ThreadRole role);
+}
+
+#endif /* MIR_THREAD_POLICY_H_ */
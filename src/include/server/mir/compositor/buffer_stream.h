@@ -46,6 +46,14 @@ public:
     virtual auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
 
+    /**
+     * Whether the stream is on screen
+     *
+     * The textures of a stream that isn't visible may be released to save memory.
+     * Streams start out visible.
+     */
+    virtual void set_visible(bool visible) = 0;
+
     class Submission
     {
     public:
@@ -19,6 +19,11 @@
 
 namespace mir
 {
+namespace graphics
+{
+class Display;
+class DisplayConfiguration;
+}
 namespace compositor
 {
 
@@ -30,6 +35,22 @@ public:
     virtual void start() = 0;
     virtual void stop() = 0;
 
+    /**
+     * Apply a new configuration to the display
+     *
+     * Compositing on outputs that the new configuration does not affect should carry on
+     * uninterrupted.
+     */
+    virtual void configure_display(graphics::Display& display, graphics::DisplayConfiguration const& conf) = 0;
+
+    /**
+     * Recomposite every output
+     *
+     * For changes that affect what is drawn but don't come from the scene, such as an
+     * output's scale or orientation.
+     */
+    virtual void schedule_compositing() = 0;
+
 protected:
     Compositor() = default;
     Compositor(Compositor const&) = delete;
@@ -28,11 +28,24 @@ class CompositorReport
 {
 public:
     typedef const void* SubCompositorId;  // e.g. thread/display buffer ID
+
+    /// The phases of producing a frame that are timed individually
+    enum class FrameStage
+    {
+        scene_snapshot,     ///< Collecting the scene elements for an output
+        occlusion,          ///< Filtering out occluded scene elements
+        render,             ///< Rendering the renderables (including texture upload)
+        commit,             ///< Handing the rendered frame to the display sink
+        wait_for_flip,      ///< Posting the sync group and waiting for the flip
+    };
+
     virtual void added_display(int width, int height, int x, int y, SubCompositorId id) = 0;
     virtual void began_frame(SubCompositorId id) = 0;
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    virtual void began_stage(SubCompositorId id, FrameStage stage) = 0;
+    virtual void finished_stage(SubCompositorId id, FrameStage stage) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
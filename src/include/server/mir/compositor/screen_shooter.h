@@ -26,6 +26,10 @@
 
 namespace mir
 {
+namespace graphics
+{
+class Buffer;
+}
 namespace renderer
 {
 namespace software
@@ -49,6 +53,21 @@ public:
         mir::geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
 
+    /// As above, but \p buffer already holds an earlier capture of \p area and only \p damage (which is in the
+    /// same coordinates as \p area) needs to be brought up to date.
+    virtual void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        mir::geometry::Rectangle const& area,
+        mir::geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
+
+    /// Captures into a buffer the GPU can write directly (such as a client's dmabuf), without the image passing
+    /// through CPU memory. The callback is as for capture().
+    virtual void capture_to_gpu_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        mir::geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
+
 private:
     ScreenShooter(ScreenShooter const&) = delete;
     ScreenShooter& operator=(ScreenShooter const&) = delete;
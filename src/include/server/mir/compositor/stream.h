@@ -46,12 +46,20 @@ public:
         std::function<void(geometry::Size const&)> const& callback) override;
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> override;
     bool has_submitted_buffer() const override;
+    void set_visible(bool visible) override;
 private:
     std::shared_ptr<MultiMonitorArbiter> const arbiter;
 
     std::atomic<bool> first_frame_posted;
 
     Synchronised<std::function<void(geometry::Size const&)>> frame_callback;
+
+    struct Visibility
+    {
+        bool visible{true};
+        std::weak_ptr<graphics::Buffer> latest;
+    };
+    Synchronised<Visibility> visibility;
 };
 }
 }
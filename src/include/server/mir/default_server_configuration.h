@@ -47,6 +47,8 @@ class Scene;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class CaptureQueue;
+class OutputMirroring;
 }
 namespace frontend
 {
@@ -240,6 +242,8 @@ public:
      *  @{ */
     virtual std::shared_ptr<graphics::GraphicBufferAllocator> the_buffer_allocator();
     virtual std::shared_ptr<compositor::Scene>                  the_scene();
+    virtual std::shared_ptr<compositor::CaptureQueue>           the_capture_queue();
+    virtual std::shared_ptr<compositor::OutputMirroring>        the_output_mirroring();
     /** @} */
 
     /** @name frontend configuration - dependencies
@@ -399,6 +403,8 @@ protected:
     CachedPtr<compositor::Compositor> compositor;
     CachedPtr<compositor::CompositorReport> compositor_report;
     CachedPtr<compositor::ScreenShooter> screen_shooter;
+    CachedPtr<compositor::CaptureQueue> capture_queue;
+    CachedPtr<compositor::OutputMirroring> output_mirroring;
     CachedPtr<logging::Logger> logger;
     CachedPtr<graphics::DisplayReport> display_report;
     CachedPtr<time::Clock> clock;
@@ -21,6 +21,7 @@
 #include <functional>
 
 #include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
 
 namespace mir
 {
@@ -58,6 +59,10 @@ public:
     // TODO: How can something like SurfaceObserver be adapted to work with non surface renderables?
     virtual void emit_scene_changed() = 0;
 
+    // Trigger recomposition of only the outputs overlapping damage, for input visualizations
+    // that have changed in a known area (e.g. a moving software cursor).
+    virtual void emit_scene_damaged(geometry::Rectangle const& damage) = 0;
+
     /// Returns if the screen is currently locked
     virtual auto screen_is_locked() const -> bool = 0;
 
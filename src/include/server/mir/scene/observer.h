@@ -17,6 +17,8 @@
 #ifndef MIR_SCENE_OBSERVER_H_
 #define MIR_SCENE_OBSERVER_H_
 
+#include "mir/geometry/rectangle.h"
+
 #include <memory>
 #include <set>
 
@@ -49,6 +51,10 @@ public:
     /// and will require full recomposition.
     virtual void scene_changed() = 0;
 
+    /// Something that is not a surface (e.g. an input visualization) has changed
+    /// within the given area. Only outputs overlapping it need recomposition.
+    virtual void scene_damaged(geometry::Rectangle const& damage) = 0;
+
     /// Called at observer registration to notify of already existing surfaces.
     virtual void surface_exists(std::shared_ptr<Surface> const& surface) = 0;
 
@@ -47,6 +47,7 @@ public:
     void surfaces_reordered(SurfaceSet const& affected_surfaces) override;
     
     void scene_changed() override;
+    void scene_damaged(geometry::Rectangle const& damage) override;
 
     void surface_exists(std::shared_ptr<Surface> const& surface) override;
     void end_observation() override;
@@ -18,12 +18,16 @@
 #ifndef MIR_SCENE_SCENE_REPORT_H_
 #define MIR_SCENE_SCENE_REPORT_H_
 
+#include <cstddef>
 #include <memory>
+#include <string>
 
 namespace mir
 {
 namespace scene
 {
+class Session;
+
 class SceneReport
 {
 public:
@@ -34,6 +38,20 @@ public:
     virtual void surface_removed(BasicSurfaceId id, std::string const& name) = 0;
     virtual void surface_deleted(BasicSurfaceId id, std::string const& name) = 0;
 
+    /// Graphics memory attributed to a session, in bytes
+    struct SessionMemory
+    {
+        std::size_t shm{0};
+        std::size_t dmabuf{0};
+        std::size_t texture{0};
+
+        auto total() const -> std::size_t { return shm + dmabuf + texture; }
+    };
+
+    virtual void session_memory_changed(Session const& session, SessionMemory const& usage) = 0;
+    /// \p session holds more than \p limit bytes of graphics memory
+    virtual void session_memory_limit_exceeded(Session const& session, SessionMemory const& usage, std::size_t limit) = 0;
+
 protected:
     SceneReport() = default;
     virtual ~SceneReport() = default;
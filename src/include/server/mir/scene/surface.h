@@ -154,6 +154,12 @@ public:
     virtual auto focus_mode() const -> MirFocusMode = 0;
     virtual void set_focus_mode(MirFocusMode focus_mode) = 0;
     ///@}
+
+    /// Whether the client prefers its content presented as soon as possible, even if that tears
+    ///@{
+    virtual auto tearing_allowed() const -> bool = 0;
+    virtual void set_tearing_allowed(bool allowed) = 0;
+    ///@}
 };
 }
 }
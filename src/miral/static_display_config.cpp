@@ -63,6 +63,7 @@ char const* const mode = "mode";
 char const* const orientation = "orientation";
 char const* const scale = "scale";
 char const* const group = "group";
+char const* const vrr = "vrr";
 char const* const orientation_value[] = { "normal", "left", "inverted", "right" };
 char const* const layout_suffix = "-layout";
 
@@ -257,6 +258,11 @@ try
                         output_config.scale = s.as<float>();
                     }
 
+                    if (auto const v = port_config[vrr])
+                    {
+                        output_config.vrr = v.as<bool>();
+                    }
+
                     for (auto const& key : custom_output_attributes)
                     {
                         if (auto const value = port_config[key])
@@ -404,6 +410,12 @@ void miral::YamlFileDisplayConfig::serialize_output_configuration(
                    "\n        scale: " << conf_output.scale
                 << "\n        group: " << conf_output.logical_group_id.as_value()
                 << "\t# Outputs with the same non-zero value are treated as a single display";
+
+            if (conf_output.vrr_capable)
+            {
+                out << "\n        vrr: " << (conf_output.vrr_enabled ? "true" : "false")
+                    << "\t# Let fullscreen clients drive the refresh rate, defaults to false";
+            }
         }
 
         for (auto const& [key, value] : conf_output.custom_attribute)
@@ -500,6 +512,8 @@ void miral::YamlFileDisplayConfig::apply_to_output(mg::UserDisplayConfigurationO
         {
             conf_output.logical_group_id = mg::DisplayConfigurationLogicalGroupId{};
         }
+
+        conf_output.vrr_enabled = conf.vrr.is_set() && conf.vrr.value();
     }
     else
     {
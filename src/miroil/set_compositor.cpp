@@ -22,6 +22,7 @@
 #include <mir/server.h>
 #include <mir/shell/shell.h>
 #include <mir/compositor/compositor.h>
+#include <mir/graphics/display.h>
 
 namespace miroil {
 
@@ -32,6 +33,8 @@ struct SetCompositor::CompositorImpl : public mir::compositor::Compositor
     auto get_wrapped() -> std::shared_ptr<miroil::Compositor>;    
     void start();
     void stop();
+    void configure_display(mir::graphics::Display& display, mir::graphics::DisplayConfiguration const& conf);
+    void schedule_compositing();
     
     std::shared_ptr<miroil::Compositor> custom_compositor;
 };
@@ -58,6 +61,30 @@ void SetCompositor::CompositorImpl::stop()
     return custom_compositor->stop();
 }
 
+// The wrapped compositor can't reconfigure piecemeal, so take the long way round
+void SetCompositor::CompositorImpl::configure_display(
+    mir::graphics::Display& display,
+    mir::graphics::DisplayConfiguration const& conf)
+{
+    custom_compositor->stop();
+    try
+    {
+        display.configure(conf);
+    }
+    catch (...)
+    {
+        custom_compositor->start();
+        throw;
+    }
+    custom_compositor->start();
+}
+
+void SetCompositor::CompositorImpl::schedule_compositing()
+{
+    custom_compositor->stop();
+    custom_compositor->start();
+}
+
 SetCompositor::SetCompositor(ConstructorFunction constr, InitFunction init)
     : constructor_function(constr), init_function(init)
 {
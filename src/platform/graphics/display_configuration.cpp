@@ -131,6 +131,8 @@ std::ostream& mg::operator<<(std::ostream& out, mg::DisplayConfigurationOutput c
     out << std::endl;
 
     out << "\torientation: " << val.orientation << '\n';
+    out << "\tvariable refresh: " << (val.vrr_enabled ? "enabled" : "disabled")
+        << (val.vrr_capable ? "" : " (unsupported)") << '\n';
     out << "}" << std::endl;
 
     return out;
@@ -186,7 +188,9 @@ bool mg::operator==(mg::DisplayConfigurationOutput const& val1,
                (val1.modes.size() == val2.modes.size()) &&
                (val1.custom_logical_size == val2.custom_logical_size) &&
                (val1.scale == val2.scale) &&
-               (val1.form_factor == val2.form_factor)};
+               (val1.form_factor == val2.form_factor) &&
+               (val1.vrr_capable == val2.vrr_capable) &&
+               (val1.vrr_enabled == val2.vrr_enabled)};
 
     for (auto i = begin(val1.modes), j = begin(val2.modes); i != end(val1.modes) && equal; ++i, ++j)
     {
@@ -324,7 +328,9 @@ mg::UserDisplayConfigurationOutput::UserDisplayConfigurationOutput(
         edid(*reinterpret_cast<std::vector<uint8_t const>*>(&main.edid)),
         custom_logical_size(main.custom_logical_size),
         name(main.name),
-        custom_attribute{main.custom_attribute}
+        custom_attribute{main.custom_attribute},
+        vrr_capable(main.vrr_capable),
+        vrr_enabled(main.vrr_enabled)
 {
 }
 
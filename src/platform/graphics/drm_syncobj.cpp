@@ -0,0 +1,139 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/drm_syncobj.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <system_error>
+#include <sys/eventfd.h>
+#include <xf86drm.h>
+
+namespace mg = mir::graphics;
+
+namespace
+{
+auto import_timeline(mir::Fd const& drm_fd, mir::Fd const& timeline) -> uint32_t
+{
+    uint32_t handle;
+    if (drmSyncobjFDToHandle(drm_fd, timeline, &handle))
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{
+            errno,
+            std::system_category(),
+            "Failed to import DRM syncobj timeline"}));
+    }
+    return handle;
+}
+}
+
+mg::drm::Syncobj::Syncobj(mir::Fd drm_fd, mir::Fd const& timeline)
+    : drm_fd{std::move(drm_fd)},
+      handle{import_timeline(this->drm_fd, timeline)}
+{
+}
+
+mg::drm::Syncobj::~Syncobj()
+{
+    drmSyncobjDestroy(drm_fd, handle);
+}
+
+auto mg::drm::Syncobj::supported(mir::Fd const& drm_fd) -> bool
+{
+    uint64_t timeline_supported = 0;
+    if (drmGetCap(drm_fd, DRM_CAP_SYNCOBJ_TIMELINE, &timeline_supported) || !timeline_supported)
+    {
+        return false;
+    }
+
+#ifdef MIR_HAVE_DRM_SYNCOBJ_EVENTFD
+    // Timelines predate the eventfd ioctl (Linux 6.6), and without it the only way to wait is to block
+    uint32_t probe;
+    if (drmSyncobjCreate(drm_fd, 0, &probe))
+    {
+        return false;
+    }
+    mir::Fd const notify{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+    auto const result = drmSyncobjEventfd(drm_fd, probe, 1, notify, 0);
+    drmSyncobjDestroy(drm_fd, probe);
+
+    return result == 0;
+#else
+    return false;
+#endif
+}
+
+auto mg::drm::Syncobj::signalled_eventfd(uint64_t point) const -> mir::Fd
+{
+    mir::Fd notify{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+    if (notify == mir::Fd::invalid)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create eventfd"}));
+    }
+
+#ifdef MIR_HAVE_DRM_SYNCOBJ_EVENTFD
+    if (drmSyncobjEventfd(drm_fd, handle, point, notify, 0))
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{
+            errno,
+            std::system_category(),
+            "Failed to wait on DRM syncobj timeline point"}));
+    }
+#else
+    (void)point;
+    BOOST_THROW_EXCEPTION((std::system_error{
+        ENOSYS,
+        std::system_category(),
+        "libdrm is too old to wait on DRM syncobj timeline points"}));
+#endif
+
+    return notify;
+}
+
+void mg::drm::Syncobj::signal(uint64_t point) const
+{
+    if (drmSyncobjTimelineSignal(drm_fd, &handle, &point, 1))
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{
+            errno,
+            std::system_category(),
+            "Failed to signal DRM syncobj timeline point"}));
+    }
+}
+
+void mg::drm::Syncobj::signal_after(uint64_t point, mir::Fd const& sync_file) const
+{
+    // A sync_file can only be imported into a binary syncobj, so go via a temporary one
+    uint32_t binary;
+    if (drmSyncobjCreate(drm_fd, 0, &binary))
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create DRM syncobj"}));
+    }
+
+    auto const result =
+        drmSyncobjImportSyncFile(drm_fd, binary, sync_file) ||
+        drmSyncobjTransfer(drm_fd, handle, point, binary, 0, 0);
+    auto const error = errno;
+    drmSyncobjDestroy(drm_fd, binary);
+
+    if (result)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{
+            error,
+            std::system_category(),
+            "Failed to attach fence to DRM syncobj timeline point"}));
+    }
+}
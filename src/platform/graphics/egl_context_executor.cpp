@@ -39,36 +39,47 @@ mgc::EGLContextExecutor::~EGLContextExecutor() noexcept
 void mgc::EGLContextExecutor::spawn(
     std::function<void()>&& functor)
 {
+    // Only the first work item queued since the EGL thread last emptied the queue needs to wake it
+    if (work_queue.push(std::move(functor)))
     {
-        std::lock_guard lock{mutex};
-        work_queue.emplace_back(std::move(functor));
+        {
+            std::lock_guard lock{mutex};
+            wakeup_pending = true;
+        }
+        new_work.notify_one();
     }
-    new_work.notify_one();
 }
 
 void mgc::EGLContextExecutor::process_loop(mgc::EGLContextExecutor* const me)
 {
     me->ctx->make_current();
 
+    mir::InlineTask work;
+    auto run_queued_work = [&]()
+        {
+            while (me->work_queue.try_pop(work))
+            {
+                work();
+                // Ensure any functor cleanup happens with the EGL context current, too.
+                work.reset();
+            }
+        };
+
     std::unique_lock lock{me->mutex};
     while (!me->shutdown_requested)
     {
-        for (auto& work : me->work_queue)
-        {
-            work();
-        }
-        me->work_queue.clear();
+        me->wakeup_pending = false;
+        lock.unlock();
+
+        run_queued_work();
 
-        me->new_work.wait(lock);
+        lock.lock();
+        me->new_work.wait(lock, [me]() { return me->wakeup_pending || me->shutdown_requested; });
     }
+    lock.unlock();
 
     // Drain the work-queue
-    for (auto& work : me->work_queue)
-    {
-        work();
-    }
-    // …and ensure any functor cleanup happens with the EGL context current, too.
-    me->work_queue.clear();
+    run_queued_work();
 
     me->ctx->release_current();
 }
@@ -253,3 +253,82 @@ auto mg::EGLExtensions::MESADmaBufExport::extension_if_supported(EGLDisplay dpy)
     }
 }
 
+mg::EGLExtensions::ANDROIDNativeFenceSync::ANDROIDNativeFenceSync(EGLDisplay dpy)
+    : eglCreateSyncKHR{
+          reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+              eglGetProcAddress("eglCreateSyncKHR"))},
+      eglDestroySyncKHR{
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+              eglGetProcAddress("eglDestroySyncKHR"))},
+      eglDupNativeFenceFDANDROID{
+          reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(
+              eglGetProcAddress("eglDupNativeFenceFDANDROID"))}
+    {
+        if (!strstr(eglQueryString(dpy, EGL_EXTENSIONS), "EGL_ANDROID_native_fence_sync"))
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"Missing required EGL_ANDROID_native_fence_sync extension"}));
+        }
+        if (!eglCreateSyncKHR || !eglDestroySyncKHR || !eglDupNativeFenceFDANDROID)
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation doesn't provide native fence sync functions"}));
+        }
+    }
+
+auto mg::EGLExtensions::ANDROIDNativeFenceSync::extension_if_supported(EGLDisplay dpy)
+    -> std::optional<ANDROIDNativeFenceSync>
+{
+    try
+    {
+        return ANDROIDNativeFenceSync{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return std::nullopt;
+    }
+}
+
+
+namespace
+{
+auto swap_buffers_with_damage_proc(EGLDisplay dpy) -> PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions)
+    {
+        return nullptr;
+    }
+    if (strstr(egl_extensions, "EGL_KHR_swap_buffers_with_damage"))
+    {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+    if (strstr(egl_extensions, "EGL_EXT_swap_buffers_with_damage"))
+    {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEEXTPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+    return nullptr;
+}
+}
+
+mg::EGLExtensions::SwapBuffersWithDamage::SwapBuffersWithDamage(EGLDisplay dpy)
+    : eglSwapBuffersWithDamage{swap_buffers_with_damage_proc(dpy)}
+{
+    if (!eglSwapBuffersWithDamage)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation doesn't support swapping buffers with damage"}));
+    }
+}
+
+auto mg::EGLExtensions::SwapBuffersWithDamage::extension_if_supported(EGLDisplay dpy)
+    -> std::optional<SwapBuffersWithDamage>
+{
+    try
+    {
+        return SwapBuffersWithDamage{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return std::nullopt;
+    }
+}
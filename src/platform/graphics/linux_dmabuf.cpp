@@ -29,6 +29,7 @@
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/buffer_basic.h"
 #include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_syncobj.h"
 #include "mir/graphics/egl_context_executor.h"
 
 #include <EGL/egl.h>
@@ -40,12 +41,16 @@
 #include "mir/log.h"
 
 #include <mutex>
+#include <atomic>
+#include <map>
 #include <vector>
 #include <optional>
 #include <utility>
 #include <algorithm>
 #include <drm_fourcc.h>
 #include <wayland-server.h>
+#include <linux/sync_file.h>
+#include <sys/ioctl.h>
 
 namespace mg = mir::graphics;
 namespace mgc = mg::common;
@@ -871,11 +876,14 @@ public:
         mg::EGLExtensions const& extensions,
         mg::DMABufBuffer const& dma_buf,
         BufferGLDescription const& descriptor,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
-        : tex{get_tex_id()},
+        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        std::optional<mg::EGLExtensions::ANDROIDNativeFenceSync> const& fence_ext = std::nullopt)
+        : dpy{dpy},
+          tex{get_tex_id()},
           desc{descriptor},
           layout_{dma_buf.layout()},
-          egl_delegate{std::move(egl_delegate)}
+          egl_delegate{std::move(egl_delegate)},
+          fence_ext{fence_ext}
     {
         eglBindAPI(EGL_OPENGL_ES_API);
 
@@ -905,6 +913,10 @@ public:
 
     ~DMABufTex() override
     {
+        for (auto const& [_, sync] : fences)
+        {
+            fence_ext->eglDestroySyncKHR(dpy, sync);
+        }
         egl_delegate->spawn(
             [tex = tex]()
             {
@@ -936,17 +948,90 @@ public:
 
     void add_syncpoint() override
     {
+        if (!fence_ext || !track_fences)
+        {
+            return;
+        }
+
+        auto const sync = fence_ext->eglCreateSyncKHR(dpy, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+        if (sync == EGL_NO_SYNC_KHR)
+        {
+            return;
+        }
+
+        // Only the most recent use in each context matters; GL commands in a context complete in order
+        std::lock_guard lock{fence_mutex};
+        auto& slot = fences[eglGetCurrentContext()];
+        if (slot != EGL_NO_SYNC_KHR)
+        {
+            fence_ext->eglDestroySyncKHR(dpy, slot);
+        }
+        slot = sync;
+    }
+
+    /// Start recording fences for each use of this texture; see release_fence()
+    void track_release_fences()
+    {
+        track_fences = true;
+    }
+
+    /**
+     * A sync_file that signals once every recorded use of this texture has completed
+     *
+     * \return The merged fence, or std::nullopt if there were no uses to wait on
+     *          (or the fences could not be exported) and the caller should treat
+     *          the texture as already idle.
+     */
+    auto release_fence() -> std::optional<mir::Fd>
+    {
+        std::lock_guard lock{fence_mutex};
+
+        std::optional<mir::Fd> merged;
+        for (auto const& [_, sync] : fences)
+        {
+            auto const raw_fd = fence_ext->eglDupNativeFenceFDANDROID(dpy, sync);
+            if (raw_fd == EGL_NO_NATIVE_FENCE_FD_ANDROID)
+            {
+                // The fence was never flushed to the kernel; we can't wait for it
+                return std::nullopt;
+            }
+            mir::Fd fence{raw_fd};
+
+            if (!merged)
+            {
+                merged = std::move(fence);
+                continue;
+            }
+
+            sync_merge_data data{};
+            strncpy(data.name, "mir-release", sizeof(data.name) - 1);
+            data.fd2 = fence;
+            if (ioctl(*merged, SYNC_IOC_MERGE, &data) < 0)
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to merge release fences"}));
+            }
+            merged = mir::Fd{static_cast<int>(data.fence)};
+        }
+        return merged;
     }
 private:
+    EGLDisplay const dpy;
     GLuint const tex;
     BufferGLDescription const& desc;
     Layout const layout_;
     std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+
+    std::optional<mg::EGLExtensions::ANDROIDNativeFenceSync> const fence_ext;
+    std::atomic<bool> track_fences{false};
+    std::mutex fence_mutex;
+    std::map<EGLContext, EGLSyncKHR> fences;
 };
 
 class DmabufTexBuffer :
     public mg::BufferBasic,
-    public mg::DMABufBuffer
+    public mg::DMABufBuffer,
+    public mg::ExplicitSyncBuffer,
+    public mg::ConsumableBuffer
 {
 public:
     // Note: Must be called with a current EGL context
@@ -957,10 +1042,11 @@ public:
         BufferGLDescription const& descriptor,
         std::shared_ptr<mg::DMABufEGLProvider> provider,
         std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        std::optional<mg::EGLExtensions::ANDROIDNativeFenceSync> const& fence_ext,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release)
         : dpy{dpy},
-          tex{dpy, extensions, dma_buf, descriptor, std::move(egl_delegate)},
+          tex{dpy, extensions, dma_buf, descriptor, std::move(egl_delegate), fence_ext},
           provider_{std::move(provider)},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
@@ -974,9 +1060,18 @@ public:
 
     ~DmabufTexBuffer() override
     {
+        signal_release_point();
         on_release();
     }
 
+    void set_release_point(std::shared_ptr<mg::drm::Syncobj const> timeline, uint64_t point) override
+    {
+        std::lock_guard lock{release_mutex};
+        release_timeline = std::move(timeline);
+        release_point = point;
+        tex.track_release_fences();
+    }
+
     auto on_same_egl_display(EGLDisplay dpy) -> bool
     {
         return this->dpy == dpy;
@@ -1015,11 +1110,16 @@ public:
          * texture from this buffer; it's a good indication that the buffer
          * has been consumed.
          */
+        notify_consumed();
+
+        return &tex;
+    }
+
+    void notify_consumed() override
+    {
         std::lock_guard lock{consumed_mutex};
         on_consumed();
         on_consumed = [](){};
-
-        return &tex;
     }
 
     auto format() const -> mg::DRMFormat override
@@ -1047,11 +1147,49 @@ public:
         return provider_;
     }
 private:
+    void signal_release_point() noexcept
+    {
+        std::lock_guard lock{release_mutex};
+        if (!release_timeline)
+        {
+            return;
+        }
+
+        try
+        {
+            if (auto const fence = tex.release_fence())
+            {
+                // Let the kernel signal the point when the GPU is done, rather than waiting here
+                release_timeline->signal_after(release_point, *fence);
+            }
+            else
+            {
+                release_timeline->signal(release_point);
+            }
+        }
+        catch (std::exception const& err)
+        {
+            mir::log_warning("Failed to signal buffer release point: %s", err.what());
+            try
+            {
+                // Signalling early is better than leaving the client waiting forever
+                release_timeline->signal(release_point);
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
     EGLDisplay const dpy;
     DMABufTex tex;
 
     std::shared_ptr<mg::DMABufEGLProvider> const provider_;
 
+    std::mutex release_mutex;
+    std::shared_ptr<mg::drm::Syncobj const> release_timeline;
+    uint64_t release_point{0};
+
     std::mutex consumed_mutex;
     std::function<void()> on_consumed;
     std::function<void()> const on_release;
@@ -1140,6 +1278,7 @@ mg::DMABufEGLProvider::DMABufEGLProvider(
     : dpy{dpy},
       egl_extensions{std::move(egl_extensions)},
       dmabuf_export_ext{mg::EGLExtensions::MESADmaBufExport::extension_if_supported(dpy)},
+      fence_ext{mg::EGLExtensions::ANDROIDNativeFenceSync::extension_if_supported(dpy)},
       formats{std::make_unique<DmaBufFormatDescriptors>(dpy, dmabuf_ext)},
       egl_delegate{std::move(egl_delegate)},
       allocate_importable_image{std::move(allocate_importable_image)},
@@ -1171,6 +1310,7 @@ auto mg::DMABufEGLProvider::import_dma_buf(
         *descriptor,
         shared_from_this(),
         egl_delegate,
+        fence_ext,
         std::move(on_consumed),
         std::move(on_release));
 }
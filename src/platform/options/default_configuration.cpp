@@ -26,6 +26,7 @@ namespace mo = mir::options;
 char const* const mo::arw_server_socket_opt       = "arw-file";
 char const* const mo::enable_input_opt            = "enable-input,i";
 char const* const mo::compositor_report_opt       = "compositor-report";
+char const* const mo::compositor_metrics_file_opt = "compositor-metrics-file";
 char const* const mo::display_report_opt          = "display-report";
 char const* const mo::scene_report_opt            = "scene-report";
 char const* const mo::input_report_opt            = "input-report";
@@ -37,6 +38,7 @@ char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
+char const* const mo::renderer_opt                = "renderer";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
 char const* const mo::x11_display_opt             = "enable-x11";
 char const* const mo::x11_scale_opt               = "x11-scale";
@@ -44,6 +46,14 @@ char const* const mo::wayland_extensions_opt      = "wayland-extensions";
 char const* const mo::add_wayland_extensions_opt  = "add-wayland-extensions";
 char const* const mo::drop_wayland_extensions_opt = "drop-wayland-extensions";
 char const* const mo::idle_timeout_opt            = "idle-timeout";
+char const* const mo::compositor_thread_policy_opt = "compositor-thread-policy";
+char const* const mo::input_thread_policy_opt     = "input-thread-policy";
+char const* const mo::page_flip_thread_policy_opt = "page-flip-thread-policy";
+char const* const mo::workqueue_thread_policy_opt = "workqueue-thread-policy";
+char const* const mo::client_memory_soft_limit_opt = "client-memory-soft-limit";
+char const* const mo::client_memory_hard_limit_opt = "client-memory-hard-limit";
+char const* const mo::texture_memory_budget_opt = "texture-memory-budget";
+char const* const mo::shm_udmabuf_opt = "shm-udmabuf";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
@@ -152,6 +162,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "Compositor reporting [{log,lttng,off}]")
+        (compositor_metrics_file_opt, po::value<std::string>(),
+            "File to periodically write per-output frame timing histograms to, as JSON "
+            "[requires --compositor-report=log]")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the Display report. [{log,lttng,off}]")
         (input_report_opt, po::value<std::string>()->default_value(off_opt_value),
@@ -169,6 +182,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "frames from clients before compositing). Higher values result in "
             "lower latency but risk causing frame skipping. "
             "Default: A negative value means decide automatically.")
+        (renderer_opt, po::value<std::string>()->default_value("gl"),
+            "Renderer to use for compositing [{gl,software}]. The software renderer "
+            "is also used when no rendering platform supports GL.")
         (touchspots_opt,
             "Display visualization of touchspots (e.g. for screencasting).")
         (cursor_opt,
@@ -179,6 +195,31 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Time (in seconds) Mir will remain idle before turning off the display, "
             "or 0 to keep display on forever.")
+        (compositor_thread_policy_opt, po::value<std::string>(),
+            "Scheduling for compositor threads, as [{fifo,rr,nice}:<value>][@<cpus>] "
+            "(e.g. \"fifo:10@2-3\"). Real-time scheduling needs CAP_SYS_NICE or RLIMIT_RTPRIO.")
+        (input_thread_policy_opt, po::value<std::string>(),
+            "Scheduling for the input thread [see --compositor-thread-policy]")
+        (page_flip_thread_policy_opt, po::value<std::string>(),
+            "Scheduling for page-flip event threads [see --compositor-thread-policy]. "
+            "Only the eglstream-kms platform has these; gbm-kms handles page-flip events "
+            "on the compositor threads waiting for them.")
+        (workqueue_thread_policy_opt, po::value<std::string>(),
+            "Scheduling for workqueue threads [see --compositor-thread-policy]")
+        (client_memory_soft_limit_opt, po::value<int>()->default_value(0),
+            "Graphics memory (in MiB) a client may hold before it is reported and the textures of its "
+            "hidden or occluded SHM buffers are released, or 0 for no limit. "
+            "Counts mapped SHM pools, imported dmabufs and the textures SHM buffers are uploaded to.")
+        (client_memory_hard_limit_opt, po::value<int>()->default_value(0),
+            "Graphics memory (in MiB) a client may hold before it is disconnected, or 0 for no limit "
+            "[see --client-memory-soft-limit]")
+        (texture_memory_budget_opt, po::value<int>()->default_value(0),
+            "Memory (in MiB) for the textures client SHM buffers are uploaded to, or 0 for no limit. "
+            "Textures of hidden or occluded surfaces are released to stay within it, "
+            "and uploaded again when next drawn. A budget also shrinks under kernel memory pressure.")
+        (shm_udmabuf_opt, po::value<bool>()->default_value(false),
+            "Share client SHM buffers backed by sealed memfds with the GPU through /dev/udmabuf, "
+            "rather than copying them into textures. Other SHM buffers are still copied.")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
@@ -0,0 +1,258 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define MIR_LOG_COMPONENT "drm-events"
+
+#include "drm_event_source.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+namespace mgk = mir::graphics::kms;
+
+namespace
+{
+auto create_epoll() -> mir::Fd
+{
+    mir::Fd fd{epoll_create1(EPOLL_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create epoll instance"}));
+    }
+    return fd;
+}
+
+auto create_eventfd() -> mir::Fd
+{
+    mir::Fd fd{eventfd(0, EFD_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create eventfd"}));
+    }
+    return fd;
+}
+
+void add_to_epoll(int epoll_fd, int fd, uint32_t events)
+{
+    epoll_event event;
+    ::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event))
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to add fd to epoll"}));
+    }
+}
+}
+
+mgk::DRMEventSource::DRMEventSource(mir::Fd drm_fd)
+    : drm_fd{std::move(drm_fd)},
+      epoll_fd{create_epoll()},
+      interrupt_fd{create_eventfd()}
+{
+    add_to_epoll(epoll_fd, interrupt_fd, EPOLLIN);
+    // The DRM fd starts disarmed; expect_flip() arms it when there's something to wait for
+    add_to_epoll(epoll_fd, this->drm_fd, 0);
+}
+
+mgk::DRMEventSource::~DRMEventSource() = default;
+
+auto mgk::DRMEventSource::event_data() const -> void*
+{
+    return const_cast<DRMEventSource*>(this);
+}
+
+void mgk::DRMEventSource::expect_flip(uint32_t crtc_id, FlipHandler handler)
+{
+    std::unique_lock lock{mutex};
+
+    if (device_lost)
+    {
+        // There will never be an event, so there's no point making the caller wait for one
+        lock.unlock();
+        handler(std::nullopt);
+        return;
+    }
+
+    if (!pending.try_emplace(crtc_id, std::move(handler)).second)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already expected"));
+    }
+
+    if (pending.size() == 1)
+    {
+        watch_drm_fd(true);
+    }
+}
+
+auto mgk::DRMEventSource::cancel_flip(uint32_t crtc_id) -> bool
+{
+    std::lock_guard lock{mutex};
+
+    auto const cancelled = pending.erase(crtc_id) > 0;
+    if (cancelled && pending.empty())
+    {
+        watch_drm_fd(false);
+    }
+    return cancelled;
+}
+
+/* This method should be called with the 'mutex' locked */
+void mgk::DRMEventSource::watch_drm_fd(bool watch)
+{
+    if (device_lost)
+    {
+        return;
+    }
+
+    epoll_event event;
+    ::memset(&event, 0, sizeof(event));
+    event.events = watch ? uint32_t{EPOLLIN} : 0u;
+    event.data.fd = drm_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, drm_fd, &event))
+    {
+        log_warning("Failed to %s DRM fd: %s", watch ? "watch" : "unwatch", strerror(errno));
+    }
+}
+
+void mgk::DRMEventSource::fail_pending_flips()
+{
+    decltype(pending) failed;
+    {
+        std::lock_guard lock{mutex};
+        failed.swap(pending);
+        watch_drm_fd(false);
+    }
+
+    for (auto const& [crtc_id, handler] : failed)
+    {
+        handler(std::nullopt);
+    }
+}
+
+void mgk::DRMEventSource::interrupt()
+{
+    uint64_t const wake{1};
+    if (::write(interrupt_fd, &wake, sizeof(wake)) != sizeof(wake))
+    {
+        log_error("Failed to interrupt DRM event dispatch: %s", strerror(errno));
+    }
+}
+
+auto mgk::DRMEventSource::dispatch() -> bool
+{
+    drmEventContext ctx;
+    ::memset(&ctx, 0, sizeof(ctx));
+    ctx.version = 3;
+    ctx.page_flip_handler2 = &flip_handler;
+
+    epoll_event events[2];
+    int count;
+    do
+    {
+        count = epoll_wait(epoll_fd, events, 2, -1);
+    }
+    while (count < 0 && errno == EINTR);
+
+    if (count < 0)
+    {
+        log_error("Error waiting for DRM events: %s", strerror(errno));
+        {
+            std::lock_guard lock{mutex};
+            device_lost = true;
+        }
+        fail_pending_flips();
+        return false;
+    }
+
+    for (auto i = 0; i != count; ++i)
+    {
+        if (events[i].data.fd == interrupt_fd)
+        {
+            // Left unread, so that every later dispatch() returns straight away too
+            return false;
+        }
+    }
+
+    for (auto i = 0; i != count; ++i)
+    {
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+        {
+            log_error("DRM device hung up; abandoning pending page flips");
+            {
+                std::lock_guard lock{mutex};
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, drm_fd, nullptr);
+                device_lost = true;
+            }
+            fail_pending_flips();
+        }
+        else if (events[i].events & EPOLLIN)
+        {
+            if (drmHandleEvent(drm_fd, &ctx) < 0 && errno != EINTR && errno != EAGAIN)
+            {
+                log_error("Failed to read DRM events: %s", strerror(errno));
+                fail_pending_flips();
+            }
+            else
+            {
+                std::lock_guard lock{mutex};
+                if (pending.empty())
+                {
+                    watch_drm_fd(false);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void mgk::DRMEventSource::flip_handler(
+    int /*drm_fd*/,
+    unsigned int sequence,
+    unsigned int sec,
+    unsigned int usec,
+    unsigned int crtc_id,
+    void* data) noexcept
+{
+    auto const self = static_cast<DRMEventSource*>(data);
+
+    FlipHandler handler;
+    {
+        std::lock_guard lock{self->mutex};
+        auto const expected = self->pending.find(crtc_id);
+        if (expected == self->pending.end())
+        {
+            // Cancelled, or not one of ours
+            return;
+        }
+        handler = std::move(expected->second);
+        self->pending.erase(expected);
+    }
+
+    handler(FlipEvent{sequence, std::chrono::seconds{sec} + std::chrono::microseconds{usec}});
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_GRAPHICS_COMMON_KMS_UTILS_DRM_EVENT_SOURCE_H_
+#define MIR_GRAPHICS_COMMON_KMS_UTILS_DRM_EVENT_SOURCE_H_
+
+#include "mir/fd.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mir
+{
+namespace graphics
+{
+namespace kms
+{
+/**
+ * Dispatches page-flip completions for a DRM device
+ *
+ * Events are read by whichever thread calls dispatch(), so a thread waiting for
+ * a flip can read it itself rather than being woken by another thread that did.
+ * A completion is delivered straight to the handler registered for its CRTC, so
+ * waiters on other CRTCs are never woken by it. The DRM fd is only watched while
+ * at least one flip is outstanding.
+ */
+class DRMEventSource
+{
+public:
+    struct FlipEvent
+    {
+        uint32_t sequence;                      ///< vblank sequence number of the flip
+        std::chrono::nanoseconds timestamp;     ///< vblank timestamp, in the clock reported by DRM_CAP_TIMESTAMP_MONOTONIC
+    };
+
+    /**
+     * Called on the dispatching thread when the flip completes
+     *
+     * The argument is empty if the flip will never complete because the
+     * device has failed.
+     */
+    using FlipHandler = std::function<void(std::optional<FlipEvent> const&)>;
+
+    explicit DRMEventSource(mir::Fd drm_fd);
+    ~DRMEventSource();
+
+    DRMEventSource(DRMEventSource const&) = delete;
+    DRMEventSource& operator=(DRMEventSource const&) = delete;
+
+    /// The user data to pass to drmModePageFlip() or an atomic commit
+    auto event_data() const -> void*;
+
+    /**
+     * Register the handler for the next flip event on crtc_id
+     *
+     * This must be called before the flip is submitted, so that the event
+     * cannot arrive before its handler.
+     *
+     * \throws std::logic_error if a flip is already expected on crtc_id
+     */
+    void expect_flip(uint32_t crtc_id, FlipHandler handler);
+
+    /**
+     * Forget the flip expected on crtc_id, without calling its handler
+     *
+     * \returns true if a flip was expected (and has not already completed)
+     */
+    auto cancel_flip(uint32_t crtc_id) -> bool;
+
+    /**
+     * Wait for DRM events and call the handlers of any flips they complete
+     *
+     * Only one thread may dispatch at a time.
+     *
+     * \returns false, without waiting, once interrupt() has been called, or
+     *          if waiting for events has failed (and pending flips with it)
+     */
+    auto dispatch() -> bool;
+
+    /// Make dispatch() return false, now and in future
+    void interrupt();
+
+private:
+    void fail_pending_flips();
+    void watch_drm_fd(bool watch);
+
+    static void flip_handler(
+        int drm_fd,
+        unsigned int sequence,
+        unsigned int sec,
+        unsigned int usec,
+        unsigned int crtc_id,
+        void* data) noexcept;
+
+    mir::Fd const drm_fd;
+    mir::Fd const epoll_fd;
+    mir::Fd const interrupt_fd;
+
+    std::mutex mutex;
+    std::unordered_map<uint32_t, FlipHandler> pending;
+    bool device_lost{false};
+};
+}
+}
+}
+
+#endif //MIR_GRAPHICS_COMMON_KMS_UTILS_DRM_EVENT_SOURCE_H_
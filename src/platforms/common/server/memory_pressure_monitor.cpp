@@ -0,0 +1,142 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define MIR_LOG_COMPONENT "memory-pressure"
+
+#include "memory_pressure_monitor.h"
+#include "mir/log.h"
+#include "mir/thread_name.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace mgc = mir::graphics::common;
+
+namespace
+{
+/* A stall of 150ms in any 2s window. Unprivileged processes may only
+ * create triggers with a window that is a multiple of 2s.
+ */
+char const trigger[] = "some 150000 2000000";
+
+auto create_trigger() -> mir::Fd
+{
+    mir::Fd fd{open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to open /proc/pressure/memory"}));
+    }
+    // The terminating NUL is part of the trigger
+    if (write(fd, trigger, sizeof(trigger)) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create memory pressure trigger"}));
+    }
+    return fd;
+}
+
+auto create_eventfd() -> mir::Fd
+{
+    mir::Fd fd{eventfd(0, EFD_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create eventfd"}));
+    }
+    return fd;
+}
+}
+
+mgc::MemoryPressureMonitor::MemoryPressureMonitor(
+    std::function<void()> on_pressure,
+    std::function<void()> on_relief,
+    std::chrono::milliseconds relief_period)
+    : on_pressure{std::move(on_pressure)},
+      on_relief{std::move(on_relief)},
+      relief_period{relief_period},
+      trigger_fd{create_trigger()},
+      shutdown_fd{create_eventfd()}
+{
+    monitor_thread = std::thread{[this]() { monitor_loop(); }};
+}
+
+mgc::MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+    uint64_t const wake{1};
+    if (::write(shutdown_fd, &wake, sizeof(wake)) != sizeof(wake))
+    {
+        log_error("Failed to signal memory pressure thread to stop: %s", strerror(errno));
+    }
+    if (monitor_thread.joinable())
+    {
+        monitor_thread.join();
+    }
+}
+
+void mgc::MemoryPressureMonitor::monitor_loop() noexcept
+{
+    mir::set_thread_name("Mir/Mem pressure");
+
+    bool under_pressure{false};
+
+    for (;;)
+    {
+        pollfd fds[2] = {
+            {trigger_fd, POLLPRI, 0},
+            {shutdown_fd, POLLIN, 0}};
+
+        // Only time out while waiting for the pressure to subside
+        auto const timeout = under_pressure ? static_cast<int>(relief_period.count()) : -1;
+        auto const count = poll(fds, 2, timeout);
+
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            log_error("Error waiting for memory pressure: %s", strerror(errno));
+            return;
+        }
+
+        if (fds[1].revents)
+        {
+            return;
+        }
+
+        if (count == 0)
+        {
+            under_pressure = false;
+            on_relief();
+        }
+        else if (fds[0].revents & POLLERR)
+        {
+            log_error("Memory pressure trigger failed; no longer watching for memory pressure");
+            return;
+        }
+        else if (fds[0].revents & POLLPRI)
+        {
+            under_pressure = true;
+            on_pressure();
+        }
+    }
+}
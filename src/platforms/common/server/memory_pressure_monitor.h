@@ -0,0 +1,71 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_GRAPHICS_COMMON_MEMORY_PRESSURE_MONITOR_H_
+#define MIR_GRAPHICS_COMMON_MEMORY_PRESSURE_MONITOR_H_
+
+#include "mir/fd.h"
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace mir
+{
+namespace graphics
+{
+namespace common
+{
+/**
+ * Watches for memory pressure using a Linux PSI trigger on /proc/pressure/memory
+ *
+ * on_pressure is called (on the monitor's thread) each time tasks have been
+ * stalled waiting for memory for too long within the trigger's window.
+ * on_relief is called once no pressure has been reported for relief_period.
+ */
+class MemoryPressureMonitor
+{
+public:
+    /**
+     * \throws std::system_error if the kernel does not support PSI triggers
+     */
+    MemoryPressureMonitor(
+        std::function<void()> on_pressure,
+        std::function<void()> on_relief,
+        std::chrono::milliseconds relief_period);
+    ~MemoryPressureMonitor();
+
+    MemoryPressureMonitor(MemoryPressureMonitor const&) = delete;
+    MemoryPressureMonitor& operator=(MemoryPressureMonitor const&) = delete;
+
+private:
+    void monitor_loop() noexcept;
+
+    std::function<void()> const on_pressure;
+    std::function<void()> const on_relief;
+    std::chrono::milliseconds const relief_period;
+
+    mir::Fd const trigger_fd;
+    mir::Fd const shutdown_fd;
+
+    std::thread monitor_thread;
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_COMMON_MEMORY_PRESSURE_MONITOR_H_ */
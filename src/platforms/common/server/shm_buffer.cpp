@@ -94,10 +94,12 @@ bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 mgc::ShmBuffer::ShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& format,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<TextureBudget> texture_budget)
     : size_{size},
       pixel_format_{format},
-      egl_delegate{std::move(egl_delegate)}
+      egl_delegate{std::move(egl_delegate)},
+      texture_budget{std::move(texture_budget)}
 {
 }
 
@@ -105,7 +107,7 @@ mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& pixel_format,
     std::shared_ptr<EGLContextExecutor> egl_delegate)
-    : ShmBuffer(size, pixel_format, std::move(egl_delegate)),
+    : ShmBuffer(size, pixel_format, std::move(egl_delegate), nullptr),
       stride_{MIR_BYTES_PER_PIXEL(pixel_format) * size.width.as_uint32_t()},
       pixels{new unsigned char[stride_.as_int() * size.height.as_int()]}
 {
@@ -113,6 +115,12 @@ mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
 
 mgc::ShmBuffer::~ShmBuffer() noexcept
 {
+    // Once forgotten the budget can't evict us, so there's no need to lock tex_id_mutex
+    if (texture_budget)
+    {
+        texture_budget->forget(*this);
+    }
+
     if (tex_id != 0)
     {
         egl_delegate->spawn(
@@ -184,34 +192,93 @@ mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 
 void mgc::ShmBuffer::bind()
 {
-    std::lock_guard lock{tex_id_mutex};
-    bool const needs_initialisation = tex_id == 0;
-    if (needs_initialisation)
     {
-        glGenTextures(1, &tex_id);
+        std::lock_guard lock{tex_id_mutex};
+        bool const needs_initialisation = tex_id == 0;
+        if (needs_initialisation)
+        {
+            glGenTextures(1, &tex_id);
+        }
+        glBindTexture(GL_TEXTURE_2D, tex_id);
+        if (needs_initialisation)
+        {
+            // The ShmBuffer *should* be immutable, so we only need to upload
+            // once (or again, if the texture has been evicted).
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            upload();
+            if (texture_resized)
+            {
+                texture_resized(texture_bytes());
+            }
+        }
+    }
+
+    // The budget may evict other buffers' textures, so don't hold our lock while it does
+    if (texture_budget)
+    {
+        texture_budget->drawn(*this, texture_bytes());
+    }
+}
+
+void mgc::ShmBuffer::set_visible(bool visible)
+{
+    if (visible_.exchange(visible) && !visible && texture_budget)
+    {
+        texture_budget->trim();
     }
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-    if (needs_initialisation)
+}
+
+void mgc::ShmBuffer::release_texture()
+{
+    // Going through the budget keeps its accounting right
+    if (texture_budget)
     {
-        // The ShmBuffer *should* be immutable, so we can just upload once.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        texture_budget->evict(*this);
     }
 }
 
-void mgc::MemoryBackedShmBuffer::bind()
+auto mgc::ShmBuffer::visible() const -> bool
+{
+    return visible_;
+}
+
+void mgc::ShmBuffer::on_texture_resized(std::function<void(std::size_t bytes)> on_texture_resized)
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
+    std::lock_guard lock{tex_id_mutex};
+    texture_resized = std::move(on_texture_resized);
+}
+
+void mgc::ShmBuffer::evict()
+{
+    std::lock_guard lock{tex_id_mutex};
+    if (tex_id != 0)
     {
-        upload_to_texture(pixels.get(), stride_);
-        uploaded = true;
+        egl_delegate->spawn(
+            [id = tex_id]()
+            {
+                glDeleteTextures(1, &id);
+            });
+        tex_id = 0;
+        if (texture_resized)
+        {
+            texture_resized(0);
+        }
     }
 }
 
+auto mgc::ShmBuffer::texture_bytes() const -> std::size_t
+{
+    return std::size_t{size_.width.as_uint32_t()} * size_.height.as_uint32_t() * MIR_BYTES_PER_PIXEL(pixel_format_);
+}
+
+void mgc::MemoryBackedShmBuffer::upload()
+{
+    upload_to_texture(pixels.get(), stride_);
+}
+
 template<typename T>
 class mgc::MemoryBackedShmBuffer::Mapping : public mir::renderer::software::Mapping<T>
 {
@@ -289,8 +356,9 @@ void mgc::ShmBuffer::add_syncpoint()
 
 mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
-    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate)),
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<TextureBudget> texture_budget)
+    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate), std::move(texture_budget)),
       data{std::move(data)}
 {
 }
@@ -310,16 +378,10 @@ auto mgc::MappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsi
     return data->map_rw();
 }
 
-void mgc::MappableBackedShmBuffer::bind()
+void mgc::MappableBackedShmBuffer::upload()
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        auto mapping = data->map_readable();
-        upload_to_texture(mapping->data(), mapping->stride());
-        uploaded = true;
-    }
+    auto mapping = data->map_readable();
+    upload_to_texture(mapping->data(), mapping->stride());
 }
 
 auto mgc::MappableBackedShmBuffer::format() const -> MirPixelFormat
@@ -340,9 +402,10 @@ auto mgc::MappableBackedShmBuffer::size() const -> geometry::Size
 mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<TextureBudget> texture_budget,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release)
-    :  MappableBackedShmBuffer(std::move(data), std::move(egl_delegate)),
+    :  MappableBackedShmBuffer(std::move(data), std::move(egl_delegate), std::move(texture_budget)),
        on_consumed{std::move(on_consumed)},
        on_release{std::move(on_release)}
 {
@@ -24,9 +24,12 @@
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/texture.h"
+#include "mir/graphics/uploaded_buffer.h"
+#include "texture_budget.h"
 
 #include <GLES2/gl2.h>
 
+#include <atomic>
 #include <mutex>
 
 namespace mir
@@ -42,7 +45,9 @@ class EGLContextExecutor;
 class ShmBuffer :
     public BufferBasic,
     public NativeBufferBase,
-    public graphics::gl::Texture
+    public graphics::gl::Texture,
+    public UploadedBuffer,
+    public TextureBudget::Texture
 {
 public:
     ~ShmBuffer() noexcept override;
@@ -57,22 +62,53 @@ public:
     gl::Program const& shader(gl::ProgramFactory& cache) const override;
     Layout layout() const override;
     void add_syncpoint() override;
+
+    void on_texture_resized(std::function<void(std::size_t bytes)> on_texture_resized) override;
+    void set_visible(bool visible) override;
+    void release_texture() override;
+
+    void evict() override;
+    auto visible() const -> bool override;
 protected:
+    /**
+     * \param [in] texture_budget  The budget to keep the texture within, or null if the texture
+     *                              must never be evicted
+     */
     ShmBuffer(
         geometry::Size const& size,
         MirPixelFormat const& format,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<TextureBudget> texture_budget);
+
+    /**
+     * Upload the buffer's content to the bound texture
+     *
+     * This is called from bind() whenever the texture has been (re)created.
+     * \note This is called with a current GL context
+     */
+    virtual void upload() = 0;
 
     /// \note This must be called with a current GL context
     void upload_to_texture(void const* pixels, geometry::Stride const& stride);
 private:
+    auto texture_bytes() const -> std::size_t;
+
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
     std::shared_ptr<EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<TextureBudget> const texture_budget;
     std::mutex tex_id_mutex;
     GLuint tex_id{0};
+    std::function<void(std::size_t bytes)> texture_resized;
+    std::atomic<bool> visible_{true};
 };
 
+/**
+ * A buffer allocated by the server for the CPU to draw into
+ *
+ * Its texture is never evicted: the GPU may draw into it too (mirrored outputs and
+ * screen captures render into the texture), and the CPU copy would then be stale.
+ */
 class MemoryBackedShmBuffer :
     public ShmBuffer,
     public renderer::software::RWMappableBuffer
@@ -88,14 +124,14 @@ public:
 
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override { return ShmBuffer::pixel_format(); }
     auto stride() const -> geometry::Stride override { return stride_; }
     auto size() const -> geometry::Size override { return ShmBuffer::size(); }
 
     MemoryBackedShmBuffer(MemoryBackedShmBuffer const&) = delete;
     MemoryBackedShmBuffer& operator=(MemoryBackedShmBuffer const&) = delete;
+protected:
+    void upload() override;
 private:
     template<typename T>
     class Mapping;
@@ -105,8 +141,6 @@ private:
 
     geometry::Stride const stride_;
     std::unique_ptr<unsigned char[]> const pixels;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class MappableBackedShmBuffer :
@@ -116,24 +150,23 @@ class MappableBackedShmBuffer :
 public:
     MappableBackedShmBuffer(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<TextureBudget> texture_budget);
 
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override;
     auto stride() const -> geometry::Stride override;
     auto size() const -> geometry::Size override;
 
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
+protected:
+    void upload() override;
 private:
     std::shared_ptr<renderer::software::RWMappableBuffer> const data;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class NotifyingMappableBackedShmBuffer : public MappableBackedShmBuffer
@@ -142,6 +175,7 @@ public:
     NotifyingMappableBackedShmBuffer(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+        std::shared_ptr<TextureBudget> texture_budget,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release);
 
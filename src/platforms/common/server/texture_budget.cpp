@@ -0,0 +1,199 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define MIR_LOG_COMPONENT "texture-budget"
+
+#include "texture_budget.h"
+#include "memory_pressure_monitor.h"
+#include "mir/log.h"
+#include "mir/options/configuration.h"
+#include "mir/options/option.h"
+
+#include <algorithm>
+#include <system_error>
+
+namespace mgc = mir::graphics::common;
+namespace mo = mir::options;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+auto limit_or_nothing(std::size_t limit) -> std::optional<std::size_t>
+{
+    if (limit)
+    {
+        return limit;
+    }
+    return std::nullopt;
+}
+}
+
+mgc::TextureBudget::TextureBudget(std::size_t limit)
+    : configured_limit{limit_or_nothing(limit)}
+{
+}
+
+mgc::TextureBudget::~TextureBudget() = default;
+
+void mgc::TextureBudget::drawn(Texture& texture, std::size_t bytes)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const resident = residents.find(&texture); resident != residents.end())
+    {
+        total_bytes = total_bytes - resident->second->bytes + bytes;
+        resident->second->bytes = bytes;
+        lru.splice(lru.begin(), lru, resident->second);
+        return;
+    }
+
+    lru.push_front(Resident{&texture, bytes});
+    residents[&texture] = lru.begin();
+    total_bytes += bytes;
+
+    evict_to_limit(&texture);
+}
+
+void mgc::TextureBudget::trim()
+{
+    std::lock_guard lock{mutex};
+    evict_to_limit(nullptr);
+}
+
+void mgc::TextureBudget::evict(Texture& texture)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const resident = residents.find(&texture); resident != residents.end() && !texture.visible())
+    {
+        texture.evict();
+        total_bytes -= resident->second->bytes;
+        lru.erase(resident->second);
+        residents.erase(resident);
+    }
+}
+
+void mgc::TextureBudget::forget(Texture& texture)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const resident = residents.find(&texture); resident != residents.end())
+    {
+        total_bytes -= resident->second->bytes;
+        lru.erase(resident->second);
+        residents.erase(resident);
+    }
+}
+
+void mgc::TextureBudget::apply_pressure()
+{
+    std::lock_guard lock{mutex};
+
+    auto const current = effective_limit().value_or(total_bytes);
+    pressure_limit = std::min(current, total_bytes) / 2;
+
+    auto const before = total_bytes;
+    evict_to_limit(nullptr);
+    log_info(
+        "Memory pressure: texture budget reduced to %zu KiB, released %zu KiB of textures",
+        *pressure_limit / 1024,
+        (before - total_bytes) / 1024);
+}
+
+void mgc::TextureBudget::relieve_pressure()
+{
+    std::lock_guard lock{mutex};
+
+    if (pressure_limit)
+    {
+        pressure_limit = std::nullopt;
+        log_info("Memory pressure relieved: texture budget restored");
+    }
+}
+
+void mgc::TextureBudget::monitor_memory_pressure()
+{
+    try
+    {
+        pressure_monitor = std::make_unique<MemoryPressureMonitor>(
+            [this]() { apply_pressure(); },
+            [this]() { relieve_pressure(); },
+            10s);
+    }
+    catch (std::system_error const& error)
+    {
+        log_info("Not shrinking texture budget under memory pressure: %s", error.what());
+    }
+}
+
+auto mgc::TextureBudget::resident_bytes() const -> std::size_t
+{
+    std::lock_guard lock{mutex};
+    return total_bytes;
+}
+
+auto mgc::TextureBudget::current_limit() const -> std::optional<std::size_t>
+{
+    std::lock_guard lock{mutex};
+    return effective_limit();
+}
+
+auto mgc::TextureBudget::effective_limit() const -> std::optional<std::size_t>
+{
+    if (configured_limit && pressure_limit)
+    {
+        return std::min(*configured_limit, *pressure_limit);
+    }
+    return configured_limit ? configured_limit : pressure_limit;
+}
+
+void mgc::TextureBudget::evict_to_limit(Texture const* about_to_draw)
+{
+    auto const limit = effective_limit();
+    if (!limit)
+    {
+        return;
+    }
+
+    // Least recently drawn first
+    for (auto victim = lru.end(); total_bytes > *limit && victim != lru.begin();)
+    {
+        --victim;
+        if (victim->texture == about_to_draw || victim->texture->visible())
+        {
+            continue;
+        }
+
+        victim->texture->evict();
+        total_bytes -= victim->bytes;
+        residents.erase(victim->texture);
+        victim = lru.erase(victim);
+    }
+}
+
+auto mgc::make_texture_budget(mo::Option const& options) -> std::shared_ptr<TextureBudget>
+{
+    auto const mebibytes = std::max(options.get(mo::texture_memory_budget_opt, 0), 0);
+
+    auto const budget = std::make_shared<TextureBudget>(std::size_t(mebibytes) << 20);
+    if (mebibytes)
+    {
+        budget->monitor_memory_pressure();
+    }
+    return budget;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_GRAPHICS_COMMON_TEXTURE_BUDGET_H_
+#define MIR_GRAPHICS_COMMON_TEXTURE_BUDGET_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mir
+{
+namespace options
+{
+class Option;
+}
+namespace graphics
+{
+namespace common
+{
+class MemoryPressureMonitor;
+
+/**
+ * Keeps the memory used by textures uploaded from CPU buffers within a budget
+ *
+ * When the textures resident exceed the budget, the least recently drawn of
+ * those that are not visible (those of hidden or occluded surfaces) are
+ * evicted. An evicted texture is uploaded again the next time it is drawn;
+ * evicting anything that is on screen would just mean uploading it again on
+ * the next frame.
+ *
+ * The budget is halved each time the kernel reports memory pressure, and
+ * restored once the pressure has gone.
+ */
+class TextureBudget
+{
+public:
+    class Texture
+    {
+    public:
+        /**
+         * Release the GL texture, so that it will be uploaded again when next drawn
+         *
+         * \note This is called with the budget locked, so must not call back into it
+         */
+        virtual void evict() = 0;
+
+        /// Whether the texture is on screen, and so must not be evicted
+        virtual auto visible() const -> bool = 0;
+
+    protected:
+        Texture() = default;
+        virtual ~Texture() = default;
+        Texture(Texture const&) = delete;
+        Texture& operator=(Texture const&) = delete;
+    };
+
+    /// \param [in] limit  The budget in bytes, or 0 for no limit
+    explicit TextureBudget(std::size_t limit);
+    ~TextureBudget();
+
+    TextureBudget(TextureBudget const&) = delete;
+    TextureBudget& operator=(TextureBudget const&) = delete;
+
+    /**
+     * Record that texture, occupying bytes, has just been drawn
+     *
+     * This may evict other textures to bring the total back within budget.
+     */
+    void drawn(Texture& texture, std::size_t bytes);
+
+    /**
+     * Evict what we can to bring the total back within budget
+     *
+     * Call this when a texture stops being visible, so that a budget that could
+     * not be met while it was is enforced without waiting for the next upload.
+     */
+    void trim();
+
+    /**
+     * Evict texture now, unless it is visible
+     *
+     * For reclaiming the memory of a particular client, whatever the budget.
+     */
+    void evict(Texture& texture);
+
+    /// Stop accounting for texture; this must be called before it is destroyed
+    void forget(Texture& texture);
+
+    /// Halve the budget (or the textures resident, if that's less) and evict what we can
+    void apply_pressure();
+
+    /// Restore the configured budget
+    void relieve_pressure();
+
+    /**
+     * Shrink the budget whenever the kernel reports memory pressure
+     *
+     * Does nothing (other than log) if the kernel doesn't support pressure notifications.
+     */
+    void monitor_memory_pressure();
+
+    auto resident_bytes() const -> std::size_t;
+
+    /// The current budget in bytes, or std::nullopt if there is no limit
+    auto current_limit() const -> std::optional<std::size_t>;
+
+private:
+    struct Resident
+    {
+        Texture* texture;
+        std::size_t bytes;
+    };
+
+    /* These must be called with mutex locked */
+    auto effective_limit() const -> std::optional<std::size_t>;
+    void evict_to_limit(Texture const* about_to_draw);
+
+    std::optional<std::size_t> const configured_limit;
+
+    std::mutex mutable mutex;
+    std::list<Resident> lru;                ///< Most recently drawn first
+    std::unordered_map<Texture*, std::list<Resident>::iterator> residents;
+    std::size_t total_bytes{0};
+    std::optional<std::size_t> pressure_limit;
+
+    // Declared last, so its thread is stopped before the rest of the budget is destroyed
+    std::unique_ptr<MemoryPressureMonitor> pressure_monitor;
+};
+
+/// The budget configured by options, shrinking under memory pressure if the kernel reports it (and there is a budget)
+auto make_texture_budget(options::Option const& options) -> std::shared_ptr<TextureBudget>;
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_COMMON_TEXTURE_BUDGET_H_ */
@@ -0,0 +1,230 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define MIR_LOG_COMPONENT "udmabuf-importer"
+
+#include "udmabuf_importer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+#include "mir/graphics/egl_error.h"
+#include "mir/graphics/linux_dmabuf.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/log.h"
+
+#include <fcntl.h>
+#include <linux/udmabuf.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <system_error>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+class UDMABuf : public mg::DMABufBuffer
+{
+public:
+    UDMABuf(mg::DRMFormat format, geom::Size size, PlaneDescriptor plane)
+        : format_{format},
+          size_{size},
+          planes_{std::move(plane)}
+    {
+    }
+
+    auto format() const -> mg::DRMFormat override
+    {
+        return format_;
+    }
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        // udmabufs are plain linear memory
+        return std::nullopt;
+    }
+    auto planes() const -> std::vector<PlaneDescriptor> const& override
+    {
+        return planes_;
+    }
+    auto layout() const -> mg::gl::Texture::Layout override
+    {
+        // As for any other SHM buffer, the first row is at the top
+        return mg::gl::Texture::Layout::GL;
+    }
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+private:
+    mg::DRMFormat const format_;
+    geom::Size const size_;
+    std::vector<PlaneDescriptor> const planes_;
+};
+
+auto create_udmabuf(mir::Fd const& device, mir::Fd const& memfd, size_t offset, size_t size) -> std::optional<mir::Fd>
+{
+    udmabuf_create request{};
+    request.memfd = static_cast<uint32_t>(static_cast<int>(memfd));
+    request.flags = UDMABUF_FLAGS_CLOEXEC;
+    request.offset = offset;
+    request.size = size;
+
+    mir::Fd udmabuf{ioctl(device, UDMABUF_CREATE, &request)};
+    if (udmabuf == mir::Fd::invalid)
+    {
+        mir::log_debug(
+            "Failed to create udmabuf for SHM buffer: %s",
+            std::system_category().message(errno).c_str());
+        return std::nullopt;
+    }
+    return udmabuf;
+}
+
+/// The EGL_EXT_image_dma_buf_import error for a format the GPU doesn't support, whatever the buffer
+auto is_unsupported_format(std::system_error const& error) -> bool
+{
+    return error.code() == std::error_code{EGL_BAD_MATCH, mg::egl_category()};
+}
+}
+
+mgc::UDMABufImporter::UDMABufImporter(CreateDMABuf create_dmabuf, ImportDMABuf import_dmabuf)
+    : create_dmabuf{std::move(create_dmabuf)},
+      import_dmabuf{std::move(import_dmabuf)}
+{
+}
+
+auto mgc::UDMABufImporter::import(
+    mrs::RWMappableBuffer const& data,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
+{
+    auto const memfd_backed = dynamic_cast<mrs::MemfdBackedBuffer const*>(&data);
+    if (!memfd_backed)
+    {
+        return nullptr;
+    }
+
+    auto const format = DRMFormat::from_mir_format(data.format());
+    auto const range = memfd_backed->memfd_range();
+    if (!range)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<DMABufBuffer const> dmabuf;
+    {
+        std::lock_guard lock{mutex};
+        if (failed_formats.contains(format))
+        {
+            return nullptr;
+        }
+
+        // Forget client buffers that have gone, so their pages aren't pinned any longer
+        std::erase_if(client_buffers, [](auto const& entry) { return entry.second.owner.expired(); });
+
+        auto const [entry, inserted] = client_buffers.try_emplace(
+            range->owner.get(),
+            ClientBuffer{range->owner, nullptr});
+        if (inserted)
+        {
+            // The kernel only accepts whole pages of the memfd
+            static size_t const page_size = sysconf(_SC_PAGESIZE);
+            auto const aligned_offset = range->offset - range->offset % page_size;
+            auto const aligned_end = (range->offset + range->len + page_size - 1) / page_size * page_size;
+
+            if (auto udmabuf = create_dmabuf(range->memfd, aligned_offset, aligned_end - aligned_offset))
+            {
+                entry->second.dmabuf = std::make_shared<UDMABuf>(
+                    format,
+                    data.size(),
+                    DMABufBuffer::PlaneDescriptor{
+                        std::move(*udmabuf),
+                        data.stride().as_uint32_t(),
+                        static_cast<uint32_t>(range->offset - aligned_offset)});
+            }
+        }
+        dmabuf = entry->second.dmabuf;
+    }
+
+    if (!dmabuf)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        return import_dmabuf(*dmabuf, std::move(on_consumed), std::move(on_release));
+    }
+    catch (std::exception const& error)
+    {
+        std::lock_guard lock{mutex};
+        if (auto const egl_error = dynamic_cast<std::system_error const*>(&error);
+            egl_error && is_unsupported_format(*egl_error))
+        {
+            // Don't keep trying (and failing) for every buffer of this format
+            mir::log_info(
+                "Copying %s SHM buffers: the GPU can't import them from udmabufs: %s",
+                format.name(), error.what());
+            failed_formats.insert(format);
+        }
+        else
+        {
+            // Something about this buffer (its stride, say) that the GPU can't handle; others may be fine
+            mir::log_debug("Copying SHM buffer: the GPU can't import its udmabuf: %s", error.what());
+            if (auto const entry = client_buffers.find(range->owner.get()); entry != client_buffers.end())
+            {
+                entry->second.dmabuf = nullptr;
+            }
+        }
+        return nullptr;
+    }
+}
+
+auto mgc::maybe_make_udmabuf_importer(
+    bool enabled,
+    std::shared_ptr<DMABufEGLProvider> const& provider) -> std::shared_ptr<UDMABufImporter>
+{
+    if (!enabled)
+    {
+        return nullptr;
+    }
+    if (!provider)
+    {
+        mir::log_info("Copying SHM buffers: udmabuf import needs linux-dmabuf import support");
+        return nullptr;
+    }
+
+    mir::Fd device{open("/dev/udmabuf", O_RDWR | O_CLOEXEC)};
+    if (device == mir::Fd::invalid)
+    {
+        mir::log_info(
+            "Copying SHM buffers: Failed to open /dev/udmabuf: %s",
+            std::system_category().message(errno).c_str());
+        return nullptr;
+    }
+
+    return std::make_shared<UDMABufImporter>(
+        [device](mir::Fd const& memfd, size_t offset, size_t size)
+        {
+            return create_udmabuf(device, memfd, offset, size);
+        },
+        [provider](DMABufBuffer const& dmabuf, std::function<void()>&& on_consumed, std::function<void()>&& on_release)
+        {
+            return provider->import_dma_buf(dmabuf, std::move(on_consumed), std::move(on_release));
+        });
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_GRAPHICS_COMMON_UDMABUF_IMPORTER_H_
+#define MIR_GRAPHICS_COMMON_UDMABUF_IMPORTER_H_
+
+#include "mir/fd.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace mir
+{
+namespace renderer::software
+{
+class RWMappableBuffer;
+}
+namespace graphics
+{
+class Buffer;
+class DMABufBuffer;
+class DMABufEGLProvider;
+
+namespace common
+{
+/**
+ * Turns client SHM buffers into dmabufs through /dev/udmabuf, so the GPU can
+ * sample them in place instead of them being copied into textures
+ *
+ * Only buffers in memfds sealed against shrinking qualify: anything else
+ * could be truncated by the client while the GPU is reading it.
+ *
+ * Each client buffer gets one udmabuf, kept for as long as the buffer exists,
+ * rather than one for every frame committed with it.
+ */
+class UDMABufImporter
+{
+public:
+    /// Create a dmabuf of size bytes of memfd from offset (both whole pages), or nothing if that fails
+    using CreateDMABuf = std::function<std::optional<mir::Fd>(mir::Fd const& memfd, size_t offset, size_t size)>;
+
+    /**
+     * Import a dmabuf for the GPU to sample
+     *
+     * \throws std::system_error in egl_category() if the GPU can't import it
+     */
+    using ImportDMABuf = std::function<std::shared_ptr<Buffer>(
+        DMABufBuffer const& dmabuf,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release)>;
+
+    UDMABufImporter(CreateDMABuf create_dmabuf, ImportDMABuf import_dmabuf);
+
+    /**
+     * Import data as a dmabuf-backed buffer
+     *
+     * \note    Must be called with a current EGL context
+     * \note    on_consumed and on_release are consumed even if the import fails,
+     *          so callers that fall back to copying should pass copies.
+     * \return  The imported buffer, or nullptr if data can't be imported;
+     *          the caller should then fall back to copying it.
+     */
+    auto import(
+        renderer::software::RWMappableBuffer const& data,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release) -> std::shared_ptr<Buffer>;
+
+private:
+    struct ClientBuffer
+    {
+        std::weak_ptr<void const> owner;
+        std::shared_ptr<DMABufBuffer const> dmabuf;     ///< Null if this buffer can't be imported
+    };
+
+    CreateDMABuf const create_dmabuf;
+    ImportDMABuf const import_dmabuf;
+
+    std::mutex mutex;
+    std::unordered_set<uint32_t> failed_formats;  ///< DRM formats the GPU can't import at all
+    std::unordered_map<void const*, ClientBuffer> client_buffers;
+};
+
+/// An importer, if enabled and supported by both the kernel and the rendering platform
+auto maybe_make_udmabuf_importer(
+    bool enabled,
+    std::shared_ptr<DMABufEGLProvider> const& provider) -> std::shared_ptr<UDMABufImporter>;
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_COMMON_UDMABUF_IMPORTER_H_ */
@@ -67,10 +67,13 @@ namespace geom = mir::geometry;
 #define EGL_WAYLAND_EGLSTREAM_WL              0x334B
 #endif /* EGL_WL_wayland_eglstream */
 
-mge::BufferAllocator::BufferAllocator(std::unique_ptr<renderer::gl::Context> ctx)
+mge::BufferAllocator::BufferAllocator(
+    std::unique_ptr<renderer::gl::Context> ctx,
+    std::shared_ptr<mgc::TextureBudget> texture_budget)
     : wayland_ctx{ctx->make_share_context()},
       egl_delegate{
-          std::make_shared<mgc::EGLContextExecutor>(std::move(ctx))}
+          std::make_shared<mgc::EGLContextExecutor>(std::move(ctx))},
+      texture_budget{std::move(texture_budget)}
 {
 }
 
@@ -543,10 +546,16 @@ auto mge::BufferAllocator::buffer_from_shm(
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        texture_budget,
         std::move(on_consumed),
         std::move(on_release));
 }
 
+auto mge::BufferAllocator::drm_syncobj_device() -> std::optional<mir::Fd>
+{
+    return std::nullopt;
+}
+
 namespace
 {
 // libepoxy replaces the GL symbols with resolved-on-first-use function pointers
@@ -41,6 +41,11 @@ namespace graphics
 {
 class Display;
 
+namespace common
+{
+class TextureBudget;
+}
+
 namespace gl
 {
 class Program;
@@ -53,7 +58,9 @@ class BufferAllocator:
     public graphics::GraphicBufferAllocator
 {
 public:
-    BufferAllocator(std::unique_ptr<renderer::gl::Context> ctx);
+    BufferAllocator(
+        std::unique_ptr<renderer::gl::Context> ctx,
+        std::shared_ptr<common::TextureBudget> texture_budget);
     ~BufferAllocator();
 
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat format) override;
@@ -71,6 +78,7 @@ public:
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
+    auto drm_syncobj_device() -> std::optional<Fd> override;
 
 private:
     static void create_buffer_eglstream_resource(
@@ -88,6 +96,7 @@ private:
     EGLExtensions::LazyDisplayExtensions<EGLExtensions::NVStreamAttribExtensions> const nv_extensions;
     std::shared_ptr<renderer::gl::Context> const wayland_ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::TextureBudget> const texture_budget;
     std::unique_ptr<gl::Program> shader;
     static struct wl_eglstream_controller_interface const impl;
 };
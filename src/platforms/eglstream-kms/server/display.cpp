@@ -521,6 +521,15 @@ void mge::Display::configure(DisplayConfiguration const& conf)
          });
 }
 
+void mge::Display::configure_incrementally(
+    DisplayConfiguration const& conf,
+    std::function<void(DisplaySyncGroup&)> const& retire)
+{
+    // configure() recreates every sync group
+    for_each_display_sync_group(retire);
+    configure(conf);
+}
+
 namespace
 {
 std::unique_ptr<mir::udev::Monitor> create_drm_monitor()
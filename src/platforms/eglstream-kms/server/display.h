@@ -53,6 +53,9 @@ public:
     bool apply_if_configuration_preserves_display_buffers(DisplayConfiguration const& conf) override;
 
     void configure(DisplayConfiguration const& conf) override;
+    void configure_incrementally(
+        DisplayConfiguration const& conf,
+        std::function<void(DisplaySyncGroup&)> const& retire) override;
 
     void register_configuration_change_handler(EventHandlerRegister& handlers,
         DisplayConfigurationChangeHandler const& conf_change_handler) override;
@@ -173,9 +173,10 @@ private:
 };
 }
 
-mge::RenderingPlatform::RenderingPlatform(EGLDisplay dpy)
+mge::RenderingPlatform::RenderingPlatform(EGLDisplay dpy, std::shared_ptr<mg::common::TextureBudget> texture_budget)
     : dpy{dpy},
-      ctx{std::make_unique<BasicEGLContext>(dpy)}
+      ctx{std::make_unique<BasicEGLContext>(dpy)},
+      texture_budget{std::move(texture_budget)}
 {
     // XWayland eglstream has always been kinda flaky, now it's somehow worse.
     // Disable it until we've had a chance to look at what's wrong.
@@ -190,7 +191,7 @@ mge::RenderingPlatform::~RenderingPlatform()
 mir::UniqueModulePtr<mg::GraphicBufferAllocator> mge::RenderingPlatform::create_buffer_allocator(
     mg::Display const&)
 {
-    return mir::make_module_ptr<mge::BufferAllocator>(ctx->make_share_context());
+    return mir::make_module_ptr<mge::BufferAllocator>(ctx->make_share_context(), texture_budget);
 }
 
 auto mge::RenderingPlatform::maybe_create_provider(
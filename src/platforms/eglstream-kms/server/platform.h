@@ -36,12 +36,17 @@ class Device;
 
 namespace graphics
 {
+namespace common
+{
+class TextureBudget;
+}
+
 namespace eglstream
 {
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    RenderingPlatform(EGLDisplay dpy);
+    RenderingPlatform(EGLDisplay dpy, std::shared_ptr<common::TextureBudget> texture_budget);
     ~RenderingPlatform() override;
 
     UniqueModulePtr<GraphicBufferAllocator>
@@ -53,6 +58,7 @@ protected:
 private:
     EGLDisplay const dpy;
     std::unique_ptr<renderer::gl::Context> const ctx;
+    std::shared_ptr<common::TextureBudget> const texture_budget;
 };
 
 class DisplayPlatform : public graphics::DisplayPlatform
@@ -27,6 +27,7 @@
 #include "mir/log.h"
 #include "mir/graphics/egl_error.h"
 #include "one_shot_device_observer.h"
+#include "texture_budget.h"
 #include "mir/raii.h"
 #include "kms-utils/drm_mode_resources.h"
 #include "mir/graphics/egl_logger.h"
@@ -50,7 +51,7 @@ namespace mge = mir::graphics::eglstream;
 auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& /*displays*/,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
@@ -82,7 +83,7 @@ auto create_rendering_platform(
         }
     }
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(display);
+    return mir::make_module_ptr<mge::RenderingPlatform>(display, mg::common::make_texture_budget(options));
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& /*config*/)
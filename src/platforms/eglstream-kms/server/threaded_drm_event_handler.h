@@ -18,14 +18,15 @@
 #define MIR_PLATFORM_EGLSTREAM_THREADED_DRM_EVENT_HANDLER_H_
 
 #include "drm_event_handler.h"
+#include "kms-utils/drm_event_source.h"
 
 #include "mir/fd.h"
 
 #include <functional>
-#include <vector>
-#include <optional>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <thread>
+#include <unordered_map>
 
 namespace mir
 {
@@ -47,32 +48,14 @@ public:
 
     void cancel_flip_events(KMSCrtcId id) override;
 private:
-    void event_loop() noexcept;
+    auto take_completion(KMSCrtcId id) -> std::promise<void>;
 
-    static void flip_handler(
-        int drm_fd,
-        unsigned int frame_number,
-        unsigned int sec,
-        unsigned int usec,
-        KMSCrtcId crtc_id,
-        void* data) noexcept;
+    std::mutex completions_mutex;
+    std::unordered_map<KMSCrtcId, std::promise<void>> completions;
 
-    mir::Fd const drm_fd;
-    class Pipe;
-    std::unique_ptr<Pipe> const cancel_pipe;
+    std::unique_ptr<kms::DRMEventSource> const events;
 
-    struct FlipEventData
-    {
-        KMSCrtcId id;
-        std::function<void(unsigned int, std::chrono::milliseconds)> callback;
-        std::promise<void> completion;
-    };
-    // We *could* do something fancy and lock-free, but a basic mutex will suffice for now
-    std::mutex expectation_mutex;
-    std::condition_variable expectations_changed;
-    std::vector<std::optional<FlipEventData>> pending_expectations;
-
-    bool shutdown{false};
+    /* Last, so that everything it calls back into exists before it starts */
     std::thread dispatch_thread;
 };
 }
@@ -22,6 +22,7 @@
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/platform.h"
 #include "shm_buffer.h"
+#include "udmabuf_importer.h"
 #include "mir/graphics/egl_context_executor.h"
 #include "mir/graphics/egl_extensions.h"
 #include "mir/graphics/egl_error.h"
@@ -65,11 +66,17 @@ namespace geom = mir::geometry;
 mgg::BufferAllocator::BufferAllocator(
     std::unique_ptr<mgg::SurfacelessEGLContext> context,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
-    std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider)
+    std::shared_ptr<mgc::TextureBudget> texture_budget,
+    std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider,
+    std::shared_ptr<mgc::UDMABufImporter> udmabuf_importer,
+    std::optional<mir::Fd> syncobj_device)
     : ctx{std::move(context)},
       egl_delegate{std::move(egl_delegate)},
+      texture_budget{std::move(texture_budget)},
       egl_extensions(std::make_shared<mg::EGLExtensions>()),
-      dmabuf_provider{std::move(dmabuf_provider)}
+      dmabuf_provider{std::move(dmabuf_provider)},
+      udmabuf_importer{std::move(udmabuf_importer)},
+      syncobj_device{std::move(syncobj_device)}
 {
 }
 
@@ -224,13 +231,33 @@ auto mgg::BufferAllocator::buffer_from_shm(
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
+    if (udmabuf_importer)
+    {
+        auto context_guard = mir::raii::paired_calls(
+            [this]() { ctx->make_current(); },
+            [this]() { ctx->release_current(); });
+
+        if (auto imported = udmabuf_importer->import(
+            *data,
+            std::function<void()>{on_consumed},
+            std::function<void()>{on_release}))
+        {
+            return imported;
+        }
+    }
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        texture_budget,
         std::move(on_consumed),
         std::move(on_release));
 }
 
+auto mgg::BufferAllocator::drm_syncobj_device() -> std::optional<mir::Fd>
+{
+    return syncobj_device;
+}
+
 auto mgg::BufferAllocator::shared_egl_context() -> EGLContext
 {
     return static_cast<EGLContext>(*ctx);
@@ -56,6 +56,8 @@
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
+#include <set>
+#include <optional>
 
 namespace mgg = mir::graphics::gbm;
 namespace mg = mir::graphics;
@@ -210,7 +212,25 @@ void mgg::Display::configure(mg::DisplayConfiguration const& conf)
 
     {
         std::lock_guard lock{configuration_mutex};
-        configure_locked(dynamic_cast<RealKMSDisplayConfiguration const&>(conf), lock);
+        configure_locked(dynamic_cast<RealKMSDisplayConfiguration const&>(conf), {}, lock);
+    }
+
+    if (auto c = cursor.lock()) c->resume();
+}
+
+void mgg::Display::configure_incrementally(
+    mg::DisplayConfiguration const& conf,
+    std::function<void(mg::DisplaySyncGroup&)> const& retire)
+{
+    if (!conf.valid())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error("Invalid or inconsistent display configuration"));
+    }
+
+    {
+        std::lock_guard lock{configuration_mutex};
+        configure_locked(dynamic_cast<RealKMSDisplayConfiguration const&>(conf), retire, lock);
     }
 
     if (auto c = cursor.lock()) c->resume();
@@ -336,7 +356,7 @@ bool mgg::Display::apply_if_configuration_preserves_display_buffers(
         std::lock_guard lock{configuration_mutex};
         if (compatible(current_display_configuration, new_kms_conf))
         {
-            configure_locked(new_kms_conf, lock);
+            configure_locked(new_kms_conf, {}, lock);
             result = true;
         }
     }
@@ -347,6 +367,7 @@ bool mgg::Display::apply_if_configuration_preserves_display_buffers(
 
 void mgg::Display::configure_locked(
     mgg::RealKMSDisplayConfiguration const& kms_conf,
+    std::function<void(mg::DisplaySyncGroup&)> const& retire,
     std::lock_guard<std::mutex> const&)
 {
     // Treat the current_display_configuration as incompatible with itself,
@@ -355,9 +376,64 @@ void mgg::Display::configure_locked(
         (&kms_conf != &current_display_configuration) &&
         compatible(kms_conf, current_display_configuration)};
     std::vector<std::unique_ptr<DisplaySink>> display_buffers_new;
+    std::vector<std::vector<DisplayConfigurationOutput>> display_buffer_outputs_new;
+
+    /* Set up used outputs */
+    OverlappingOutputGrouping grouping{kms_conf};
+
+    /*
+     * Each new group's output configuration, and (if retire is set) the index of the
+     * existing sink it can keep. Kept sinks stay in display_sinks until nothing else
+     * can throw, so a failure part way through leaves them where the compositor expects.
+     */
+    std::vector<std::vector<DisplayConfigurationOutput>> group_outputs;
+    std::vector<std::optional<size_t>> preserved;
+    std::vector<bool> sink_preserved(display_sinks.size(), false);
+    std::set<DisplayConfigurationOutputId> preserved_outputs;
+
+    grouping.for_each_group(
+        [&](OverlappingOutputGroup const& group)
+        {
+            auto& outputs = group_outputs.emplace_back();
+            group.for_each_output(
+                [&](DisplayConfigurationOutput const& conf_output)
+                {
+                    outputs.push_back(conf_output);
+                });
+
+            auto& reused = preserved.emplace_back();
+            if (!comp && retire)
+            {
+                for (auto i = 0u; i != display_sinks.size(); ++i)
+                {
+                    if (!sink_preserved[i] && display_sink_outputs[i] == outputs)
+                    {
+                        reused = i;
+                        sink_preserved[i] = true;
+                        for (auto const& output : outputs)
+                        {
+                            preserved_outputs.insert(output.id);
+                        }
+                        break;
+                    }
+                }
+            }
+        });
 
     if (!comp)
     {
+        // Anything still in display_sinks is going away; its users need to let go of it first
+        if (retire)
+        {
+            for (auto i = 0u; i != display_sinks.size(); ++i)
+            {
+                if (!sink_preserved[i])
+                {
+                    retire(*display_sinks[i]);
+                }
+            }
+        }
+
         /*
          * Notice for a little while here we will have duplicate
          * DisplayBuffers attached to each output, and the display_buffers_new
@@ -366,26 +442,43 @@ void mgg::Display::configure_locked(
          * sure we wait for all pending page flips to finish before the
          * display_buffers_new are created and take control of the outputs.
          */
-        for (auto& db : display_sinks)
-            db->wait_for_page_flip();
+        for (auto i = 0u; i != display_sinks.size(); ++i)
+        {
+            if (!sink_preserved[i])
+            {
+                display_sinks[i]->wait_for_page_flip();
+            }
+        }
 
-        /* Reset the state of all outputs */
+        /* Reset the state of all outputs, other than those of preserved sinks */
         kms_conf.for_each_output(
             [&](DisplayConfigurationOutput const& conf_output)
             {
+                if (preserved_outputs.contains(conf_output.id))
+                {
+                    return;
+                }
                 auto kms_output = current_display_configuration.get_output_for(conf_output.id);
                 kms_output->clear_cursor();
                 kms_output->reset();
             });
     }
 
-    /* Set up used outputs */
-    OverlappingOutputGrouping grouping{kms_conf};
     auto group_idx = 0;
 
     grouping.for_each_group(
         [&](OverlappingOutputGroup const& group)
         {
+            auto const this_group = group_idx++;
+
+            if (preserved[this_group])
+            {
+                // Nothing about these outputs has changed, so leave them (and their sink) running
+                display_buffers_new.emplace_back();
+                display_buffer_outputs_new.push_back(std::move(group_outputs[this_group]));
+                return;
+            }
+
             auto bounding_rect = group.bounding_rectangle();
             std::vector<std::shared_ptr<KMSOutput>> kms_outputs;
             glm::mat2 transformation;
@@ -399,6 +492,7 @@ void mgg::Display::configure_locked(
                     auto const mode_index = kms_conf.get_kms_mode_index(conf_output.id,
                                                                   conf_output.current_mode_index);
                     kms_output->configure(conf_output.top_left - bounding_rect.top_left, mode_index);
+                    kms_output->set_vrr_enabled(conf_output.vrr_enabled);
                     if (!comp)
                     {
                         kms_output->set_power_mode(conf_output.power_mode);
@@ -417,8 +511,9 @@ void mgg::Display::configure_locked(
 
             if (comp)
             {
-                display_sinks[group_idx++]->set_transformation(transformation,
-                                                                 bounding_rect);
+                display_sinks[this_group]->set_transformation(transformation,
+                                                                bounding_rect);
+                display_sink_outputs[this_group] = std::move(group_outputs[this_group]);
             }
             else
             {
@@ -432,11 +527,22 @@ void mgg::Display::configure_locked(
                     transformation);
 
                 display_buffers_new.push_back(std::move(db));
+                display_buffer_outputs_new.push_back(std::move(group_outputs[this_group]));
             }
         });
 
     if (!comp)
+    {
+        for (auto i = 0u; i != preserved.size(); ++i)
+        {
+            if (preserved[i])
+            {
+                display_buffers_new[i] = std::move(display_sinks[*preserved[i]]);
+            }
+        }
         display_sinks = std::move(display_buffers_new);
+        display_sink_outputs = std::move(display_buffer_outputs_new);
+    }
 
     /* Store applied configuration */
     current_display_configuration = kms_conf;
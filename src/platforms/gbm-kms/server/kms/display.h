@@ -72,6 +72,9 @@ public:
     std::unique_ptr<DisplayConfiguration> configuration() const override;
     bool apply_if_configuration_preserves_display_buffers(DisplayConfiguration const& conf) override;
     void configure(DisplayConfiguration const& conf) override;
+    void configure_incrementally(
+        DisplayConfiguration const& conf,
+        std::function<void(graphics::DisplaySyncGroup&)> const& retire) override;
 
     void register_configuration_change_handler(
         EventHandlerRegister& handlers,
@@ -92,11 +95,14 @@ private:
     mir::udev::Monitor monitor;
     std::shared_ptr<KMSOutputContainer> const output_container;
     std::vector<std::unique_ptr<DisplaySink>> display_sinks;
+    /// The configuration of the outputs each of display_sinks was created for
+    std::vector<std::vector<DisplayConfigurationOutput>> display_sink_outputs;
     mutable RealKMSDisplayConfiguration current_display_configuration;
     mutable std::atomic<bool> dirty_configuration;
 
     void configure_locked(
         RealKMSDisplayConfiguration const& conf,
+        std::function<void(graphics::DisplaySyncGroup&)> const& retire,
         std::lock_guard<decltype(configuration_mutex)> const&);
 
     BypassOption bypass_option;
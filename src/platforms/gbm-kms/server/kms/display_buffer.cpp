@@ -139,6 +139,8 @@ bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_lis
     if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
     {
         next_swap = std::move(fb);
+        next_swap_is_client_buffer = true;
+        next_swap_allows_tearing = renderable_list[0].tearing_allowed;
         return true;
     }
     return false;
@@ -189,12 +191,25 @@ void mgg::DisplaySink::post()
     scheduled_fb = std::move(next_swap);
     next_swap = nullptr;
 
+    holding_client_buffers = next_swap_is_client_buffer;
+
+    /*
+     * A client scanned out directly may ask for its frames as soon as
+     * possible. Only honour that outside clone mode: an async flip on one
+     * CRTC would just leave the others to catch up at their own vblank.
+     */
+    bool const tearing = holding_client_buffers && next_swap_allows_tearing && outputs.size() == 1;
+
     /*
-     * Try to schedule a page flip as first preference to avoid tearing.
-     * [will complete in a background thread]
+     * Otherwise try to schedule a page flip as first preference to avoid
+     * tearing. [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+    if (!needs_set_crtc &&
+        !(tearing && schedule_async_page_flip(*scheduled_fb)) &&
+        !schedule_page_flip(*scheduled_fb))
+    {
         needs_set_crtc = true;
+    }
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
@@ -252,7 +267,18 @@ void mgg::DisplaySink::post()
     }
 
     recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    /*
+     * With variable refresh the panel waits for us, so the next flip of a
+     * client's buffer should follow the client's next commit rather than a
+     * fixed vblank schedule. The same goes for a client that has asked for
+     * tearing.
+     *
+     * Composited desktop updates (cursor movement, animations) arrive
+     * irregularly and would have the panel hopping between rates, which
+     * some panels show as flicker. So those stay paced to the mode's rate.
+     */
+    bool const follow_client = holding_client_buffers && outputs.size() == 1 && outputs.front()->vrr_active();
+    if (outputs.size() == 1 && !follow_client && !tearing)
     {
         auto const& output = outputs.front();
         auto const min_frame_interval = 1000ms / output->max_refresh_rate();
@@ -281,6 +307,14 @@ bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
     return page_flips_pending;
 }
 
+bool mgg::DisplaySink::schedule_async_page_flip(FBHandle const& bufobj)
+{
+    if (outputs.front()->schedule_async_page_flip(bufobj))
+        page_flips_pending = true;
+
+    return page_flips_pending;
+}
+
 void mgg::DisplaySink::wait_for_page_flip()
 {
     if (page_flips_pending)
@@ -327,6 +361,7 @@ void mir::graphics::gbm::DisplaySink::set_next_image(std::unique_ptr<Framebuffer
         // Oh, oh! We should be *guaranteed* to “overlay” a single Framebuffer; this is likely a programming error
         BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
     }
+    next_swap_is_client_buffer = false;
 }
 
 auto mgg::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag)
@@ -28,6 +28,7 @@
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <chrono>
 
 namespace mir
 {
@@ -83,10 +84,13 @@ protected:
 
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_async_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
 
     std::shared_ptr<struct gbm_device> const gbm;
     bool holding_client_buffers{false};
+    bool next_swap_is_client_buffer{false};
+    bool next_swap_allows_tearing{false};
     std::shared_ptr<FBHandle const> bypass_bufobj{nullptr};
     std::shared_ptr<DisplayReport> const listener;
 
@@ -61,6 +61,20 @@ public:
      */
     virtual int max_refresh_rate() const = 0;
 
+    /**
+     * Allow (or forbid) variable refresh on this output. Has no effect if
+     * the connector is not "vrr_capable".
+     *
+     * This programs the CRTC, so is only for use while (re)configuring the
+     * output, with no page flip pending.
+     */
+    virtual void set_vrr_enabled(bool enabled) = 0;
+
+    /**
+     * \returns true if the CRTC is driven with variable refresh timing
+     */
+    virtual bool vrr_active() const = 0;
+
     virtual bool set_crtc(FBHandle const& fb) = 0;
 
     /**
@@ -70,6 +84,12 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
+    /**
+     * Schedule a page flip that does not wait for vblank, allowing tearing.
+     * @returns false if an asynchronous flip could not be scheduled; nothing has been
+     *          queued and the caller should use schedule_page_flip() instead
+     */
+    virtual bool schedule_async_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
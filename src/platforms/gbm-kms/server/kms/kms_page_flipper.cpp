@@ -19,56 +19,77 @@
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
-#include <boost/exception/errinfo_errno.hpp>
 
 #include <xf86drm.h>
 #include <xf86drmMode.h>
-#include <chrono>
-#include <cstring>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
-
-namespace
-{
-
-void page_flip_handler(int /*fd*/, unsigned int seq,
-                       unsigned int sec, unsigned int usec,
-                       void* data)
-{
-    auto page_flip_data = static_cast<mgg::PageFlipEventData*>(data);
-    std::chrono::nanoseconds ns{sec*1000000000LL + usec*1000LL};
-    page_flip_data->flipper->notify_page_flip(page_flip_data->crtc_id,
-                                              seq, ns);
-}
-
-}
+namespace mgk = mir::graphics::kms;
 
 mgg::KMSPageFlipper::KMSPageFlipper(
-    int drm_fd,
+    mir::Fd drm_fd,
     std::shared_ptr<DisplayReport> const& report) :
-    drm_fd{drm_fd},
+    drm_fd{std::move(drm_fd)},
     report{report},
-    pending_page_flips(),
-    worker_tid()
+    events{std::make_unique<mgk::DRMEventSource>(this->drm_fd)}
 {
     uint64_t mono = 0;
-    if (drmGetCap(drm_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &mono) || !mono)
+    if (drmGetCap(this->drm_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &mono) || !mono)
         clock_id = CLOCK_REALTIME;
     else
         clock_id = CLOCK_MONOTONIC;
+
+    uint64_t async_flip = 0;
+    async_flip_supported = drmGetCap(this->drm_fd, DRM_CAP_ASYNC_PAGE_FLIP, &async_flip) == 0 && async_flip;
 }
 
 bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
                                         uint32_t fb_id,
                                         uint32_t connector_id)
 {
-    std::unique_lock lock{pf_mutex};
+    return schedule_flip_with_flags(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT);
+}
+
+bool mgg::KMSPageFlipper::schedule_async_flip(uint32_t crtc_id,
+                                              uint32_t fb_id,
+                                              uint32_t connector_id)
+{
+    if (!async_flip_supported)
+        return false;
 
-    if (pending_page_flips.find(crtc_id) != pending_page_flips.end())
-        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+    return schedule_flip_with_flags(
+        crtc_id, fb_id, connector_id,
+        DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC);
+}
+
+bool mgg::KMSPageFlipper::schedule_flip_with_flags(uint32_t crtc_id,
+                                                   uint32_t fb_id,
+                                                   uint32_t connector_id,
+                                                   uint32_t flags)
+{
+    {
+        std::lock_guard lock{pf_mutex};
+
+        auto& crtc = crtcs[crtc_id];
+        if (crtc.pending)
+            BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+
+        crtc.pending = true;
+        crtc.failed = false;
+        crtc.connector_id = connector_id;
+    }
 
-    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
+    /*
+     * The handler must be in place before the flip is submitted; the
+     * event can be dispatched before drmModePageFlip() returns.
+     */
+    events->expect_flip(
+        crtc_id,
+        [this, crtc_id](auto const& event)
+        {
+            notify_page_flip(crtc_id, event);
+        });
 
     /*
      * It appears we can't tell the difference between flipping being
@@ -76,113 +97,97 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
      * fails with -22 (Invalid argument) despite the arguments being
      * apparently valid.
      */
-    auto ret = drmModePageFlip(drm_fd, crtc_id, fb_id,
-                               DRM_MODE_PAGE_FLIP_EVENT,
-                               &pending_page_flips[crtc_id]);
+    auto ret = drmModePageFlip(drm_fd, crtc_id, fb_id, flags, events->event_data());
 
     if (ret)
-        pending_page_flips.erase(crtc_id);
+    {
+        events->cancel_flip(crtc_id);
+
+        std::lock_guard lock{pf_mutex};
+        crtcs[crtc_id].pending = false;
+    }
 
     return (ret == 0);
 }
 
 mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
-    drmEventContext evctx;
-    memset(&evctx, 0, sizeof evctx);
-    evctx.version = 2;  // We only support the old v2 page_flip_handler
-    evctx.page_flip_handler = &page_flip_handler;
+    std::unique_lock lock{pf_mutex};
 
-    static std::thread::id const invalid_tid;
+    auto& crtc = crtcs[crtc_id];
 
+    /*
+     * Rather than have a dedicated thread read DRM events and wake us, the
+     * first waiter to find no one reading them reads them itself. Its own
+     * flip then completes on its own thread, with no wakeup in between. Other
+     * waiters sleep until their own flip completes (only that wakes them;
+     * other outputs flip independently) or the reader hands over to them.
+     */
+    crtc.waiting = true;
+    while (crtc.pending)
     {
-        std::unique_lock lock{pf_mutex};
-
-        /*
-         * While another thread is the worker (it is controlling the
-         * page flip event loop) and our event has not arrived, wait.
-         */
-        while (worker_tid != invalid_tid && !page_flip_is_done(crtc_id))
-            pf_cv.wait(lock);
+        if (dispatching)
+        {
+            crtc.flipped.wait(lock);
+            continue;
+        }
 
-        /* If the page flip we are waiting for has arrived we are done. */
-        if (page_flip_is_done(crtc_id))
-            return completed_page_flips[crtc_id];
+        dispatching = true;
+        lock.unlock();
+        events->dispatch();
+        lock.lock();
+        dispatching = false;
+    }
+    crtc.waiting = false;
+    hand_over_dispatch();
 
-        /* ...otherwise we become the worker */
-        worker_tid = std::this_thread::get_id();
+    if (crtc.failed)
+    {
+        crtc.failed = false;
+        BOOST_THROW_EXCEPTION(std::runtime_error("Error while waiting for page-flip event"));
     }
 
-    /* Only the worker thread reaches this point */
-    bool done{false};
+    return crtc.last_flip;
+}
 
-    while (!done)
+void mgg::KMSPageFlipper::notify_page_flip(
+    uint32_t crtc_id,
+    std::optional<mgk::DRMEventSource::FlipEvent> const& event)
+{
+    std::condition_variable* flipped;
     {
-        fd_set fds;
-        FD_ZERO(&fds);
-        FD_SET(drm_fd, &fds);
-
-        /*
-         * Wait for a page flip event. When we get a page flip event,
-         * page_flip_handler(), called through drmHandleEvent(), will update
-         * the pending_page_flips map.
-         */
-        auto ret = select(drm_fd + 1, &fds, nullptr, nullptr, nullptr);
+        std::lock_guard lock{pf_mutex};
 
+        auto& crtc = crtcs[crtc_id];
+        if (event)
         {
-            std::unique_lock lock{pf_mutex};
-
-            if (ret > 0)
-            {
-                drmHandleEvent(drm_fd, &evctx);
-            }
-            else if (ret < 0 && errno != EINTR)
-            {
-                std::string const msg("Error while waiting for page-flip event");
-                BOOST_THROW_EXCEPTION(
-                    boost::enable_error_info(
-                        std::runtime_error(msg)) << boost::errinfo_errno(errno));
-            }
-
-            done = page_flip_is_done(crtc_id);
-            /* Give up loop control if we are done */
-            if (done)
-                worker_tid = invalid_tid;
+            crtc.last_flip.msc = event->sequence;
+            crtc.last_flip.ust = {clock_id, event->timestamp};
+            report->report_vsync(crtc.connector_id, crtc.last_flip);
         }
-
-        /*
-         * Wake up other (non-worker) threads, so they can check whether
-         * their page-flip events have arrived, or whether they can become
-         * the worker (see pf_cv.wait(lock) above).
-         */
-        pf_cv.notify_all();
+        else
+        {
+            crtc.failed = true;
+        }
+        crtc.pending = false;
+        flipped = &crtc.flipped;
     }
-    return completed_page_flips[crtc_id];
-}
 
-std::thread::id mgg::KMSPageFlipper::debug_get_worker_tid()
-{
-    std::unique_lock lock{pf_mutex};
-
-    return worker_tid;
+    flipped->notify_all();
 }
 
 /* This method should be called with the 'pf_mutex' locked */
-bool mgg::KMSPageFlipper::page_flip_is_done(uint32_t crtc_id)
+void mgg::KMSPageFlipper::hand_over_dispatch()
 {
-    return pending_page_flips.find(crtc_id) == pending_page_flips.end();
-}
+    if (dispatching)
+        return;
 
-void mgg::KMSPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc,
-                                           std::chrono::nanoseconds ust)
-{
-    auto pending = pending_page_flips.find(crtc_id);
-    if (pending != pending_page_flips.end())
+    for (auto& [crtc_id, crtc] : crtcs)
     {
-        auto& frame = completed_page_flips[crtc_id];
-        frame.msc = msc;
-        frame.ust = {clock_id, ust};
-        report->report_vsync(pending->second.connector_id, frame);
-        pending_page_flips.erase(pending);
+        if (crtc.waiting && crtc.pending)
+        {
+            crtc.flipped.notify_all();
+            return;
+        }
     }
 }
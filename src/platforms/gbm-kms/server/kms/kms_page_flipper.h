@@ -18,14 +18,17 @@
 #define MIR_GRAPHICS_GBM_KMS_PAGE_FLIPPER_H_
 
 #include "page_flipper.h"
+#include "kms-utils/drm_event_source.h"
+
+#include "mir/fd.h"
 
 #include <unordered_map>
 #include <chrono>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <condition_variable>
-#include <thread>
 #include <ctime>
-#include <sys/time.h>
 
 namespace mir
 {
@@ -37,36 +40,39 @@ class DisplayReport;
 namespace gbm
 {
 
-class KMSPageFlipper;
-struct PageFlipEventData
-{
-    uint32_t crtc_id;
-    uint32_t connector_id;
-    KMSPageFlipper* flipper;
-};
-
 class KMSPageFlipper : public PageFlipper
 {
 public:
-    KMSPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
+    KMSPageFlipper(mir::Fd drm_fd, std::shared_ptr<DisplayReport> const& report);
 
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_async_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
-    std::thread::id debug_get_worker_tid();
-
-    void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
 private:
-    bool page_flip_is_done(uint32_t crtc_id);
+    struct CrtcState
+    {
+        bool pending{false};
+        bool failed{false};
+        uint32_t connector_id{0};
+        bool waiting{false};
+        Frame last_flip;
+        std::condition_variable flipped;
+    };
+
+    bool schedule_flip_with_flags(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id, uint32_t flags);
+    void notify_page_flip(uint32_t crtc_id, std::optional<kms::DRMEventSource::FlipEvent> const& event);
+    void hand_over_dispatch();
 
-    int const drm_fd;
+    mir::Fd const drm_fd;
     std::shared_ptr<DisplayReport> const report;
-    std::unordered_map<uint32_t,PageFlipEventData> pending_page_flips;
-    std::unordered_map<uint32_t,Frame> completed_page_flips;
     std::mutex pf_mutex;
-    std::condition_variable pf_cv;
-    std::thread::id worker_tid;
+    std::unordered_map<uint32_t, CrtcState> crtcs;
     clockid_t clock_id;
+    bool async_flip_supported;
+    bool dispatching{false};
+    /* Last, so that the flip handlers calling back into the state above go first */
+    std::unique_ptr<kms::DRMEventSource> const events;
 };
 
 }
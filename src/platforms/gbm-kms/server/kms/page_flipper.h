@@ -33,6 +33,13 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * Schedule a flip that takes effect as soon as possible rather than at the next vblank
+     *
+     * \return false if the device does not support asynchronous flips or the flip was rejected;
+     *         the caller should fall back to schedule_flip()
+     */
+    virtual bool schedule_async_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
@@ -21,6 +21,7 @@
 #include "mir/emergency_cleanup_registry.h"
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir/graphics/drm_formats.h"
+#include "mir/graphics/drm_syncobj.h"
 #include "mir/graphics/egl_context_executor.h"
 #include "mir/graphics/platform.h"
 #include "mir/graphics/texture.h"
@@ -32,6 +33,7 @@
 #include "mir/graphics/egl_context_executor.h"
 #include "kms_cpu_addressable_display_provider.h"
 #include "surfaceless_egl_context.h"
+#include "udmabuf_importer.h"
 #include <boost/throw_exception.hpp>
 #include <drm_fourcc.h>
 #include <gbm.h>
@@ -382,18 +384,27 @@ auto maybe_make_dmabuf_provider(
 
 mgg::RenderingPlatform::RenderingPlatform(
     mir::udev::Device const& device,
-    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms)
-    : RenderingPlatform(gbm_device_for_udev_device(device, platforms))
+    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
+    std::shared_ptr<mg::common::TextureBudget> texture_budget,
+    bool import_shm_with_udmabuf)
+    : RenderingPlatform(
+          gbm_device_for_udev_device(device, platforms),
+          std::move(texture_budget),
+          import_shm_with_udmabuf)
 {
 }
 
 mgg::RenderingPlatform::RenderingPlatform(
-    std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw)
+    std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
+    std::shared_ptr<mg::common::TextureBudget> texture_budget,
+    bool import_shm_with_udmabuf)
     : device{std::visit(gbm_device_from_hw{}, hw)},
       bound_display{std::visit(display_provider_or_nothing{}, hw)},
       share_ctx{std::make_unique<SurfacelessEGLContext>(initialise_egl(dpy_for_gbm_device(device.get()), 1, 4))},
       egl_delegate{std::make_shared<mg::common::EGLContextExecutor>(share_ctx->make_share_context())},
-      dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate)}
+      texture_budget{std::move(texture_budget)},
+      dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate)},
+      udmabuf_importer{mg::common::maybe_make_udmabuf_importer(import_shm_with_udmabuf, dmabuf_provider)}
 {
 }
 
@@ -402,10 +413,24 @@ mgg::RenderingPlatform::~RenderingPlatform() = default;
 mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgg::RenderingPlatform::create_buffer_allocator(
     mg::Display const&)
 {
+    std::optional<mir::Fd> syncobj_device;
+    if (dmabuf_provider)
+    {
+        // Explicit sync only applies to dmabuf client buffers, so don't advertise it without them
+        mir::Fd drm_fd{fcntl(gbm_device_get_fd(device.get()), F_DUPFD_CLOEXEC, 0)};
+        if (drm_fd != mir::Fd::invalid && mg::drm::Syncobj::supported(drm_fd))
+        {
+            syncobj_device = std::move(drm_fd);
+        }
+    }
+
     return make_module_ptr<mgg::BufferAllocator>(
         std::make_unique<SurfacelessEGLContext>(share_ctx->egl_display(), static_cast<EGLContext>(*share_ctx)),
         egl_delegate,
-        dmabuf_provider);
+        texture_budget,
+        dmabuf_provider,
+        udmabuf_importer,
+        std::move(syncobj_device));
 }
 
 auto mgg::RenderingPlatform::maybe_create_provider(
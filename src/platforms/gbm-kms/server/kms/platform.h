@@ -36,6 +36,8 @@ class DMABufEGLProvider;
 namespace common
 {
 class EGLContextExecutor;
+class TextureBudget;
+class UDMABufImporter;
 }
 
 namespace gbm
@@ -91,7 +93,9 @@ class RenderingPlatform : public graphics::RenderingPlatform
 public:
     RenderingPlatform(
         udev::Device const& device,
-        std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms);
+        std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms,
+        std::shared_ptr<common::TextureBudget> texture_budget,
+        bool import_shm_with_udmabuf);
 
     ~RenderingPlatform() override;
 
@@ -104,13 +108,17 @@ protected:
 
 private:
     RenderingPlatform(
-        std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw);
+        std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
+        std::shared_ptr<common::TextureBudget> texture_budget,
+        bool import_shm_with_udmabuf);
     
     std::shared_ptr<gbm_device> const device;                   ///< gbm_device this platform is created on, always valid.
     std::shared_ptr<GBMDisplayProvider> const bound_display;    ///< Associated Display, if any (nullptr is valid)
     std::unique_ptr<SurfacelessEGLContext> const share_ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::TextureBudget> const texture_budget;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    std::shared_ptr<common::UDMABufImporter> const udmabuf_importer;
 };
 }
 }
@@ -21,6 +21,7 @@
 #include "platform.h"
 #include "display_helpers.h"
 #include "quirks.h"
+#include "texture_budget.h"
 #include "kms-utils/drm_mode_resources.h"
 #include "mir/options/program_option.h"
 #include "mir/options/option.h"
@@ -78,12 +79,16 @@ mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
 auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mgg::RenderingPlatform>(*device.device, platforms);
+    return mir::make_module_ptr<mgg::RenderingPlatform>(
+        *device.device,
+        platforms,
+        mg::common::make_texture_budget(options),
+        options.get(mo::shm_udmabuf_opt, false));
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
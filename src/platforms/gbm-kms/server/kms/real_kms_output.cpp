@@ -17,6 +17,7 @@
 #include "real_kms_output.h"
 #include "kms_framebuffer.h"
 #include "mir/graphics/display_configuration.h"
+#include "mir/graphics/edid.h"
 #include "page_flipper.h"
 #include "kms-utils/kms_connector.h"
 #include "mir/fatal.h"
@@ -117,6 +118,9 @@ void mgg::RealKMSOutput::reset()
         }
     }
 
+    /* Don't leave variable refresh behind on a CRTC we may be giving up */
+    set_crtc_vrr(false);
+
     /* Discard previously current crtc */
     current_crtc = nullptr;
 }
@@ -198,6 +202,8 @@ void mgg::RealKMSOutput::clear_crtc()
         return;
     }
 
+    set_crtc_vrr(false);
+
     auto result = drmModeSetCrtc(drm_fd_, current_crtc->crtc_id,
                                  0, 0, 0, nullptr, 0, nullptr);
     if (result)
@@ -243,6 +249,19 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
         connector->connector_id);
 }
 
+bool mgg::RealKMSOutput::schedule_async_page_flip(FBHandle const& fb)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+    if (!current_crtc)
+        return false;
+    return page_flipper->schedule_async_flip(
+        current_crtc->crtc_id,
+        fb,
+        connector->connector_id);
+}
+
 void mgg::RealKMSOutput::wait_for_page_flip()
 {
     std::unique_lock lg(power_mutex);
@@ -328,6 +347,10 @@ bool mgg::RealKMSOutput::ensure_crtc()
     connector = kms::get_connector(drm_fd_, connector->connector_id);
     current_crtc = mgk::find_crtc_for_connector(drm_fd_, connector);
 
+    /* A newly acquired CRTC has nothing pending on it, so this is when to set its refresh timing */
+    if (current_crtc)
+        set_crtc_vrr(vrr_enabled);
+
     return (current_crtc != nullptr);
 }
 
@@ -528,6 +551,14 @@ std::vector<uint8_t> edid_for_connector(int drm_fd, uint32_t connector_id)
 
     return edid;
 }
+
+bool connector_is_vrr_capable(int drm_fd, uint32_t connector_id)
+{
+    mgk::ObjectProperties connector_props{
+        drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+
+    return connector_props.has_property("vrr_capable") && connector_props["vrr_capable"];
+}
 }
 
 void mgg::RealKMSOutput::update_from_hardware_state(
@@ -545,11 +576,13 @@ void mgg::RealKMSOutput::update_from_hardware_state(
                                         mir_pixel_format_xrgb_8888};
 
     std::vector<uint8_t> edid;
+    bool vrr_capable{false};
     if (connected) {
         /* Only ask for the EDID on connected outputs. There's obviously no monitor EDID
          * when there is no monitor connected!
          */
         edid = edid_for_connector(drm_fd_, connector->connector_id);
+        vrr_capable = connector_is_vrr_capable(drm_fd_, connector->connector_id);
     }
 
     drmModeModeInfo current_mode_info = drmModeModeInfo();
@@ -606,6 +639,79 @@ void mgg::RealKMSOutput::update_from_hardware_state(
     output.subpixel_arrangement = kms_subpixel_to_mir_subpixel(connector->subpixel);
     output.gamma = gamma;
     output.edid = edid;
+    output.vrr_capable = vrr_capable;
+}
+
+void mgg::RealKMSOutput::set_vrr_enabled(bool enabled)
+{
+    if (enabled && !vrr_enabled)
+    {
+        if (!connector_is_vrr_capable(drm_fd_, connector->connector_id))
+        {
+            mir::log_info("Output %s does not support variable refresh",
+                          mgk::connector_name(connector).c_str());
+            return;
+        }
+
+        int min_hz{0}, max_hz{0};
+        auto const edid = edid_for_connector(drm_fd_, connector->connector_id);
+        if (edid.size() >= Edid::minimum_size &&
+            reinterpret_cast<Edid const*>(edid.data())->get_vertical_refresh_range(min_hz, max_hz))
+        {
+            mir::log_info("Output %s variable refresh range %d-%dHz",
+                          mgk::connector_name(connector).c_str(), min_hz, max_hz);
+        }
+    }
+
+    vrr_enabled = enabled;
+
+    /*
+     * Without a CRTC this waits for ensure_crtc(); otherwise we're being
+     * reconfigured, and the display has already waited out any page flip.
+     */
+    if (current_crtc)
+        set_crtc_vrr(vrr_enabled);
+}
+
+bool mgg::RealKMSOutput::vrr_active() const
+{
+    return vrr_active_;
+}
+
+void mgg::RealKMSOutput::set_crtc_vrr(bool active)
+{
+    if (active == vrr_active_ || !current_crtc)
+        return;
+
+    mgk::ObjectProperties crtc_props{drm_fd_, current_crtc};
+    if (!crtc_props.has_property("VRR_ENABLED"))
+    {
+        if (active)
+        {
+            // The sink can do it but the driver can't drive it; stop asking
+            mir::log_info("Driver does not support variable refresh on output %s",
+                          mgk::connector_name(connector).c_str());
+            vrr_enabled = false;
+        }
+        return;
+    }
+
+    if (auto const err = -drmModeObjectSetProperty(
+            drm_fd_,
+            current_crtc->crtc_id,
+            DRM_MODE_OBJECT_CRTC,
+            crtc_props.id_for("VRR_ENABLED"),
+            active))
+    {
+        mir::log_warning("Failed to %s variable refresh on output %s: %s (%i)",
+                         active ? "enable" : "disable",
+                         mgk::connector_name(connector).c_str(),
+                         strerror(err),
+                         err);
+        return;
+    }
+
+    vrr_active_ = active;
 }
 
 int mgg::RealKMSOutput::drm_fd() const
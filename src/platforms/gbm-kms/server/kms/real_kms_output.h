@@ -20,6 +20,7 @@
 #include "kms_output.h"
 #include "kms-utils/drm_mode_resources.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -47,11 +48,14 @@ public:
     void configure(geometry::Displacement fb_offset, size_t kms_mode_index) override;
     geometry::Size size() const override;
     int max_refresh_rate() const override;
+    void set_vrr_enabled(bool enabled) override;
+    bool vrr_active() const override;
 
     bool set_crtc(FBHandle const& fb) override;
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
+    bool schedule_async_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
 
     bool set_cursor(gbm_bo* buffer) override;
@@ -70,6 +74,7 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    void set_crtc_vrr(bool active);
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -85,6 +90,9 @@ private:
     MirPowerMode power_mode;
     int dpms_enum_id;
 
+    std::atomic<bool> vrr_enabled{false};
+    std::atomic<bool> vrr_active_{false};
+
     std::mutex power_mutex;
 };
 
@@ -21,6 +21,7 @@
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/platform.h"
 #include "shm_buffer.h"
+#include "udmabuf_importer.h"
 #include "mir/graphics/egl_context_executor.h"
 #include "mir/graphics/egl_extensions.h"
 #include "mir/graphics/egl_error.h"
@@ -159,12 +160,16 @@ private:
 mge::BufferAllocator::BufferAllocator(
     EGLDisplay dpy,
     EGLContext share_with,
-    std::shared_ptr<DMABufEGLProvider> dmabuf_provider)
+    std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
+    std::shared_ptr<mgc::TextureBudget> texture_budget,
+    std::shared_ptr<mgc::UDMABufImporter> udmabuf_importer)
     : ctx{std::make_unique<SurfacelessEGLContext>(dpy, share_with)},
       egl_delegate{
           std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context())},
+      texture_budget{std::move(texture_budget)},
       egl_extensions(std::make_shared<mg::EGLExtensions>()),
-      dmabuf_provider{std::move(dmabuf_provider)}
+      dmabuf_provider{std::move(dmabuf_provider)},
+      udmabuf_importer{std::move(udmabuf_importer)}
 {
 }
 
@@ -318,13 +323,33 @@ auto mge::BufferAllocator::buffer_from_shm(
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
+    if (udmabuf_importer)
+    {
+        auto context_guard = mir::raii::paired_calls(
+            [this]() { ctx->make_current(); },
+            [this]() { ctx->release_current(); });
+
+        if (auto imported = udmabuf_importer->import(
+            *data,
+            std::function<void()>{on_consumed},
+            std::function<void()>{on_release}))
+        {
+            return imported;
+        }
+    }
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        texture_budget,
         std::move(on_consumed),
         std::move(on_release));
 }
 
+auto mge::BufferAllocator::drm_syncobj_device() -> std::optional<mir::Fd>
+{
+    return std::nullopt;
+}
+
 auto mge::BufferAllocator::shared_egl_context() -> EGLContext
 {
     return static_cast<EGLContext>(*ctx);
@@ -442,9 +467,31 @@ auto mge::GLRenderingProvider::surface_for_sink(
         *cpu_provider);
 }
 
-auto mge::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
+auto mge::GLRenderingProvider::make_framebuffer_provider(DisplaySink& sink)
     -> std::unique_ptr<FramebufferProvider>
 {
+    if (auto const passthrough = sink.acquire_compatible_allocator<PassthroughDisplayAllocator>())
+    {
+        // The sink can show client buffers itself, so we don't need to render them
+        class PassthroughFramebufferProvider : public FramebufferProvider
+        {
+        public:
+            explicit PassthroughFramebufferProvider(PassthroughDisplayAllocator* allocator)
+                : allocator{allocator}
+            {
+            }
+
+            auto buffer_to_framebuffer(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override
+            {
+                return allocator->framebuffer_for(std::move(buffer));
+            }
+
+        private:
+            PassthroughDisplayAllocator* const allocator;
+        };
+        return std::make_unique<PassthroughFramebufferProvider>(passthrough);
+    }
+
     // TODO: Work out under what circumstances the EGL renderer *can* provide overlayable framebuffers
     class NullFramebufferProvider : public FramebufferProvider
     {
@@ -43,6 +43,8 @@ struct EGLExtensions;
 namespace common
 {
 class EGLContextExecutor;
+class TextureBudget;
+class UDMABufImporter;
 }
 
 namespace egl::generic
@@ -54,7 +56,12 @@ class BufferAllocator:
     public graphics::GraphicBufferAllocator
 {
 public:
-    BufferAllocator(EGLDisplay dpy, EGLContext share_with, std::shared_ptr<DMABufEGLProvider> dmabuf_provider);
+    BufferAllocator(
+        EGLDisplay dpy,
+        EGLContext share_with,
+        std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
+        std::shared_ptr<common::TextureBudget> texture_budget,
+        std::shared_ptr<common::UDMABufImporter> udmabuf_importer);
     ~BufferAllocator() override;
     
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat) override;
@@ -70,15 +77,18 @@ public:
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
+    auto drm_syncobj_device() -> std::optional<Fd> override;
 
     auto shared_egl_context() -> EGLContext;
 private:
     std::unique_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::TextureBudget> const texture_budget;
     std::shared_ptr<Executor> wayland_executor;
     std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable*)>> dmabuf_extension;
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    std::shared_ptr<common::UDMABufImporter> const udmabuf_importer;
     bool egl_display_bound{false};
 };
 
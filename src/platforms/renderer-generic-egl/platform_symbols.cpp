@@ -19,6 +19,9 @@
 #include "mir/log.h"
 
 #include "rendering_platform.h"
+#include "texture_budget.h"
+#include "mir/options/configuration.h"
+#include "mir/options/option.h"
 #include "mir/module_deleter.h"
 #include "mir/assert_module_entry_point.h"
 #include "mir/libname.h"
@@ -38,12 +41,15 @@ namespace mge = mg::egl::generic;
 auto create_rendering_platform(
     mg::SupportedDevice const&,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& displays,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
    mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(displays);
+    return mir::make_module_ptr<mge::RenderingPlatform>(
+        displays,
+        mg::common::make_texture_budget(options),
+        options.get(mo::shm_udmabuf_opt, false));
 }
 
 void add_graphics_platform_options(boost::program_options::options_description&)
@@ -16,6 +16,7 @@
 
 #include "rendering_platform.h"
 #include "buffer_allocator.h"
+#include "udmabuf_importer.h"
 #include "mir/graphics/egl_extensions.h"
 #include "mir/graphics/platform.h"
 #include "mir/graphics/egl_error.h"
@@ -196,12 +197,18 @@ auto maybe_make_dmabuf_provider(
 }
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays)
-    : RenderingPlatform(egl_display_from_platforms(displays))
+mge::RenderingPlatform::RenderingPlatform(
+    std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+    std::shared_ptr<mgc::TextureBudget> texture_budget,
+    bool import_shm_with_udmabuf)
+    : RenderingPlatform(egl_display_from_platforms(displays), std::move(texture_budget), import_shm_with_udmabuf)
 {
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
+mge::RenderingPlatform::RenderingPlatform(
+    std::tuple<EGLDisplay, bool> display,
+    std::shared_ptr<mgc::TextureBudget> texture_budget,
+    bool import_shm_with_udmabuf)
     : dpy{std::get<0>(display)},
       owns_dpy{std::get<1>(display)},
       ctx{std::make_unique<SurfacelessEGLContext>(dpy)},
@@ -209,7 +216,9 @@ mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
           maybe_make_dmabuf_provider(
               dpy,
               std::make_shared<mg::EGLExtensions>(),
-              std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()))}
+              std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()))},
+      texture_budget{std::move(texture_budget)},
+      udmabuf_importer{mgc::maybe_make_udmabuf_importer(import_shm_with_udmabuf, dmabuf_provider)}
 {
 }
 
@@ -224,7 +233,12 @@ mge::RenderingPlatform::~RenderingPlatform()
 auto mge::RenderingPlatform::create_buffer_allocator(
     mg::Display const& /*output*/) -> mir::UniqueModulePtr<mg::GraphicBufferAllocator>
 {
-    return make_module_ptr<mge::BufferAllocator>(dpy, static_cast<EGLContext>(*ctx), dmabuf_provider);
+    return make_module_ptr<mge::BufferAllocator>(
+        dpy,
+        static_cast<EGLContext>(*ctx),
+        dmabuf_provider,
+        texture_budget,
+        udmabuf_importer);
 }
 
 auto mge::RenderingPlatform::maybe_create_provider(RenderingProvider::Tag const& tag)
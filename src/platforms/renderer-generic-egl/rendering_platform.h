@@ -29,13 +29,22 @@ namespace renderer::gl
 class Context;
 }
 
+namespace graphics::common
+{
+class TextureBudget;
+class UDMABufImporter;
+}
+
 namespace graphics::egl::generic
 {
 
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    explicit RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays);
+    RenderingPlatform(
+        std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+        std::shared_ptr<common::TextureBudget> texture_budget,
+        bool import_shm_with_udmabuf);
 
     ~RenderingPlatform();
 
@@ -47,12 +56,17 @@ protected:
         RenderingProvider::Tag const& type_tag) -> std::shared_ptr<RenderingProvider> override;
 
 private:
-    explicit RenderingPlatform(std::tuple<EGLDisplay, bool> dpy);
+    RenderingPlatform(
+        std::tuple<EGLDisplay, bool> dpy,
+        std::shared_ptr<common::TextureBudget> texture_budget,
+        bool import_shm_with_udmabuf);
 
     EGLDisplay const dpy;
     bool const owns_dpy;
     std::unique_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    std::shared_ptr<common::TextureBudget> const texture_budget;
+    std::shared_ptr<common::UDMABufImporter> const udmabuf_importer;
 };
 
 }
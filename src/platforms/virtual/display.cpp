@@ -17,8 +17,10 @@
 #include "display.h"
 #include <mir/graphics/display_configuration.h>
 #include "display_configuration.h"
+#include "display_sink.h"
 #include <mir/log.h>
 
+#include <algorithm>
 #include <utility>
 
 namespace mg = mir::graphics;
@@ -36,15 +38,90 @@ auto build_configuration(std::vector<mgv::VirtualOutputConfig> const& output_siz
     }
     return std::make_unique<mgv::DisplayConfiguration>(output_configurations);
 }
+
+auto is_active(mg::DisplayConfigurationOutput const& output) -> bool
+{
+    return output.connected && output.used && output.power_mode == mir_power_mode_on &&
+        output.current_mode_index < output.modes.size();
+}
+
+/// Whether \p conf would need sinks created or removed
+auto changes_active_outputs(
+    mg::DisplayConfiguration const& conf,
+    std::vector<std::shared_ptr<mgv::DisplaySink>> const& sinks) -> bool
+{
+    size_t active = 0;
+    bool unmatched = false;
+    conf.for_each_output([&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (is_active(output))
+            {
+                ++active;
+                unmatched |= std::none_of(sinks.begin(), sinks.end(),
+                    [&](auto const& sink) { return sink->output_id() == output.id; });
+            }
+        });
+    return unmatched || active != sinks.size();
+}
 }
 
-mgv::Display::Display(std::vector<VirtualOutputConfig> const& output_sizes)
-    : display_configuration{build_configuration(output_sizes)}
+mgv::Display::Display(std::vector<VirtualOutputConfig> const& output_sizes, std::shared_ptr<DisplayReport> report)
+    : report{std::move(report)},
+      display_configuration{build_configuration(output_sizes)}
 {
+    update_sinks();
 }
 
-void mgv::Display::for_each_display_sync_group(std::function<void(DisplaySyncGroup &)> const&)
+mgv::Display::~Display() = default;
+
+void mgv::Display::for_each_display_sync_group(std::function<void(DisplaySyncGroup &)> const& f)
 {
+    for (auto const& sink : sinks())
+    {
+        f(*sink);
+    }
+}
+
+auto mgv::Display::sinks() const -> std::vector<std::shared_ptr<DisplaySink>>
+{
+    std::lock_guard lock{mutex};
+    return display_sinks;
+}
+
+auto mgv::Display::update_sinks() -> std::vector<std::shared_ptr<DisplaySink>>
+{
+    std::vector<std::shared_ptr<DisplaySink>> updated;
+    display_configuration->for_each_output([&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (!is_active(output))
+            {
+                return;
+            }
+
+            auto const existing = std::find_if(display_sinks.begin(), display_sinks.end(),
+                [&](auto const& sink) { return sink->output_id() == output.id; });
+            if (existing != display_sinks.end())
+            {
+                (*existing)->configure(output);
+                updated.push_back(*existing);
+            }
+            else
+            {
+                updated.push_back(std::make_shared<DisplaySink>(output, report));
+            }
+        });
+
+    std::vector<std::shared_ptr<DisplaySink>> removed;
+    for (auto const& sink : display_sinks)
+    {
+        if (std::find(updated.begin(), updated.end(), sink) == updated.end())
+        {
+            removed.push_back(sink);
+        }
+    }
+
+    display_sinks = std::move(updated);
+    return removed;
 }
 
 std::unique_ptr<mg::DisplayConfiguration> mgv::Display::configuration() const
@@ -55,16 +132,43 @@ std::unique_ptr<mg::DisplayConfiguration> mgv::Display::configuration() const
 
 bool mgv::Display::apply_if_configuration_preserves_display_buffers(mir::graphics::DisplayConfiguration const& conf)
 {
-    configure(conf);
+    auto const& new_conf = dynamic_cast<DisplayConfiguration const&>(conf);
+
+    std::lock_guard lock{mutex};
+    // Existing sinks are updated in place, but sinks can't appear or disappear
+    if (changes_active_outputs(new_conf, display_sinks))
+    {
+        return false;
+    }
+
+    display_configuration = new_conf.clone();
+    update_sinks();
     return true;
 }
 
 void mgv::Display::configure(mir::graphics::DisplayConfiguration const& conf)
+{
+    configure_incrementally(conf, [](auto&) {});
+}
+
+void mgv::Display::configure_incrementally(
+    mir::graphics::DisplayConfiguration const& conf,
+    std::function<void(mir::graphics::DisplaySyncGroup&)> const& retire)
 {
     auto const& new_conf = dynamic_cast<DisplayConfiguration const&>(conf);
 
-    std::lock_guard lock{mutex};
-    display_configuration = new_conf.clone();
+    std::vector<std::shared_ptr<DisplaySink>> removed;
+    {
+        std::lock_guard lock{mutex};
+        display_configuration = new_conf.clone();
+        removed = update_sinks();
+    }
+
+    // Removed sinks live until the compositor has let go of them
+    for (auto const& sink : removed)
+    {
+        retire(*sink);
+    }
 }
 
 void mgv::Display::register_configuration_change_handler(
@@ -19,7 +19,9 @@
 
 #include "platform.h"
 #include <mir/graphics/display.h>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -27,15 +29,20 @@ namespace graphics
 {
 namespace virt
 {
+class DisplaySink;
 
 class Display : public mir::graphics::Display
 {
 public:
-    explicit Display(std::vector<VirtualOutputConfig> const& output_sizes);
+    Display(std::vector<VirtualOutputConfig> const& output_sizes, std::shared_ptr<DisplayReport> report);
+    ~Display() override;
     void for_each_display_sync_group(std::function<void(DisplaySyncGroup &)> const& f) override;
     std::unique_ptr<mir::graphics::DisplayConfiguration> configuration() const override;
     bool apply_if_configuration_preserves_display_buffers(mir::graphics::DisplayConfiguration const& conf) override;
     void configure(mir::graphics::DisplayConfiguration const& conf) override;
+    void configure_incrementally(
+        mir::graphics::DisplayConfiguration const& conf,
+        std::function<void(mir::graphics::DisplaySyncGroup&)> const& retire) override;
     void register_configuration_change_handler(
         EventHandlerRegister &handlers,
         DisplayConfigurationChangeHandler const& conf_change_handler) override;
@@ -43,9 +50,17 @@ public:
     void resume() override;
     std::shared_ptr<Cursor> create_hardware_cursor() override;
 
+    /// The sinks for the outputs currently in use, in configuration order
+    auto sinks() const -> std::vector<std::shared_ptr<DisplaySink>>;
+
 private:
+    /// Creates, updates and removes sinks to match display_configuration; returns those removed
+    auto update_sinks() -> std::vector<std::shared_ptr<DisplaySink>>;
+
+    std::shared_ptr<DisplayReport> const report;
     std::mutex mutable mutex;
     std::shared_ptr<DisplayConfiguration> display_configuration;
+    std::vector<std::shared_ptr<DisplaySink>> display_sinks;
 };
 }
 }
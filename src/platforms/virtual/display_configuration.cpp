@@ -28,7 +28,7 @@ mg::DisplayConfigurationOutput mgv::DisplayConfiguration::build_output(mgv::Virt
         BOOST_THROW_EXCEPTION(std::runtime_error("An output must be specified with at least one size"));
     std::vector<DisplayConfigurationMode> configuration_modes;
     for (auto size : config.sizes)
-        configuration_modes.push_back({size, 60.0});
+        configuration_modes.push_back({size, config.refresh_rate});
 
     last_output_id++;
     return  DisplayConfigurationOutput{
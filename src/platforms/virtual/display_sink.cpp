@@ -0,0 +1,252 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_sink.h"
+
+#include <mir/graphics/display_report.h>
+#include <mir/renderer/sw/pixel_source.h>
+
+#include <boost/throw_exception.hpp>
+#include <drm_fourcc.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+#include <typeinfo>
+
+namespace mg = mir::graphics;
+namespace mgv = mir::graphics::virt;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto period_of(mg::DisplayConfigurationOutput const& output) -> std::chrono::nanoseconds
+{
+    auto const hz = output.modes.at(output.current_mode_index).vrefresh_hz;
+    return std::chrono::nanoseconds{std::llround(1e9 / (hz > 0 ? hz : 60.0))};
+}
+
+void wait_until(mir::time::PosixTimestamp const& deadline)
+{
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(deadline.nanoseconds);
+    timespec const ts{
+        static_cast<time_t>(seconds.count()),
+        static_cast<long>((deadline.nanoseconds - seconds).count())};
+    while (clock_nanosleep(deadline.clock_id, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {
+    }
+}
+}
+
+mgv::MemoryFramebuffer::MemoryFramebuffer(DRMFormat format, geom::Size size)
+    : drm_format{format},
+      extents{size},
+      storage(size.width.as_uint32_t() * size.height.as_uint32_t() * 4)
+{
+}
+
+auto mgv::MemoryFramebuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    class Mapping : public mrs::Mapping<unsigned char>
+    {
+    public:
+        explicit Mapping(MemoryFramebuffer& fb) : fb{fb} {}
+
+        auto format() const -> MirPixelFormat override { return fb.format(); }
+        auto stride() const -> geom::Stride override { return fb.stride(); }
+        auto size() const -> geom::Size override { return fb.size(); }
+        auto data() -> unsigned char* override { return fb.storage.data(); }
+        auto len() const -> size_t override { return fb.storage.size(); }
+
+    private:
+        MemoryFramebuffer& fb;
+    };
+
+    return std::make_unique<Mapping>(*this);
+}
+
+auto mgv::MemoryFramebuffer::format() const -> MirPixelFormat
+{
+    return drm_format.as_mir_format().value_or(mir_pixel_format_invalid);
+}
+
+auto mgv::MemoryFramebuffer::stride() const -> geom::Stride
+{
+    return geom::Stride{extents.width.as_uint32_t() * 4};
+}
+
+auto mgv::MemoryFramebuffer::size() const -> geom::Size
+{
+    return extents;
+}
+
+auto mgv::MemoryFramebuffer::pixels() const -> std::vector<unsigned char> const&
+{
+    return storage;
+}
+
+class mgv::DisplaySink::Allocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    explicit Allocator(DisplaySink const& sink)
+        : sink{sink}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<DRMFormat> override
+    {
+        return {DRMFormat{DRM_FORMAT_XRGB8888}, DRMFormat{DRM_FORMAT_ARGB8888}};
+    }
+
+    auto alloc_fb(DRMFormat format) -> std::unique_ptr<MappableFB> override
+    {
+        return std::make_unique<MemoryFramebuffer>(format, output_size());
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        std::lock_guard lock{sink.mutex};
+        return sink.pixel_size;
+    }
+
+private:
+    DisplaySink const& sink;
+};
+
+mgv::DisplaySink::DisplaySink(DisplayConfigurationOutput const& output, std::shared_ptr<DisplayReport> report)
+    : id{output.id},
+      report{std::move(report)},
+      allocator{std::make_unique<Allocator>(*this)},
+      area{output.extents()},
+      pixel_size{output.modes.at(output.current_mode_index).size},
+      transform{output.transformation()},
+      period{period_of(output)},
+      epoch{0, time::PosixTimestamp::now(CLOCK_MONOTONIC)},
+      presented{epoch}
+{
+}
+
+mgv::DisplaySink::~DisplaySink() = default;
+
+auto mgv::DisplaySink::view_area() const -> geom::Rectangle
+{
+    std::lock_guard lock{mutex};
+    return area;
+}
+
+auto mgv::DisplaySink::overlay(std::vector<DisplayElement> const& /*renderlist*/) -> bool
+{
+    // There's no display hardware to compose planes
+    return false;
+}
+
+void mgv::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
+{
+    auto const image = dynamic_cast<MemoryFramebuffer*>(content.get());
+    if (!image)
+    {
+        BOOST_THROW_EXCEPTION((std::bad_cast{}));
+    }
+    content.release();
+
+    std::lock_guard lock{mutex};
+    next_image.reset(image);
+}
+
+auto mgv::DisplaySink::transformation() const -> glm::mat2
+{
+    std::lock_guard lock{mutex};
+    return transform;
+}
+
+void mgv::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
+{
+    f(*this);
+}
+
+void mgv::DisplaySink::post()
+{
+    std::unique_lock lock{mutex};
+
+    // The first vblank from now, but never one we've already presented on
+    auto const now = time::PosixTimestamp::now(CLOCK_MONOTONIC);
+    auto const msc = std::max(epoch.msc + (now - epoch.ust) / period + 1, presented.msc + 1);
+    Frame const vblank{msc, epoch.ust + (msc - epoch.msc) * period};
+    auto image = std::move(next_image);
+
+    lock.unlock();
+    wait_until(vblank.ust);
+    lock.lock();
+
+    presented = vblank;
+    if (image)
+    {
+        current_image = std::move(image);
+    }
+    lock.unlock();
+
+    report->report_vsync(id.as_value(), vblank);
+}
+
+auto mgv::DisplaySink::recommended_sleep() const -> std::chrono::milliseconds
+{
+    return std::chrono::milliseconds::zero();
+}
+
+auto mgv::DisplaySink::output_id() const -> DisplayConfigurationOutputId
+{
+    return id;
+}
+
+void mgv::DisplaySink::configure(DisplayConfigurationOutput const& output)
+{
+    std::lock_guard lock{mutex};
+    area = output.extents();
+    pixel_size = output.modes.at(output.current_mode_index).size;
+    transform = output.transformation();
+
+    if (auto const new_period = period_of(output); new_period != period)
+    {
+        // Restart the clock from the most recent vblank, so msc keeps counting up
+        auto const now = time::PosixTimestamp::now(CLOCK_MONOTONIC);
+        auto const msc = epoch.msc + (now - epoch.ust) / period;
+        epoch = Frame{msc, epoch.ust + (msc - epoch.msc) * period};
+        period = new_period;
+    }
+}
+
+auto mgv::DisplaySink::last_frame() const -> Frame
+{
+    std::lock_guard lock{mutex};
+    return presented;
+}
+
+auto mgv::DisplaySink::last_image() const -> std::shared_ptr<MemoryFramebuffer const>
+{
+    std::lock_guard lock{mutex};
+    return current_image;
+}
+
+auto mgv::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator*
+{
+    if (dynamic_cast<CPUAddressableDisplayAllocator::Tag const*>(&type_tag))
+    {
+        return allocator.get();
+    }
+    return nullptr;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRT_DISPLAY_SINK_H_
+#define MIR_GRAPHICS_VIRT_DISPLAY_SINK_H_
+
+#include <mir/graphics/display.h>
+#include <mir/graphics/display_configuration.h>
+#include <mir/graphics/display_sink.h>
+#include <mir/graphics/frame.h>
+#include <mir/graphics/platform.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class DisplayReport;
+
+namespace virt
+{
+/// A framebuffer in ordinary memory; what a virtual output "scans out"
+class MemoryFramebuffer : public CPUAddressableDisplayAllocator::MappableFB
+{
+public:
+    MemoryFramebuffer(DRMFormat format, geometry::Size size);
+
+    auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+
+    auto format() const -> MirPixelFormat override;
+    auto stride() const -> geometry::Stride override;
+    auto size() const -> geometry::Size override;
+
+    /// The pixels, stride() bytes per row
+    auto pixels() const -> std::vector<unsigned char> const&;
+
+private:
+    DRMFormat const drm_format;
+    geometry::Size const extents;
+    std::vector<unsigned char> storage;
+};
+
+/**
+ * An offscreen output that presents into memory on a simulated vblank clock
+ *
+ * post() waits for the next vblank of a clock ticking at the output's refresh rate, then
+ * makes the submitted image current and reports the frame as a real output would.
+ */
+class DisplaySink : public graphics::DisplaySink, public graphics::DisplaySyncGroup
+{
+public:
+    DisplaySink(DisplayConfigurationOutput const& output, std::shared_ptr<DisplayReport> report);
+    ~DisplaySink() override;
+
+    auto view_area() const -> geometry::Rectangle override;
+    auto overlay(std::vector<DisplayElement> const& renderlist) -> bool override;
+    void set_next_image(std::unique_ptr<Framebuffer> content) override;
+    auto transformation() const -> glm::mat2 override;
+
+    void for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f) override;
+    void post() override;
+    auto recommended_sleep() const -> std::chrono::milliseconds override;
+
+    auto output_id() const -> DisplayConfigurationOutputId;
+
+    /// Follows a change of mode, position or orientation of our output without interrupting the vblank clock
+    void configure(DisplayConfigurationOutput const& output);
+
+    /// The last frame post() presented; msc counts vblanks since the sink was created
+    auto last_frame() const -> Frame;
+
+    /// The image the last post() presented, or nullptr if nothing has been
+    auto last_image() const -> std::shared_ptr<MemoryFramebuffer const>;
+
+protected:
+    auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
+
+private:
+    class Allocator;
+
+    DisplayConfigurationOutputId const id;
+    std::shared_ptr<DisplayReport> const report;
+    std::unique_ptr<Allocator> const allocator;
+
+    std::mutex mutable mutex;
+    geometry::Rectangle area;
+    geometry::Size pixel_size;
+    glm::mat2 transform;
+    std::chrono::nanoseconds period;
+    /// The vblank clock: vblank n is at epoch + (n - epoch_msc) × period
+    Frame epoch;
+    Frame presented;
+    std::unique_ptr<MemoryFramebuffer> next_image;
+    std::shared_ptr<MemoryFramebuffer const> current_image;
+};
+}
+}
+}
+
+#endif // MIR_GRAPHICS_VIRT_DISPLAY_SINK_H_
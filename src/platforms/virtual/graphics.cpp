@@ -61,7 +61,8 @@ void add_graphics_platform_options(boost::program_options::options_description&
         (virtual_displays_option_name,
          boost::program_options::value<std::vector<std::string>>()
             ->multitoken(),
-         "[mir-on-virtual specific] Colon separated list of WIDTHxHEIGHT sizes for the \"output\" size."
+         "[mir-on-virtual specific] Colon separated list of WIDTHxHEIGHT sizes for the \"output\" size,"
+         " optionally followed by @HZ to set its refresh rate (default 60)."
          " Multiple outputs may be specified by providing the argument multiple times.");
 }
 
@@ -22,6 +22,9 @@
 #include "options_parsing_helpers.h"
 #include <drm_fourcc.h>
 
+#include <boost/throw_exception.hpp>
+#include <stdexcept>
+
 namespace mg = mir::graphics;
 namespace mgv = mir::graphics::virt;
 namespace geom = mir::geometry;
@@ -44,7 +47,7 @@ mir::UniqueModulePtr<mg::Display> mgv::Platform::create_display(
     std::shared_ptr<DisplayConfigurationPolicy> const&,
     std::shared_ptr<GLConfig> const&)
 {
-    return mir::make_module_ptr<mgv::Display>(outputs);
+    return mir::make_module_ptr<mgv::Display>(outputs, report);
 }
 
 auto mgv::Platform::maybe_create_provider(DisplayProvider::Tag const& type_tag) -> std::shared_ptr<DisplayProvider>
@@ -56,11 +59,38 @@ auto mgv::Platform::maybe_create_provider(DisplayProvider::Tag const& type_tag)
     return nullptr;
 }
 
+namespace
+{
+auto parse_refresh_rate(std::string const& str) -> double
+{
+    try
+    {
+        size_t num_end = 0;
+        double const value = std::stod(str, &num_end);
+        if (num_end != str.size() || !(value > 0))
+            BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is not a positive number"));
+        return value;
+    }
+    catch (std::logic_error const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is not a positive number"));
+    }
+}
+}
+
 auto mgv::Platform::parse_output_sizes(std::vector<std::string> virtual_outputs) -> std::vector<mgv::VirtualOutputConfig>
 {
     std::vector<VirtualOutputConfig> configs;
-    for (auto const& output : virtual_outputs)
+    for (auto output : virtual_outputs)
     {
+        // An optional "@HZ" suffix sets the output's refresh rate
+        double refresh_rate = 60.0;
+        if (auto const at = output.rfind('@'); at != std::string::npos)
+        {
+            refresh_rate = parse_refresh_rate(output.substr(at + 1));
+            output.resize(at);
+        }
+
         std::vector<geom::Size > sizes;
         for (int start = 0, end; start - 1 < (int)output.size(); start = end + 1)
         {
@@ -70,7 +100,7 @@ auto mgv::Platform::parse_output_sizes(std::vector<std::string> virtual_outputs)
             sizes.push_back(common::parse_size(output.substr(start, end - start)));
         }
 
-        configs.push_back(VirtualOutputConfig(std::move(sizes)));
+        configs.push_back(VirtualOutputConfig(std::move(sizes), refresh_rate));
     }
     return configs;
 }
\ No newline at end of file
@@ -31,16 +31,19 @@ namespace virt
 
 struct VirtualOutputConfig
 {
-    VirtualOutputConfig(std::vector<geometry::Size> sizes)
-        : sizes{sizes}
+    VirtualOutputConfig(std::vector<geometry::Size> sizes, double refresh_rate = 60.0)
+        : sizes{sizes},
+          refresh_rate{refresh_rate}
     {
     }
 
     bool operator==(VirtualOutputConfig const& output) const
     {
-        return sizes == output.sizes;
+        return sizes == output.sizes && refresh_rate == output.refresh_rate;
     }
     std::vector<geometry::Size> sizes;
+    /// Rate of the simulated vblank clock, in Hz, for every size
+    double refresh_rate;
 };
 
 class Platform : public graphics::DisplayPlatform
@@ -95,8 +95,9 @@ mgw::Display::Display(
     wl_display* const wl_display,
     std::shared_ptr<WlDisplayProvider> provider,
     std::shared_ptr<GLConfig> const&,
-    std::shared_ptr<DisplayReport> const& report) :
-    DisplayClient{wl_display, std::move(provider)},
+    std::shared_ptr<DisplayReport> const& report,
+    bool passthrough) :
+    DisplayClient{wl_display, std::move(provider), passthrough},
     report{report},
     shutdown_signal{::eventfd(0, EFD_CLOEXEC)},
     flush_signal{::eventfd(0, EFD_SEMAPHORE)},
@@ -122,6 +123,14 @@ void mgw::Display::configure(DisplayConfiguration const& /*conf*/)
     delete_outputs_to_be_deleted();
 }
 
+void mgw::Display::configure_incrementally(
+    DisplayConfiguration const& /*conf*/,
+    std::function<void(DisplaySyncGroup&)> const& retire)
+{
+    // Only the outputs the host compositor has removed go away
+    delete_outputs_to_be_deleted(retire);
+}
+
 void mgw::Display::register_configuration_change_handler(
     EventHandlerRegister& /*handlers*/,
     DisplayConfigurationChangeHandler const& conf_change_handler)
@@ -61,7 +61,8 @@ public:
         wl_display* const wl_display,
         std::shared_ptr<WlDisplayProvider> provider,
         std::shared_ptr<GLConfig> const& gl_config,
-        std::shared_ptr<DisplayReport> const& report);
+        std::shared_ptr<DisplayReport> const& report,
+        bool passthrough);
 
     ~Display();
 
@@ -79,6 +80,10 @@ public:
 
     void configure(DisplayConfiguration const& conf) override;
 
+    void configure_incrementally(
+        DisplayConfiguration const& conf,
+        std::function<void(DisplaySyncGroup&)> const& retire) override;
+
     void register_configuration_change_handler(EventHandlerRegister& handlers,
         DisplayConfigurationChangeHandler const& conf_change_handler) override;
 
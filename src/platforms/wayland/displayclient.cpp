@@ -16,6 +16,8 @@
  */
 
 #include "displayclient.h"
+#include "subsurface_passthrough.h"
+#include "linux-dmabuf-unstable-v1-client.h"
 #include "mir/fatal.h"
 #include "wl_egl_display_provider.h"
 #include "mir/graphics/platform.h"
@@ -24,6 +26,7 @@
 #include <wayland-client.h>
 #include <wayland-egl.h>
 
+#include <drm_fourcc.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <xkbcommon/xkbcommon.h>
@@ -102,10 +105,89 @@ public:
     auto transformation() const -> glm::mat2 override;
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
     void set_next_image(std::unique_ptr<Framebuffer> content) override;
+    void set_next_image_damage(std::vector<geometry::Rectangle> const& damage) override;
 
 private:
+    class FrameThrottle;
+
     std::unique_ptr<WlDisplayAllocator::Framebuffer> next_frame;
+    /// What changed in next_frame, in surface coordinates; empty for everything
+    std::vector<geometry::Rectangle> next_damage;
     std::shared_ptr<WlDisplayAllocator> provider;
+    std::unique_ptr<FrameThrottle> const frame_throttle;
+    /// Created if the renderer asks for it, and passthrough is enabled and possible
+    std::unique_ptr<SubsurfacePassthrough> subsurfaces;
+    /// Whether the next post() should show the subsurfaces rather than next_frame
+    bool showing_subsurfaces{false};
+};
+
+/// Keeps us from submitting frames faster than the host shows them, without waiting on each frame
+class mgw::DisplayClient::Output::FrameThrottle
+{
+public:
+    explicit FrameThrottle(wl_surface* surface)
+        : surface{surface}
+    {
+    }
+
+    ~FrameThrottle()
+    {
+        std::lock_guard lock{mutex};
+        if (callback)
+        {
+            wl_callback_destroy(callback);
+        }
+    }
+
+    /// Wait until the host has shown the frame we last submitted
+    void wait_for_host()
+    {
+        std::unique_lock lock{mutex};
+        // The host may stop sending frame events (for example, if it hides us), so don't wait forever
+        cv.wait_for(lock, std::chrono::milliseconds{100}, [this]{ return !callback; });
+        if (callback)
+        {
+            // Give up on it; whatever it was for has gone
+            wl_callback_destroy(callback);
+            callback = nullptr;
+        }
+    }
+
+    /// Ask for a frame event for the next commit; the proxy is created here so it precedes that commit
+    void request_frame()
+    {
+        static wl_callback_listener const frame_listener{
+            [](void* data, wl_callback* callback, uint32_t)
+            {
+                static_cast<FrameThrottle*>(data)->frame_done(callback);
+            },
+        };
+
+        std::lock_guard lock{mutex};
+        callback = wl_surface_frame(surface);
+        wl_callback_add_listener(callback, &frame_listener, this);
+    }
+
+private:
+    void frame_done(wl_callback* done)
+    {
+        {
+            std::lock_guard lock{mutex};
+            if (done != callback)
+            {
+                return;
+            }
+            wl_callback_destroy(callback);
+            callback = nullptr;
+        }
+        cv.notify_all();
+    }
+
+    wl_surface* const surface;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    wl_callback* callback{nullptr};
 };
 
 mgw::DisplayClient::Output::Output(
@@ -113,7 +195,8 @@ mgw::DisplayClient::Output::Output(
     DisplayClient* owner) :
     output{output},
     owner_{owner},
-    surface{wl_compositor_create_surface(owner->compositor)}
+    surface{wl_compositor_create_surface(owner->compositor)},
+    frame_throttle{std::make_unique<FrameThrottle>(surface)}
 {
     // If building against newer Wayland protocol definitions we may miss trailing fields
     #pragma GCC diagnostic push
@@ -143,6 +226,8 @@ mgw::DisplayClient::Output::Output(
 
 mgw::DisplayClient::Output::~Output()
 {
+    subsurfaces.reset();
+
     if (output)
     {
         wl_output_destroy(output);
@@ -330,64 +415,21 @@ void mgw::DisplayClient::Output::for_each_display_sink(std::function<void(Displa
 
 void mgw::DisplayClient::Output::post()
 {
-    struct FrameSync
-    {
-        explicit FrameSync(wl_surface* surface):
-            surface{surface}
-        {
-        }
-
-        void init()
-        {
-            callback = wl_surface_frame(surface);
-            static struct wl_callback_listener const frame_listener =
-                {
-                    [](void* data, auto... args)
-                    { static_cast<FrameSync*>(data)->frame_done(args...); },
-                };
-            wl_callback_add_listener(callback, &frame_listener, this);
-        }
-
-        ~FrameSync()
-        {
-            wl_callback_destroy(callback);
-        }
-
-        void frame_done(wl_callback*, uint32_t)
-        {
-            {
-                std::lock_guard lock{mutex};
-                posted = true;
-            }
-            cv.notify_one();
-        }
-
-        void wait_for_done()
-        {
-            std::unique_lock lock{mutex};
-            cv.wait_for(lock, std::chrono::milliseconds{100}, [this]{ return posted; });
-        }
-
-        wl_surface* const surface;
+    /* The Framebuffer ensures that swap_buffers() doesn't block, so we throttle rendering
+     * to the host's frame events. Only the previous frame needs to have been shown: we go
+     * on compositing while the host works on this one.
+     */
+    frame_throttle->wait_for_host();
+    frame_throttle->request_frame();
 
-        wl_callback* callback;
-        std::mutex mutex;
-        bool posted = false;
-        std::condition_variable cv;
-    };
-
-    auto const frame_sync = std::make_shared<FrameSync>(surface);
-    owner_->spawn([frame_sync]()
-                  {
-                      frame_sync->init();
-                  });
-
-    // The Framebuffer ensures that this swap_buffers call doesn't block...
-    next_frame->swap_buffers();
-
-    // ...so we need external synchronisation to throttle rendering.
-    // Wait for the host compositor to tell us to render.
-    frame_sync->wait_for_done();
+    if (showing_subsurfaces)
+    {
+        subsurfaces->commit();
+    }
+    else
+    {
+        next_frame->swap_buffers(next_damage);
+    }
 }
 
 auto mgw::DisplayClient::Output::recommended_sleep() const -> std::chrono::milliseconds
@@ -400,9 +442,10 @@ auto mgw::DisplayClient::Output::view_area() const -> geometry::Rectangle
     return dcout.extents();
 }
 
-bool mgw::DisplayClient::Output::overlay(std::vector<DisplayElement> const&)
+bool mgw::DisplayClient::Output::overlay(std::vector<DisplayElement> const& renderlist)
 {
-    return false;
+    showing_subsurfaces = subsurfaces && subsurfaces->show(renderlist, view_area(), host_scale);
+    return showing_subsurfaces;
 }
 
 auto mgw::DisplayClient::Output::transformation() const -> glm::mat2
@@ -420,6 +463,22 @@ auto mgw::DisplayClient::Output::maybe_create_allocator(DisplayAllocator::Tag co
         }
         return provider.get();
     }
+    if (dynamic_cast<PassthroughDisplayAllocator::Tag const*>(&type_tag))
+    {
+        if (!owner_->passthrough || !SubsurfacePassthrough::supported_by(*owner_))
+        {
+            return nullptr;
+        }
+        if (!has_initialized)
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"Attempted to create allocator before Output is fully initialised"}));
+        }
+        if (!subsurfaces)
+        {
+            subsurfaces = std::make_unique<SubsurfacePassthrough>(owner_, surface, output_size);
+        }
+        return subsurfaces.get();
+    }
     return nullptr;
 }
 
@@ -444,6 +503,13 @@ void mgw::DisplayClient::Output::set_next_image(std::unique_ptr<Framebuffer> con
     if (auto wl_content = unique_ptr_cast<WlDisplayAllocator::Framebuffer>(std::move(content)))
     {
         next_frame = std::move(wl_content);
+        next_damage.clear();
+
+        showing_subsurfaces = false;
+        if (subsurfaces)
+        {
+            subsurfaces->hide();
+        }
     }
     else
     {
@@ -451,11 +517,28 @@ void mgw::DisplayClient::Output::set_next_image(std::unique_ptr<Framebuffer> con
     }
 }
 
+void mgw::DisplayClient::Output::set_next_image_damage(std::vector<geometry::Rectangle> const& damage)
+{
+    next_damage.clear();
+    auto const area = view_area();
+    if (!next_frame || next_frame->size() != area.size)
+    {
+        // Damage can't be mapped onto the image, so it all needs updating
+        return;
+    }
+    for (auto const& rect : damage)
+    {
+        next_damage.push_back({rect.top_left - as_displacement(area.top_left), rect.size});
+    }
+}
+
 mgw::DisplayClient::DisplayClient(
     wl_display* display,
-    std::shared_ptr<WlDisplayProvider> provider) :
+    std::shared_ptr<WlDisplayProvider> provider,
+    bool passthrough) :
     display{display},
     provider{std::move(provider)},
+    passthrough{passthrough},
     keyboard_context_{xkb_context_new(XKB_CONTEXT_NO_FLAGS)},
     registry{nullptr, [](auto){}}
 {
@@ -510,6 +593,22 @@ void mgw::DisplayClient::delete_outputs_to_be_deleted()
     outputs_to_be_deleted.clear();
 }
 
+void mgw::DisplayClient::delete_outputs_to_be_deleted(std::function<void(DisplaySyncGroup&)> const& retire)
+{
+    decltype(outputs_to_be_deleted) deleted;
+    {
+        std::lock_guard lock{outputs_mutex};
+        deleted = std::move(outputs_to_be_deleted);
+        outputs_to_be_deleted.clear();
+    }
+
+    // Don't hold outputs_mutex while the outputs' users let go of them
+    for (auto const& output : deleted)
+    {
+        retire(*output);
+    }
+}
+
 mgw::DisplayClient::~DisplayClient()
 {
     {
@@ -542,6 +641,18 @@ void mgw::DisplayClient::new_global(
         // {arg} TODO needs fixing
         add_shm_listener(self, self->shm);
     }
+    else if (strcmp(interface, "wl_subcompositor") == 0)
+    {
+        self->subcompositor = static_cast<decltype(self->subcompositor)>(
+            wl_registry_bind(registry, id, &wl_subcompositor_interface, std::min(version, 1u)));
+    }
+    else if (strcmp(interface, zwp_linux_dmabuf_v1_interface.name) == 0)
+    {
+        // Version 3 tells us the modifiers; we don't need the feedback objects of version 4
+        self->linux_dmabuf = static_cast<decltype(self->linux_dmabuf)>(
+            wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, std::min(version, 3u)));
+        add_linux_dmabuf_listener(self, self->linux_dmabuf);
+    }
     else if (strcmp(interface, "wl_seat") == 0)
     {
         if (version < 5) self->fake_pointer_frame = true;
@@ -873,6 +984,39 @@ void mir::graphics::wayland::DisplayClient::shm_format(wl_shm* /*wl_shm*/, uint3
     }
 }
 
+void mgw::DisplayClient::add_linux_dmabuf_listener(DisplayClient* self, zwp_linux_dmabuf_v1* linux_dmabuf)
+{
+    static zwp_linux_dmabuf_v1_listener const linux_dmabuf_listener{
+        [](void* self, zwp_linux_dmabuf_v1* linux_dmabuf, uint32_t format)
+        {
+            // From version 3 the modifier events say everything, including whether implicit modifiers work
+            if (zwp_linux_dmabuf_v1_get_version(linux_dmabuf) < 3)
+            {
+                static_cast<DisplayClient*>(self)->linux_dmabuf_modifier(format, DRM_FORMAT_MOD_INVALID);
+            }
+        },
+        [](void* self, zwp_linux_dmabuf_v1*, uint32_t format, uint32_t modifier_hi, uint32_t modifier_lo)
+        {
+            auto const modifier = (static_cast<uint64_t>(modifier_hi) << 32) | modifier_lo;
+            static_cast<DisplayClient*>(self)->linux_dmabuf_modifier(format, modifier);
+        },
+    };
+
+    zwp_linux_dmabuf_v1_add_listener(linux_dmabuf, &linux_dmabuf_listener, self);
+}
+
+void mgw::DisplayClient::linux_dmabuf_modifier(uint32_t format, uint64_t modifier)
+{
+    std::lock_guard lock{dmabuf_formats_mutex};
+    dmabuf_formats.emplace(format, modifier);
+}
+
+auto mgw::DisplayClient::host_supports_dmabuf(uint32_t format, uint64_t modifier) const -> bool
+{
+    std::lock_guard lock{dmabuf_formats_mutex};
+    return dmabuf_formats.contains({format, modifier});
+}
+
 namespace mir
 {
 namespace graphics
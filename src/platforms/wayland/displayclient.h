@@ -34,11 +34,13 @@
 #include <unordered_map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <mir/geometry/displacement.h>
 
 struct xkb_context;
 struct xkb_keymap;
 struct xkb_state;
+struct zwp_linux_dmabuf_v1;
 
 namespace mir
 {
@@ -54,7 +56,8 @@ class DisplayClient
 public:
     DisplayClient(
         wl_display* display,
-        std::shared_ptr<WlDisplayProvider> provider);
+        std::shared_ptr<WlDisplayProvider> provider,
+        bool passthrough);
 
     virtual ~DisplayClient();
 
@@ -62,6 +65,8 @@ protected:
 
     wl_display* const display;
     std::shared_ptr<WlDisplayProvider> const provider;
+    /// Whether outputs may show client buffers as host subsurfaces rather than compositing them
+    bool const passthrough;
 
     auto display_configuration() const -> std::unique_ptr<DisplayConfiguration>;
     void for_each_display_sync_group(const std::function<void(DisplaySyncGroup&)>& f);
@@ -130,13 +135,18 @@ protected:
         wl_fixed_t orientation);
 
     class Output;
+    class SubsurfacePassthrough;
     void on_display_config_changed();
     void delete_outputs_to_be_deleted();
+    /// As delete_outputs_to_be_deleted(), calling retire for each output first
+    void delete_outputs_to_be_deleted(std::function<void(DisplaySyncGroup&)> const& retire);
 
     wl_compositor* compositor = nullptr;
     xdg_wm_base* shell = nullptr;
     wl_seat* seat = nullptr;
     wl_shm* shm = nullptr;
+    wl_subcompositor* subcompositor = nullptr;
+    zwp_linux_dmabuf_v1* linux_dmabuf = nullptr;
 
     static void new_global(
         void* data,
@@ -158,6 +168,13 @@ protected:
     void shm_format(wl_shm *wl_shm, uint32_t format);
     MirPixelFormat shm_pixel_format{mir_pixel_format_invalid};
 
+    static void add_linux_dmabuf_listener(DisplayClient* self, zwp_linux_dmabuf_v1* linux_dmabuf);
+    void linux_dmabuf_modifier(uint32_t format, uint64_t modifier);
+    /// Whether the host will accept dmabufs of this format and modifier
+    auto host_supports_dmabuf(uint32_t format, uint64_t modifier) const -> bool;
+    std::mutex mutable dmabuf_formats_mutex;
+    std::set<std::pair<uint32_t, uint64_t>> dmabuf_formats;
+
     xkb_context* keyboard_context_;
     xkb_keymap* keyboard_map_ = nullptr;
     xkb_state* keyboard_state_ = nullptr;
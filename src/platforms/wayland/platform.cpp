@@ -68,9 +68,13 @@ auto make_initialised_egl_display(struct wl_display* wl_display) -> EGLDisplay
 }
 }
 
-mgw::Platform::Platform(struct wl_display* const wl_display, std::shared_ptr<mg::DisplayReport> const& report) :
+mgw::Platform::Platform(
+    struct wl_display* const wl_display,
+    std::shared_ptr<mg::DisplayReport> const& report,
+    bool passthrough) :
     wl_display{wl_display},
     report{report},
+    passthrough{passthrough},
     provider{std::make_shared<WlDisplayProvider>(make_initialised_egl_display(wl_display))}
 {
 }
@@ -79,7 +83,7 @@ mir::UniqueModulePtr<mg::Display> mgw::Platform::create_display(
     std::shared_ptr<DisplayConfigurationPolicy> const&,
     std::shared_ptr<GLConfig> const& gl_config)
 {
-    return mir::make_module_ptr<mgw::Display>(wl_display, provider, gl_config, report);
+    return mir::make_module_ptr<mgw::Display>(wl_display, provider, gl_config, report, passthrough);
 }
 
 auto mgw::Platform::maybe_create_provider(const DisplayProvider::Tag& type_tag) -> std::shared_ptr<DisplayProvider>
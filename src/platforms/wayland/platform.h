@@ -34,7 +34,7 @@ class WlDisplayProvider;
 class Platform : public graphics::DisplayPlatform
 {
 public:
-    Platform(struct wl_display* const wl_display, std::shared_ptr<DisplayReport> const& report);
+    Platform(struct wl_display* const wl_display, std::shared_ptr<DisplayReport> const& report, bool passthrough);
     ~Platform() = default;
 
     UniqueModulePtr<Display> create_display(
@@ -47,6 +47,7 @@ private:
 
     struct wl_display* const wl_display;
     std::shared_ptr<DisplayReport> const report;
+    bool const passthrough;
 
     std::shared_ptr<WlDisplayProvider> const provider;
 };
@@ -39,6 +39,8 @@ mir::ModuleProperties const description = {
     MIR_VERSION_MICRO,
     mir::libname()
 };
+
+char const* passthrough_option_name{"wayland-host-passthrough"};
 }
 
 mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
@@ -49,13 +51,20 @@ mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
     std::shared_ptr<mg::DisplayReport> const& report)
 {
     mir::assert_entry_point_signature<mg::CreateDisplayPlatform>(&create_display_platform);
-    return mir::make_module_ptr<mgw::Platform>(mpw::connection(*options), report);
+    return mir::make_module_ptr<mgw::Platform>(
+        mpw::connection(*options),
+        report,
+        options->get<bool>(passthrough_option_name));
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
 {
     mir::assert_entry_point_signature<mg::AddPlatformOptions>(&add_graphics_platform_options);
     mpw::add_connection_options(config);
+    config.add_options()
+        (passthrough_option_name,
+         boost::program_options::value<bool>()->default_value(false),
+         "[platform-specific] show suitable client buffers as subsurfaces on the host instead of compositing them.");
 }
 
 auto probe_graphics_platform(
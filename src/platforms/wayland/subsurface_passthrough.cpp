@@ -0,0 +1,437 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "subsurface_passthrough.h"
+#include "linux-dmabuf-unstable-v1-client.h"
+
+#include <mir/anonymous_shm_file.h>
+#include <mir/graphics/display_sink.h>
+#include <mir/graphics/dmabuf_buffer.h>
+#include <mir/graphics/drm_formats.h>
+#include <mir/renderer/sw/pixel_source.h>
+
+#include <drm_fourcc.h>
+#include <wayland-client.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <optional>
+
+namespace mg = mir::graphics;
+namespace mgw = mir::graphics::wayland;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The host gets its own copy of \p content (or zeros, if that's null)
+auto create_shm_buffer(wl_shm* shm, geom::Size size, int32_t stride, uint32_t format, unsigned char const* content)
+    -> wl_buffer*
+{
+    auto const length = stride * size.height.as_int();
+    mir::AnonymousShmFile file{static_cast<size_t>(length)};
+    if (content)
+    {
+        memcpy(file.base_ptr(), content, length);
+    }
+
+    // The pool (and our mapping) can go as soon as the buffer exists; the host has its own
+    auto const pool = wl_shm_create_pool(shm, file.fd(), length);
+    auto const buffer = wl_shm_pool_create_buffer(
+        pool, 0, size.width.as_int(), size.height.as_int(), stride, format);
+    wl_shm_pool_destroy(pool);
+    return buffer;
+}
+
+auto shm_format_for(MirPixelFormat format) -> std::optional<uint32_t>
+{
+    // These are the formats every host has to support
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+        return WL_SHM_FORMAT_ARGB8888;
+
+    case mir_pixel_format_xrgb_8888:
+        return WL_SHM_FORMAT_XRGB8888;
+
+    default:
+        return std::nullopt;
+    }
+}
+}
+
+class mgw::DisplayClient::SubsurfacePassthrough::HostBuffer
+{
+public:
+    /// \param client_buffer    Kept while we exist, for host buffers that share its storage
+    HostBuffer(wl_buffer* buffer, geom::Size size, std::shared_ptr<Buffer> client_buffer) :
+        buffer{buffer},
+        size{size},
+        client_buffer{std::move(client_buffer)}
+    {
+        static wl_buffer_listener const buffer_listener{
+            [](void* data, wl_buffer*) { static_cast<HostBuffer*>(data)->held = false; },
+        };
+        wl_buffer_add_listener(buffer, &buffer_listener, this);
+    }
+
+    ~HostBuffer()
+    {
+        wl_buffer_destroy(buffer);
+    }
+
+    HostBuffer(HostBuffer const&) = delete;
+    HostBuffer& operator=(HostBuffer const&) = delete;
+
+    /// Let the client know its content is on its way to the screen
+    void notify_consumed()
+    {
+        if (client_buffer)
+        {
+            if (auto const consumable = dynamic_cast<ConsumableBuffer*>(client_buffer->native_buffer_base()))
+            {
+                consumable->notify_consumed();
+            }
+        }
+    }
+
+    wl_buffer* const buffer;
+    geom::Size const size;
+    /// Set when the buffer is attached, and cleared when the host releases it
+    std::atomic<bool> held{false};
+
+private:
+    std::shared_ptr<Buffer> const client_buffer;
+};
+
+class mgw::DisplayClient::SubsurfacePassthrough::PassthroughFramebuffer : public Framebuffer
+{
+public:
+    explicit PassthroughFramebuffer(std::shared_ptr<HostBuffer> host_buffer) :
+        host_buffer{std::move(host_buffer)}
+    {
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return host_buffer->size;
+    }
+
+    std::shared_ptr<HostBuffer> const host_buffer;
+};
+
+auto mgw::DisplayClient::SubsurfacePassthrough::supported_by(DisplayClient const& owner) -> bool
+{
+    // Without dmabuf support we can still pass SHM buffers through
+    return owner.subcompositor && owner.shm;
+}
+
+mgw::DisplayClient::SubsurfacePassthrough::SubsurfacePassthrough(
+    DisplayClient* owner,
+    wl_surface* parent,
+    geom::Size parent_size) :
+    owner{owner},
+    parent{parent},
+    parent_size{parent_size}
+{
+}
+
+mgw::DisplayClient::SubsurfacePassthrough::~SubsurfacePassthrough()
+{
+    for (auto const& subsurface : subsurfaces)
+    {
+        wl_subsurface_destroy(subsurface.subsurface);
+        wl_surface_destroy(subsurface.surface);
+    }
+}
+
+auto mgw::DisplayClient::SubsurfacePassthrough::framebuffer_for(std::shared_ptr<Buffer> buffer)
+    -> std::unique_ptr<Framebuffer>
+{
+    if (!buffer)
+    {
+        return nullptr;
+    }
+
+    // The compositor asks again every frame; unchanged buffers shouldn't be imported (or copied) again
+    if (auto const found = imported.find(buffer->id()); found != imported.end())
+    {
+        found->second.used = true;
+        return std::make_unique<PassthroughFramebuffer>(found->second.host_buffer);
+    }
+
+    std::shared_ptr<HostBuffer> host_buffer;
+    if (auto const dmabuf = dynamic_cast<DMABufBuffer*>(buffer->native_buffer_base()))
+    {
+        host_buffer = import_dmabuf(buffer, *dmabuf);
+    }
+    else if (auto const mappable = dynamic_cast<mrs::ReadMappableBuffer*>(buffer->native_buffer_base()))
+    {
+        host_buffer = copy_shm(*mappable);
+    }
+
+    if (!host_buffer)
+    {
+        return nullptr;
+    }
+
+    imported[buffer->id()] = Import{host_buffer, true};
+    return std::make_unique<PassthroughFramebuffer>(std::move(host_buffer));
+}
+
+auto mgw::DisplayClient::SubsurfacePassthrough::import_dmabuf(
+    std::shared_ptr<Buffer> const& buffer,
+    DMABufBuffer const& dmabuf) -> std::shared_ptr<HostBuffer>
+{
+    auto const modifier = dmabuf.modifier().value_or(DRM_FORMAT_MOD_INVALID);
+
+    // Creating a buffer the host can't import is a protocol error, so only try what it has advertised
+    if (!owner->linux_dmabuf || !owner->host_supports_dmabuf(dmabuf.format(), modifier))
+    {
+        return nullptr;
+    }
+
+    auto const params = zwp_linux_dmabuf_v1_create_params(owner->linux_dmabuf);
+    uint32_t plane_index{0};
+    for (auto const& plane : dmabuf.planes())
+    {
+        zwp_linux_buffer_params_v1_add(
+            params,
+            plane.dma_buf,
+            plane_index++,
+            plane.offset,
+            plane.stride,
+            modifier >> 32,
+            modifier & 0xffffffff);
+    }
+
+    uint32_t const flags = dmabuf.layout() == gl::Texture::Layout::BottomRowFirst ?
+        ZWP_LINUX_BUFFER_PARAMS_V1_FLAGS_Y_INVERT : 0;
+    auto const size = dmabuf.size();
+    auto const host_buffer = zwp_linux_buffer_params_v1_create_immed(
+        params,
+        size.width.as_int(),
+        size.height.as_int(),
+        dmabuf.format(),
+        flags);
+    zwp_linux_buffer_params_v1_destroy(params);
+
+    // The host reads the client's storage, so the client mustn't get it back until the host is done
+    return std::make_shared<HostBuffer>(host_buffer, size, buffer);
+}
+
+auto mgw::DisplayClient::SubsurfacePassthrough::copy_shm(mrs::ReadMappableBuffer& buffer)
+    -> std::shared_ptr<HostBuffer>
+{
+    auto const format = shm_format_for(buffer.format());
+    if (!format)
+    {
+        return nullptr;
+    }
+
+    auto const mapping = buffer.map_readable();
+    auto const size = mapping->size();
+    auto const stride = mapping->stride().as_int();
+    if (static_cast<size_t>(stride * size.height.as_int()) > mapping->len())
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<HostBuffer>(
+        create_shm_buffer(owner->shm, size, stride, *format, mapping->data()),
+        size,
+        nullptr);
+}
+
+auto mgw::DisplayClient::SubsurfacePassthrough::show(
+    std::vector<DisplayElement> const& renderlist,
+    geom::Rectangle const& view_area,
+    int32_t scale) -> bool
+{
+    // Check everything first, so that a renderlist we can't show leaves the subsurfaces alone
+    for (auto const& element : renderlist)
+    {
+        auto const framebuffer = dynamic_cast<PassthroughFramebuffer const*>(element.buffer.get());
+        if (!framebuffer)
+        {
+            return false;
+        }
+
+        // Subsurfaces can't be scaled or cropped without wp_viewporter, which we don't use
+        auto const& position = element.screen_positon;
+        if (framebuffer->size() != position.size ||
+            element.source_position != geom::RectangleF{{0, 0}, geom::SizeF{position.size}} ||
+            !view_area.contains(position))
+        {
+            return false;
+        }
+
+        auto const offset = position.top_left - view_area.top_left;
+        if (offset.dx.as_int() % scale || offset.dy.as_int() % scale ||
+            position.size.width.as_int() % scale || position.size.height.as_int() % scale)
+        {
+            return false;
+        }
+    }
+
+    // Leave buffers on the subsurfaces already showing them, so that only what changed is sent to the host
+    std::vector<std::optional<size_t>> slots(renderlist.size());
+    std::vector<bool> in_use(subsurfaces.size(), false);
+    for (size_t i = 0; i != renderlist.size(); ++i)
+    {
+        auto const& host_buffer = static_cast<PassthroughFramebuffer const&>(*renderlist[i].buffer).host_buffer;
+        for (size_t j = 0; j != subsurfaces.size(); ++j)
+        {
+            if (!in_use[j] && subsurfaces[j].attached == host_buffer)
+            {
+                slots[i] = j;
+                in_use[j] = true;
+                break;
+            }
+        }
+    }
+
+    for (auto& slot : slots)
+    {
+        if (slot)
+        {
+            continue;
+        }
+
+        auto const free = std::find(in_use.begin(), in_use.end(), false);
+        if (free != in_use.end())
+        {
+            slot = free - in_use.begin();
+            *free = true;
+        }
+        else
+        {
+            auto const surface = wl_compositor_create_surface(owner->compositor);
+            subsurfaces.push_back({surface, wl_subcompositor_get_subsurface(owner->subcompositor, surface, parent), {}});
+            in_use.push_back(true);
+            slot = subsurfaces.size() - 1;
+        }
+    }
+
+    // Subsurfaces are synchronized by default, so none of this shows until the parent is committed
+    wl_surface* below = parent;
+    for (size_t i = 0; i != renderlist.size(); ++i)
+    {
+        auto const& element = renderlist[i];
+        auto& subsurface = subsurfaces[*slots[i]];
+        auto const offset = element.screen_positon.top_left - view_area.top_left;
+
+        wl_subsurface_set_position(subsurface.subsurface, offset.dx.as_int() / scale, offset.dy.as_int() / scale);
+        wl_subsurface_place_above(subsurface.subsurface, below);
+
+        auto const& host_buffer = static_cast<PassthroughFramebuffer const&>(*element.buffer).host_buffer;
+        if (subsurface.attached != host_buffer)
+        {
+            wl_surface_set_buffer_scale(subsurface.surface, scale);
+            attach(subsurface, host_buffer);
+        }
+        wl_surface_commit(subsurface.surface);
+        below = subsurface.surface;
+    }
+
+    for (size_t j = 0; j != subsurfaces.size(); ++j)
+    {
+        if (!in_use[j] && subsurfaces[j].attached)
+        {
+            attach(subsurfaces[j], nullptr);
+            wl_surface_commit(subsurfaces[j].surface);
+        }
+    }
+
+    forget_unused_imports();
+    return true;
+}
+
+void mgw::DisplayClient::SubsurfacePassthrough::commit()
+{
+    if (!background_attached)
+    {
+        // Whatever isn't covered by a subsurface is black, as it would be if we'd rendered it
+        if (!background)
+        {
+            background = std::make_shared<HostBuffer>(
+                create_shm_buffer(owner->shm, parent_size, 4 * parent_size.width.as_int(), WL_SHM_FORMAT_XRGB8888, nullptr),
+                parent_size,
+                nullptr);
+        }
+        wl_surface_attach(parent, background->buffer, 0, 0);
+        wl_surface_damage(parent, 0, 0, INT32_MAX, INT32_MAX);
+        background_attached = true;
+    }
+    wl_surface_commit(parent);
+
+    drop_released_buffers();
+}
+
+void mgw::DisplayClient::SubsurfacePassthrough::hide()
+{
+    for (auto& subsurface : subsurfaces)
+    {
+        if (subsurface.attached)
+        {
+            attach(subsurface, nullptr);
+            wl_surface_commit(subsurface.surface);
+        }
+    }
+
+    // The next commit of the parent will be a rendered frame, replacing the background
+    background_attached = false;
+
+    forget_unused_imports();
+    drop_released_buffers();
+}
+
+void mgw::DisplayClient::SubsurfacePassthrough::attach(Subsurface& subsurface, std::shared_ptr<HostBuffer> buffer)
+{
+    if (subsurface.attached)
+    {
+        releasing.push_back(std::move(subsurface.attached));
+    }
+
+    if (buffer)
+    {
+        buffer->held = true;
+        buffer->notify_consumed();
+        wl_surface_attach(subsurface.surface, buffer->buffer, 0, 0);
+        wl_surface_damage(subsurface.surface, 0, 0, INT32_MAX, INT32_MAX);
+    }
+    else
+    {
+        wl_surface_attach(subsurface.surface, nullptr, 0, 0);
+    }
+    subsurface.attached = std::move(buffer);
+}
+
+void mgw::DisplayClient::SubsurfacePassthrough::forget_unused_imports()
+{
+    std::erase_if(imported, [](auto const& entry) { return !entry.second.used; });
+    for (auto& [id, import] : imported)
+    {
+        import.used = false;
+    }
+}
+
+void mgw::DisplayClient::SubsurfacePassthrough::drop_released_buffers()
+{
+    std::erase_if(releasing, [](auto const& buffer) { return !buffer->held; });
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_PLATFORM_WAYLAND_SUBSURFACE_PASSTHROUGH_H_
+#define MIR_PLATFORM_WAYLAND_SUBSURFACE_PASSTHROUGH_H_
+
+#include "displayclient.h"
+
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/platform.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace mir::renderer::software
+{
+class ReadMappableBuffer;
+}
+
+namespace mir::graphics
+{
+class DMABufBuffer;
+}
+
+namespace mir::graphics::wayland
+{
+/**
+ * Shows client buffers on the host as subsurfaces of an output's surface, instead of compositing them
+ *
+ * The host does the compositing: we hand it dmabufs as they are, and copies of SHM buffers. Everything
+ * here happens on the compositor thread, except for the host telling us it has finished with a buffer.
+ */
+class DisplayClient::SubsurfacePassthrough : public PassthroughDisplayAllocator
+{
+public:
+    /// Whether the host has what we need
+    static auto supported_by(DisplayClient const& owner) -> bool;
+
+    SubsurfacePassthrough(DisplayClient* owner, wl_surface* parent, geometry::Size parent_size);
+    ~SubsurfacePassthrough();
+
+    SubsurfacePassthrough(SubsurfacePassthrough const&) = delete;
+    SubsurfacePassthrough& operator=(SubsurfacePassthrough const&) = delete;
+
+    auto framebuffer_for(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override;
+
+    /**
+     * Put \p renderlist on our subsurfaces, ready for commit()
+     *
+     * \param view_area     The area of the scene the parent surface shows
+     * \param scale         The buffer scale of the parent surface
+     * \return              false, having changed nothing, if the renderlist can't be shown this way
+     */
+    auto show(std::vector<DisplayElement> const& renderlist, geometry::Rectangle const& view_area, int32_t scale)
+        -> bool;
+
+    /// Commit the parent surface, and with it what show() set up
+    void commit();
+
+    /// Take everything off our subsurfaces, as the parent surface is being rendered to again
+    void hide();
+
+private:
+    class HostBuffer;
+    class PassthroughFramebuffer;
+
+    struct Subsurface
+    {
+        wl_surface* surface;
+        wl_subsurface* subsurface;
+        std::shared_ptr<HostBuffer> attached;
+    };
+
+    struct Import
+    {
+        std::shared_ptr<HostBuffer> host_buffer;
+        bool used;
+    };
+
+    auto import_dmabuf(std::shared_ptr<Buffer> const& buffer, DMABufBuffer const& dmabuf)
+        -> std::shared_ptr<HostBuffer>;
+    auto copy_shm(renderer::software::ReadMappableBuffer& buffer) -> std::shared_ptr<HostBuffer>;
+    void attach(Subsurface& subsurface, std::shared_ptr<HostBuffer> buffer);
+    /// Stop holding on to host buffers for client buffers that weren't in this frame
+    void forget_unused_imports();
+    void drop_released_buffers();
+
+    DisplayClient* const owner;
+    wl_surface* const parent;
+    geometry::Size const parent_size;
+
+    std::vector<Subsurface> subsurfaces;
+    /// Host buffers for the client buffers in the scene, which are likely to be shown again
+    std::map<BufferID, Import> imported;
+    /// Buffers taken off a subsurface that the host hasn't finished with
+    std::vector<std::shared_ptr<HostBuffer>> releasing;
+    /// Shown on the parent surface, beneath the subsurfaces
+    std::shared_ptr<HostBuffer> background;
+    bool background_attached{false};
+};
+}
+
+#endif // MIR_PLATFORM_WAYLAND_SUBSURFACE_PASSTHROUGH_H_
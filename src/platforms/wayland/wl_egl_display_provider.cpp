@@ -1,6 +1,7 @@
 #include "wl_egl_display_provider.h"
 
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/egl_extensions.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/platform.h"
 #include <EGL/egl.h>
@@ -18,7 +19,8 @@ public:
     EGLState(EGLDisplay dpy, EGLContext ctx, EGLSurface surf)
         : dpy{dpy},
           ctx{ctx},
-          surf{surf}
+          surf{surf},
+          swap_with_damage{mg::EGLExtensions::SwapBuffersWithDamage::extension_if_supported(dpy)}
     {
     }
 
@@ -32,6 +34,7 @@ public:
     EGLDisplay const dpy;
     EGLContext const ctx;
     EGLSurface const surf;
+    std::optional<mg::EGLExtensions::SwapBuffersWithDamage> const swap_with_damage;
 };
 
 mgw::WlDisplayAllocator::Framebuffer::Framebuffer(EGLDisplay dpy, EGLContext ctx, EGLSurface surf, geom::Size size)
@@ -77,11 +80,33 @@ void mgw::WlDisplayAllocator::Framebuffer::release_current()
     }
 }
 
-void mgw::WlDisplayAllocator::Framebuffer::swap_buffers()
+void mgw::WlDisplayAllocator::Framebuffer::swap_buffers(std::vector<geom::Rectangle> const& damage)
 {
-    if (eglSwapBuffers(state->dpy, state->surf) != EGL_TRUE)
+    if (damage.empty() || !state->swap_with_damage)
     {
-        BOOST_THROW_EXCEPTION((mg::egl_error("eglSwapBuffers failed")));
+        if (eglSwapBuffers(state->dpy, state->surf) != EGL_TRUE)
+        {
+            BOOST_THROW_EXCEPTION((mg::egl_error("eglSwapBuffers failed")));
+        }
+        return;
+    }
+
+    // The host only needs to pick up what changed, so pass that on as wl_surface.damage_buffer
+    std::vector<EGLint> rects;
+    rects.reserve(4 * damage.size());
+    for (auto const& rect : damage)
+    {
+        // EGL puts the origin at the bottom left
+        rects.push_back(rect.left().as_int());
+        rects.push_back(size_.height.as_int() - rect.bottom().as_int());
+        rects.push_back(rect.size.width.as_int());
+        rects.push_back(rect.size.height.as_int());
+    }
+
+    if (state->swap_with_damage->eglSwapBuffersWithDamage(
+            state->dpy, state->surf, rects.data(), static_cast<EGLint>(damage.size())) != EGL_TRUE)
+    {
+        BOOST_THROW_EXCEPTION((mg::egl_error("eglSwapBuffersWithDamage failed")));
     }
 }
 
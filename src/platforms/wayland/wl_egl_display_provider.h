@@ -18,9 +18,12 @@
 #define MIR_PLATFORM_WAYLAND_DISPLAY_PROVIDER_H_
 
 #include "mir/graphics/platform.h"
+#include "mir/geometry/rectangle.h"
 
 #include <wayland-client.h>
 
+#include <vector>
+
 struct wl_egl_window;
 
 namespace mir::graphics::wayland
@@ -68,7 +71,8 @@ public:
         void release_current() override;
         auto clone_handle() -> std::unique_ptr<GenericEGLDisplayAllocator::EGLFramebuffer> override;
 
-        void swap_buffers();
+        /// Present the frame; \p damage (in surface coordinates) is what changed, or empty for everything
+        void swap_buffers(std::vector<geometry::Rectangle> const& damage);
     private:
         class EGLState;
         Framebuffer(std::shared_ptr<EGLState const> surf, geometry::Size size);
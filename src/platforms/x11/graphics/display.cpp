@@ -180,6 +180,14 @@ std::unique_ptr<mg::DisplayConfiguration> mgx::Display::configuration() const
 }
 
 void mgx::Display::configure(mg::DisplayConfiguration const& new_configuration)
+{
+    // Nothing is compositing, so there's nothing to retire
+    configure_incrementally(new_configuration, [](auto&) {});
+}
+
+void mgx::Display::configure_incrementally(
+    mg::DisplayConfiguration const& new_configuration,
+    std::function<void(mg::DisplaySyncGroup&)> const& retire)
 {
     std::lock_guard lock{mutex};
 
@@ -198,20 +206,32 @@ void mgx::Display::configure(mg::DisplayConfiguration const& new_configuration)
             if (output->config->id == conf_output.id)
             {
                 *output->config = conf_output;
-                output->display_sink->set_view_area(output->config->extents());
+
+                auto const area = output->config->extents();
+                glm::mat2 transform{1};
                 switch (output->config->power_mode)
                 {
                 case mir_power_mode_on:
-                    output->display_sink->set_transformation(output->config->transformation());
+                    transform = output->config->transformation();
                     break;
 
                 case mir_power_mode_standby:
                 case mir_power_mode_suspend:
                 case mir_power_mode_off:
                     // Simulate an off display by setting a zeroed-out transform
-                    output->display_sink->set_transformation(glm::mat2{0});
+                    transform = glm::mat2{0};
                     break;
                 }
+
+                // The output windows outlive any configuration change, but their compositor
+                // reads the area and transformation unsynchronised, so has to stop first
+                auto& sink = *output->display_sink;
+                if (sink.view_area() != area || sink.transformation() != transform)
+                {
+                    retire(sink);
+                    sink.set_view_area(area);
+                    sink.set_transformation(transform);
+                }
                 found_info = true;
                 break;
             }
@@ -79,6 +79,9 @@ public:
     bool apply_if_configuration_preserves_display_buffers(graphics::DisplayConfiguration const& conf) override;
 
     void configure(graphics::DisplayConfiguration const&) override;
+    void configure_incrementally(
+        graphics::DisplayConfiguration const& conf,
+        std::function<void(graphics::DisplaySyncGroup&)> const& retire) override;
 
     void register_configuration_change_handler(
         EventHandlerRegister& handlers,
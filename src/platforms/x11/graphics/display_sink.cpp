@@ -94,6 +94,21 @@ auto unique_ptr_cast(std::unique_ptr<From> ptr) -> std::unique_ptr<To>
 void mgx::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
 {
     next_frame = unique_ptr_cast<helpers::Framebuffer>(std::move(content));
+    next_damage.clear();
+}
+
+void mgx::DisplaySink::set_next_image_damage(std::vector<geometry::Rectangle> const& damage)
+{
+    next_damage.clear();
+    if (!next_frame || next_frame->size() != area.size)
+    {
+        // The window is scaled, so damage can't simply be mapped onto it
+        return;
+    }
+    for (auto const& rect : damage)
+    {
+        next_damage.push_back({rect.top_left - as_displacement(area.top_left), rect.size});
+    }
 }
 
 glm::mat2 mgx::DisplaySink::transformation() const
@@ -118,8 +133,9 @@ void mgx::DisplaySink::for_each_display_sink(std::function<void(graphics::Displa
 
 void mgx::DisplaySink::post()
 {
-    next_frame->swap_buffers();
+    next_frame->swap_buffers(next_damage);
     next_frame.reset();
+    next_damage.clear();
 }
 
 std::chrono::milliseconds mgx::DisplaySink::recommended_sleep() const
@@ -55,6 +55,7 @@ public:
 
     auto overlay(std::vector<DisplayElement> const& renderlist) -> bool override;
     void set_next_image(std::unique_ptr<Framebuffer> content) override;
+    void set_next_image_damage(std::vector<geometry::Rectangle> const& damage) override;
 
     glm::mat2 transformation() const override;
 
@@ -77,6 +78,8 @@ private:
     std::unique_ptr<Allocator> egl_allocator;
 
     std::shared_ptr<helpers::Framebuffer> next_frame;
+    /// What changed in next_frame, in window coordinates; empty for everything
+    std::vector<geometry::Rectangle> next_damage;
     geometry::Rectangle area;
     geometry::Size in_pixels;
     glm::mat2 transform;
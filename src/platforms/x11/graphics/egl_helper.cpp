@@ -18,6 +18,7 @@
 
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/egl_extensions.h"
 
 #include <EGL/egl.h>
 #include <boost/throw_exception.hpp>
@@ -32,7 +33,8 @@ public:
     EGLState(EGLDisplay dpy, EGLContext ctx, EGLSurface surf)
         : dpy{dpy},
           ctx{ctx},
-          surf{surf}
+          surf{surf},
+          swap_with_damage{mg::EGLExtensions::SwapBuffersWithDamage::extension_if_supported(dpy)}
     {
     }
 
@@ -46,6 +48,7 @@ public:
     EGLDisplay const dpy;
     EGLContext const ctx;
     EGLSurface const surf;
+    std::optional<mg::EGLExtensions::SwapBuffersWithDamage> const swap_with_damage;
 };
 
 mgxh::Framebuffer::Framebuffer(EGLDisplay dpy, EGLContext ctx, EGLSurface surf, geometry::Size size)
@@ -80,11 +83,33 @@ void mgxh::Framebuffer::release_current()
     }
 }
 
-void mgxh::Framebuffer::swap_buffers()
+void mgxh::Framebuffer::swap_buffers(std::vector<geometry::Rectangle> const& damage)
 {
-    if (eglSwapBuffers(state->dpy, state->surf) != EGL_TRUE)
+    if (damage.empty() || !state->swap_with_damage)
     {
-        BOOST_THROW_EXCEPTION((mg::egl_error("eglSwapBuffers failed")));
+        if (eglSwapBuffers(state->dpy, state->surf) != EGL_TRUE)
+        {
+            BOOST_THROW_EXCEPTION((mg::egl_error("eglSwapBuffers failed")));
+        }
+        return;
+    }
+
+    // Lets the X server (which may be remote) update only what changed
+    std::vector<EGLint> rects;
+    rects.reserve(4 * damage.size());
+    for (auto const& rect : damage)
+    {
+        // EGL puts the origin at the bottom left
+        rects.push_back(rect.left().as_int());
+        rects.push_back(size_.height.as_int() - rect.bottom().as_int());
+        rects.push_back(rect.size.width.as_int());
+        rects.push_back(rect.size.height.as_int());
+    }
+
+    if (state->swap_with_damage->eglSwapBuffersWithDamage(
+            state->dpy, state->surf, rects.data(), static_cast<EGLint>(damage.size())) != EGL_TRUE)
+    {
+        BOOST_THROW_EXCEPTION((mg::egl_error("eglSwapBuffersWithDamage failed")));
     }
 }
 
@@ -19,11 +19,14 @@
 
 #include <memory>
 #include <functional>
+#include <optional>
+#include <vector>
 
 #include <xcb/xcb.h>
 #include <EGL/egl.h>
 
 #include "mir/graphics/platform.h"
+#include "mir/geometry/rectangle.h"
 
 typedef struct _XDisplay Display;
 
@@ -56,7 +59,8 @@ public:
     void release_current() override;
     auto clone_handle() -> std::unique_ptr<GenericEGLDisplayAllocator::EGLFramebuffer> override;
 
-    void swap_buffers();
+    /// Present the frame; \p damage (in window coordinates) is what changed, or empty for everything
+    void swap_buffers(std::vector<geometry::Rectangle> const& damage);
 private:
     class EGLState;
     Framebuffer(std::shared_ptr<EGLState const> surf, geometry::Size size);
@@ -29,11 +29,13 @@
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
 #include "mir/renderer/gl/gl_surface.h"
+#include "mir/renderer/sw/pixel_source.h"
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
@@ -342,6 +344,11 @@ mrg::Renderer::Renderer(
 
 mrg::Renderer::~Renderer()
 {
+    // Nobody else will complete captures that never got a frame
+    for (auto const& capture : pending_captures)
+    {
+        capture.done(false);
+    }
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -366,6 +373,8 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
         draw(*r);
     }
 
+    copy_to_captures();
+
     auto output = output_surface->commit();
 
     // Report any GL errors after commit, to catch any *during* commit
@@ -646,3 +655,143 @@ void mrg::Renderer::suspend()
 {
     output_surface->release_current();
 }
+
+void mrg::Renderer::capture_next_frame(std::vector<FrameCapture>&& captures)
+{
+    std::move(captures.begin(), captures.end(), std::back_inserter(pending_captures));
+}
+
+void mrg::Renderer::copy_to_captures() const
+{
+    if (pending_captures.empty())
+    {
+        return;
+    }
+
+    auto const captures = std::exchange(pending_captures, {});
+
+    /*
+     * The frame can only be copied as it stands if it was drawn unrotated, unflipped and at
+     * one pixel per unit of viewport; anything else is left for the caller to capture some
+     * other way.
+     */
+    auto const copyable = display_transform == glm::mat4{1.0f} && output_surface->size() == viewport.size;
+
+    std::vector<std::pair<std::function<void(bool)>, bool>> results;
+    results.reserve(captures.size());
+    bool copied_on_gpu = false;
+
+    for (auto const& capture : captures)
+    {
+        bool copied = false;
+        if (copyable && viewport.contains(capture.area) && capture.area.contains(capture.damage))
+        {
+            try
+            {
+                if (capture.cpu_target)
+                {
+                    copied = read_into(capture);
+                }
+                else if (capture.gpu_target)
+                {
+                    copied = copy_into(capture);
+                    copied_on_gpu |= copied;
+                }
+            }
+            catch (...)
+            {
+                mir::log(
+                    mir::logging::Severity::warning,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Failed to copy frame for capture");
+            }
+        }
+        results.emplace_back(capture.done, copied);
+    }
+
+    if (copied_on_gpu)
+    {
+        // Implicit synchronisation on the target orders the client's reads after our writes, once they're submitted
+        glFlush();
+    }
+
+    for (auto const& [done, copied] : results)
+    {
+        done(copied);
+    }
+}
+
+auto mrg::Renderer::read_into(FrameCapture const& capture) const -> bool
+{
+    auto const& target = *capture.cpu_target;
+    auto const format = target.format();
+    if (target.size() != capture.area.size ||
+        (format != mir_pixel_format_argb_8888 && format != mir_pixel_format_xrgb_8888) ||
+        target.stride() != geom::Stride{capture.area.size.width.as_int() * 4})
+    {
+        return false;
+    }
+
+    auto const mapping = capture.cpu_target->map_writeable();
+    auto const stride = target.stride().as_int();
+
+    // GL rows run bottom to top, and so do the target's (captures are flagged as y-inverted)
+    auto const damage_x = (capture.damage.top_left.x - viewport.top_left.x).as_int();
+    auto const damage_gl_y = (viewport.bottom() - capture.damage.bottom()).as_int();
+    auto const target_x = (capture.damage.top_left.x - capture.area.top_left.x).as_int();
+    auto const target_row = (capture.area.bottom() - capture.damage.bottom()).as_int();
+    auto const width = capture.damage.size.width.as_int();
+    auto const height = capture.damage.size.height.as_int();
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    if (capture.damage.size.width == capture.area.size.width)
+    {
+        glReadPixels(
+            damage_x, damage_gl_y, width, height,
+            GL_BGRA_EXT, GL_UNSIGNED_BYTE,
+            mapping->data() + target_row * stride);
+    }
+    else
+    {
+        // GLES2 can't read into a sub-rectangle of a larger image, so read the damage a row at a time
+        for (auto row = 0; row != height; ++row)
+        {
+            glReadPixels(
+                damage_x, damage_gl_y + row, width, 1,
+                GL_BGRA_EXT, GL_UNSIGNED_BYTE,
+                mapping->data() + (target_row + row) * stride + target_x * 4);
+        }
+    }
+    return true;
+}
+
+auto mrg::Renderer::copy_into(FrameCapture const& capture) const -> bool
+{
+    if (capture.gpu_target->size() != capture.area.size)
+    {
+        return false;
+    }
+
+    auto const texture = gl_interface->as_texture(capture.gpu_target);
+
+    // Only a GL_TEXTURE_2D can be written to; a texture that binds elsewhere (such as an external image) can't
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture->bind();
+    GLint bound{0};
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+    if (!bound)
+    {
+        return false;
+    }
+
+    glCopyTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        0, 0,
+        (capture.area.top_left.x - viewport.top_left.x).as_int(),
+        (viewport.bottom() - capture.area.bottom()).as_int(),
+        capture.area.size.width.as_int(),
+        capture.area.size.height.as_int());
+    texture->add_syncpoint();
+    return true;
+}
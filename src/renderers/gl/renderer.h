@@ -51,6 +51,8 @@ public:
     // This is called _without_ a GL context:
     void suspend() override;
 
+    void capture_next_frame(std::vector<FrameCapture>&& captures) override;
+
     struct Program
     {
         GLuint id = 0;
@@ -102,12 +104,18 @@ protected:
 private:
     void update_gl_viewport();
 
+    /// Copies the frame just drawn into any pending captures; called before the frame is committed
+    void copy_to_captures() const;
+    auto read_into(FrameCapture const& capture) const -> bool;
+    auto copy_into(FrameCapture const& capture) const -> bool;
+
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+    std::vector<FrameCapture> mutable pending_captures;
     std::shared_ptr<graphics::GLRenderingProvider> const gl_interface;
 };
 
@@ -0,0 +1,460 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MIR_SOFTWARE_RENDERER_X86
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace mrs = mir::renderer::software;
+
+namespace
+{
+/* All of these compute x × y / 255 (rounded to nearest) as ((x × y + 128) + ((x × y + 128) >> 8)) >> 8,
+ * which is exact for 8-bit x and y. The SIMD versions must give bit-identical results to the scalar ones.
+ */
+
+// Multiplies each channel of p by a/255
+inline auto scale_pixel(uint32_t p, uint32_t a) -> uint32_t
+{
+    uint32_t rb = (p & 0x00ff00ff) * a + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    uint32_t ag = ((p >> 8) & 0x00ff00ff) * a + 0x00800080;
+    ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+    return rb | ag;
+}
+
+inline auto over(uint32_t dst, uint32_t src) -> uint32_t
+{
+    return src + scale_pixel(dst, 255 - (src >> 24));
+}
+
+void blend_scalar(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    if (alpha == 255)
+    {
+        for (size_t i = 0; i != count; ++i)
+        {
+            dst[i] = over(dst[i], src[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i != count; ++i)
+        {
+            dst[i] = over(dst[i], scale_pixel(src[i], alpha));
+        }
+    }
+}
+
+void fade_scalar(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    for (size_t i = 0; i != count; ++i)
+    {
+        dst[i] = scale_pixel(src[i], alpha);
+    }
+}
+
+void scale_scalar(uint32_t* dst, uint32_t const* src, size_t count, uint32_t start, uint32_t step)
+{
+    for (size_t i = 0; i != count; ++i, start += step)
+    {
+        dst[i] = src[start >> 16];
+    }
+}
+
+void make_opaque_scalar(uint32_t* pixels, size_t count)
+{
+    for (size_t i = 0; i != count; ++i)
+    {
+        pixels[i] |= 0xff000000;
+    }
+}
+
+void swap_red_blue_scalar(uint32_t* pixels, size_t count)
+{
+    for (size_t i = 0; i != count; ++i)
+    {
+        auto const p = pixels[i];
+        pixels[i] = (p & 0xff00ff00) | ((p & 0x000000ff) << 16) | ((p >> 16) & 0x000000ff);
+    }
+}
+
+mrs::Kernels const scalar{
+    "scalar",
+    &blend_scalar,
+    &fade_scalar,
+    &scale_scalar,
+    &make_opaque_scalar,
+    &swap_red_blue_scalar};
+
+#if defined(MIR_SOFTWARE_RENDERER_X86) && defined(__SSE2__)
+// 16-bit lanes of x × a / 255, for lanes holding 8-bit values
+inline auto div_255_sse2(__m128i x, __m128i a) -> __m128i
+{
+    auto const t = _mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Each 8-bit channel of four pixels multiplied by the matching 8-bit channel of a
+inline auto scale_sse2(__m128i pixels, __m128i a_lo, __m128i a_hi) -> __m128i
+{
+    auto const zero = _mm_setzero_si128();
+    return _mm_packus_epi16(
+        div_255_sse2(_mm_unpacklo_epi8(pixels, zero), a_lo),
+        div_255_sse2(_mm_unpackhi_epi8(pixels, zero), a_hi));
+}
+
+inline auto over_sse2(__m128i dst, __m128i src) -> __m128i
+{
+    // 255 - alpha of each source pixel, in every 16-bit lane of that pixel
+    auto inverse = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(src, 24));
+    inverse = _mm_or_si128(inverse, _mm_slli_epi32(inverse, 16));
+    return _mm_add_epi8(
+        src,
+        scale_sse2(dst, _mm_unpacklo_epi32(inverse, inverse), _mm_unpackhi_epi32(inverse, inverse)));
+}
+
+void blend_sse2(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    auto const a = _mm_set1_epi16(static_cast<short>(alpha));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        if (alpha != 255)
+        {
+            s = scale_sse2(s, a, a);
+        }
+        auto const d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), over_sse2(d, s));
+    }
+    blend_scalar(dst + i, src + i, count - i, alpha);
+}
+
+void fade_sse2(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    auto const a = _mm_set1_epi16(static_cast<short>(alpha));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), scale_sse2(s, a, a));
+    }
+    fade_scalar(dst + i, src + i, count - i, alpha);
+}
+
+void scale_unrolled(uint32_t* dst, uint32_t const* src, size_t count, uint32_t start, uint32_t step)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, start += 4 * step)
+    {
+        dst[i] = src[start >> 16];
+        dst[i + 1] = src[(start + step) >> 16];
+        dst[i + 2] = src[(start + 2 * step) >> 16];
+        dst[i + 3] = src[(start + 3 * step) >> 16];
+    }
+    scale_scalar(dst + i, src, count - i, start, step);
+}
+
+void make_opaque_sse2(uint32_t* pixels, size_t count)
+{
+    auto const opaque = _mm_set1_epi32(static_cast<int>(0xff000000));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), _mm_or_si128(p, opaque));
+    }
+    make_opaque_scalar(pixels + i, count - i);
+}
+
+void swap_red_blue_sse2(uint32_t* pixels, size_t count)
+{
+    auto const kept = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+    auto const low = _mm_set1_epi32(0x000000ff);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + i));
+        auto const swapped = _mm_or_si128(
+            _mm_and_si128(p, kept),
+            _mm_or_si128(
+                _mm_slli_epi32(_mm_and_si128(p, low), 16),
+                _mm_and_si128(_mm_srli_epi32(p, 16), low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), swapped);
+    }
+    swap_red_blue_scalar(pixels + i, count - i);
+}
+
+mrs::Kernels const sse2{
+    "SSE2",
+    &blend_sse2,
+    &fade_sse2,
+    &scale_unrolled,
+    &make_opaque_sse2,
+    &swap_red_blue_sse2};
+#endif
+
+#if defined(MIR_SOFTWARE_RENDERER_X86)
+[[gnu::target("avx2")]]
+inline auto div_255_avx2(__m256i x, __m256i a) -> __m256i
+{
+    auto const t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// As for SSE2; the unpacks and pack work within each 128-bit half, so pixels stay in order
+[[gnu::target("avx2")]]
+inline auto scale_avx2(__m256i pixels, __m256i a_lo, __m256i a_hi) -> __m256i
+{
+    auto const zero = _mm256_setzero_si256();
+    return _mm256_packus_epi16(
+        div_255_avx2(_mm256_unpacklo_epi8(pixels, zero), a_lo),
+        div_255_avx2(_mm256_unpackhi_epi8(pixels, zero), a_hi));
+}
+
+[[gnu::target("avx2")]]
+inline auto over_avx2(__m256i dst, __m256i src) -> __m256i
+{
+    auto inverse = _mm256_sub_epi32(_mm256_set1_epi32(255), _mm256_srli_epi32(src, 24));
+    inverse = _mm256_or_si256(inverse, _mm256_slli_epi32(inverse, 16));
+    return _mm256_add_epi8(
+        src,
+        scale_avx2(dst, _mm256_unpacklo_epi32(inverse, inverse), _mm256_unpackhi_epi32(inverse, inverse)));
+}
+
+[[gnu::target("avx2")]]
+void blend_avx2(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    auto const a = _mm256_set1_epi16(static_cast<short>(alpha));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        if (alpha != 255)
+        {
+            s = scale_avx2(s, a, a);
+        }
+        auto const d = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), over_avx2(d, s));
+    }
+    blend_scalar(dst + i, src + i, count - i, alpha);
+}
+
+[[gnu::target("avx2")]]
+void fade_avx2(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    auto const a = _mm256_set1_epi16(static_cast<short>(alpha));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto const s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), scale_avx2(s, a, a));
+    }
+    fade_scalar(dst + i, src + i, count - i, alpha);
+}
+
+[[gnu::target("avx2")]]
+void scale_avx2_gather(uint32_t* dst, uint32_t const* src, size_t count, uint32_t start, uint32_t step)
+{
+    auto position = _mm256_add_epi32(
+        _mm256_set1_epi32(static_cast<int>(start)),
+        _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(step))));
+    auto const advance = _mm256_set1_epi32(static_cast<int>(8 * step));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, start += 8 * step)
+    {
+        auto const pixels = _mm256_i32gather_epi32(
+            reinterpret_cast<int const*>(src),
+            _mm256_srli_epi32(position, 16),
+            4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), pixels);
+        position = _mm256_add_epi32(position, advance);
+    }
+    scale_scalar(dst + i, src, count - i, start, step);
+}
+
+[[gnu::target("avx2")]]
+void make_opaque_avx2(uint32_t* pixels, size_t count)
+{
+    auto const opaque = _mm256_set1_epi32(static_cast<int>(0xff000000));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), _mm256_or_si256(p, opaque));
+    }
+    make_opaque_scalar(pixels + i, count - i);
+}
+
+[[gnu::target("avx2")]]
+void swap_red_blue_avx2(uint32_t* pixels, size_t count)
+{
+    auto const order = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), _mm256_shuffle_epi8(p, order));
+    }
+    swap_red_blue_scalar(pixels + i, count - i);
+}
+
+mrs::Kernels const avx2{
+    "AVX2",
+    &blend_avx2,
+    &fade_avx2,
+    &scale_avx2_gather,
+    &make_opaque_avx2,
+    &swap_red_blue_avx2};
+#endif
+
+#if defined(__ARM_NEON)
+// Each 8-bit channel of eight pixels' worth of bytes multiplied by the matching byte of a
+inline auto scale_neon(uint8x16_t pixels, uint8x16_t a) -> uint8x16_t
+{
+    auto const round = vdupq_n_u16(128);
+    auto lo = vaddq_u16(vmull_u8(vget_low_u8(pixels), vget_low_u8(a)), round);
+    auto hi = vaddq_u16(vmull_u8(vget_high_u8(pixels), vget_high_u8(a)), round);
+    lo = vshrq_n_u16(vaddq_u16(lo, vshrq_n_u16(lo, 8)), 8);
+    hi = vshrq_n_u16(vaddq_u16(hi, vshrq_n_u16(hi, 8)), 8);
+    return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+}
+
+inline auto over_neon(uint8x16_t dst, uint8x16_t src) -> uint8x16_t
+{
+    // 255 - alpha of each source pixel, in every byte of that pixel
+    auto const inverse = vsubq_u32(vdupq_n_u32(255), vshrq_n_u32(vreinterpretq_u32_u8(src), 24));
+    auto const spread = vreinterpretq_u8_u32(vmulq_n_u32(inverse, 0x01010101));
+    return vaddq_u8(src, scale_neon(dst, spread));
+}
+
+void blend_neon(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    auto const a = vdupq_n_u8(static_cast<uint8_t>(alpha));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto s = vreinterpretq_u8_u32(vld1q_u32(src + i));
+        if (alpha != 255)
+        {
+            s = scale_neon(s, a);
+        }
+        auto const d = vreinterpretq_u8_u32(vld1q_u32(dst + i));
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(over_neon(d, s)));
+    }
+    blend_scalar(dst + i, src + i, count - i, alpha);
+}
+
+void fade_neon(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha)
+{
+    auto const a = vdupq_n_u8(static_cast<uint8_t>(alpha));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const s = vreinterpretq_u8_u32(vld1q_u32(src + i));
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(scale_neon(s, a)));
+    }
+    fade_scalar(dst + i, src + i, count - i, alpha);
+}
+
+void scale_unrolled(uint32_t* dst, uint32_t const* src, size_t count, uint32_t start, uint32_t step)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, start += 4 * step)
+    {
+        dst[i] = src[start >> 16];
+        dst[i + 1] = src[(start + step) >> 16];
+        dst[i + 2] = src[(start + 2 * step) >> 16];
+        dst[i + 3] = src[(start + 3 * step) >> 16];
+    }
+    scale_scalar(dst + i, src, count - i, start, step);
+}
+
+void make_opaque_neon(uint32_t* pixels, size_t count)
+{
+    auto const opaque = vdupq_n_u32(0xff000000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_u32(pixels + i, vorrq_u32(vld1q_u32(pixels + i), opaque));
+    }
+    make_opaque_scalar(pixels + i, count - i);
+}
+
+void swap_red_blue_neon(uint32_t* pixels, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Byte-wise: B G R A -> R G B A, by swapping the 16-bit halves and then putting G and A back
+        auto const p = vld1q_u32(pixels + i);
+        auto const rotated = vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(p)));
+        auto const kept = vdupq_n_u32(0xff00ff00);
+        vst1q_u32(pixels + i, vbslq_u32(kept, p, rotated));
+    }
+    swap_red_blue_scalar(pixels + i, count - i);
+}
+
+mrs::Kernels const neon{
+    "NEON",
+    &blend_neon,
+    &fade_neon,
+    &scale_unrolled,
+    &make_opaque_neon,
+    &swap_red_blue_neon};
+#endif
+}
+
+auto mrs::scalar_kernels() -> Kernels const&
+{
+    return scalar;
+}
+
+auto mrs::supported_kernels() -> std::vector<Kernels const*>
+{
+    std::vector<Kernels const*> kernels{&scalar};
+#if defined(MIR_SOFTWARE_RENDERER_X86) && defined(__SSE2__)
+    kernels.push_back(&sse2);
+#endif
+#if defined(MIR_SOFTWARE_RENDERER_X86)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back(&avx2);
+    }
+#endif
+#if defined(__ARM_NEON)
+    kernels.push_back(&neon);
+#endif
+    return kernels;
+}
+
+auto mrs::best_kernels() -> Kernels const&
+{
+    static Kernels const& best = *supported_kernels().back();
+    return best;
+}
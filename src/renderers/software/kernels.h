@@ -0,0 +1,69 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_KERNELS_H_
+#define MIR_RENDERER_SOFTWARE_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+/**
+ * Row operations the software renderer builds frames from
+ *
+ * Pixels are 32-bit words in 0xAARRGGBB order (DRM_FORMAT_ARGB8888) with premultiplied alpha,
+ * as Wayland clients supply them.
+ */
+struct Kernels
+{
+    /// The instruction set these are written for, for logging
+    char const* name;
+
+    /// Source-over: dst = src × alpha/255 + dst × (1 - alpha of the scaled src), over count pixels
+    void (*blend)(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha);
+
+    /// dst = src × alpha/255, over count pixels
+    void (*fade)(uint32_t* dst, uint32_t const* src, size_t count, uint32_t alpha);
+
+    /// Nearest-neighbour resampling: dst[i] = src[(start + i × step) >> 16]
+    void (*scale)(uint32_t* dst, uint32_t const* src, size_t count, uint32_t start, uint32_t step);
+
+    /// Sets every pixel's alpha to opaque, for formats whose alpha byte is padding
+    void (*make_opaque)(uint32_t* pixels, size_t count);
+
+    /// Exchanges the red and blue channels, converting between ARGB and ABGR orders
+    void (*swap_red_blue)(uint32_t* pixels, size_t count);
+};
+
+/// Plain C++ versions that run anywhere; the reference the others must match
+auto scalar_kernels() -> Kernels const&;
+
+/// The fastest kernels the CPU we're running on supports
+auto best_kernels() -> Kernels const&;
+
+/// Every set of kernels this CPU can run, scalar first
+auto supported_kernels() -> std::vector<Kernels const*>;
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_KERNELS_H_
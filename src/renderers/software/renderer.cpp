@@ -0,0 +1,612 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include "renderer.h"
+#include "tile_workers.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/platform.h"
+#include "mir/log.h"
+#include "mir/renderer/sw/pixel_source.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// What shows where nothing is drawn: opaque black, as the GL renderer clears to
+uint32_t const clear_pixel = 0xff000000;
+
+/// Output rows are copied in bands of this many, one band per TileWorkers job
+int const rows_per_band = 32;
+
+auto is_empty(geom::Rectangle const& rect) -> bool
+{
+    return rect.size.width.as_int() <= 0 || rect.size.height.as_int() <= 0;
+}
+
+auto is_red_blue_swapped(MirPixelFormat format) -> bool
+{
+    return format == mir_pixel_format_abgr_8888 || format == mir_pixel_format_xbgr_8888;
+}
+
+auto has_alpha(MirPixelFormat format) -> bool
+{
+    return format == mir_pixel_format_argb_8888 || format == mir_pixel_format_abgr_8888;
+}
+
+auto is_drawable(MirPixelFormat format) -> bool
+{
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+auto choose_format(mg::CPUAddressableDisplayAllocator const& allocator) -> mg::DRMFormat
+{
+    // The shadow buffer is ARGB, so anything else costs a channel swap on every copy
+    std::optional<mg::DRMFormat> swapped;
+    for (auto const& format : allocator.supported_formats())
+    {
+        switch (format.as_mir_format().value_or(mir_pixel_format_invalid))
+        {
+        case mir_pixel_format_xrgb_8888:
+        case mir_pixel_format_argb_8888:
+            return format;
+
+        case mir_pixel_format_xbgr_8888:
+        case mir_pixel_format_abgr_8888:
+            swapped = format;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (swapped)
+    {
+        return *swapped;
+    }
+
+    BOOST_THROW_EXCEPTION((std::runtime_error{"Output supports no 32-bit RGB format for software rendering"}));
+}
+
+auto bands_of(int rows) -> size_t
+{
+    return (rows + rows_per_band - 1) / rows_per_band;
+}
+
+/// A renderable with its buffer mapped, ready for the tiles to draw from
+struct Source
+{
+    geom::Rectangle position;
+    geom::Rectangle visible;
+    uint32_t alpha;
+    std::unique_ptr<mrs::Mapping<unsigned char const>> mapping;
+};
+
+void draw_tile(
+    mrs::Kernels const& kernels,
+    uint32_t* shadow,
+    int shadow_stride,
+    geom::Rectangle const& tile,
+    std::vector<Source> const& sources)
+{
+    thread_local std::vector<uint32_t> scratch;
+
+    auto const tile_x = tile.left().as_int();
+    auto const tile_width = tile.size.width.as_int();
+    for (auto y = tile.top().as_int(); y != tile.bottom().as_int(); ++y)
+    {
+        std::fill_n(shadow + y * shadow_stride + tile_x, tile_width, clear_pixel);
+    }
+
+    for (auto const& source : sources)
+    {
+        auto const area = intersection_of(source.visible, tile);
+        if (is_empty(area))
+        {
+            continue;
+        }
+
+        auto const format = source.mapping->format();
+        auto const swap = is_red_blue_swapped(format);
+        auto const opaque = !has_alpha(format);
+        auto const data = source.mapping->data();
+        auto const source_stride = source.mapping->stride().as_int();
+        auto const source_size = source.mapping->size();
+
+        // Nearest-neighbour sampling at pixel centres, in 16.16 fixed point
+        auto const dest_width = source.position.size.width.as_int();
+        auto const dest_height = source.position.size.height.as_int();
+        auto const step_x = static_cast<uint32_t>((uint64_t{source_size.width.as_uint32_t()} << 16) / dest_width);
+        auto const step_y = static_cast<uint32_t>((uint64_t{source_size.height.as_uint32_t()} << 16) / dest_height);
+        auto const scaled = source_size.width.as_int() != dest_width;
+
+        auto const offset_x = (area.left() - source.position.left()).as_int();
+        auto const start_x = static_cast<uint32_t>(offset_x * uint64_t{step_x} + step_x / 2);
+        auto const width = area.size.width.as_int();
+        auto const direct = !scaled && !swap && !opaque;
+        if (!direct)
+        {
+            scratch.resize(width);
+        }
+
+        for (auto y = area.top().as_int(); y != area.bottom().as_int(); ++y)
+        {
+            auto const offset_y = y - source.position.top().as_int();
+            auto const source_y = (offset_y * uint64_t{step_y} + step_y / 2) >> 16;
+            auto const row = reinterpret_cast<uint32_t const*>(data + source_y * source_stride);
+
+            uint32_t const* pixels = row + offset_x;
+            if (!direct)
+            {
+                if (scaled)
+                {
+                    kernels.scale(scratch.data(), row, width, start_x, step_x);
+                }
+                else
+                {
+                    std::memcpy(scratch.data(), row + offset_x, width * sizeof(uint32_t));
+                }
+                if (swap)
+                {
+                    kernels.swap_red_blue(scratch.data(), width);
+                }
+                if (opaque)
+                {
+                    kernels.make_opaque(scratch.data(), width);
+                }
+                pixels = scratch.data();
+            }
+
+            auto const dest = shadow + y * shadow_stride + area.left().as_int();
+            if (opaque && source.alpha == 255)
+            {
+                std::memcpy(dest, pixels, width * sizeof(uint32_t));
+            }
+            else
+            {
+                kernels.blend(dest, pixels, width, source.alpha);
+            }
+        }
+    }
+}
+}
+
+mrs::Renderer::Renderer(
+    mg::CPUAddressableDisplayAllocator& allocator,
+    std::shared_ptr<TileWorkers> workers,
+    Kernels const& kernels) :
+    allocator{allocator},
+    workers{std::move(workers)},
+    kernels{kernels},
+    format{choose_format(allocator)}
+{
+}
+
+mrs::Renderer::~Renderer()
+{
+    // Nobody else will complete captures that never got a frame
+    for (auto const& capture : pending_captures)
+    {
+        capture.done(false);
+    }
+}
+
+void mrs::Renderer::set_viewport(geom::Rectangle const& rect)
+{
+    if (rect != viewport)
+    {
+        viewport = rect;
+        everything_dirty = true;
+    }
+}
+
+void mrs::Renderer::set_output_transform(glm::mat2 const& transform)
+{
+    /*
+     * The transform maps GL's y-up coordinates; conjugating by a y flip gives the same
+     * rotation in the y-down coordinates of the shadow buffer and framebuffer. glm is
+     * column-major, so transform[column][row].
+     */
+    int const updated[2][2]{
+        {static_cast<int>(std::lround(transform[0][0])), -static_cast<int>(std::lround(transform[1][0]))},
+        {-static_cast<int>(std::lround(transform[0][1])), static_cast<int>(std::lround(transform[1][1]))}};
+
+    if (!std::equal(&updated[0][0], &updated[0][0] + 4, &orientation[0][0]))
+    {
+        std::copy(&updated[0][0], &updated[0][0] + 4, &orientation[0][0]);
+        everything_dirty = true;
+    }
+}
+
+auto mrs::Renderer::render(mg::RenderableList const& renderables) const -> std::unique_ptr<mg::Framebuffer>
+{
+    auto const size = shadow_size();
+    if (size != shadow_extents)
+    {
+        shadow_extents = size;
+        shadow.assign(size.width.as_uint32_t() * size.height.as_uint32_t(), clear_pixel);
+        tiles_across = (size.width.as_int() + tile_size - 1) / tile_size;
+        tiles_down = (size.height.as_int() + tile_size - 1) / tile_size;
+        dirty_tiles.assign(tiles_across * tiles_down, false);
+        everything_dirty = true;
+    }
+
+    // Anything outside the viewport is clipped, as glViewport() would
+    auto const content = to_shadow(viewport);
+
+    std::vector<Drawn> drawn;
+    std::vector<std::shared_ptr<mg::Renderable>> drawn_renderables;
+    for (auto const& renderable : renderables)
+    {
+        auto const position = to_shadow(renderable->screen_position());
+        auto visible = intersection_of(position, content);
+        if (auto const clip = renderable->clip_area())
+        {
+            visible = intersection_of(visible, to_shadow(*clip));
+        }
+        auto const buffer = renderable->buffer();
+        if (is_empty(visible) || !buffer || renderable->alpha() <= 0.0f)
+        {
+            continue;
+        }
+
+        drawn.push_back(Drawn{renderable->id(), buffer->id(), position, visible, renderable->alpha()});
+        drawn_renderables.push_back(renderable);
+    }
+
+    damage_changes(drawn);
+
+    std::vector<geom::Rectangle> tiles;
+    for (auto row = 0; row != tiles_down; ++row)
+    {
+        for (auto column = 0; column != tiles_across; ++column)
+        {
+            if (everything_dirty || dirty_tiles[row * tiles_across + column])
+            {
+                geom::Rectangle const tile{{column * tile_size, row * tile_size}, {tile_size, tile_size}};
+                tiles.push_back(intersection_of(tile, geom::Rectangle{{0, 0}, shadow_extents}));
+            }
+        }
+    }
+    std::fill(dirty_tiles.begin(), dirty_tiles.end(), false);
+    everything_dirty = false;
+
+    if (!tiles.empty())
+    {
+        // Only buffers that show in a redrawn tile need mapping
+        std::vector<Source> sources;
+        for (size_t i = 0; i != drawn.size(); ++i)
+        {
+            auto const& entry = drawn[i];
+            auto const needed = std::any_of(tiles.begin(), tiles.end(),
+                [&](auto const& tile) { return tile.overlaps(entry.visible); });
+            if (!needed)
+            {
+                continue;
+            }
+
+            try
+            {
+                auto mapping = mrs::as_read_mappable_buffer(drawn_renderables[i]->buffer())->map_readable();
+                if (!is_drawable(mapping->format()))
+                {
+                    BOOST_THROW_EXCEPTION((std::runtime_error{"Buffer format is not 32-bit RGB"}));
+                }
+                auto const alpha = std::clamp(std::lround(entry.alpha * 255.0f), 0l, 255l);
+                sources.push_back(Source{entry.position, entry.visible, static_cast<uint32_t>(alpha), std::move(mapping)});
+            }
+            catch (...)
+            {
+                if (!warned_undrawable)
+                {
+                    warned_undrawable = true;
+                    mir::log(
+                        mir::logging::Severity::warning,
+                        MIR_LOG_COMPONENT,
+                        std::current_exception(),
+                        "Skipping a buffer the software renderer can't draw");
+                }
+            }
+        }
+
+        try
+        {
+            auto const stride = shadow_extents.width.as_int();
+            workers->for_each(tiles.size(), [&](size_t i)
+                {
+                    draw_tile(kernels, shadow.data(), stride, tiles[i], sources);
+                });
+        }
+        catch (...)
+        {
+            // We don't know what was drawn, so start again from scratch next time
+            everything_dirty = true;
+            throw;
+        }
+    }
+
+    copy_to_captures();
+
+    return copy_to_framebuffer();
+}
+
+void mrs::Renderer::suspend()
+{
+}
+
+void mrs::Renderer::capture_next_frame(std::vector<FrameCapture>&& captures)
+{
+    std::move(captures.begin(), captures.end(), std::back_inserter(pending_captures));
+}
+
+auto mrs::Renderer::shadow_size() const -> geom::Size
+{
+    auto const output = allocator.output_size();
+    if (orientation[0][0] == 0)
+    {
+        return {output.height.as_int(), output.width.as_int()};
+    }
+    return output;
+}
+
+auto mrs::Renderer::to_shadow(geom::Rectangle const& rect) const -> geom::Rectangle
+{
+    // The viewport is scaled uniformly to fit the shadow buffer, and centred
+    auto const shadow_width = shadow_extents.width.as_int();
+    auto const shadow_height = shadow_extents.height.as_int();
+    auto const viewport_width = std::max(viewport.size.width.as_int(), 1);
+    auto const viewport_height = std::max(viewport.size.height.as_int(), 1);
+
+    auto const scale = std::min(
+        static_cast<double>(shadow_width) / viewport_width,
+        static_cast<double>(shadow_height) / viewport_height);
+    auto const offset_x = (shadow_width - viewport_width * scale) / 2;
+    auto const offset_y = (shadow_height - viewport_height * scale) / 2;
+
+    auto const map_x = [&](geom::X x) { return static_cast<int>(std::lround(offset_x + (x - viewport.left()).as_int() * scale)); };
+    auto const map_y = [&](geom::Y y) { return static_cast<int>(std::lround(offset_y + (y - viewport.top()).as_int() * scale)); };
+
+    auto const left = map_x(rect.left());
+    auto const top = map_y(rect.top());
+    return {{left, top}, {map_x(rect.right()) - left, map_y(rect.bottom()) - top}};
+}
+
+void mrs::Renderer::damage(geom::Rectangle const& rect) const
+{
+    auto const area = intersection_of(rect, geom::Rectangle{{0, 0}, shadow_extents});
+    if (is_empty(area))
+    {
+        return;
+    }
+
+    auto const first_column = area.left().as_int() / tile_size;
+    auto const last_column = (area.right().as_int() - 1) / tile_size;
+    auto const first_row = area.top().as_int() / tile_size;
+    auto const last_row = (area.bottom().as_int() - 1) / tile_size;
+    for (auto row = first_row; row <= last_row; ++row)
+    {
+        for (auto column = first_column; column <= last_column; ++column)
+        {
+            dirty_tiles[row * tiles_across + column] = true;
+        }
+    }
+}
+
+void mrs::Renderer::damage_changes(std::vector<Drawn> const& drawn) const
+{
+    auto const find = [](std::vector<Drawn> const& in, mg::Renderable::ID id)
+        {
+            return std::find_if(in.begin(), in.end(), [id](auto const& entry) { return entry.id == id; });
+        };
+
+    if (!everything_dirty)
+    {
+        // If renderables have been restacked, everything they cover may look different
+        std::vector<mg::Renderable::ID> order_now, order_before;
+        for (auto const& entry : drawn)
+        {
+            if (find(last_drawn, entry.id) != last_drawn.end())
+            {
+                order_now.push_back(entry.id);
+            }
+        }
+        for (auto const& entry : last_drawn)
+        {
+            if (find(drawn, entry.id) != drawn.end())
+            {
+                order_before.push_back(entry.id);
+            }
+        }
+
+        if (order_now != order_before)
+        {
+            for (auto const& entry : drawn)
+            {
+                damage(entry.visible);
+            }
+            for (auto const& entry : last_drawn)
+            {
+                damage(entry.visible);
+            }
+        }
+        else
+        {
+            for (auto const& entry : drawn)
+            {
+                auto const before = find(last_drawn, entry.id);
+                if (before == last_drawn.end())
+                {
+                    damage(entry.visible);
+                }
+                else if (!(*before == entry))
+                {
+                    damage(before->visible);
+                    damage(entry.visible);
+                }
+            }
+            for (auto const& entry : last_drawn)
+            {
+                if (find(drawn, entry.id) == drawn.end())
+                {
+                    damage(entry.visible);
+                }
+            }
+        }
+    }
+
+    last_drawn = drawn;
+}
+
+auto mrs::Renderer::copy_to_framebuffer() const -> std::unique_ptr<mg::Framebuffer>
+{
+    auto fb = allocator.alloc_fb(format);
+    {
+        auto const mapping = fb->map_writeable();
+        auto const data = mapping->data();
+        auto const stride = mapping->stride().as_int();
+        auto const width = mapping->size().width.as_int();
+        auto const height = mapping->size().height.as_int();
+        auto const swap = is_red_blue_swapped(format.as_mir_format().value_or(mir_pixel_format_invalid));
+
+        auto const shadow_width = shadow_extents.width.as_int();
+        auto const shadow_height = shadow_extents.height.as_int();
+        auto const identity = orientation[0][0] == 1 && orientation[1][1] == 1;
+        auto const& m = orientation;
+
+        workers->for_each(bands_of(height), [&](size_t band)
+            {
+                auto const first = static_cast<int>(band) * rows_per_band;
+                auto const last = std::min(first + rows_per_band, height);
+                for (auto y = first; y != last; ++y)
+                {
+                    auto const row = reinterpret_cast<uint32_t*>(data + y * stride);
+                    if (identity)
+                    {
+                        std::memcpy(row, shadow.data() + y * shadow_width, std::min(width, shadow_width) * sizeof(uint32_t));
+                    }
+                    else
+                    {
+                        /*
+                         * Work in doubled, centred coordinates so that pixel centres are integers;
+                         * the orientation is orthogonal, so its transpose maps back to the shadow.
+                         */
+                        auto const yc = 2 * y + 1 - height;
+                        auto xc = 1 - width;
+                        auto const sx = (m[0][0] * xc + m[1][0] * yc + shadow_width - 1) / 2;
+                        auto const sy = (m[0][1] * xc + m[1][1] * yc + shadow_height - 1) / 2;
+                        auto source = shadow.data() + sy * shadow_width + sx;
+                        auto const step = m[0][0] + m[0][1] * shadow_width;
+                        for (auto x = 0; x != width; ++x, source += step)
+                        {
+                            row[x] = *source;
+                        }
+                    }
+                    if (swap)
+                    {
+                        kernels.swap_red_blue(row, width);
+                    }
+                }
+            });
+    }
+    return fb;
+}
+
+void mrs::Renderer::copy_to_captures() const
+{
+    if (pending_captures.empty())
+    {
+        return;
+    }
+
+    auto const captures = std::exchange(pending_captures, {});
+
+    // As for the GL renderer, only an unrotated frame at one pixel per unit of viewport can be copied
+    auto const copyable = orientation[0][0] == 1 && orientation[1][1] == 1 && shadow_extents == viewport.size;
+
+    for (auto const& capture : captures)
+    {
+        bool copied = false;
+        if (copyable && capture.cpu_target && viewport.contains(capture.area) && capture.area.contains(capture.damage))
+        {
+            try
+            {
+                copied = read_into(capture);
+            }
+            catch (...)
+            {
+                mir::log(
+                    mir::logging::Severity::warning,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Failed to copy frame for capture");
+            }
+        }
+        capture.done(copied);
+    }
+}
+
+auto mrs::Renderer::read_into(FrameCapture const& capture) const -> bool
+{
+    auto const& target = *capture.cpu_target;
+    auto const target_format = target.format();
+    if (target.size() != capture.area.size ||
+        (target_format != mir_pixel_format_argb_8888 && target_format != mir_pixel_format_xrgb_8888) ||
+        target.stride().as_int() < capture.area.size.width.as_int() * 4)
+    {
+        return false;
+    }
+
+    auto const mapping = capture.cpu_target->map_writeable();
+    auto const stride = target.stride().as_int();
+    auto const shadow_width = shadow_extents.width.as_int();
+
+    // The target's rows run bottom to top, as GL's do (captures are flagged as y-inverted)
+    auto const damage_x = (capture.damage.left() - viewport.left()).as_int();
+    auto const target_x = (capture.damage.left() - capture.area.left()).as_int();
+    auto const width = capture.damage.size.width.as_int();
+    for (auto y = capture.damage.top(); y < capture.damage.bottom(); y += geom::DeltaY{1})
+    {
+        auto const shadow_row = (y - viewport.top()).as_int();
+        auto const target_row = (capture.area.bottom() - y).as_int() - 1;
+        std::memcpy(
+            mapping->data() + target_row * stride + target_x * 4,
+            shadow.data() + shadow_row * shadow_width + damage_x,
+            width * sizeof(uint32_t));
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_RENDERER_H_
+#define MIR_RENDERER_SOFTWARE_RENDERER_H_
+
+#include "kernels.h"
+
+#include <mir/renderer/renderer.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/drm_formats.h>
+#include <mir/graphics/renderable.h>
+
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics { class CPUAddressableDisplayAllocator; }
+namespace renderer
+{
+namespace software
+{
+class TileWorkers;
+
+/**
+ * Composites Renderables into CPU-addressable framebuffers without any GL
+ *
+ * The frame is built in a shadow buffer, a tile at a time, redrawing only tiles whose content
+ * changed since the previous frame; the finished frame is then copied (and, for rotated outputs,
+ * rotated) into a fresh framebuffer from the output's allocator.
+ *
+ * Only client buffers that can be mapped for reading (such as wl_shm buffers) in 32-bit RGB
+ * formats are drawn. Renderable transformations aren't supported; those renderables are drawn
+ * untransformed.
+ */
+class Renderer : public renderer::Renderer
+{
+public:
+    /// Frames are divided into tile_size × tile_size squares for damage tracking and drawing
+    static int constexpr tile_size = 64;
+
+    Renderer(
+        graphics::CPUAddressableDisplayAllocator& allocator,
+        std::shared_ptr<TileWorkers> workers,
+        Kernels const& kernels);
+    ~Renderer() override;
+
+    void set_viewport(geometry::Rectangle const& rect) override;
+    void set_output_transform(glm::mat2 const& transform) override;
+    auto render(graphics::RenderableList const& renderables) const -> std::unique_ptr<graphics::Framebuffer> override;
+    void suspend() override;
+    void capture_next_frame(std::vector<FrameCapture>&& captures) override;
+
+private:
+    /// What was drawn for a renderable, in shadow buffer coordinates
+    struct Drawn
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle position;
+        geometry::Rectangle visible;
+        float alpha;
+
+        auto operator==(Drawn const&) const -> bool = default;
+    };
+
+    /// Size of the shadow buffer for the current output size and orientation
+    auto shadow_size() const -> geometry::Size;
+    /// Maps a rectangle in viewport coordinates into the shadow buffer
+    auto to_shadow(geometry::Rectangle const& rect) const -> geometry::Rectangle;
+    /// Marks every tile \p rect touches as needing redrawing
+    void damage(geometry::Rectangle const& rect) const;
+    void damage_changes(std::vector<Drawn> const& drawn) const;
+    auto copy_to_framebuffer() const -> std::unique_ptr<graphics::Framebuffer>;
+    void copy_to_captures() const;
+    auto read_into(FrameCapture const& capture) const -> bool;
+
+    graphics::CPUAddressableDisplayAllocator& allocator;
+    std::shared_ptr<TileWorkers> const workers;
+    Kernels const& kernels;
+    graphics::DRMFormat const format;
+
+    geometry::Rectangle viewport;
+    /// The output transform, in y-down coordinates: entries are 0 or ±1
+    int orientation[2][2]{{1, 0}, {0, 1}};
+
+    std::vector<uint32_t> mutable shadow;
+    geometry::Size mutable shadow_extents;
+    int mutable tiles_across{0};
+    int mutable tiles_down{0};
+    std::vector<char> mutable dirty_tiles;
+    bool mutable everything_dirty{true};
+    bool mutable warned_undrawable{false};
+    std::vector<Drawn> mutable last_drawn;
+    std::vector<FrameCapture> mutable pending_captures;
+};
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_RENDERER_H_
@@ -0,0 +1,68 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include "renderer_factory.h"
+#include "renderer.h"
+#include "kernels.h"
+#include "tile_workers.h"
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/platform.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+
+namespace
+{
+/// Beyond this, extra threads mostly contend for memory bandwidth
+unsigned const max_helpers = 7;
+
+auto helper_count() -> unsigned
+{
+    auto const cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::min(cpus - 1, max_helpers);
+}
+}
+
+mrs::RendererFactory::RendererFactory() :
+    kernels{best_kernels()},
+    workers{std::make_shared<TileWorkers>(helper_count())}
+{
+    mir::log_info("Software renderer using %s kernels and %u helper threads", kernels.name, helper_count());
+}
+
+mrs::RendererFactory::~RendererFactory() = default;
+
+auto mrs::RendererFactory::create_renderer_for(mg::DisplaySink& sink) const -> std::unique_ptr<renderer::Renderer>
+{
+    auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>();
+    if (!allocator)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Output does not support CPU-addressable framebuffers"}));
+    }
+
+    auto renderer = std::make_unique<Renderer>(*allocator, workers, kernels);
+    renderer->set_viewport(sink.view_area());
+    return renderer;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_RENDERER_FACTORY_H_
+#define MIR_RENDERER_SOFTWARE_RENDERER_FACTORY_H_
+
+#include "mir/renderer/renderer.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class DisplaySink;
+}
+namespace renderer
+{
+namespace software
+{
+struct Kernels;
+class TileWorkers;
+
+/**
+ * Creates software renderers for outputs that can be drawn to by the CPU
+ *
+ * The renderers share one pool of tile-drawing threads and the fastest pixel kernels the
+ * CPU supports.
+ */
+class RendererFactory
+{
+public:
+    RendererFactory();
+    ~RendererFactory();
+
+    /// \throws std::runtime_error if \p sink can't provide CPU-addressable framebuffers
+    auto create_renderer_for(graphics::DisplaySink& sink) const -> std::unique_ptr<renderer::Renderer>;
+
+private:
+    Kernels const& kernels;
+    std::shared_ptr<TileWorkers> const workers;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_RENDERER_FACTORY_H_
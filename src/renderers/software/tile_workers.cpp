@@ -0,0 +1,136 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tile_workers.h"
+#include "mir/thread_name.h"
+
+#include <utility>
+
+namespace mrs = mir::renderer::software;
+
+mrs::TileWorkers::TileWorkers(unsigned helper_count)
+{
+    helpers.reserve(helper_count);
+    for (unsigned i = 0; i != helper_count; ++i)
+    {
+        helpers.emplace_back([this]() { run_helper(); });
+    }
+}
+
+mrs::TileWorkers::~TileWorkers()
+{
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    batch_started.notify_all();
+    for (auto& helper : helpers)
+    {
+        helper.join();
+    }
+}
+
+void mrs::TileWorkers::for_each(size_t count, std::function<void(size_t)> const& work)
+{
+    std::unique_lock use{in_use, std::try_to_lock};
+    if (helpers.empty() || count < 2 || !use.owns_lock())
+    {
+        for (size_t i = 0; i != count; ++i)
+        {
+            work(i);
+        }
+        return;
+    }
+
+    Batch const this_batch{&work, count};
+    {
+        std::lock_guard lock{mutex};
+        batch = this_batch;
+        next_index = 0;
+        failure = nullptr;
+        ++generation;
+    }
+    batch_started.notify_all();
+
+    drain(this_batch);
+
+    std::unique_lock lock{mutex};
+    helper_finished.wait(lock, [this]() { return busy_helpers == 0; });
+    batch = {nullptr, 0};
+    if (auto const error = std::exchange(failure, nullptr))
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void mrs::TileWorkers::run_helper()
+{
+    mir::set_thread_name("Mir/SwRender");
+
+    unsigned long seen_generation{0};
+    std::unique_lock lock{mutex};
+    for (;;)
+    {
+        batch_started.wait(lock, [&]() { return stopping || generation != seen_generation; });
+        if (stopping)
+        {
+            return;
+        }
+        seen_generation = generation;
+        if (!batch.work)
+        {
+            // We woke too late; that batch has already been finished without us
+            continue;
+        }
+
+        auto const current = batch;
+        ++busy_helpers;
+        lock.unlock();
+        drain(current);
+        lock.lock();
+        --busy_helpers;
+        helper_finished.notify_all();
+    }
+}
+
+void mrs::TileWorkers::drain(Batch current)
+{
+    for (;;)
+    {
+        size_t index;
+        {
+            std::lock_guard lock{mutex};
+            if (next_index >= current.count || failure)
+            {
+                return;
+            }
+            index = next_index++;
+        }
+
+        try
+        {
+            (*current.work)(index);
+        }
+        catch (...)
+        {
+            std::lock_guard lock{mutex};
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_TILE_WORKERS_H_
+#define MIR_RENDERER_SOFTWARE_TILE_WORKERS_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+/**
+ * A small pool of threads for drawing the tiles of a frame in parallel
+ *
+ * One pool is shared by all the software renderers; a renderer that finds the pool busy with
+ * another output's frame draws its own tiles on the calling thread rather than waiting.
+ */
+class TileWorkers
+{
+public:
+    /// \param helpers  Number of threads to start, in addition to the thread calling for_each()
+    explicit TileWorkers(unsigned helpers);
+    ~TileWorkers();
+
+    /// Calls work(i) for each i in [0, count), returning once all calls have; rethrows the first exception
+    void for_each(size_t count, std::function<void(size_t)> const& work);
+
+private:
+    TileWorkers(TileWorkers const&) = delete;
+    TileWorkers& operator=(TileWorkers const&) = delete;
+
+    struct Batch
+    {
+        std::function<void(size_t)> const* work;
+        size_t count;
+    };
+
+    void run_helper();
+    void drain(Batch batch);
+
+    /// Held for the whole of a for_each() that uses the helpers
+    std::mutex in_use;
+
+    std::mutex mutex;
+    std::condition_variable batch_started;
+    std::condition_variable helper_finished;
+    Batch batch{nullptr, 0};
+    size_t next_index{0};
+    unsigned long generation{0};
+    unsigned busy_helpers{0};
+    std::exception_ptr failure;
+    bool stopping{false};
+
+    std::vector<std::thread> helpers;
+};
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_TILE_WORKERS_H_
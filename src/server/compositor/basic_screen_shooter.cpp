@@ -28,12 +28,74 @@
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/display_sink.h"
 
+#include <future>
+
 namespace mc = mir::compositor;
 namespace mr = mir::renderer;
 namespace mg = mir::graphics;
 namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
+using namespace std::chrono_literals;
+
+namespace
+{
+/* How long to wait for the compositor to draw a frame we can copy before rendering our own.
+ * This is a few frames at any reasonable refresh rate; if it passes the output is most likely
+ * being scanned out directly, or is switched off.
+ */
+auto const composited_frame_timeout = 100ms;
+}
+
+class mc::BasicScreenShooter::Self::ScratchBuffer : public mrs::WriteMappableBuffer
+{
+public:
+    ScratchBuffer(geom::Size size)
+        : size_{size},
+          pixels(size.width.as_uint32_t() * size.height.as_uint32_t() * 4)
+    {
+    }
+
+    auto map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        class Mapping : public mrs::Mapping<unsigned char>
+        {
+        public:
+            Mapping(ScratchBuffer& buffer)
+                : buffer{buffer}
+            {
+            }
+
+            auto format() const -> MirPixelFormat override { return buffer.format(); }
+            auto stride() const -> geom::Stride override { return buffer.stride(); }
+            auto size() const -> geom::Size override { return buffer.size(); }
+            auto data() -> unsigned char* override { return buffer.pixels.data(); }
+            auto len() const -> size_t override { return buffer.pixels.size(); }
+
+        private:
+            ScratchBuffer& buffer;
+        };
+        return std::make_unique<Mapping>(*this);
+    }
+
+    auto format() const -> MirPixelFormat override
+    {
+        return mir_pixel_format_argb_8888;
+    }
+    auto stride() const -> geom::Stride override
+    {
+        return geom::Stride{size_.width.as_uint32_t() * 4};
+    }
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+private:
+    geom::Size const size_;
+    std::vector<unsigned char> pixels;
+};
+
 class mc::BasicScreenShooter::Self::OneShotBufferDisplayProvider : public mg::CPUAddressableDisplayAllocator
 {
 public:
@@ -155,16 +217,51 @@ mc::BasicScreenShooter::Self::Self(
     std::shared_ptr<Scene> const& scene,
     std::shared_ptr<time::Clock> const& clock,
     std::shared_ptr<mg::GLRenderingProvider> render_provider,
-    std::shared_ptr<mr::RendererFactory> renderer_factory)
+    std::shared_ptr<mr::RendererFactory> renderer_factory,
+    std::shared_ptr<CaptureQueue> capture_queue)
     : scene{scene},
       clock{clock},
       render_provider{std::move(render_provider)},
       renderer_factory{std::move(renderer_factory)},
+      capture_queue{std::move(capture_queue)},
       last_rendered_size{0, 0},
       output{std::make_shared<OneShotBufferDisplayProvider>()}
 {
 }
 
+auto mc::BasicScreenShooter::Self::capture_composited(
+    geom::Rectangle const& area,
+    geom::Rectangle const& damage,
+    std::shared_ptr<mrs::WriteMappableBuffer> const& cpu_target,
+    std::shared_ptr<mg::Buffer> const& gpu_target) -> std::optional<time::Timestamp>
+{
+    if (!capture_queue->is_composited(area))
+    {
+        return std::nullopt;
+    }
+
+    auto const result = std::make_shared<std::promise<std::optional<time::Timestamp>>>();
+    auto copied = result->get_future();
+    auto const capture = std::make_shared<CaptureQueue::Capture>(CaptureQueue::Capture{
+        area,
+        damage,
+        cpu_target,
+        gpu_target,
+        [result, clock=clock](bool success)
+        {
+            result->set_value(success ? std::make_optional(clock->now()) : std::nullopt);
+        }});
+
+    capture_queue->enqueue(capture);
+
+    if (copied.wait_for(composited_frame_timeout) != std::future_status::ready && capture_queue->withdraw(capture))
+    {
+        return std::nullopt;
+    }
+    // Either it's done, or a compositor has taken it and is about to be
+    return copied.get();
+}
+
 auto mc::BasicScreenShooter::Self::render(
     std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
     geom::Rectangle const& area) -> time::Timestamp
@@ -194,6 +291,46 @@ auto mc::BasicScreenShooter::Self::render(
     return captured_time;
 }
 
+auto mc::BasicScreenShooter::Self::render_to_gpu_buffer(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    geom::Rectangle const& area) -> time::Timestamp
+{
+    std::lock_guard lock{mutex};
+
+    auto scene_elements = scene->scene_elements_for(this);
+    auto const captured_time = clock->now();
+    mg::RenderableList renderable_list;
+    renderable_list.reserve(scene_elements.size());
+    for (auto const& element : scene_elements)
+    {
+        renderable_list.push_back(element->renderable());
+    }
+    scene_elements.clear();
+
+    /* The offscreen renderer always draws into CPU memory, so give it somewhere to draw
+     * and have it copy the frame into the target on the GPU as it goes.
+     */
+    if (!gpu_scratch || gpu_scratch->size() != area.size)
+    {
+        gpu_scratch = std::make_shared<ScratchBuffer>(area.size);
+    }
+    auto& renderer = renderer_for_buffer(gpu_scratch);
+    renderer.set_viewport(area);
+
+    bool copied{false};
+    std::vector<mr::Renderer::FrameCapture> captures;
+    captures.push_back({area, area, nullptr, buffer, [&copied](bool success) { copied = success; }});
+    renderer.capture_next_frame(std::move(captures));
+    renderer.render(renderable_list);
+    renderer.suspend();
+
+    if (!copied)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to copy capture into GPU buffer"}));
+    }
+    return captured_time;
+}
+
 auto mc::BasicScreenShooter::Self::renderer_for_buffer(std::shared_ptr<mrs::WriteMappableBuffer> buffer)
     -> mr::Renderer&
 {
@@ -254,8 +391,14 @@ mc::BasicScreenShooter::BasicScreenShooter(
     std::shared_ptr<time::Clock> const& clock,
     Executor& executor,
     std::span<std::shared_ptr<mg::GLRenderingProvider>> const& providers,
-    std::shared_ptr<mr::RendererFactory> render_factory)
-    : self{std::make_shared<Self>(scene, clock, select_provider(providers), std::move(render_factory))},
+    std::shared_ptr<mr::RendererFactory> render_factory,
+    std::shared_ptr<CaptureQueue> capture_queue)
+    : self{std::make_shared<Self>(
+          scene,
+          clock,
+          select_provider(providers),
+          std::move(render_factory),
+          std::move(capture_queue))},
       executor{executor}
 {
 }
@@ -264,15 +407,30 @@ void mc::BasicScreenShooter::capture(
     std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
     geom::Rectangle const& area,
     std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    capture(buffer, area, area, std::move(callback));
+}
+
+void mc::BasicScreenShooter::capture(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    geom::Rectangle const& area,
+    geom::Rectangle const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
 {
     // TODO: use an atomic to keep track of number of in-flight captures, and error if it's too many
 
-    executor.spawn([weak_self=std::weak_ptr{self}, buffer, area, callback=std::move(callback)]
+    executor.spawn([weak_self=std::weak_ptr{self}, buffer, area, damage, callback=std::move(callback)]
         {
             if (auto const self = weak_self.lock())
             {
                 try
                 {
+                    if (auto const captured = self->capture_composited(area, damage, buffer, nullptr))
+                    {
+                        callback(captured);
+                        return;
+                    }
+                    // Rendering ourselves redraws all of area, so the damage doesn't help here
                     callback(self->render(buffer, area));
                     return;
                 }
@@ -289,3 +447,36 @@ void mc::BasicScreenShooter::capture(
             callback(std::nullopt);
         });
 }
+
+void mc::BasicScreenShooter::capture_to_gpu_buffer(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    geom::Rectangle const& area,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    executor.spawn([weak_self=std::weak_ptr{self}, buffer, area, callback=std::move(callback)]
+        {
+            if (auto const self = weak_self.lock())
+            {
+                try
+                {
+                    if (auto const captured = self->capture_composited(area, area, nullptr, buffer))
+                    {
+                        callback(captured);
+                        return;
+                    }
+                    callback(self->render_to_gpu_buffer(buffer, area));
+                    return;
+                }
+                catch (...)
+                {
+                    mir::log(
+                        ::mir::logging::Severity::error,
+                        "BasicScreenShooter",
+                        std::current_exception(),
+                        "failed to capture screen to GPU buffer");
+                }
+            }
+
+            callback(std::nullopt);
+        });
+}
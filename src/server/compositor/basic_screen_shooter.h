@@ -18,6 +18,7 @@
 #define MIR_COMPOSITOR_BASIC_SCREEN_SHOOTER_H_
 
 #include "mir/compositor/screen_shooter.h"
+#include "capture_queue.h"
 #include "mir/graphics/platform.h"
 #include "mir/renderer/renderer_factory.h"
 #include "mir/renderer/sw/pixel_source.h"
@@ -45,28 +46,53 @@ public:
         std::shared_ptr<time::Clock> const& clock,
         Executor& executor,
         std::span<std::shared_ptr<graphics::GLRenderingProvider>> const& providers,
-        std::shared_ptr<renderer::RendererFactory> render_factory);
+        std::shared_ptr<renderer::RendererFactory> render_factory,
+        std::shared_ptr<CaptureQueue> capture_queue);
 
     void capture(
         std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
         geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) override;
 
+    void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    void capture_to_gpu_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
 private:
     struct Self
     {
         class OneShotBufferDisplayProvider;
+        class ScratchBuffer;
 
         Self(
             std::shared_ptr<Scene> const& scene,
             std::shared_ptr<time::Clock> const& clock,
             std::shared_ptr<graphics::GLRenderingProvider> provider,
-            std::shared_ptr<renderer::RendererFactory> render_factory);
+            std::shared_ptr<renderer::RendererFactory> render_factory,
+            std::shared_ptr<CaptureQueue> capture_queue);
+
+        /// Copies from the next frame the compositor draws, if it draws all of \p area in time
+        auto capture_composited(
+            geometry::Rectangle const& area,
+            geometry::Rectangle const& damage,
+            std::shared_ptr<renderer::software::WriteMappableBuffer> const& cpu_target,
+            std::shared_ptr<graphics::Buffer> const& gpu_target) -> std::optional<time::Timestamp>;
 
         auto render(
             std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
             geometry::Rectangle const& area) -> time::Timestamp;
 
+        auto render_to_gpu_buffer(
+            std::shared_ptr<graphics::Buffer> const& buffer,
+            geometry::Rectangle const& area) -> time::Timestamp;
+
         auto renderer_for_buffer(std::shared_ptr<renderer::software::WriteMappableBuffer> buffer)
             -> renderer::Renderer&;
 
@@ -75,6 +101,7 @@ private:
         std::shared_ptr<time::Clock> const clock;
         std::shared_ptr<graphics::GLRenderingProvider> const render_provider;
         std::shared_ptr<renderer::RendererFactory> const renderer_factory;
+        std::shared_ptr<CaptureQueue> const capture_queue;
 
         /* The Renderer instantiation is tied to a particular output size, and
          * requires enough setup to make it worth keeping around as a consumer
@@ -85,6 +112,9 @@ private:
 
         std::unique_ptr<graphics::DisplaySink> offscreen_sink;
         std::shared_ptr<OneShotBufferDisplayProvider> const output;
+
+        /// Somewhere for the offscreen renderer to draw when the real target is a GPU buffer
+        std::shared_ptr<ScratchBuffer> gpu_scratch;
     };
     std::shared_ptr<Self> const self;
     Executor& executor;
@@ -0,0 +1,84 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "capture_queue.h"
+#include "mir/graphics/display_sink.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+mc::CaptureQueue::CaptureQueue(std::function<void()> schedule_compositing)
+    : schedule_compositing{std::move(schedule_compositing)}
+{
+}
+
+void mc::CaptureQueue::add_output(mg::DisplaySink& sink)
+{
+    std::lock_guard lock{mutex};
+    outputs.push_back(&sink);
+}
+
+void mc::CaptureQueue::remove_output(mg::DisplaySink& sink)
+{
+    std::lock_guard lock{mutex};
+    std::erase(outputs, &sink);
+}
+
+auto mc::CaptureQueue::is_composited(geom::Rectangle const& area) const -> bool
+{
+    std::lock_guard lock{mutex};
+    return std::any_of(
+        outputs.begin(), outputs.end(),
+        [&area](mg::DisplaySink* sink) { return sink->view_area().contains(area); });
+}
+
+void mc::CaptureQueue::enqueue(std::shared_ptr<Capture> const& capture)
+{
+    {
+        std::lock_guard lock{mutex};
+        pending.push_back(capture);
+    }
+    schedule_compositing();
+}
+
+auto mc::CaptureQueue::withdraw(std::shared_ptr<Capture> const& capture) -> bool
+{
+    std::lock_guard lock{mutex};
+    return std::erase(pending, capture) > 0;
+}
+
+auto mc::CaptureQueue::take_within(geom::Rectangle const& view_area) -> std::vector<Capture>
+{
+    std::vector<Capture> taken;
+
+    std::lock_guard lock{mutex};
+    std::erase_if(
+        pending,
+        [&](std::shared_ptr<Capture> const& capture)
+        {
+            if (!view_area.contains(capture->area))
+            {
+                return false;
+            }
+            taken.push_back(std::move(*capture));
+            return true;
+        });
+
+    return taken;
+}
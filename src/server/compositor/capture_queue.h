@@ -0,0 +1,75 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_CAPTURE_QUEUE_H_
+#define MIR_COMPOSITOR_CAPTURE_QUEUE_H_
+
+#include "mir/renderer/renderer.h"
+#include "mir/geometry/rectangle.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class DisplaySink;
+}
+namespace compositor
+{
+
+/**
+ * Screen captures waiting to be copied from the next frame the compositor draws
+ *
+ * This lets a capture share the compositor's work instead of rendering the scene again.
+ */
+class CaptureQueue
+{
+public:
+    using Capture = renderer::Renderer::FrameCapture;
+
+    /// \param schedule_compositing  called when a capture is enqueued, so an idle compositor draws a frame for it
+    explicit CaptureQueue(std::function<void()> schedule_compositing);
+
+    /// Outputs are registered while they are being composited
+    void add_output(graphics::DisplaySink& sink);
+    void remove_output(graphics::DisplaySink& sink);
+
+    /// Whether a single output being composited covers all of \p area
+    auto is_composited(geometry::Rectangle const& area) const -> bool;
+
+    void enqueue(std::shared_ptr<Capture> const& capture);
+
+    /// Removes \p capture if no compositor has taken it yet, and returns whether it did
+    auto withdraw(std::shared_ptr<Capture> const& capture) -> bool;
+
+    /// Takes the waiting captures that lie entirely within \p view_area
+    auto take_within(geometry::Rectangle const& view_area) -> std::vector<Capture>;
+
+private:
+    std::function<void()> const schedule_compositing;
+
+    std::mutex mutable mutex;
+    std::vector<graphics::DisplaySink*> outputs;
+    std::vector<std::shared_ptr<Capture>> pending;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_CAPTURE_QUEUE_H_
@@ -19,11 +19,15 @@
 #include "mir/log.h"
 #include "mir/shell/shell.h"
 #include "default_display_buffer_compositor_factory.h"
+#include "software_display_buffer_compositor_factory.h"
 #include "mir/executor.h"
 #include "multi_threaded_compositor.h"
 #include "gl/renderer_factory.h"
+#include "software/renderer_factory.h"
 #include "basic_screen_shooter.h"
 #include "null_screen_shooter.h"
+#include "capture_queue.h"
+#include "output_mirroring.h"
 #include "mir/main_loop.h"
 #include "mir/graphics/platform.h"
 #include "mir/options/configuration.h"
@@ -38,6 +42,21 @@ mir::DefaultServerConfiguration::the_display_buffer_compositor_factory()
     return display_buffer_compositor_factory(
         [this]()
         {
+            auto const software_factory = [this]()
+                {
+                    return wrap_display_buffer_compositor_factory(
+                        std::make_shared<mc::SoftwareDisplayBufferCompositorFactory>(
+                            std::make_shared<mir::renderer::software::RendererFactory>(),
+                            the_compositor_report(),
+                            the_capture_queue(),
+                            the_output_mirroring()));
+                };
+
+            if (the_options()->get<std::string>(options::renderer_opt) == "software")
+            {
+                return software_factory();
+            }
+
             std::vector<std::shared_ptr<mg::GLRenderingProvider>> providers;
             providers.reserve(the_rendering_platforms().size());
             for (auto const& platform : the_rendering_platforms())
@@ -49,11 +68,18 @@ mir::DefaultServerConfiguration::the_display_buffer_compositor_factory()
             }
             if (providers.empty())
             {
-                BOOST_THROW_EXCEPTION((std::runtime_error{"Selected rendering platform does not support GL"}));
+                mir::log_info("Selected rendering platform does not support GL; compositing in software");
+                return software_factory();
             }
             return wrap_display_buffer_compositor_factory(
                 std::make_shared<mc::DefaultDisplayBufferCompositorFactory>(
-                    std::move(providers), the_gl_config(), the_renderer_factory(), the_buffer_allocator(), the_compositor_report()));
+                    std::move(providers),
+                    the_gl_config(),
+                    the_renderer_factory(),
+                    the_buffer_allocator(),
+                    the_compositor_report(),
+                    the_capture_queue(),
+                    the_output_mirroring()));
         });
 }
 
@@ -93,6 +119,28 @@ std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration:
         });
 }
 
+auto mir::DefaultServerConfiguration::the_capture_queue() -> std::shared_ptr<compositor::CaptureQueue>
+{
+    return capture_queue(
+        [this]()
+        {
+            // Captures are only enqueued while outputs are being composited, so the compositor exists by then
+            return std::make_shared<compositor::CaptureQueue>([this]() { the_compositor()->schedule_compositing(); });
+        });
+}
+
+auto mir::DefaultServerConfiguration::the_output_mirroring() -> std::shared_ptr<compositor::OutputMirroring>
+{
+    return output_mirroring(
+        [this]()
+        {
+            // Frames are only published while outputs are being composited, so the compositor exists by then
+            return std::make_shared<compositor::OutputMirroring>(
+                [this]() { the_compositor()->schedule_compositing(); },
+                the_buffer_allocator());
+        });
+}
+
 auto mir::DefaultServerConfiguration::the_screen_shooter() -> std::shared_ptr<compositor::ScreenShooter>
 {
     return screen_shooter(
@@ -118,7 +166,8 @@ auto mir::DefaultServerConfiguration::the_screen_shooter() -> std::shared_ptr<co
                     the_clock(),
                     thread_pool_executor,
                     providers,
-                    the_renderer_factory());
+                    the_renderer_factory(),
+                    the_capture_queue());
             }
             catch (...)
             {
@@ -24,22 +24,123 @@
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/platform.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/renderer/renderer.h"
+#include "capture_queue.h"
+#include "output_mirroring.h"
 #include "occlusion.h"
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Beyond this many damaged areas we report their bounding rectangle instead
+auto constexpr max_damage_rects = 16u;
+
+/// A frame drawn for another output showing the same area
+class MirroredFrame : public mg::Renderable
+{
+public:
+    MirroredFrame(std::shared_ptr<mg::Buffer> frame, geom::Rectangle const& area)
+        : frame{std::move(frame)},
+          area{area}
+    {
+    }
+
+    auto id() const -> mg::Renderable::ID override
+    {
+        return frame.get();
+    }
+
+    auto buffer() const -> std::shared_ptr<mg::Buffer> override
+    {
+        return frame;
+    }
+
+    auto screen_position() const -> geom::Rectangle override
+    {
+        return area;
+    }
+
+    auto clip_area() const -> std::optional<geom::Rectangle> override
+    {
+        return {};
+    }
+
+    auto alpha() const -> float override
+    {
+        return 1.0f;
+    }
+
+    auto transformation() const -> glm::mat4 override
+    {
+        // Copied frames have their rows bottom to top, as GL does
+        return glm::mat4{
+            1.0, 0.0, 0.0, 0.0,
+            0.0, -1.0, 0.0, 0.0,
+            0.0, 0.0, 1.0, 0.0,
+            0.0, 0.0, 0.0, 1.0};
+    }
+
+    auto shaped() const -> bool override
+    {
+        return false;
+    }
+
+    auto surface_if_any() const -> std::optional<mir::scene::Surface const*> override
+    {
+        return std::nullopt;
+    }
+
+private:
+    std::shared_ptr<mg::Buffer> const frame;
+    geom::Rectangle const area;
+};
+}
 
 mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplaySink& display_sink,
     graphics::GLRenderingProvider& gl_provider,
     std::shared_ptr<mir::renderer::Renderer> const& renderer,
-    std::shared_ptr<CompositorReport> const& report) :
+    std::shared_ptr<CompositorReport> const& report,
+    std::shared_ptr<CaptureQueue> const& capture_queue,
+    std::shared_ptr<OutputMirroring> const& mirroring) :
+    DefaultDisplayBufferCompositor(
+        display_sink,
+        gl_provider.make_framebuffer_provider(display_sink),
+        renderer,
+        report,
+        capture_queue,
+        mirroring)
+{
+}
+
+mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
+    mg::DisplaySink& display_sink,
+    std::unique_ptr<mg::RenderingProvider::FramebufferProvider> fb_adaptor,
+    std::shared_ptr<mir::renderer::Renderer> const& renderer,
+    std::shared_ptr<CompositorReport> const& report,
+    std::shared_ptr<CaptureQueue> const& capture_queue,
+    std::shared_ptr<OutputMirroring> const& mirroring) :
     display_sink(display_sink),
     renderer(renderer),
-    fb_adaptor{gl_provider.make_framebuffer_provider(display_sink)},
-    report(report)
+    fb_adaptor{std::move(fb_adaptor)},
+    report(report),
+    capture_queue(capture_queue),
+    mirroring(mirroring)
+{
+    capture_queue->add_output(display_sink);
+    mirroring->add_output(display_sink);
+}
+
+mc::DefaultDisplayBufferCompositor::~DefaultDisplayBufferCompositor()
 {
+    mirroring->remove_output(display_sink);
+    capture_queue->remove_output(display_sink);
 }
 
 bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& scene_elements)
@@ -48,10 +149,12 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
         return false;
 
     completed_first_render = true;
-    report->began_frame(this);
 
     auto const& view_area = display_sink.view_area();
+
+    report->began_stage(this, CompositorReport::FrameStage::occlusion);
     auto const& occlusions = mc::filter_occlusions_from(scene_elements, view_area);
+    report->finished_stage(this, CompositorReport::FrameStage::occlusion);
 
     for (auto const& element : occlusions)
         element->occluded();
@@ -74,11 +177,47 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
+    // An output mirroring another draws the frame that one drew, rather than the whole scene again
+    auto const mirrored = mirroring->mirrored_frame(display_sink);
+    if (mirrored)
+    {
+        renderable_list = {std::make_shared<MirroredFrame>(mirrored->buffer, view_area)};
+    }
+
+    /*
+     * Waking the compositor means something changed somewhere, not necessarily on this output.
+     * If nothing visible here differs from what we last presented there's no need to render
+     * or post again.
+     */
+    auto const output_transformation = display_sink.transformation();
+    auto signature = signature_of(renderable_list, view_area, output_transformation);
+    if (mirrored)
+    {
+        signature.mirrored_publication = mirrored->publication;
+    }
+
+    // Screen captures waiting on this output are copied from the frame we draw, so they need one drawing
+    auto captures = capture_queue->take_within(view_area);
+
+    if (signature == last_presented && captures.empty())
+    {
+        return false;
+    }
+    auto const damage = last_presented ? damage_between(*last_presented, signature) : std::vector<geom::Rectangle>{};
+    last_presented = std::move(signature);
+
+    report->began_frame(this);
+
     std::vector<mg::DisplayElement> framebuffers;
     framebuffers.reserve(renderable_list.size());
 
     for (auto const& renderable : renderable_list)
     {
+        // A DisplayElement has no way to say how to blend or transform its buffer
+        if (renderable->alpha() < 1.0f || renderable->transformation() != glm::mat4{1})
+        {
+            break;
+        }
         auto fb = fb_adaptor->buffer_to_framebuffer(renderable->buffer());
         if (!fb)
         {
@@ -104,21 +243,42 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
         framebuffers.emplace_back(mg::DisplayElement{
             renderable->screen_position(),
             geometry::RectangleF{source_origin, source_size},
-            std::move(fb)
+            std::move(fb),
+            renderable->tearing_allowed()
         });
     }
 
-    if (framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
+    if (captures.empty() && framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
     {
+        // Outputs mirroring this one can't copy a frame we didn't draw
+        mirroring->withdraw_frame(display_sink);
+
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
     }
     else
     {
-        renderer->set_output_transform(display_sink.transformation());
+        renderer->set_output_transform(output_transformation);
         renderer->set_viewport(view_area);
 
-        display_sink.set_next_image(renderer->render(renderable_list));
+        if (auto mirror_capture = mirroring->capture_for(display_sink))
+        {
+            captures.push_back(std::move(*mirror_capture));
+        }
+
+        if (!captures.empty())
+        {
+            renderer->capture_next_frame(std::move(captures));
+        }
+
+        report->began_stage(this, CompositorReport::FrameStage::render);
+        auto frame = renderer->render(renderable_list);
+        report->finished_stage(this, CompositorReport::FrameStage::render);
+
+        report->began_stage(this, CompositorReport::FrameStage::commit);
+        display_sink.set_next_image(std::move(frame));
+        display_sink.set_next_image_damage(damage);
+        report->finished_stage(this, CompositorReport::FrameStage::commit);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
@@ -140,3 +300,117 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->finished_frame(this);
     return true;
 }
+
+auto mc::DefaultDisplayBufferCompositor::signature_of(
+    mg::RenderableList const& renderables,
+    geometry::Rectangle const& view_area,
+    glm::mat2 const& output_transformation) -> FrameSignature
+{
+    FrameSignature signature{view_area, output_transformation, {}, std::nullopt};
+    signature.renderables.reserve(renderables.size());
+
+    for (auto const& renderable : renderables)
+    {
+        auto const buffer = renderable->buffer();
+        signature.renderables.push_back(RenderableState{
+            renderable->id(),
+            buffer ? buffer->id() : mg::BufferID{},
+            renderable->screen_position(),
+            renderable->clip_area(),
+            renderable->alpha(),
+            renderable->transformation(),
+            renderable->shaped()});
+    }
+
+    return signature;
+}
+
+auto mc::DefaultDisplayBufferCompositor::damage_between(
+    FrameSignature const& previous,
+    FrameSignature const& next) -> std::vector<geom::Rectangle>
+{
+    // Damage is in view_area coordinates, which only map simply onto the image without an output transform.
+    // A newly mirrored frame can differ anywhere, even when drawn into the same buffer as the last.
+    if (previous.view_area != next.view_area ||
+        previous.output_transformation != next.output_transformation ||
+        previous.mirrored_publication != next.mirrored_publication ||
+        next.output_transformation != glm::mat2{1})
+    {
+        return {};
+    }
+
+    auto const find_id = [](std::vector<RenderableState> const& states, mg::Renderable::ID id)
+        {
+            return std::find_if(states.begin(), states.end(), [id](auto const& state) { return state.id == id; });
+        };
+
+    // Restacking renderables that are otherwise unchanged still changes what's on top
+    std::vector<mg::Renderable::ID> previous_order;
+    for (auto const& state : previous.renderables)
+    {
+        if (find_id(next.renderables, state.id) != next.renderables.end())
+            previous_order.push_back(state.id);
+    }
+    std::vector<mg::Renderable::ID> next_order;
+    for (auto const& state : next.renderables)
+    {
+        if (find_id(previous.renderables, state.id) != previous.renderables.end())
+            next_order.push_back(state.id);
+    }
+    if (previous_order != next_order)
+    {
+        return {};
+    }
+
+    geom::Rectangles damage;
+    bool bounded = true;
+    auto const add_damage = [&](RenderableState const& state)
+        {
+            // A transformed renderable can be drawn outside its screen position
+            if (state.transformation != glm::mat4{1})
+            {
+                bounded = false;
+                return;
+            }
+            auto area = intersection_of(state.screen_position, next.view_area);
+            if (state.clip_area)
+            {
+                area = intersection_of(area, *state.clip_area);
+            }
+            if (area.size != geom::Size{})
+            {
+                damage.add(area);
+            }
+        };
+
+    for (auto const& state : next.renderables)
+    {
+        auto const before = find_id(previous.renderables, state.id);
+        if (before == previous.renderables.end())
+        {
+            add_damage(state);
+        }
+        else if (!(*before == state))
+        {
+            add_damage(*before);
+            add_damage(state);
+        }
+    }
+    for (auto const& state : previous.renderables)
+    {
+        if (find_id(next.renderables, state.id) == next.renderables.end())
+        {
+            add_damage(state);
+        }
+    }
+
+    if (!bounded || damage.size() == 0)
+    {
+        return {};
+    }
+    if (damage.size() > max_damage_rects)
+    {
+        return {damage.bounding_rectangle()};
+    }
+    return {damage.begin(), damage.end()};
+}
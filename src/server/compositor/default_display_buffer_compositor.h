@@ -19,7 +19,13 @@
 
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/graphics/platform.h"
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer_id.h"
+
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -39,6 +45,8 @@ namespace compositor
 {
 
 class Scene;
+class CaptureQueue;
+class OutputMirroring;
 
 class DefaultDisplayBufferCompositor : public DisplayBufferCompositor
 {
@@ -47,16 +55,66 @@ public:
         graphics::DisplaySink& display_sink,
         graphics::GLRenderingProvider& gl_provider,
         std::shared_ptr<renderer::Renderer> const& renderer,
-        std::shared_ptr<compositor::CompositorReport> const& report);
+        std::shared_ptr<compositor::CompositorReport> const& report,
+        std::shared_ptr<CaptureQueue> const& capture_queue,
+        std::shared_ptr<OutputMirroring> const& mirroring);
+    /// For renderers without a GL provider; \p fb_adaptor decides which buffers can be overlaid
+    DefaultDisplayBufferCompositor(
+        graphics::DisplaySink& display_sink,
+        std::unique_ptr<graphics::RenderingProvider::FramebufferProvider> fb_adaptor,
+        std::shared_ptr<renderer::Renderer> const& renderer,
+        std::shared_ptr<compositor::CompositorReport> const& report,
+        std::shared_ptr<CaptureQueue> const& capture_queue,
+        std::shared_ptr<OutputMirroring> const& mirroring);
+    ~DefaultDisplayBufferCompositor();
 
     bool composite(SceneElementSequence&& scene_sequence) override;
 
 private:
+    /// Everything about a renderable that affects what it looks like on this output
+    struct RenderableState
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle screen_position;
+        std::optional<geometry::Rectangle> clip_area;
+        float alpha;
+        glm::mat4 transformation;
+        bool shaped;
+
+        auto operator==(RenderableState const&) const -> bool = default;
+    };
+
+    /// What was on the output after the last frame, so we can skip frames that would look the same
+    struct FrameSignature
+    {
+        geometry::Rectangle view_area;
+        glm::mat2 output_transformation;
+        std::vector<RenderableState> renderables;
+        /// The mirrored frame drawn, if any; its buffer can be reused for a later frame
+        std::optional<std::uint64_t> mirrored_publication;
+
+        auto operator==(FrameSignature const&) const -> bool = default;
+    };
+
+    static auto signature_of(
+        graphics::RenderableList const& renderables,
+        geometry::Rectangle const& view_area,
+        glm::mat2 const& output_transformation) -> FrameSignature;
+
+    /// The areas of the output that differ between two frames; empty if that can't be narrowed down
+    static auto damage_between(
+        FrameSignature const& previous,
+        FrameSignature const& next) -> std::vector<geometry::Rectangle>;
+
     graphics::DisplaySink& display_sink;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::unique_ptr<graphics::RenderingProvider::FramebufferProvider> const fb_adaptor;
     std::shared_ptr<compositor::CompositorReport> const report;
+    std::shared_ptr<CaptureQueue> const capture_queue;
+    std::shared_ptr<OutputMirroring> const mirroring;
     bool completed_first_render = false;
+    std::optional<FrameSignature> last_presented;
 };
 
 }
@@ -35,12 +35,16 @@ mc::DefaultDisplayBufferCompositorFactory::DefaultDisplayBufferCompositorFactory
     std::shared_ptr<mg::GLConfig> gl_config,
     std::shared_ptr<mir::renderer::RendererFactory> const& renderer_factory,
     std::shared_ptr<mg::GraphicBufferAllocator> const& buffer_allocator,
-    std::shared_ptr<mc::CompositorReport> const& report) :
+    std::shared_ptr<mc::CompositorReport> const& report,
+    std::shared_ptr<CaptureQueue> const& capture_queue,
+    std::shared_ptr<OutputMirroring> const& mirroring) :
         platforms{std::move(render_platforms)},
         gl_config{std::move(gl_config)},
         renderer_factory{renderer_factory},
         buffer_allocator{buffer_allocator},
-        report{report}
+        report{report},
+        capture_queue{capture_queue},
+        mirroring{mirroring}
 {
 }
 
@@ -85,5 +89,5 @@ mc::DefaultDisplayBufferCompositorFactory::create_compositor_for(
     auto renderer = renderer_factory->create_renderer_for(std::move(output_surface), chosen_allocator);
     renderer->set_viewport(display_sink.view_area());
     return std::make_unique<DefaultDisplayBufferCompositor>(
-        display_sink, *chosen_allocator, std::move(renderer), report);
+        display_sink, *chosen_allocator, std::move(renderer), report, capture_queue, mirroring);
 }
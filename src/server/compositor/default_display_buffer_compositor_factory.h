@@ -40,6 +40,8 @@ class GraphicBufferAllocator;
 ///  Compositing. Combining renderables into a display image.
 namespace compositor
 {
+class CaptureQueue;
+class OutputMirroring;
 
 class DefaultDisplayBufferCompositorFactory : public DisplayBufferCompositorFactory
 {
@@ -49,7 +51,9 @@ public:
         std::shared_ptr<graphics::GLConfig> gl_config,
         std::shared_ptr<renderer::RendererFactory> const& renderer_factory,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
-        std::shared_ptr<CompositorReport> const& report);
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<CaptureQueue> const& capture_queue,
+        std::shared_ptr<OutputMirroring> const& mirroring);
 
     std::unique_ptr<DisplayBufferCompositor> create_compositor_for(graphics::DisplaySink& display_sink) override;
 
@@ -59,6 +63,8 @@ private:
     std::shared_ptr<renderer::RendererFactory> const renderer_factory;
     std::shared_ptr<graphics::GraphicBufferAllocator> const buffer_allocator;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<CaptureQueue> const capture_queue;
+    std::shared_ptr<OutputMirroring> const mirroring;
 };
 
 }
@@ -27,6 +27,7 @@
 #include "mir/raii.h"
 #include "mir/unwind_helpers.h"
 #include "mir/thread_name.h"
+#include "mir/thread_policy.h"
 #include "mir/executor.h"
 #include "mir/signal.h"
 
@@ -34,6 +35,7 @@
 #include <thread>
 #include <chrono>
 #include <future>
+#include <algorithm>
 #include <boost/throw_exception.hpp>
 
 using namespace std::literals::chrono_literals;
@@ -73,6 +75,7 @@ public:
     try
     {
         mir::set_thread_name("Mir/Comp");
+        mir::apply_thread_policy(mir::ThreadRole::compositor);
         auto const signal_when_stopped = mir::raii::paired_calls(
             [](){},
             [this]()
@@ -113,6 +116,9 @@ public:
                     scene->unregister_compositor(std::get<1>(compositor).get());
             });
 
+        std::vector<CompositorReport::SubCompositorId> composited;
+        composited.reserve(compositors.size());
+
         started.set_value();
 
         try
@@ -128,18 +134,33 @@ public:
                  */
                 if (running)
                 {
-                    bool needs_post = false;
+                    composited.clear();
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
-                        if (compositor->composite(scene->scene_elements_for(compositor.get())))
-                            needs_post = true;
+                        auto const id = CompositorReport::SubCompositorId{compositor.get()};
+
+                        report->began_stage(id, CompositorReport::FrameStage::scene_snapshot);
+                        auto elements = scene->scene_elements_for(compositor.get());
+                        report->finished_stage(id, CompositorReport::FrameStage::scene_snapshot);
+
+                        // Compositors skip outputs where nothing visible changed; those keep their current frame
+                        if (compositor->composite(std::move(elements)))
+                            composited.push_back(id);
                     }
 
                     // We can skip the post if none of the compositors ended up compositing
-                    if (needs_post)
+                    if (!composited.empty())
+                    {
+                        for (auto const id : composited)
+                            report->began_stage(id, CompositorReport::FrameStage::wait_for_flip);
+
                         group.post();
 
+                        for (auto const id : composited)
+                            report->finished_stage(id, CompositorReport::FrameStage::wait_for_flip);
+                    }
+
                     /*
                      * "Predictive bypass" optimization: If the last frame was
                      * bypassed/overlayed or you simply have a fast GPU, it is
@@ -180,6 +201,11 @@ public:
         }
     }
 
+    auto composites(mg::DisplaySyncGroup const& candidate) const -> bool
+    {
+        return &group == &candidate;
+    }
+
     void stop()
     {
         running = false;
@@ -257,6 +283,7 @@ mc::MultiThreadedCompositor::~MultiThreadedCompositor()
 void mc::MultiThreadedCompositor::schedule_compositing()
 {
     report->scheduled();
+    std::lock_guard lock{thread_functors_mutex};
     for (auto& f : thread_functors)
         f->schedule_compositing();
 }
@@ -264,6 +291,7 @@ void mc::MultiThreadedCompositor::schedule_compositing()
 void mc::MultiThreadedCompositor::schedule_compositing(geometry::Rectangle const& damage) const
 {
     report->scheduled();
+    std::lock_guard lock{thread_functors_mutex};
     for (auto& f : thread_functors)
         f->schedule_compositing(damage);
 }
@@ -323,21 +351,80 @@ void mc::MultiThreadedCompositor::stop()
     state = CompositorState::stopped;
 }
 
-void mc::MultiThreadedCompositor::create_compositing_threads()
+void mc::MultiThreadedCompositor::configure_display(mg::Display& display, mg::DisplayConfiguration const& conf)
+{
+    if (state != CompositorState::started)
+    {
+        display.configure(conf);
+        return;
+    }
+
+    /*
+     * Only the sync groups the display actually replaces lose their compositing
+     * thread; every other output keeps compositing while the change is applied.
+     */
+    auto const retire = [this](mg::DisplaySyncGroup& group)
+        {
+            std::unique_ptr<CompositingFunctor> retired;
+            {
+                std::lock_guard lock{thread_functors_mutex};
+                auto const i = std::find_if(
+                    thread_functors.begin(), thread_functors.end(),
+                    [&group](auto const& functor) { return functor->composites(group); });
+
+                if (i == thread_functors.end())
+                    return;
+
+                retired = std::move(*i);
+                thread_functors.erase(i);
+            }
+
+            // The thread may notify the scene as it shuts down, so don't hold the lock here
+            retired->wait_until_stopped();
+        };
+
+    try
+    {
+        display.configure_incrementally(conf, retire);
+    }
+    catch (...)
+    {
+        // Whatever groups the display was left with still need compositing
+        create_compositing_threads();
+        throw;
+    }
+
+    // New outputs need a first frame whether or not the scene changes
+    for (auto const functor : create_compositing_threads())
+        functor->schedule_compositing();
+}
+
+auto mc::MultiThreadedCompositor::create_compositing_threads() -> std::vector<CompositingFunctor*>
 {
+    std::vector<CompositingFunctor*> created;
+
     /* Start the display buffer compositing threads */
-    display->for_each_display_sync_group([this](mg::DisplaySyncGroup& group)
+    display->for_each_display_sync_group([this, &created](mg::DisplaySyncGroup& group)
     {
+        std::lock_guard lock{thread_functors_mutex};
+        if (std::any_of(
+                thread_functors.begin(), thread_functors.end(),
+                [&group](auto const& functor) { return functor->composites(group); }))
+        {
+            return;
+        }
+
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
             fixed_composite_delay, report);
 
-        mir::thread_pool_executor.spawn(std::ref(*thread_functor));
+        mir::ThreadPoolExecutor::spawn_blocking(std::ref(*thread_functor));
+        created.push_back(thread_functor.get());
         thread_functors.push_back(std::move(thread_functor));
     });
 
     std::exception_ptr x;
-    for (auto& functor : thread_functors)
+    for (auto const functor : created)
     try
     {
         functor->wait_until_started();
@@ -351,15 +438,21 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         rethrow_exception(x);
     }
+
+    return created;
 }
 
 void mc::MultiThreadedCompositor::destroy_compositing_threads()
 {
-    for (auto& f : thread_functors)
+    decltype(thread_functors) stopping;
+    {
+        std::lock_guard lock{thread_functors_mutex};
+        stopping.swap(thread_functors);
+    }
+
+    for (auto& f : stopping)
         f->stop();
 
-    for (auto& f : thread_functors)
+    for (auto& f : stopping)
         f->wait_until_stopped();
-
-    thread_functors.clear();
 }
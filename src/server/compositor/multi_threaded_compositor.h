@@ -24,12 +24,14 @@
 #include <vector>
 #include <chrono>
 #include <atomic>
+#include <mutex>
 
 namespace mir
 {
 namespace graphics
 {
 class Display;
+class DisplayConfiguration;
 }
 namespace scene
 {
@@ -66,11 +68,14 @@ public:
         bool compose_on_start);
     ~MultiThreadedCompositor();
 
-    void start();
-    void stop();
+    void start() override;
+    void stop() override;
+    void configure_display(graphics::Display& display, graphics::DisplayConfiguration const& conf) override;
+    void schedule_compositing() override;
 
 private:
-    void create_compositing_threads();
+    /// Starts compositing threads for any sync groups that don't have one; returns the new threads
+    auto create_compositing_threads() -> std::vector<CompositingFunctor*>;
     void destroy_compositing_threads();
 
     std::shared_ptr<graphics::Display> const display;
@@ -79,13 +84,14 @@ private:
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
 
+    /// Guards thread_functors, which scene notifications may iterate from any thread
+    std::mutex mutable thread_functors_mutex;
     std::vector<std::unique_ptr<CompositingFunctor>> thread_functors;
 
     std::atomic<CompositorState> state;
     std::chrono::milliseconds fixed_composite_delay;
     bool compose_on_start;
 
-    void schedule_compositing();
     void schedule_compositing(geometry::Rectangle const& damage) const;
 
     std::shared_ptr<mir::scene::Observer> observer;
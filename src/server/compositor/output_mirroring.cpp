@@ -0,0 +1,174 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "output_mirroring.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/graphic_buffer_allocator.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+namespace
+{
+/// Enough for one frame being drawn by a mirror, one published and one being copied into
+auto constexpr max_buffers_per_source = 3u;
+}
+
+mc::OutputMirroring::OutputMirroring(
+    std::function<void()> schedule_compositing,
+    std::shared_ptr<mg::GraphicBufferAllocator> allocator)
+    : schedule_compositing{std::move(schedule_compositing)},
+      allocator{std::move(allocator)}
+{
+}
+
+void mc::OutputMirroring::add_output(mg::DisplaySink& sink)
+{
+    std::lock_guard lock{mutex};
+    outputs.push_back(&sink);
+}
+
+void mc::OutputMirroring::remove_output(mg::DisplaySink& sink)
+{
+    std::lock_guard lock{mutex};
+    std::erase(outputs, &sink);
+    std::erase(uncopyable, &sink);
+    sources.erase(&sink);
+}
+
+auto mc::OutputMirroring::source_for(mg::DisplaySink& sink) const -> mg::DisplaySink*
+{
+    auto const view_area = sink.view_area();
+    auto const mirrors = std::count_if(
+        outputs.begin(), outputs.end(),
+        [&](mg::DisplaySink* output) { return output->view_area() == view_area; });
+    if (mirrors < 2)
+    {
+        return nullptr;
+    }
+
+    // The renderers can only copy frames drawn without an output transform
+    auto const source = std::find_if(
+        outputs.begin(), outputs.end(),
+        [&](mg::DisplaySink* output)
+        {
+            return output->view_area() == view_area &&
+                   output->transformation() == glm::mat2{1} &&
+                   std::find(uncopyable.begin(), uncopyable.end(), output) == uncopyable.end();
+        });
+    return source != outputs.end() ? *source : nullptr;
+}
+
+auto mc::OutputMirroring::capture_for(mg::DisplaySink& sink) -> std::optional<Capture>
+{
+    std::shared_ptr<mg::Buffer> target;
+    auto const view_area = sink.view_area();
+    {
+        std::lock_guard lock{mutex};
+        if (source_for(sink) != &sink)
+        {
+            sources.erase(&sink);
+            return std::nullopt;
+        }
+
+        auto& buffers = sources[&sink].buffers;
+        std::erase_if(buffers, [&](auto const& buffer) { return buffer->size() != view_area.size; });
+
+        // A buffer only we hold isn't published, being drawn by a mirror, or waiting for a copy
+        auto const unused = std::find_if(
+            buffers.begin(), buffers.end(),
+            [](auto const& buffer) { return buffer.use_count() == 1; });
+        if (unused != buffers.end())
+        {
+            target = *unused;
+        }
+        else if (buffers.size() < max_buffers_per_source)
+        {
+            target = allocator->alloc_software_buffer(view_area.size, mir_pixel_format_argb_8888);
+            buffers.push_back(target);
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    return Capture{
+        view_area,
+        view_area,
+        nullptr,
+        target,
+        [this, sink = &sink, target](bool copied) { publish(sink, target, copied); }};
+}
+
+void mc::OutputMirroring::publish(mg::DisplaySink* sink, std::shared_ptr<mg::Buffer> const& frame, bool copied)
+{
+    {
+        std::lock_guard lock{mutex};
+        // A renderer being destroyed fails its captures, possibly after its output was removed
+        if (std::find(outputs.begin(), outputs.end(), sink) == outputs.end())
+        {
+            return;
+        }
+
+        if (copied)
+        {
+            auto const source = sources.find(sink);
+            if (source == sources.end())
+            {
+                return;
+            }
+            source->second.latest = Frame{frame, ++publications};
+        }
+        else
+        {
+            // Let the next candidate draw for the mirrors instead
+            uncopyable.push_back(sink);
+            sources.erase(sink);
+        }
+    }
+    schedule_compositing();
+}
+
+void mc::OutputMirroring::withdraw_frame(mg::DisplaySink& sink)
+{
+    {
+        std::lock_guard lock{mutex};
+        auto const source = sources.find(&sink);
+        if (source == sources.end() || !source->second.latest)
+        {
+            return;
+        }
+        source->second.latest.reset();
+    }
+    schedule_compositing();
+}
+
+auto mc::OutputMirroring::mirrored_frame(mg::DisplaySink& sink) const -> std::optional<Frame>
+{
+    std::lock_guard lock{mutex};
+    auto const source = source_for(sink);
+    if (!source || source == &sink)
+    {
+        return std::nullopt;
+    }
+    auto const frames = sources.find(source);
+    return frames != sources.end() ? frames->second.latest : std::nullopt;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_COMPOSITOR_OUTPUT_MIRRORING_H_
+#define MIR_COMPOSITOR_OUTPUT_MIRRORING_H_
+
+#include "mir/renderer/renderer.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+class DisplaySink;
+class GraphicBufferAllocator;
+}
+namespace compositor
+{
+
+/**
+ * Lets outputs that show the same part of the scene draw it only once
+ *
+ * Of the outputs being composited with identical view areas, the first without a display
+ * transform draws the scene and has its frame copied; the others draw that copy, which the
+ * renderer scales and rotates as it would any buffer. Outputs already sharing a scanout buffer
+ * (as the gbm-kms platform arranges for compatible clones) are a single sink, so don't need this.
+ */
+class OutputMirroring
+{
+public:
+    using Capture = renderer::Renderer::FrameCapture;
+
+    /// A frame published for mirrors
+    struct Frame
+    {
+        std::shared_ptr<graphics::Buffer> buffer;
+        /// Differs for each frame published, even when a buffer is reused for a later one
+        std::uint64_t publication;
+    };
+
+    /// \param schedule_compositing  called when a new frame is published, so the mirrors draw it
+    /// \param allocator             allocates the buffers frames are copied into
+    OutputMirroring(
+        std::function<void()> schedule_compositing,
+        std::shared_ptr<graphics::GraphicBufferAllocator> allocator);
+
+    /// Outputs are registered while they are being composited
+    void add_output(graphics::DisplaySink& sink);
+    void remove_output(graphics::DisplaySink& sink);
+
+    /// If other outputs mirror \p sink, a capture that publishes the next frame it draws for them
+    auto capture_for(graphics::DisplaySink& sink) -> std::optional<Capture>;
+
+    /// \p sink presented its last frame without drawing it, so its mirrors must draw their own
+    void withdraw_frame(graphics::DisplaySink& sink);
+
+    /// The latest frame drawn by the output \p sink mirrors, or nothing if \p sink should draw the scene itself
+    auto mirrored_frame(graphics::DisplaySink& sink) const -> std::optional<Frame>;
+
+private:
+    /// The frames an output draws for its mirrors
+    struct Source
+    {
+        std::vector<std::shared_ptr<graphics::Buffer>> buffers;
+        std::optional<Frame> latest;
+    };
+
+    /// The output that draws for \p sink and its mirrors, if any; requires the mutex to be held
+    auto source_for(graphics::DisplaySink& sink) const -> graphics::DisplaySink*;
+    void publish(graphics::DisplaySink* sink, std::shared_ptr<graphics::Buffer> const& frame, bool copied);
+
+    std::function<void()> const schedule_compositing;
+    std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
+
+    std::mutex mutable mutex;
+    std::vector<graphics::DisplaySink*> outputs;
+    /// Outputs whose frames couldn't be copied, so aren't asked again
+    std::vector<graphics::DisplaySink*> uncopyable;
+    std::map<graphics::DisplaySink*, Source> sources;
+    std::uint64_t publications{0};
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_OUTPUT_MIRRORING_H_
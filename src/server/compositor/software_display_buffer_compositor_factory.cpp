@@ -0,0 +1,61 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "software_display_buffer_compositor_factory.h"
+#include "default_display_buffer_compositor.h"
+#include "software/renderer_factory.h"
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/platform.h"
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+namespace
+{
+/// Without a GL provider to import them there's no way to scan out client buffers
+class NoOverlays : public mg::RenderingProvider::FramebufferProvider
+{
+public:
+    auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer>) -> std::unique_ptr<mg::Framebuffer> override
+    {
+        return nullptr;
+    }
+};
+}
+
+mc::SoftwareDisplayBufferCompositorFactory::SoftwareDisplayBufferCompositorFactory(
+    std::shared_ptr<renderer::software::RendererFactory> renderer_factory,
+    std::shared_ptr<CompositorReport> report,
+    std::shared_ptr<CaptureQueue> capture_queue,
+    std::shared_ptr<OutputMirroring> mirroring) :
+    renderer_factory{std::move(renderer_factory)},
+    report{std::move(report)},
+    capture_queue{std::move(capture_queue)},
+    mirroring{std::move(mirroring)}
+{
+}
+
+auto mc::SoftwareDisplayBufferCompositorFactory::create_compositor_for(mg::DisplaySink& display_sink)
+    -> std::unique_ptr<DisplayBufferCompositor>
+{
+    return std::make_unique<DefaultDisplayBufferCompositor>(
+        display_sink,
+        std::make_unique<NoOverlays>(),
+        renderer_factory->create_renderer_for(display_sink),
+        report,
+        capture_queue,
+        mirroring);
+}
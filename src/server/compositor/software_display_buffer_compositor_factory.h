@@ -0,0 +1,65 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_SOFTWARE_DISPLAY_BUFFER_COMPOSITOR_FACTORY_H_
+#define MIR_COMPOSITOR_SOFTWARE_DISPLAY_BUFFER_COMPOSITOR_FACTORY_H_
+
+#include "mir/compositor/display_buffer_compositor_factory.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+class RendererFactory;
+}
+}
+namespace compositor
+{
+class CaptureQueue;
+class OutputMirroring;
+class CompositorReport;
+
+/**
+ * Creates compositors that draw with the software renderer
+ *
+ * Used when asked for (--renderer=software) or when no rendering platform supports GL.
+ * Every frame is drawn; client buffers are never handed to the display directly.
+ */
+class SoftwareDisplayBufferCompositorFactory : public DisplayBufferCompositorFactory
+{
+public:
+    SoftwareDisplayBufferCompositorFactory(
+        std::shared_ptr<renderer::software::RendererFactory> renderer_factory,
+        std::shared_ptr<CompositorReport> report,
+        std::shared_ptr<CaptureQueue> capture_queue,
+        std::shared_ptr<OutputMirroring> mirroring);
+
+    std::unique_ptr<DisplayBufferCompositor> create_compositor_for(graphics::DisplaySink& display_sink) override;
+
+private:
+    std::shared_ptr<renderer::software::RendererFactory> const renderer_factory;
+    std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<CaptureQueue> const capture_queue;
+    std::shared_ptr<OutputMirroring> const mirroring;
+};
+}
+}
+
+#endif /* MIR_COMPOSITOR_SOFTWARE_DISPLAY_BUFFER_COMPOSITOR_FACTORY_H_ */
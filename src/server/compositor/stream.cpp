@@ -18,6 +18,7 @@
 #include "multi_monitor_arbiter.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/uploaded_buffer.h"
 #include <boost/throw_exception.hpp>
 #include <math.h>
 
@@ -27,6 +28,17 @@ namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
+namespace
+{
+void set_buffer_visible(mg::Buffer& buffer, bool visible)
+{
+    if (auto const uploaded = dynamic_cast<mg::UploadedBuffer*>(buffer.native_buffer_base()))
+    {
+        uploaded->set_visible(visible);
+    }
+}
+}
+
 mc::Stream::Stream() :
     arbiter(std::make_shared<mc::MultiMonitorArbiter>()),
     first_frame_posted(false),
@@ -44,6 +56,12 @@ void mc::Stream::submit_buffer(
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
+    {
+        auto const state = visibility.lock();
+        state->latest = buffer;
+        set_buffer_visible(*buffer, state->visible);
+    }
+
     arbiter->submit_buffer(buffer, dst_size, src_bounds);
     first_frame_posted = true;
     {
@@ -67,3 +85,13 @@ bool mc::Stream::has_submitted_buffer() const
     // Don't need to lock mutex because first_frame_posted is atomic
     return first_frame_posted;
 }
+
+void mc::Stream::set_visible(bool visible)
+{
+    auto const state = visibility.lock();
+    state->visible = visible;
+    if (auto const latest = state->latest.lock())
+    {
+        set_buffer_visible(*latest, visible);
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "client_flusher.h"
+#include "wl_client.h"
+
+#include <wayland-server-core.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <poll.h>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+/// The most dispatches of already-ready events before flushing; bounds the latency added to the first event
+int const max_dispatches_per_flush = 16;
+
+/// How often to check client sockets for unread events
+auto const sample_interval = std::chrono::milliseconds{100};
+
+auto events_ready(int event_loop_fd) -> bool
+{
+    pollfd fd{event_loop_fd, POLLIN, 0};
+    return poll(&fd, 1, 0) > 0;
+}
+}
+
+mf::ClientFlusher::ClientFlusher(wl_display* display)
+    : display{display},
+      event_loop_fd{wl_event_loop_get_fd(wl_display_get_event_loop(display))},
+      sample_timer{wl_event_loop_add_timer(wl_display_get_event_loop(display), &on_sample_timer, this)},
+      next_sample{std::chrono::steady_clock::now()}
+{
+    if (!sample_timer)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to create client backlog sampling timer"}));
+    }
+}
+
+mf::ClientFlusher::~ClientFlusher()
+{
+    wl_event_source_remove(sample_timer);
+}
+
+void mf::ClientFlusher::add(WlClient& client)
+{
+    clients.push_back(wayland::make_weak(&client));
+}
+
+void mf::ClientFlusher::dispatch_and_flush(int timeout)
+{
+    auto const loop = wl_display_get_event_loop(display);
+
+    wl_event_loop_dispatch(loop, timeout);
+
+    /* A burst of work (requests from clients, or WaylandExecutor work from other threads) is usually
+     * spread over several dispatches. Handle everything that is already ready before flushing so that
+     * the resulting events reach each client in one write, rather than one per dispatch.
+     */
+    for (auto i = 0; i != max_dispatches_per_flush && events_ready(event_loop_fd); ++i)
+    {
+        wl_event_loop_dispatch(loop, 0);
+    }
+
+    wl_display_flush_clients(display);
+
+    if (std::chrono::steady_clock::now() >= next_sample)
+    {
+        sample_outgoing_queues();
+    }
+}
+
+int mf::ClientFlusher::on_sample_timer(void* data)
+{
+    static_cast<ClientFlusher*>(data)->sample_outgoing_queues();
+    return 0;
+}
+
+void mf::ClientFlusher::sample_outgoing_queues()
+{
+    next_sample = std::chrono::steady_clock::now() + sample_interval;
+
+    clients.erase(
+        std::remove_if(begin(clients), end(clients), [](auto const& client) { return !client; }),
+        end(clients));
+
+    // Work deferred until a client is uncongested may destroy clients, so check each is still live
+    for (size_t i = 0; i != clients.size(); ++i)
+    {
+        if (clients[i])
+        {
+            clients[i].value().sample_outgoing_queue();
+        }
+    }
+
+    auto const any_congested = std::any_of(
+        begin(clients), end(clients), [](auto const& client) { return client && client.value().is_congested(); });
+
+    // An idle event loop would otherwise never notice a congested client catching up
+    auto const timeout = std::chrono::duration_cast<std::chrono::milliseconds>(sample_interval).count();
+    wl_event_source_timer_update(sample_timer, any_congested ? timeout : 0);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_FRONTEND_CLIENT_FLUSHER_H_
+#define MIR_FRONTEND_CLIENT_FLUSHER_H_
+
+#include "mir/wayland/weak.h"
+
+#include <chrono>
+#include <vector>
+
+struct wl_display;
+struct wl_event_source;
+
+namespace mir
+{
+namespace frontend
+{
+class WlClient;
+
+/// Flushes events to clients once per dispatch cycle of the Wayland event loop, and keeps track of how far
+/// behind each client is in reading them.
+///
+/// While any client is congested its backlog is also sampled on a timer, so that it is seen to catch up (and work
+/// deferred until then runs) even if nothing else wakes the event loop.
+///
+/// Must only be used on the Wayland thread.
+class ClientFlusher
+{
+public:
+    explicit ClientFlusher(wl_display* display);
+    ~ClientFlusher();
+
+    ClientFlusher(ClientFlusher const&) = delete;
+    ClientFlusher& operator=(ClientFlusher const&) = delete;
+
+    /// Start tracking how far behind the client is
+    void add(WlClient& client);
+
+    /// Dispatch the event loop until it has nothing ready (up to a limit), then flush every client once
+    ///
+    /// \param [in] timeout     how long to wait for the first event, in milliseconds (-1 to wait indefinitely)
+    void dispatch_and_flush(int timeout);
+
+private:
+    void sample_outgoing_queues();
+    static int on_sample_timer(void* data);
+
+    wl_display* const display;
+    int const event_loop_fd;
+    wl_event_source* const sample_timer;
+    std::vector<wayland::Weak<WlClient>> clients;
+    std::chrono::steady_clock::time_point next_sample;
+};
+}
+}
+
+#endif // MIR_FRONTEND_CLIENT_FLUSHER_H_
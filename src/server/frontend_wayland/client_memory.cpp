@@ -0,0 +1,186 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "client_memory.h"
+#include "resource_lifetime_tracker.h"
+
+#include "mir/wayland/client.h"
+#include "mir/wayland/weak.h"
+
+#include <wayland-server-core.h>
+
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace ms = mir::scene;
+namespace mw = mir::wayland;
+
+struct mf::ClientMemory::Charge::Account
+{
+    Account(mw::Client& client, Limits const& limits, std::shared_ptr<ms::SceneReport> const& report)
+        : client{mw::make_weak(&client)},
+          session{client.client_session()},
+          limits{limits},
+          report{report}
+    {
+    }
+
+    void update(Kind kind, std::size_t from, std::size_t to)
+    {
+        if (from == to)
+        {
+            return;
+        }
+
+        auto& bytes = kind == Kind::shm ? usage.shm : kind == Kind::dmabuf ? usage.dmabuf : usage.texture;
+        bytes = bytes - from + to;
+        report->session_memory_changed(*session, usage);
+
+        auto const total = usage.total();
+        if (limits.hard && total > limits.hard)
+        {
+            if (!disconnecting)
+            {
+                disconnecting = true;
+                report->session_memory_limit_exceeded(*session, usage, limits.hard);
+                if (client)
+                {
+                    wl_client_post_no_memory(client.value().raw_client());
+                }
+            }
+        }
+        else if (limits.soft && total > limits.soft)
+        {
+            if (!over_soft_limit)
+            {
+                over_soft_limit = true;
+                report->session_memory_limit_exceeded(*session, usage, limits.soft);
+            }
+            if (to > from)
+            {
+                reclaim();
+            }
+        }
+        else
+        {
+            over_soft_limit = false;
+        }
+    }
+
+    void reclaim() const
+    {
+        for (auto const charge : charges)
+        {
+            if (charge->reclaim)
+            {
+                charge->reclaim();
+            }
+        }
+    }
+
+    mw::Weak<mw::Client> const client;
+    std::shared_ptr<ms::Session> const session;
+    Limits const limits;
+    std::shared_ptr<ms::SceneReport> const report;
+    Usage usage;
+    bool over_soft_limit{false};
+    bool disconnecting{false};
+    std::vector<Charge*> charges;
+};
+
+mf::ClientMemory::Charge::Charge(std::shared_ptr<Account> account, Kind kind, std::size_t bytes)
+    : account{std::move(account)},
+      kind{kind},
+      bytes{bytes}
+{
+    this->account->charges.push_back(this);
+    this->account->update(kind, 0, bytes);
+}
+
+mf::ClientMemory::Charge::~Charge()
+{
+    std::erase(account->charges, this);
+    account->update(kind, bytes, 0);
+}
+
+void mf::ClientMemory::Charge::resize(std::size_t bytes)
+{
+    account->update(kind, this->bytes, bytes);
+    this->bytes = bytes;
+}
+
+void mf::ClientMemory::Charge::reclaim_with(std::function<void()> reclaim)
+{
+    this->reclaim = std::move(reclaim);
+}
+
+mf::ClientMemory::ClientMemory(Limits const& limits, std::shared_ptr<ms::SceneReport> const& report)
+    : limits{limits},
+      report{report}
+{
+}
+
+mf::ClientMemory::~ClientMemory() = default;
+
+auto mf::ClientMemory::account_for(wl_client* client) -> std::shared_ptr<Charge::Account>
+{
+    auto& wayland_client = mw::Client::from(client);
+
+    // A wl_client* can be reused once its client is destroyed, so check the account is for this one
+    if (auto const existing = accounts.find(client); existing != accounts.end())
+    {
+        if (auto const account = existing->second.lock(); account && account->client.is(wayland_client))
+        {
+            return account;
+        }
+    }
+
+    std::erase_if(accounts, [](auto const& entry) { return entry.second.expired(); });
+
+    auto const account = std::make_shared<Charge::Account>(wayland_client, limits, report);
+    accounts[client] = account;
+    return account;
+}
+
+auto mf::ClientMemory::charge(wl_client* client, Kind kind, std::size_t bytes) -> std::shared_ptr<Charge>
+{
+    // Can't use std::make_shared because the Charge constructor is private
+    return std::shared_ptr<Charge>{new Charge{account_for(client), kind, bytes}};
+}
+
+void mf::ClientMemory::charge_for_buffer(wl_resource* buffer, Kind kind, std::size_t bytes)
+{
+    if (buffer_charges.contains(buffer))
+    {
+        return;
+    }
+
+    buffer_charges[buffer] = charge(wl_resource_get_client(buffer), kind, bytes);
+    ResourceLifetimeTracker::from(buffer)->add_destroy_listener([this, buffer]() { buffer_charges.erase(buffer); });
+}
+
+auto mf::ClientMemory::usage_of(wl_client* client) const -> Usage
+{
+    if (auto const existing = accounts.find(client); existing != accounts.end())
+    {
+        if (auto const account = existing->second.lock(); account && account->client)
+        {
+            return account->usage;
+        }
+    }
+    return {};
+}
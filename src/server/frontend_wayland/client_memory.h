@@ -0,0 +1,115 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_FRONTEND_CLIENT_MEMORY_H_
+#define MIR_FRONTEND_CLIENT_MEMORY_H_
+
+#include "mir/scene/scene_report.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+struct wl_client;
+struct wl_resource;
+
+namespace mir
+{
+namespace frontend
+{
+/// Graphics memory attributed to each Wayland client's session, with limits on how much one client may hold
+///
+/// Must only be used on the Wayland thread.
+class ClientMemory
+{
+public:
+    using Usage = scene::SceneReport::SessionMemory;
+
+    enum class Kind
+    {
+        shm,        ///< Mapped wl_shm pools
+        dmabuf,     ///< Imported dmabufs
+        texture,    ///< GL textures SHM buffers are uploaded to, while they exist
+    };
+
+    struct Limits
+    {
+        /// A client holding more than this many bytes is reported, and what can be reclaimed from it is
+        /// each time its usage grows (0 for no limit)
+        std::size_t soft{0};
+        /// A client holding more than this many bytes is disconnected (0 for no limit)
+        std::size_t hard{0};
+    };
+
+    /// Memory attributed to a client for as long as this exists
+    class Charge
+    {
+    public:
+        ~Charge();
+
+        /// Change the number of bytes attributed
+        void resize(std::size_t bytes);
+
+        /**
+         * Call \p reclaim to release what can be of this memory when the client is over its soft limit
+         *
+         * \note \p reclaim is called from within ClientMemory, so must not create or destroy charges
+         */
+        void reclaim_with(std::function<void()> reclaim);
+
+        Charge(Charge const&) = delete;
+        Charge& operator=(Charge const&) = delete;
+
+    private:
+        friend ClientMemory;
+        struct Account;
+        Charge(std::shared_ptr<Account> account, Kind kind, std::size_t bytes);
+
+        std::shared_ptr<Account> const account;
+        Kind const kind;
+        std::size_t bytes;
+        std::function<void()> reclaim;
+    };
+
+    ClientMemory(Limits const& limits, std::shared_ptr<scene::SceneReport> const& report);
+    ~ClientMemory();
+
+    /// Attribute \p bytes of \p kind to \p client until the returned charge is destroyed
+    auto charge(wl_client* client, Kind kind, std::size_t bytes) -> std::shared_ptr<Charge>;
+
+    /// Attribute \p bytes of \p kind to the client owning \p buffer until \p buffer is destroyed
+    /// \note Buffers already charged for are not charged again
+    void charge_for_buffer(wl_resource* buffer, Kind kind, std::size_t bytes);
+
+    auto usage_of(wl_client* client) const -> Usage;
+
+    ClientMemory(ClientMemory const&) = delete;
+    ClientMemory& operator=(ClientMemory const&) = delete;
+
+private:
+    auto account_for(wl_client* client) -> std::shared_ptr<Charge::Account>;
+
+    Limits const limits;
+    std::shared_ptr<scene::SceneReport> const report;
+    std::unordered_map<wl_client*, std::weak_ptr<Charge::Account>> accounts;
+    std::unordered_map<wl_resource*, std::shared_ptr<Charge>> buffer_charges;
+};
+}
+}
+
+#endif // MIR_FRONTEND_CLIENT_MEMORY_H_
@@ -33,6 +33,7 @@
 #include <algorithm>
 #include <mutex>
 #include <map>
+#include <optional>
 #include <boost/throw_exception.hpp>
 #include <fstream>
 #include <gio/gdesktopappinfo.h>
@@ -141,6 +142,8 @@ private:
     /// If nullptr, the surface is not supposed to have a handle (such as when it does not have a toplevel type)
     /// If it points to an empty Weak, the handle is being created or was destroyed by the client
     std::shared_ptr<wayland::Weak<ForeignToplevelHandleV1>> handle;
+    /// The latest title not yet sent to handle's client because it is congested
+    std::shared_ptr<std::optional<std::string>> deferred_title;
 
     std::shared_ptr<DesktopFileManager> const desktop_file_manager;
 };
@@ -394,6 +397,7 @@ void mf::ForeignSurfaceObserver::create_or_close_toplevel_handle_as_needed(std::
                 return;
 
             handle = std::make_shared<mw::Weak<ForeignToplevelHandleV1>>();
+            deferred_title = std::make_shared<std::optional<std::string>>();
 
             std::string name = surface->name();
             std::string app_id = desktop_file_manager->resolve_app_id(surface.get());
@@ -473,10 +477,30 @@ void mf::ForeignSurfaceObserver::renamed(ms::Surface const*, std::string const&
 {
     std::lock_guard lock{mutex};
 
-    with_toplevel_handle(lock, [name](ForeignToplevelHandleV1& handle)
+    with_toplevel_handle(lock, [this, name](ForeignToplevelHandleV1& handle)
         {
-            handle.send_title_event(name);
-            handle.send_done_event();
+            if (!handle.client->is_congested())
+            {
+                handle.send_title_event(name);
+                handle.send_done_event();
+                return;
+            }
+
+            // Some apps retitle constantly; a taskbar that is falling behind only needs the latest title
+            bool const already_deferred{deferred_title->has_value()};
+            *deferred_title = name;
+            if (!already_deferred)
+            {
+                handle.client->when_uncongested([weak_handle = *this->handle, title = deferred_title]()
+                    {
+                        if (weak_handle && title->has_value())
+                        {
+                            weak_handle.value().send_title_event(title->value());
+                            weak_handle.value().send_done_event();
+                        }
+                        title->reset();
+                    });
+            }
         });
 }
 
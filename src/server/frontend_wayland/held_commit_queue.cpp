@@ -0,0 +1,112 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "held_commit_queue.h"
+
+#include "mir/wayland/protocol_error.h"
+
+#include <wayland-server-core.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+
+mf::HeldCommitQueue::HeldCommitQueue(wl_event_loop* loop, wl_client* client)
+    : loop{loop},
+      client{client}
+{
+}
+
+mf::HeldCommitQueue::~HeldCommitQueue()
+{
+    if (source)
+    {
+        wl_event_source_remove(source);
+    }
+    for (auto const& commit : held)
+    {
+        commit.discard();
+    }
+}
+
+void mf::HeldCommitQueue::push(
+    std::optional<Fd> ready,
+    std::function<void()>&& apply,
+    std::function<void()>&& discard)
+{
+    if (held.empty() && !ready)
+    {
+        apply();
+        return;
+    }
+
+    held.push_back({std::move(ready), std::move(apply), std::move(discard)});
+    if (!source)
+    {
+        apply_ready();
+    }
+}
+
+auto mf::HeldCommitQueue::empty() const -> bool
+{
+    return held.empty();
+}
+
+void mf::HeldCommitQueue::apply_ready()
+{
+    while (!held.empty())
+    {
+        auto& next = held.front();
+        if (next.ready)
+        {
+            waiting_on = std::move(*next.ready);
+            next.ready = std::nullopt;
+            source = wl_event_loop_add_fd(loop, waiting_on, WL_EVENT_READABLE, &on_ready, this);
+            if (!source)
+            {
+                BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to wait for held commit"}));
+            }
+            return;
+        }
+
+        // Remove the commit before applying it, so one that fails isn't applied again
+        auto const apply = std::move(next.apply);
+        held.pop_front();
+        apply();
+    }
+}
+
+int mf::HeldCommitQueue::on_ready(int, uint32_t, void* data)
+{
+    auto const self = static_cast<HeldCommitQueue*>(data);
+
+    wl_event_source_remove(self->source);
+    self->source = nullptr;
+    self->waiting_on = Fd{};
+
+    try
+    {
+        self->apply_ready();
+    }
+    catch (...)
+    {
+        mw::internal_error_processing_request(self->client, "HeldCommitQueue::on_ready()");
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_HELD_COMMIT_QUEUE_H_
+#define MIR_FRONTEND_HELD_COMMIT_QUEUE_H_
+
+#include "mir/fd.h"
+
+#include <deque>
+#include <functional>
+#include <optional>
+
+struct wl_client;
+struct wl_event_loop;
+struct wl_event_source;
+
+namespace mir
+{
+namespace frontend
+{
+/// Surface commits that must wait for the client's GPU work before they are applied
+///
+/// Commits are applied in the order they were pushed, so a commit with nothing to wait for is still held behind
+/// any earlier commit that is waiting. Readiness is waited for in the Wayland event loop rather than by blocking.
+///
+/// Must only be used on the Wayland thread.
+class HeldCommitQueue
+{
+public:
+    /// \param [in] loop    the event loop to wait for readiness in
+    /// \param [in] client  the client errors applying a commit are reported to
+    HeldCommitQueue(wl_event_loop* loop, wl_client* client);
+    ~HeldCommitQueue();
+
+    HeldCommitQueue(HeldCommitQueue const&) = delete;
+    HeldCommitQueue& operator=(HeldCommitQueue const&) = delete;
+
+    /// Apply a commit once ready becomes readable (immediately if there is no ready fd and nothing else is held)
+    ///
+    /// \param [in] ready   an fd that becomes readable once the commit can be applied, if it needs to wait
+    /// \param [in] apply   applies the commit
+    /// \param [in] discard called instead of apply if the queue is destroyed before the commit is applied
+    void push(std::optional<Fd> ready, std::function<void()>&& apply, std::function<void()>&& discard);
+
+    /// If no commits are waiting
+    auto empty() const -> bool;
+
+private:
+    struct Held
+    {
+        std::optional<Fd> ready;
+        std::function<void()> apply;
+        std::function<void()> discard;
+    };
+
+    void apply_ready();
+    static int on_ready(int fd, uint32_t mask, void* data);
+
+    wl_event_loop* const loop;
+    wl_client* const client;
+    std::deque<Held> held;
+
+    /// The fd of the commit at the front of the queue, while it is being waited for
+    /// @{
+    Fd waiting_on;
+    wl_event_source* source{nullptr};
+    /// @}
+};
+}
+}
+
+#endif // MIR_FRONTEND_HELD_COMMIT_QUEUE_H_
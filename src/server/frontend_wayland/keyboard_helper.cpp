@@ -16,13 +16,11 @@
 
 #include "keyboard_helper.h"
 
-#include "mir/anonymous_shm_file.h"
 #include "mir/input/keymap.h"
+#include "mir/input/keymap_cache.h"
 #include "mir/events/keyboard_event.h"
 #include "mir/input/seat.h"
-#include "mir/fatal.h"
 
-#include <cstring> // memcpy
 #include <unordered_set>
 
 namespace mf = mir::frontend;
@@ -36,15 +34,8 @@ mf::KeyboardHelper::KeyboardHelper(
     bool enable_key_repeat)
     : callbacks{callbacks},
       mir_seat{seat},
-      current_keymap{nullptr}, // will be set later in the constructor by set_keymap()
-      compiled_keymap{nullptr, &xkb_keymap_unref},
-      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+      current_keymap{nullptr} // will be set later in the constructor by set_keymap()
 {
-    if (!context)
-    {
-        fatal_error("Failed to create XKB context");
-    }
-
     /* The wayland::Keyboard constructor has already run, creating the keyboard
      * resource. It is thus safe to send a keymap event to it; the client will receive
      * the keyboard object before this event.
@@ -131,19 +122,10 @@ void mf::KeyboardHelper::set_keymap(std::shared_ptr<mi::Keymap> const& new_keyma
     }
 
     current_keymap = new_keymap;
-    compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
-
-    std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(
-        compiled_keymap.get(),
-        XKB_KEYMAP_FORMAT_TEXT_V1),
-        free};
-    // so the null terminator is included
-    auto length = strlen(buffer.get()) + 1;
-
-    mir::AnonymousShmFile shm_buffer{length};
-    memcpy(shm_buffer.base_ptr(), buffer.get(), length);
+    // Every client with a matching keymap shares the same compilation and sealed fd
+    compiled_keymap = mi::compile_keymap(new_keymap);
 
-    callbacks->send_keymap_xkb_v1(Fd{IntOwnedFd{shm_buffer.fd()}}, length);
+    callbacks->send_keymap_xkb_v1(compiled_keymap->fd(), compiled_keymap->size());
 }
 
 void mf::KeyboardHelper::set_modifiers(MirXkbModifiers const& new_modifiers)
@@ -27,14 +27,13 @@ struct MirEvent;
 struct MirKeyboardEvent;
 
 // from <xkbcommon/xkbcommon.h>
-struct xkb_keymap;
 struct xkb_state;
-struct xkb_context;
 
 namespace mir
 {
 namespace input
 {
+class CompiledKeymap;
 class Keymap;
 class Seat;
 }
@@ -82,8 +81,7 @@ private:
     std::shared_ptr<input::Seat> const mir_seat;
     MirXkbModifiers modifiers;
     std::shared_ptr<mir::input::Keymap> current_keymap;
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> compiled_keymap;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
+    std::shared_ptr<mir::input::CompiledKeymap const> compiled_keymap;
 };
 }
 }
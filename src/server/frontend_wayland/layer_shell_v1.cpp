@@ -31,6 +31,7 @@
 #include <deque>
 #include <vector>
 #include <algorithm>
+#include <utility>
 
 namespace mf = mir::frontend;
 namespace ms = mir::scene;
@@ -113,6 +114,8 @@ private:
         auto is_pending() const -> bool { return _pending; }
         void set_pending(T const& value) { _pending = value; }
         auto committed() const -> T const& { return _committed; }
+        auto take_pending() -> std::optional<T> { return std::exchange(_pending, std::nullopt); }
+        void replace_pending(std::optional<T> const& value) { _pending = value; }
         void commit()
         {
             if (_pending)
@@ -149,6 +152,18 @@ private:
         bool bottom{false};
     };
 
+    /// Pending state held with a commit that is waiting to be applied
+    struct LayerPendingState : PendingState
+    {
+        std::unique_ptr<PendingState> window;
+        std::optional<int32_t> exclusive_zone;
+        std::optional<Anchors> anchors;
+        std::optional<Margin> margin;
+        std::optional<geometry::Size> client_size;
+        std::optional<geometry::Displacement> offset;
+        bool configure_on_next_commit{false};
+    };
+
     /// Returns all anchored edges ored together
     auto get_placement_gravity() const -> MirPlacementGravity;
 
@@ -190,6 +205,8 @@ private:
         geometry::Size const& /*new_size*/) override;
     void handle_close_request() override;
     void surface_destroyed() override;
+    auto take_pending_state() -> std::unique_ptr<PendingState> override;
+    void set_pending_state(std::unique_ptr<PendingState> state) override;
 
     void destroy_role() const override
     {
@@ -675,6 +692,34 @@ void mf::LayerSurfaceV1::handle_close_request()
     send_closed_event();
 }
 
+auto mf::LayerSurfaceV1::take_pending_state() -> std::unique_ptr<PendingState>
+{
+    auto state = std::make_unique<LayerPendingState>();
+    state->window = WindowWlSurfaceRole::take_pending_state();
+    state->exclusive_zone = exclusive_zone.take_pending();
+    state->anchors = anchors.take_pending();
+    state->margin = margin.take_pending();
+    state->client_size = client_size.take_pending();
+    state->offset = offset.take_pending();
+    state->configure_on_next_commit = std::exchange(configure_on_next_commit, false);
+    return state;
+}
+
+void mf::LayerSurfaceV1::set_pending_state(std::unique_ptr<PendingState> state)
+{
+    LayerPendingState nothing_pending;
+    auto const layer_state = dynamic_cast<LayerPendingState*>(state.get());
+    auto& pending_state = layer_state ? *layer_state : nothing_pending;
+
+    WindowWlSurfaceRole::set_pending_state(std::move(pending_state.window));
+    exclusive_zone.replace_pending(pending_state.exclusive_zone);
+    anchors.replace_pending(pending_state.anchors);
+    margin.replace_pending(pending_state.margin);
+    client_size.replace_pending(pending_state.client_size);
+    offset.replace_pending(pending_state.offset);
+    configure_on_next_commit = pending_state.configure_on_next_commit;
+}
+
 void mf::LayerSurfaceV1::surface_destroyed()
 {
     if (!Resource::client->is_being_destroyed())
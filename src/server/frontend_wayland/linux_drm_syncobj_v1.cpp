@@ -0,0 +1,277 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "linux_drm_syncobj_v1.h"
+
+#include "mir/wayland/protocol_error.h"
+#include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/drm_syncobj.h"
+#include "mir/log.h"
+
+#include "wl_surface.h"
+
+#include <boost/throw_exception.hpp>
+#include <cinttypes>
+#include <set>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+namespace
+{
+/// The surfaces that already have a wp_linux_drm_syncobj_surface_v1 (only touched on the Wayland thread)
+using SyncedSurfaces = std::set<mf::WlSurface*>;
+
+class LinuxDrmSyncobjManagerV1Global : public mw::LinuxDrmSyncobjManagerV1::Global
+{
+public:
+    LinuxDrmSyncobjManagerV1Global(wl_display* display, mir::Fd drm_fd);
+
+private:
+    void bind(wl_resource* new_resource) override;
+
+    mir::Fd const drm_fd;
+    std::shared_ptr<SyncedSurfaces> const synced_surfaces;
+};
+
+class LinuxDrmSyncobjManagerV1 : public mw::LinuxDrmSyncobjManagerV1
+{
+public:
+    LinuxDrmSyncobjManagerV1(wl_resource* resource, mir::Fd drm_fd, std::shared_ptr<SyncedSurfaces> synced_surfaces);
+
+private:
+    void get_surface(wl_resource* id, wl_resource* surface) override;
+    void import_timeline(wl_resource* id, mir::Fd fd) override;
+
+    mir::Fd const drm_fd;
+    std::shared_ptr<SyncedSurfaces> const synced_surfaces;
+};
+
+class LinuxDrmSyncobjTimelineV1 : public mw::LinuxDrmSyncobjTimelineV1
+{
+public:
+    LinuxDrmSyncobjTimelineV1(wl_resource* resource, std::shared_ptr<mg::drm::Syncobj const> timeline);
+
+    static auto timeline_from(wl_resource* resource) -> std::shared_ptr<mg::drm::Syncobj const>;
+
+private:
+    std::shared_ptr<mg::drm::Syncobj const> const timeline;
+};
+
+class LinuxDrmSyncobjSurfaceV1 : public mw::LinuxDrmSyncobjSurfaceV1
+{
+public:
+    LinuxDrmSyncobjSurfaceV1(
+        wl_resource* resource,
+        std::shared_ptr<SyncedSurfaces> synced_surfaces,
+        mf::WlSurface* surface);
+    ~LinuxDrmSyncobjSurfaceV1();
+
+private:
+    void set_acquire_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo) override;
+    void set_release_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo) override;
+
+    auto surface() -> mf::WlSurface&;
+
+    std::shared_ptr<SyncedSurfaces> const synced_surfaces;
+    mw::Weak<mf::WlSurface> const wl_surface;
+    mw::DestroyListenerId const surface_destroyed_listener_id;
+};
+
+auto point_from(uint32_t point_hi, uint32_t point_lo) -> uint64_t
+{
+    return (static_cast<uint64_t>(point_hi) << 32) | point_lo;
+}
+}
+
+auto mf::create_linux_drm_syncobj_manager_v1(
+    wl_display* display,
+    std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
+-> std::shared_ptr<mw::LinuxDrmSyncobjManagerV1::Global>
+{
+    if (auto drm_fd = allocator->drm_syncobj_device())
+    {
+        return std::make_shared<LinuxDrmSyncobjManagerV1Global>(display, std::move(*drm_fd));
+    }
+    mir::log_info("Graphics platform does not support explicit sync; not enabling wp_linux_drm_syncobj_v1");
+    return nullptr;
+}
+
+LinuxDrmSyncobjManagerV1Global::LinuxDrmSyncobjManagerV1Global(wl_display* display, mir::Fd drm_fd)
+    : Global{display, Version<1>()},
+      drm_fd{std::move(drm_fd)},
+      synced_surfaces{std::make_shared<SyncedSurfaces>()}
+{
+}
+
+void LinuxDrmSyncobjManagerV1Global::bind(wl_resource* new_resource)
+{
+    new LinuxDrmSyncobjManagerV1{new_resource, drm_fd, synced_surfaces};
+}
+
+LinuxDrmSyncobjManagerV1::LinuxDrmSyncobjManagerV1(
+    wl_resource* resource,
+    mir::Fd drm_fd,
+    std::shared_ptr<SyncedSurfaces> synced_surfaces)
+    : mw::LinuxDrmSyncobjManagerV1{resource, Version<1>()},
+      drm_fd{std::move(drm_fd)},
+      synced_surfaces{std::move(synced_surfaces)}
+{
+}
+
+void LinuxDrmSyncobjManagerV1::get_surface(wl_resource* id, wl_resource* surface)
+{
+    auto const wl_surface = mf::WlSurface::from(surface);
+
+    if (synced_surfaces->contains(wl_surface))
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::surface_exists,
+            "wl_surface already has a wp_linux_drm_syncobj_surface_v1"));
+    }
+
+    new LinuxDrmSyncobjSurfaceV1{id, synced_surfaces, wl_surface};
+}
+
+void LinuxDrmSyncobjManagerV1::import_timeline(wl_resource* id, mir::Fd fd)
+{
+    std::shared_ptr<mg::drm::Syncobj const> timeline;
+    try
+    {
+        timeline = std::make_shared<mg::drm::Syncobj const>(drm_fd, fd);
+    }
+    catch (std::system_error const& err)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_timeline,
+            "Failed to import DRM syncobj timeline: %s", err.what()));
+    }
+
+    new LinuxDrmSyncobjTimelineV1{id, std::move(timeline)};
+}
+
+LinuxDrmSyncobjTimelineV1::LinuxDrmSyncobjTimelineV1(
+    wl_resource* resource,
+    std::shared_ptr<mg::drm::Syncobj const> timeline)
+    : mw::LinuxDrmSyncobjTimelineV1{resource, Version<1>()},
+      timeline{std::move(timeline)}
+{
+}
+
+auto LinuxDrmSyncobjTimelineV1::timeline_from(wl_resource* resource) -> std::shared_ptr<mg::drm::Syncobj const>
+{
+    return static_cast<LinuxDrmSyncobjTimelineV1*>(mw::LinuxDrmSyncobjTimelineV1::from(resource))->timeline;
+}
+
+LinuxDrmSyncobjSurfaceV1::LinuxDrmSyncobjSurfaceV1(
+    wl_resource* resource,
+    std::shared_ptr<SyncedSurfaces> synced_surfaces,
+    mf::WlSurface* surface)
+    : mw::LinuxDrmSyncobjSurfaceV1{resource, Version<1>()},
+      synced_surfaces{std::move(synced_surfaces)},
+      wl_surface{surface},
+      surface_destroyed_listener_id{surface->add_destroy_listener(
+          [synced_surfaces=this->synced_surfaces, surface]()
+          {
+              synced_surfaces->erase(surface);
+          })}
+{
+    this->synced_surfaces->insert(surface);
+    surface->set_commit_validator([syncobj_surface = resource](mf::WlSurfaceState const& state)
+        {
+            mf::check_explicit_sync_commit(syncobj_surface, state);
+        });
+}
+
+LinuxDrmSyncobjSurfaceV1::~LinuxDrmSyncobjSurfaceV1()
+{
+    if (wl_surface)
+    {
+        auto& surface = wl_surface.value();
+        surface.remove_destroy_listener(surface_destroyed_listener_id);
+        surface.set_commit_validator({});
+        synced_surfaces->erase(&surface);
+    }
+}
+
+void LinuxDrmSyncobjSurfaceV1::set_acquire_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    surface().set_pending_acquire_point({LinuxDrmSyncobjTimelineV1::timeline_from(timeline), point_from(point_hi, point_lo)});
+}
+
+void LinuxDrmSyncobjSurfaceV1::set_release_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    surface().set_pending_release_point({LinuxDrmSyncobjTimelineV1::timeline_from(timeline), point_from(point_hi, point_lo)});
+}
+
+auto LinuxDrmSyncobjSurfaceV1::surface() -> mf::WlSurface&
+{
+    if (!wl_surface)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::no_surface,
+            "wl_surface of wp_linux_drm_syncobj_surface_v1 has been destroyed"));
+    }
+    return wl_surface.value();
+}
+
+void mf::check_explicit_sync_commit(wl_resource* syncobj_surface, WlSurfaceState const& state)
+{
+    bool const has_buffer = state.buffer && state.buffer.value();
+
+    if (!has_buffer)
+    {
+        if (state.acquire_point || state.release_point)
+        {
+            BOOST_THROW_EXCEPTION(mw::ProtocolError(
+                syncobj_surface,
+                mw::LinuxDrmSyncobjSurfaceV1::Error::no_buffer,
+                "Timeline point set without a buffer attached"));
+        }
+        return;
+    }
+
+    if (!state.acquire_point)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            syncobj_surface,
+            mw::LinuxDrmSyncobjSurfaceV1::Error::no_acquire_point,
+            "Buffer attached without an acquire point"));
+    }
+
+    if (!state.release_point)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            syncobj_surface,
+            mw::LinuxDrmSyncobjSurfaceV1::Error::no_release_point,
+            "Buffer attached without a release point"));
+    }
+
+    if (state.acquire_point->timeline == state.release_point->timeline &&
+        state.release_point->point <= state.acquire_point->point)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            syncobj_surface,
+            mw::LinuxDrmSyncobjSurfaceV1::Error::conflicting_points,
+            "Release point %" PRIu64 " is not after acquire point %" PRIu64 " on the same timeline",
+            state.release_point->point,
+            state.acquire_point->point));
+    }
+}
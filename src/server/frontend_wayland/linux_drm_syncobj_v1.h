@@ -0,0 +1,47 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_LINUX_DRM_SYNCOBJ_V1_H_
+#define MIR_FRONTEND_LINUX_DRM_SYNCOBJ_V1_H_
+
+#include "linux-drm-syncobj-v1_wrapper.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class GraphicBufferAllocator;
+}
+namespace frontend
+{
+struct WlSurfaceState;
+
+/// Returns nullptr if the allocator does not support explicit synchronisation
+auto create_linux_drm_syncobj_manager_v1(
+    wl_display* display,
+    std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
+-> std::shared_ptr<wayland::LinuxDrmSyncobjManagerV1::Global>;
+
+/// Checks a commit to a surface with a wp_linux_drm_syncobj_surface_v1 has the timeline points the protocol requires
+///
+/// 	hrows wayland::ProtocolError (raised on syncobj_surface) if it does not
+void check_explicit_sync_commit(wl_resource* syncobj_surface, WlSurfaceState const& state);
+}
+}
+
+#endif // MIR_FRONTEND_LINUX_DRM_SYNCOBJ_V1_H_
@@ -39,20 +39,22 @@ mf::ShmBuffer::ShmBuffer(
     std::shared_ptr<shm::RWMappableRange> data,
     geometry::Size size,
     geometry::Stride stride,
-    graphics::DRMFormat format)
+    graphics::DRMFormat format,
+    std::shared_ptr<ClientMemory::Charge> pool_charge)
     : Buffer{resource, Version<1>{}},
       weak_me{wayland::make_weak(this)},
       wayland_executor{std::move(wayland_executor)},
       data_{std::move(data)},
       size_{std::move(size)},
       stride_{stride},
-      format_{format}
+      format_{format},
+      pool_charge{std::move(pool_charge)}
 {
 }
 
 namespace
 {
-class ErrorNotifyingRWMappableBuffer : public mrs::RWMappableBuffer
+class ErrorNotifyingRWMappableBuffer : public mrs::RWMappableBuffer, public mrs::MemfdBackedBuffer
 {
 public:
     ErrorNotifyingRWMappableBuffer(
@@ -71,6 +73,8 @@ public:
     auto map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>> override;
     auto map_rw() -> std::unique_ptr<mrs::Mapping<unsigned char>> override;
 
+    auto memfd_range() const -> std::optional<Range> override;
+
     void notify_access_error() const;
 private:
     mir::wayland::Weak<mf::ShmBuffer> const weak_buffer;
@@ -198,6 +202,15 @@ auto ErrorNotifyingRWMappableBuffer::map_writeable() -> std::unique_ptr<mrs::Map
 {
     return std::make_unique<ErrorNotifyingMapping<unsigned char>>(data->map_wo(), *this);
 }
+
+auto ErrorNotifyingRWMappableBuffer::memfd_range() const -> std::optional<Range>
+{
+    if (auto range = data->sealed_memfd_range())
+    {
+        return Range{std::move(range->file), range->offset, range->len, data};
+    }
+    return std::nullopt;
+}
 }
 
 auto mf::ShmBuffer::data() -> std::shared_ptr<mrs::RWMappableBuffer>
@@ -223,11 +236,13 @@ auto mf::ShmBuffer::from(wl_resource* resource) -> ShmBuffer*
 mf::ShmPool::ShmPool(
     struct wl_resource* resource,
     std::shared_ptr<Executor> wayland_executor,
+    ClientMemory& client_memory,
     Fd backing_store,
     int32_t claimed_size) :
     wayland::ShmPool(resource, Version<1>{}),
     wayland_executor{std::move(wayland_executor)},
-    backing_store{shm::rw_pool_from_fd(std::move(backing_store), claimed_size)}
+    backing_store{shm::rw_pool_from_fd(std::move(backing_store), claimed_size)},
+    charge{client_memory.charge(client->raw_client(), ClientMemory::Kind::shm, claimed_size)}
 {
 }
 
@@ -299,29 +314,33 @@ void mf::ShmPool::create_buffer(
         std::move(backing_range),
         geometry::Size{width, height},
         geometry::Stride{stride},
-        wl_shm_format_to_drm_format(format)
+        wl_shm_format_to_drm_format(format),
+        charge
     };
 }
 
 void mf::ShmPool::resize(int32_t new_size)
 {
     backing_store->resize(new_size);
+    charge->resize(new_size);
 }
 
-mf::WlShm::WlShm(wl_display* display, std::shared_ptr<Executor> wayland_executor)
+mf::WlShm::WlShm(wl_display* display, std::shared_ptr<Executor> wayland_executor, ClientMemory& client_memory)
     : wayland::Shm::Global(display, Version<1>{}),
-      wayland_executor{std::move(wayland_executor)}
+      wayland_executor{std::move(wayland_executor)},
+      client_memory{client_memory}
 {
 }
 
 void mf::WlShm::bind(wl_resource* new_wl_shm)
 {
-    new Shm{new_wl_shm, wayland_executor};
+    new Shm{new_wl_shm, wayland_executor, client_memory};
 }
 
-mf::Shm::Shm(wl_resource* resource, std::shared_ptr<Executor> wayland_executor)
+mf::Shm::Shm(wl_resource* resource, std::shared_ptr<Executor> wayland_executor, ClientMemory& client_memory)
     : wayland::Shm(resource, Version<1>{}),
-      wayland_executor{std::move(wayland_executor)}
+      wayland_executor{std::move(wayland_executor)},
+      client_memory{client_memory}
 {
     // TODO: send all the formats we support, beyond the mandatory ones.
     for (auto format : { Format::argb8888, Format::xrgb8888 })
@@ -332,5 +351,5 @@ mf::Shm::Shm(wl_resource* resource, std::shared_ptr<Executor> wayland_executor)
 
 void mf::Shm::create_pool(wl_resource* id, Fd fd, int32_t size)
 {
-    new ShmPool{id, wayland_executor, fd, size};
+    new ShmPool{id, wayland_executor, client_memory, fd, size};
 }
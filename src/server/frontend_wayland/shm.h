@@ -18,6 +18,7 @@
 #include "mir/wayland/weak.h"
 #include "wayland_wrapper.h"
 #include "mir/graphics/drm_formats.h"
+#include "client_memory.h"
 
 #include <sys/mman.h>
 #include <fcntl.h>
@@ -49,6 +50,7 @@ class ShmBuffer : public wayland::Buffer
 {
 public:
     auto data() -> std::shared_ptr<renderer::software::RWMappableBuffer>;
+    auto size() const -> geometry::Size { return size_; }
 
     static auto from(wl_resource* resource) -> ShmBuffer*;
 private:
@@ -59,11 +61,14 @@ private:
         std::shared_ptr<shm::RWMappableRange> data,
         geometry::Size size,
         geometry::Stride stride,
-        graphics::DRMFormat format);
+        graphics::DRMFormat format,
+        std::shared_ptr<ClientMemory::Charge> pool_charge);
 
     wayland::Weak<ShmBuffer> const weak_me;
     std::shared_ptr<Executor> const wayland_executor;
     std::shared_ptr<shm::RWMappableRange> const data_;
+    /// The pool stays mapped while any of its buffers exist
+    std::shared_ptr<ClientMemory::Charge> const pool_charge;
     geometry::Size const size_;
     geometry::Stride const stride_;
     graphics::DRMFormat const format_;
@@ -76,6 +81,7 @@ private:
     ShmPool(
         struct wl_resource* resource,
         std::shared_ptr<Executor> wayland_executor,
+        ClientMemory& client_memory,
         Fd backing_store,
         int32_t claimed_size);
 
@@ -90,6 +96,7 @@ private:
 
     std::shared_ptr<Executor> const wayland_executor;
     std::shared_ptr<shm::ReadWritePool> const backing_store;
+    std::shared_ptr<ClientMemory::Charge> const charge;
 };
 
 class Shm : public wayland::Shm
@@ -97,21 +104,24 @@ class Shm : public wayland::Shm
 public:
 private:
     friend class WlShm;
-    Shm(struct wl_resource* resource, std::shared_ptr<Executor> wayland_executor);
+    Shm(struct wl_resource* resource, std::shared_ptr<Executor> wayland_executor, ClientMemory& client_memory);
 
     void create_pool(struct wl_resource* id, Fd fd, int32_t size) override;
 
     std::shared_ptr<Executor> const wayland_executor;
+    ClientMemory& client_memory;
 };
 
 class WlShm : public wayland::Shm::Global
 {
 public:
-    WlShm(wl_display* display, std::shared_ptr<Executor> wayland_executor);
+    /// \param client_memory   must outlive the display; pools are charged to the clients that create them
+    WlShm(wl_display* display, std::shared_ptr<Executor> wayland_executor, ClientMemory& client_memory);
 
 private:
     void bind(wl_resource* new_wl_shm) override;
 
     std::shared_ptr<Executor> const wayland_executor;
+    ClientMemory& client_memory;
 };
 }
@@ -0,0 +1,149 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tearing_control_v1.h"
+
+#include "mir/wayland/protocol_error.h"
+
+#include "wl_surface.h"
+
+#include <boost/throw_exception.hpp>
+#include <set>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+
+namespace
+{
+/// The surfaces that already have a wp_tearing_control_v1 (only touched on the Wayland thread)
+using ControlledSurfaces = std::set<mf::WlSurface*>;
+
+class TearingControlManagerV1Global : public mw::TearingControlManagerV1::Global
+{
+public:
+    TearingControlManagerV1Global(wl_display* display);
+
+private:
+    void bind(wl_resource* new_resource) override;
+
+    std::shared_ptr<ControlledSurfaces> const controlled_surfaces;
+};
+
+class TearingControlManagerV1 : public mw::TearingControlManagerV1
+{
+public:
+    TearingControlManagerV1(wl_resource* resource, std::shared_ptr<ControlledSurfaces> controlled_surfaces);
+
+private:
+    void get_tearing_control(wl_resource* id, wl_resource* surface) override;
+
+    std::shared_ptr<ControlledSurfaces> const controlled_surfaces;
+};
+
+class TearingControlV1 : public mw::TearingControlV1
+{
+public:
+    TearingControlV1(
+        wl_resource* resource,
+        std::shared_ptr<ControlledSurfaces> controlled_surfaces,
+        mf::WlSurface* surface);
+    ~TearingControlV1();
+
+private:
+    void set_presentation_hint(uint32_t hint) override;
+
+    std::shared_ptr<ControlledSurfaces> const controlled_surfaces;
+    mw::Weak<mf::WlSurface> const wl_surface;
+    mw::DestroyListenerId const surface_destroyed_listener_id;
+};
+}
+
+auto mf::create_tearing_control_manager_v1(wl_display* display)
+-> std::shared_ptr<mw::TearingControlManagerV1::Global>
+{
+    return std::make_shared<TearingControlManagerV1Global>(display);
+}
+
+TearingControlManagerV1Global::TearingControlManagerV1Global(wl_display* display)
+    : Global{display, Version<1>()},
+      controlled_surfaces{std::make_shared<ControlledSurfaces>()}
+{
+}
+
+void TearingControlManagerV1Global::bind(wl_resource* new_resource)
+{
+    new TearingControlManagerV1{new_resource, controlled_surfaces};
+}
+
+TearingControlManagerV1::TearingControlManagerV1(
+    wl_resource* resource,
+    std::shared_ptr<ControlledSurfaces> controlled_surfaces)
+    : mw::TearingControlManagerV1{resource, Version<1>()},
+      controlled_surfaces{std::move(controlled_surfaces)}
+{
+}
+
+void TearingControlManagerV1::get_tearing_control(wl_resource* id, wl_resource* surface)
+{
+    auto const wl_surface = mf::WlSurface::from(surface);
+
+    if (controlled_surfaces->contains(wl_surface))
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::tearing_control_exists,
+            "wl_surface already has a wp_tearing_control_v1"));
+    }
+
+    new TearingControlV1{id, controlled_surfaces, wl_surface};
+}
+
+TearingControlV1::TearingControlV1(
+    wl_resource* resource,
+    std::shared_ptr<ControlledSurfaces> controlled_surfaces,
+    mf::WlSurface* surface)
+    : mw::TearingControlV1{resource, Version<1>()},
+      controlled_surfaces{std::move(controlled_surfaces)},
+      wl_surface{surface},
+      surface_destroyed_listener_id{surface->add_destroy_listener(
+          [controlled_surfaces=this->controlled_surfaces, surface]()
+          {
+              controlled_surfaces->erase(surface);
+          })}
+{
+    this->controlled_surfaces->insert(surface);
+}
+
+TearingControlV1::~TearingControlV1()
+{
+    if (wl_surface)
+    {
+        auto& surface = wl_surface.value();
+        surface.remove_destroy_listener(surface_destroyed_listener_id);
+        controlled_surfaces->erase(&surface);
+
+        // Destroying the object reverts to vsync on the next commit
+        surface.set_pending_tearing_allowed(false);
+    }
+}
+
+void TearingControlV1::set_presentation_hint(uint32_t hint)
+{
+    if (wl_surface)
+    {
+        wl_surface.value().set_pending_tearing_allowed(hint == PresentationHint::async);
+    }
+}
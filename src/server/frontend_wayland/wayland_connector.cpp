@@ -26,6 +26,8 @@
 #include "frame_executor.h"
 #include "output_manager.h"
 #include "wayland_executor.h"
+#include "client_flusher.h"
+#include "client_memory.h"
 #include "desktop_file_manager.h"
 #include "foreign_toplevel_manager_v1.h"
 
@@ -66,9 +68,11 @@ public:
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& wayland_executor,
         std::shared_ptr<mir::Executor> const& frame_callback_executor,
-        std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
+        std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
+        ClientMemory& client_memory)
         : Global(display, Version<4>()),
           allocator{allocator},
+          client_memory{client_memory},
           wayland_executor{wayland_executor},
           frame_callback_executor{frame_callback_executor}
     {
@@ -78,6 +82,7 @@ public:
 
 private:
     std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
+    ClientMemory& client_memory;
     std::shared_ptr<mir::Executor> const wayland_executor;
     std::shared_ptr<mir::Executor> const frame_callback_executor;
     std::map<std::pair<wl_client*, uint32_t>, std::vector<std::function<void(WlSurface*)>>> surface_callbacks;
@@ -123,7 +128,8 @@ void WlCompositor::Instance::create_surface(wl_resource* new_surface)
         new_surface,
         compositor->wayland_executor,
         compositor->frame_callback_executor,
-        compositor->allocator};
+        compositor->allocator,
+        compositor->client_memory};
     auto const key = std::make_pair(wl_resource_get_client(new_surface), wl_resource_get_id(new_surface));
     auto const callbacks = compositor->surface_callbacks.find(key);
     if (callbacks != compositor->surface_callbacks.end())
@@ -148,8 +154,8 @@ namespace
 {
 int halt_eventloop(int fd, uint32_t /*mask*/, void* data)
 {
-    auto display = reinterpret_cast<wl_display*>(data);
-    wl_display_terminate(display);
+    auto dispatching = reinterpret_cast<bool*>(data);
+    *dispatching = false;
 
     eventfd_t ignored;
     if (eventfd_read(fd, &ignored) < 0)
@@ -239,15 +245,18 @@ mf::WaylandConnector::WaylandConnector(
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter,
     bool enable_key_repeat,
-    std::shared_ptr<scene::SessionLock> const& session_lock)
+    std::shared_ptr<scene::SessionLock> const& session_lock,
+    std::shared_ptr<ClientMemory> const& client_memory)
     : extension_filter{extension_filter},
+      client_memory{client_memory},
       display{wl_display_create(), &cleanup_display},
       pause_signal{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)},
       executor{std::make_shared<WaylandExecutor>(wl_display_get_event_loop(display.get()))},
       allocator{allocator_for_display(allocator, display.get(), executor)},
       shell{shell},
       extensions{std::move(extensions_)},
-      session_lock_{session_lock}
+      session_lock_{session_lock},
+      client_flusher{std::make_unique<ClientFlusher>(display.get())}
 {
     if (pause_signal == mir::Fd::invalid)
     {
@@ -282,7 +291,8 @@ mf::WaylandConnector::WaylandConnector(
         display.get(),
         executor,
         std::make_shared<FrameExecutor>(*main_loop),
-        this->allocator);
+        this->allocator,
+        *this->client_memory);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
     seat_global = std::make_unique<mf::WlSeat>(
         display.get(),
@@ -327,7 +337,7 @@ mf::WaylandConnector::WaylandConnector(
         desktop_file_manager,
         session_lock_});
 
-    shm_global = std::make_unique<WlShm>(display.get(), executor);
+    shm_global = std::make_unique<WlShm>(display.get(), executor, *this->client_memory);
 
     char const* wayland_display = nullptr;
 
@@ -366,6 +376,8 @@ mf::WaylandConnector::WaylandConnector(
 
     WlClient::setup_new_client_handler(display.get(), shell, session_authorizer, [this](WlClient& client)
         {
+            client_flusher->add(client);
+
             int const fd = wl_client_get_fd(client.raw_client());
             auto const handler_iter = connect_handlers.find(fd);
 
@@ -377,7 +389,7 @@ mf::WaylandConnector::WaylandConnector(
             }
         });
 
-    pause_source = wl_event_loop_add_fd(wayland_loop, pause_signal, WL_EVENT_READABLE, &halt_eventloop, display.get());
+    pause_source = wl_event_loop_add_fd(wayland_loop, pause_signal, WL_EVENT_READABLE, &halt_eventloop, &dispatching);
 }
 
 mf::WaylandConnector::~WaylandConnector()
@@ -404,13 +416,16 @@ mf::WaylandConnector::~WaylandConnector()
 
 void mf::WaylandConnector::start()
 {
+    dispatching = true;
     dispatch_thread = std::thread{
-        [](wl_display* d)
+        [this]()
         {
             mir::set_thread_name("Mir/Wayland");
-            wl_display_run(d);
-        },
-        display.get()};
+            while (dispatching)
+            {
+                client_flusher->dispatch_and_flush(-1);
+            }
+        }};
 }
 
 void mf::WaylandConnector::stop()
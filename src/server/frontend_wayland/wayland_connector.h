@@ -73,6 +73,8 @@ class Clock;
 }
 namespace frontend
 {
+class ClientFlusher;
+class ClientMemory;
 class OutputManager;
 class PointerInputDispatcher;
 class SessionAuthorizer;
@@ -161,7 +163,8 @@ public:
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter,
         bool enable_key_repeat,
-        std::shared_ptr<scene::SessionLock> const& session_lock);
+        std::shared_ptr<scene::SessionLock> const& session_lock,
+        std::shared_ptr<ClientMemory> const& client_memory);
 
     ~WaylandConnector() override;
 
@@ -198,6 +201,9 @@ private:
      */
     WaylandProtocolExtensionFilter const extension_filter;
 
+    /// Charges are released as client resources are destroyed, so this also needs to outlive the wl_display
+    std::shared_ptr<ClientMemory> const client_memory;
+
     std::unique_ptr<wl_display, void(*)(wl_display*)> const display;
     mir::Fd const pause_signal;
     std::unique_ptr<WlCompositor> compositor_global;
@@ -212,7 +218,9 @@ private:
     std::shared_ptr<shell::Shell> const shell;
     std::unique_ptr<WaylandExtensions> const extensions;
     std::shared_ptr<scene::SessionLock> session_lock_;
+    std::unique_ptr<ClientFlusher> const client_flusher;
     std::thread dispatch_thread;
+    bool dispatching{false};    ///< Set by start(), then only accessed on the event loop
     wl_event_source* pause_source;
     std::string wayland_display;
 
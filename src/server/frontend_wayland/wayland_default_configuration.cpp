@@ -22,16 +22,19 @@
 #include "mir/options/default_configuration.h"
 #include "mir/scene/session.h"
 
+#include "client_memory.h"
 #include "foreign_toplevel_manager_v1.h"
 #include "idle_inhibit_v1.h"
 #include "input_method_v1.h"
 #include "input_method_v2.h"
 #include "layer_shell_v1.h"
+#include "linux_drm_syncobj_v1.h"
 #include "mir_shell.h"
 #include "pointer_constraints_unstable_v1.h"
 #include "primary_selection_v1.h"
 #include "relative_pointer_unstable_v1.h"
 #include "session_lock_v1.h"
+#include "tearing_control_v1.h"
 #include "text_input_v1.h"
 #include "text_input_v2.h"
 #include "text_input_v3.h"
@@ -214,6 +217,14 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
         {
             return mf::create_mir_shell_v1(ctx.display);
         }),
+    make_extension_builder<mw::TearingControlManagerV1>([](auto const& ctx)
+        {
+            return mf::create_tearing_control_manager_v1(ctx.display);
+        }),
+    make_extension_builder<mw::LinuxDrmSyncobjManagerV1>([](auto const& ctx)
+        {
+            return mf::create_linux_drm_syncobj_manager_v1(ctx.display, ctx.graphic_buffer_allocator);
+        }),
 };
 
 ExtensionBuilder const xwayland_builder {
@@ -313,7 +324,9 @@ auto mf::get_standard_extensions() -> std::vector<std::string>
         mw::TextInputManagerV1::interface_name,
         mw::TextInputManagerV2::interface_name,
         mw::TextInputManagerV3::interface_name,
-        mw::MirShellV1::interface_name};
+        mw::MirShellV1::interface_name,
+        mw::TearingControlManagerV1::interface_name,
+        mw::LinuxDrmSyncobjManagerV1::interface_name};
 }
 
 auto mf::get_supported_extensions() -> std::vector<std::string>
@@ -340,6 +353,16 @@ std::shared_ptr<mf::Connector>
                 enabled_wayland_extensions.end()};
 
             auto const enable_repeat = options->get<bool>(options::enable_key_repeat_opt);
+
+            auto const mebibytes = [&options](char const* option) -> size_t
+                {
+                    auto const value = options->get<int>(option);
+                    return value > 0 ? size_t(value) << 20 : 0;
+                };
+            mf::ClientMemory::Limits const memory_limits{
+                mebibytes(options::client_memory_soft_limit_opt),
+                mebibytes(options::client_memory_hard_limit_opt)};
+
             auto const x11_enabled = options->is_set(mo::x11_display_opt) && options->get<bool>(mo::x11_display_opt);
 
             return std::make_shared<mf::WaylandConnector>(
@@ -369,7 +392,8 @@ std::shared_ptr<mf::Connector>
                     wayland_extension_hooks),
                 wayland_extension_filter,
                 enable_repeat,
-                the_session_lock());
+                the_session_lock(),
+                std::make_shared<mf::ClientMemory>(memory_limits, the_scene_report()));
         });
 }
 
@@ -18,13 +18,14 @@
 
 #include "mir/fd.h"
 #include "mir/log.h"
+#include "mir/mpsc_work_queue.h"
 
 #include <sys/eventfd.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
 #include <cstring>
-#include <deque>
 #include <functional>
 #include <mutex>
 #include <system_error>
@@ -64,56 +65,64 @@ public:
             });
     }
 
-    void enqueue(std::function<void()>&& work)
+    /**
+     * \return true if the event loop needs to be notified of the work
+     */
+    auto enqueue(std::function<void()>&& work) -> bool
     {
         if (on_wayland_thread)
         {
             work();
-            return;
+            return false;
         }
 
-        std::lock_guard lock{mutex};
-        if (state == ExecutionState::Running)
+        if (state.load(std::memory_order_acquire) == ExecutionState::Running)
         {
-            workqueue.emplace_back(std::move(work));
+            return workqueue.push(std::move(work));
         }
         // If we've been terminated then drop the work on the floor, letting the
         // std::function destructor clean up any necessary state.
+        return false;
     }
 
-    void enqueue_termination(std::function<void()>&& terminator)
+    void enqueue_termination(std::function<void()>&& termination)
     {
         std::lock_guard lock{mutex};
-        if (state == ExecutionState::Running)
+        if (state.load(std::memory_order_relaxed) == ExecutionState::Running)
         {
-            workqueue.emplace_front(std::move(terminator));
+            terminator = std::move(termination);
             on_wayland_thread = false;
-            state = ExecutionState::TerminationRequested;
+            state.store(ExecutionState::TerminationRequested, std::memory_order_release);
         }
     }
 
-    std::function<void()> get_work()
+    /**
+     * Get the next work item; the termination request, if any, takes precedence over queued work
+     */
+    auto get_work(mir::InlineTask& work) -> bool
     {
-        std::lock_guard lock{mutex};
-        if (!workqueue.empty())
+        if (state.load(std::memory_order_acquire) == ExecutionState::TerminationRequested)
         {
-            auto const work = std::move(workqueue.front());
-            workqueue.pop_front();
-            return work;
+            std::lock_guard lock{mutex};
+            if (terminator)
+            {
+                work = std::move(terminator);
+                terminator = nullptr;
+                return true;
+            }
         }
-        return {};
+        return workqueue.try_pop(work);
     }
 
     auto drain()
     {
         std::unique_lock lock{mutex};
 
-        if (state == ExecutionState::TerminationRequested)
+        if (state.load(std::memory_order_relaxed) == ExecutionState::TerminationRequested && terminator)
         {
-            // If we've been asked to terminate then the front of the workqueue
-            // will contain the termination request.
             {
-                std::function<void()> const work = std::move(workqueue.front());
+                std::function<void()> const work = std::move(terminator);
+                terminator = nullptr;
                 lock.unlock();
 
                 work();
@@ -122,8 +131,12 @@ public:
         }
 
         on_wayland_thread = false;
-        state = ExecutionState::Stopped;
-        workqueue.clear();
+        state.store(ExecutionState::Stopped, std::memory_order_release);
+
+        mir::InlineTask discarded;
+        while (workqueue.try_pop(discarded))
+        {
+        }
 
         return lock;
     }
@@ -131,10 +144,12 @@ public:
     static int on_notify(int fd, uint32_t, void* data);
 private:
     static thread_local bool on_wayland_thread;
-    std::mutex mutex;
-    ExecutionState state{ExecutionState::Running};
+    std::mutex mutex;   ///< Serialises termination against drain()
+    std::atomic<ExecutionState> state{ExecutionState::Running};
     wl_event_loop* const loop;
-    std::deque<std::function<void()>> workqueue;
+    std::function<void()> terminator;
+    /// Pushed to from any thread, consumed on the Wayland thread
+    mir::MPSCWorkQueue workqueue;
 };
 
 thread_local bool mf::WaylandExecutor::State::on_wayland_thread{false};
@@ -231,7 +246,8 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
             err);
     }
 
-    while (auto work = state->get_work())
+    mir::InlineTask work;
+    while (state->get_work(work))
     {
         try
         {
@@ -245,6 +261,7 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
                 std::current_exception(),
                 "Exception processing Wayland event loop work item");
         }
+        work.reset();
     }
     if (state->state != ExecutionState::Running)
     {
@@ -324,7 +341,11 @@ mf::WaylandExecutor::~WaylandExecutor()
 
 void mf::WaylandExecutor::spawn (std::function<void()>&& work)
 {
-    state->enqueue(std::move(work));
+    // Only the first work item queued since the event loop last emptied the queue needs to notify it
+    if (!state->enqueue(std::move(work)))
+    {
+        return;
+    }
 
     if (auto err = eventfd_write(notify_fd, 1))
     {
@@ -22,9 +22,7 @@
 
 #include <wayland-server-core.h>
 
-#include <mutex>
 #include <memory>
-#include <deque>
 
 namespace mir
 {
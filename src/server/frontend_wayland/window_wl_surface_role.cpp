@@ -34,6 +34,7 @@
 #include <boost/throw_exception.hpp>
 
 #include <algorithm>
+#include <utility>
 
 namespace mf = mir::frontend;
 namespace mw = mir::wayland;
@@ -60,6 +61,13 @@ inline void clear_pending_if_unchanged(mir::optional_value<T>& pending, T& cache
             cache = pending.value();
     }
 }
+
+struct WindowPendingState : mf::WlSurfaceRole::PendingState
+{
+    std::unique_ptr<msh::SurfaceSpecification> changes;
+    std::optional<geom::Width> explicit_width;
+    std::optional<geom::Height> explicit_height;
+};
 }
 
 mf::WindowWlSurfaceRole::WindowWlSurfaceRole(
@@ -405,6 +413,29 @@ void mf::WindowWlSurfaceRole::commit(WlSurfaceState const& state)
     }
 }
 
+auto mf::WindowWlSurfaceRole::take_pending_state() -> std::unique_ptr<PendingState>
+{
+    auto state = std::make_unique<WindowPendingState>();
+    state->changes = std::move(pending_changes);
+    state->explicit_width = std::exchange(pending_explicit_width, std::nullopt);
+    state->explicit_height = std::exchange(pending_explicit_height, std::nullopt);
+    return state;
+}
+
+void mf::WindowWlSurfaceRole::set_pending_state(std::unique_ptr<PendingState> state)
+{
+    pending_changes.reset();
+    pending_explicit_width = std::nullopt;
+    pending_explicit_height = std::nullopt;
+
+    if (auto const window_state = dynamic_cast<WindowPendingState*>(state.get()))
+    {
+        pending_changes = std::move(window_state->changes);
+        pending_explicit_width = window_state->explicit_width;
+        pending_explicit_height = window_state->explicit_height;
+    }
+}
+
 void mf::WindowWlSurfaceRole::surface_destroyed()
 {
     if (!client->is_being_destroyed())
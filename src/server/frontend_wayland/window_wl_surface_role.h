@@ -129,6 +129,8 @@ protected:
 
     void commit(WlSurfaceState const& state) override;
     void surface_destroyed() override;
+    auto take_pending_state() -> std::unique_ptr<PendingState> override;
+    void set_pending_state(std::unique_ptr<PendingState> state) override;
 
     auto input_event_for(uint32_t serial) -> std::shared_ptr<MirInputEvent const>;
 
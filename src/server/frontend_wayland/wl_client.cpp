@@ -23,9 +23,13 @@
 #include "mir/shell/shell.h"
 #include "mir/scene/session.h"
 #include "mir/fatal.h"
+#include "mir/log.h"
 
 #include <wayland-server-core.h>
 
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+
 namespace mf = mir::frontend;
 namespace ms = mir::scene;
 namespace msh = mir::shell;
@@ -34,6 +38,11 @@ namespace
 {
 static const int max_serial_event_pairs = 100;
 
+/// A client with more than this queued and unread is congested...
+static const size_t congested_queue_depth = 64 * 1024;
+/// ...until it has read all but this much
+static const size_t uncongested_queue_depth = 16 * 1024;
+
 /// The context required for creating new WlClient's from wl_client*s
 struct ConstructionCtx
 {
@@ -123,6 +132,49 @@ auto mf::WlClient::event_for(uint32_t serial) -> std::optional<std::shared_ptr<M
     return std::nullopt;
 }
 
+void mf::WlClient::when_uncongested(std::function<void()>&& work)
+{
+    if (congested)
+    {
+        uncongested_work.push_back(std::move(work));
+    }
+    else
+    {
+        work();
+    }
+}
+
+void mf::WlClient::sample_outgoing_queue()
+{
+    int unread{0};
+    if (ioctl(wl_client_get_fd(client), SIOCOUTQ, &unread) < 0)
+    {
+        return;
+    }
+    outgoing_queue_depth_ = unread;
+
+    if (!congested && outgoing_queue_depth_ > congested_queue_depth)
+    {
+        congested = true;
+        log_debug(
+            "Wayland client (pid %d) is not reading events, %zu bytes queued",
+            session->process_id(),
+            outgoing_queue_depth_);
+    }
+    else if (congested && outgoing_queue_depth_ < uncongested_queue_depth)
+    {
+        congested = false;
+        log_debug("Wayland client (pid %d) has caught up with events", session->process_id());
+
+        auto const work = std::move(uncongested_work);
+        uncongested_work.clear();
+        for (auto const& item : work)
+        {
+            item();
+        }
+    }
+}
+
 mf::WlClient::WlClient(wl_client* client, std::shared_ptr<ms::Session> const& session, msh::Shell* shell)
     : shell{shell},
       client{client},
@@ -24,6 +24,7 @@ struct wl_display;
 #include <functional>
 #include <optional>
 #include <deque>
+#include <vector>
 
 #include "mir/wayland/client.h"
 
@@ -66,6 +67,16 @@ public:
     void set_output_geometry_scale(float scale) override { output_geometry_scale_ = scale; }
     auto output_geometry_scale() -> float override { return output_geometry_scale_; }
 
+    auto is_congested() const -> bool override { return congested; }
+
+    void when_uncongested(std::function<void()>&& work) override;
+
+    /// Bytes sent to the client that it has not yet read, as of the last sample_outgoing_queue()
+    auto outgoing_queue_depth() const -> size_t { return outgoing_queue_depth_; }
+
+    /// Update outgoing_queue_depth() (and so whether the client is congested) from the client's socket
+    void sample_outgoing_queue();
+
 private:
     WlClient(wl_client* client, std::shared_ptr<scene::Session> const& session, shell::Shell* shell);
 
@@ -81,6 +92,10 @@ private:
     std::shared_ptr<WlClient> owned_self;
     std::deque<std::pair<uint32_t, std::shared_ptr<MirEvent const>>> serial_event_pairs;
     float output_geometry_scale_{1};
+
+    size_t outgoing_queue_depth_{0};
+    bool congested{false};
+    std::vector<std::function<void()>> uncongested_work;
 };
 }
 }
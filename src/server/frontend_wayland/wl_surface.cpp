@@ -22,6 +22,7 @@
 #include "wl_subcompositor.h"
 #include "wl_region.h"
 #include "shm.h"
+#include "client_memory.h"
 #include "resource_lifetime_tracker.h"
 
 #include "wayland_wrapper.h"
@@ -36,18 +37,67 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/drm_syncobj.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/uploaded_buffer.h"
 #include "mir/scene/surface.h"
 #include "mir/shell/surface_specification.h"
 #include "mir/log.h"
 
+#include <algorithm>
 #include <chrono>
 #include <boost/throw_exception.hpp>
 #include <wayland-server-protocol.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace mf = mir::frontend;
 namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
+namespace mg = mir::graphics;
+
+namespace
+{
+/// Tell the client we're done with a buffer that we never got to use
+void signal_unused(std::optional<mf::SyncPoint> const& release_point)
+{
+    if (release_point)
+    {
+        try
+        {
+            release_point->timeline->signal(release_point->point);
+        }
+        catch (std::exception const& err)
+        {
+            mir::log_warning("Failed to signal buffer release point: %s", err.what());
+        }
+    }
+}
+
+/// The memory behind a dmabuf's planes, counting planes that share a dmabuf once
+auto dmabuf_bytes(mg::DMABufBuffer const& buffer) -> size_t
+{
+    std::vector<ino_t> counted;
+    size_t bytes{0};
+    for (auto const& plane : buffer.planes())
+    {
+        struct stat info;
+        if (fstat(plane.dma_buf, &info) < 0 || std::find(counted.begin(), counted.end(), info.st_ino) != counted.end())
+        {
+            continue;
+        }
+        counted.push_back(info.st_ino);
+
+        // The size of a dmabuf is found by seeking to its end
+        if (auto const size = lseek(plane.dma_buf, 0, SEEK_END); size > 0)
+        {
+            bytes += size;
+        }
+    }
+    return bytes;
+}
+}
 
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()}
@@ -68,6 +118,19 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.tearing_allowed)
+        tearing_allowed = source.tearing_allowed;
+
+    if (source.acquire_point)
+        acquire_point = source.acquire_point;
+
+    if (source.release_point)
+    {
+        // The buffer this was attached with has been replaced before it was ever shown
+        signal_unused(release_point);
+        release_point = source.release_point;
+    }
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
@@ -87,15 +150,20 @@ mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& wayland_executor,
     std::shared_ptr<Executor> const& frame_callback_executor,
-    std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
+    std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+    ClientMemory& client_memory)
     : Surface(new_resource, Version<4>()),
         session{client->client_session()},
         stream{session->create_buffer_stream({{}, mir_pixel_format_invalid, graphics::BufferUsage::undefined})},
         allocator{allocator},
+        client_memory{client_memory},
         wayland_executor{wayland_executor},
         frame_callback_executor{frame_callback_executor},
         null_role{this},
-        role{&null_role}
+        role{&null_role},
+        held_commits{
+            wl_display_get_event_loop(wl_client_get_display(client->raw_client())),
+            client->raw_client()}
 {
 }
 
@@ -166,11 +234,18 @@ void mf::WlSurface::set_role(WlSurfaceRole* role_)
     if (role != &null_role)
         BOOST_THROW_EXCEPTION(std::runtime_error("Surface already has a role"));
     role = role_;
+    role_generation++;
 }
 
 void mf::WlSurface::clear_role()
 {
     role = &null_role;
+    role_generation++;
+}
+
+void mf::WlSurface::set_commit_validator(std::function<void(WlSurfaceState const&)>&& validator)
+{
+    commit_validator = std::move(validator);
 }
 
 void mf::WlSurface::set_pending_offset(std::optional<geom::Displacement> const& offset)
@@ -333,6 +408,14 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.scale)
         inv_scale = 1.0f / state.scale.value();
 
+    if (state.tearing_allowed)
+    {
+        on_scene_surface_created([allowed = state.tearing_allowed.value()](auto const& scene_surface)
+            {
+                scene_surface->set_tearing_allowed(allowed);
+            });
+    }
+
     auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
         {
             executor->spawn([weak_self]()
@@ -356,9 +439,28 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         }
         else
         {
-            auto release_buffer = [executor = wayland_executor, weak_buffer]()
+            // Only used if the buffer can't signal the release point itself
+            auto const cpu_release_point =
+                state.release_point ? std::make_shared<std::optional<SyncPoint>>() : nullptr;
+
+            auto const shm_buffer = ShmBuffer::from(weak_buffer.value());
+
+            // Resized as the texture the buffer is uploaded to (if any) comes and goes
+            auto texture_charge = shm_buffer ?
+                client_memory.charge(client->raw_client(), ClientMemory::Kind::texture, 0) :
+                nullptr;
+            std::weak_ptr<ClientMemory::Charge> const weak_texture_charge = texture_charge;
+
+            auto release_buffer =
+                [executor = wayland_executor, weak_buffer, cpu_release_point, texture_charge = std::move(texture_charge)]()
+                mutable
                 {
-                    executor->spawn([weak_buffer]()
+                    if (cpu_release_point)
+                    {
+                        signal_unused(*cpu_release_point);
+                    }
+                    // Only the Wayland thread may touch the charge, so hand it over with the release
+                    executor->spawn([weak_buffer, texture_charge = std::move(texture_charge)]()
                         {
                             if (weak_buffer)
                             {
@@ -368,12 +470,42 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                 };
             std::shared_ptr<graphics::Buffer> mir_buffer;
 
-            if (auto const shm_buffer = ShmBuffer::from(weak_buffer.value()))
+            if (shm_buffer)
             {
                 mir_buffer = allocator->buffer_from_shm(
                     shm_buffer->data(),
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
+                if (auto const uploaded = dynamic_cast<mg::UploadedBuffer*>(mir_buffer->native_buffer_base()))
+                {
+                    uploaded->on_texture_resized(
+                        [executor = wayland_executor, weak_texture_charge](size_t bytes)
+                        {
+                            // The release hands the charge to the Wayland thread, so it's only ever destroyed there
+                            executor->spawn([weak_texture_charge, bytes]()
+                                {
+                                    if (auto const charge = weak_texture_charge.lock())
+                                    {
+                                        charge->resize(bytes);
+                                    }
+                                });
+                        });
+
+                    if (auto const charge = weak_texture_charge.lock())
+                    {
+                        // A client over its soft limit loses the textures it isn't showing
+                        std::weak_ptr<mg::UploadedBuffer> const weak_uploaded =
+                            std::shared_ptr<mg::UploadedBuffer>{mir_buffer, uploaded};
+                        charge->reclaim_with(
+                            [weak_uploaded]()
+                            {
+                                if (auto const uploaded = weak_uploaded.lock())
+                                {
+                                    uploaded->release_texture();
+                                }
+                            });
+                    }
+                }
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -386,6 +518,10 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     weak_buffer.value(),
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
+                if (auto const dmabuf = dynamic_cast<mg::DMABufBuffer*>(mir_buffer->native_buffer_base()))
+                {
+                    client_memory.charge_for_buffer(weak_buffer.value(), ClientMemory::Kind::dmabuf, dmabuf_bytes(*dmabuf));
+                }
                 tracepoint(
                     mir_server_wayland,
                     hw_buffer_committed,
@@ -393,6 +529,19 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     mir_buffer->id().as_value());
             }
 
+            if (state.release_point)
+            {
+                auto const explicit_sync = dynamic_cast<mg::ExplicitSyncBuffer*>(mir_buffer->native_buffer_base());
+                if (explicit_sync)
+                {
+                    explicit_sync->set_release_point(state.release_point->timeline, state.release_point->point);
+                }
+                else
+                {
+                    *cpu_release_point = state.release_point;
+                }
+            }
+
             stream->submit_buffer(mir_buffer, mir_buffer->size() * inv_scale, {{0, 0}, geom::SizeD{mir_buffer->size()}});
             auto const new_buffer_size = mir_buffer->size() * inv_scale;
 
@@ -426,9 +575,62 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::nullopt;
 
+    if (commit_validator)
+        commit_validator(pending);
+
     // order is important
-    auto const state = std::move(pending);
+    auto state = std::move(pending);
     pending = WlSurfaceState();
+
+    if (held_commits.empty() && !state.acquire_point)
+    {
+        apply_commit(state);
+        return;
+    }
+
+    // Wait for the client's GPU work in the event loop rather than stalling the compositor on it
+    std::optional<Fd> acquired;
+    if (state.acquire_point)
+    {
+        acquired = state.acquire_point->timeline->signalled_eventfd(state.acquire_point->point);
+    }
+
+    // Role requests made after this commit (such as acking a later configure) must not take effect with it
+    auto const held = std::make_shared<WlSurfaceState>(std::move(state));
+    auto const held_role_state =
+        std::make_shared<std::unique_ptr<WlSurfaceRole::PendingState>>(role->take_pending_state());
+    held_commits.push(
+        std::move(acquired),
+        [this, held, held_role_generation = role_generation, held_role_state]()
+        {
+            apply_held_commit(*held, held_role_generation, std::move(*held_role_state));
+        },
+        [held]()
+        {
+            signal_unused(held->release_point);
+        });
+}
+
+void mf::WlSurface::apply_held_commit(
+    WlSurfaceState const& state,
+    uint64_t held_role_generation,
+    std::unique_ptr<WlSurfaceRole::PendingState> held_role_state)
+{
+    if (held_role_generation != role_generation)
+    {
+        // The role the state was taken from has gone, so there's nothing to give it back to
+        apply_commit(state);
+        return;
+    }
+
+    auto later_role_state = role->take_pending_state();
+    role->set_pending_state(std::move(held_role_state));
+    apply_commit(state);
+    role->set_pending_state(std::move(later_role_state));
+}
+
+void mf::WlSurface::apply_commit(WlSurfaceState const& state)
+{
     role->commit(state);
 
     if (scene_surface_created_callbacks.size())
@@ -22,6 +22,7 @@
 #include "mir/wayland/weak.h"
 
 #include "wl_surface_role.h"
+#include "held_commit_queue.h"
 
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
@@ -31,6 +32,7 @@
 
 #include <vector>
 #include <map>
+#include <functional>
 
 namespace mir
 {
@@ -39,6 +41,10 @@ class Executor;
 namespace graphics
 {
 class GraphicBufferAllocator;
+namespace drm
+{
+class Syncobj;
+}
 }
 namespace scene
 {
@@ -57,6 +63,14 @@ namespace frontend
 class WlSurface;
 class WlSubsurface;
 class ResourceLifetimeTracker;
+class ClientMemory;
+
+/// A point on a client's DRM syncobj timeline
+struct SyncPoint
+{
+    std::shared_ptr<graphics::drm::Syncobj const> timeline;
+    uint64_t point;
+};
 
 struct WlSurfaceState
 {
@@ -82,6 +96,9 @@ struct WlSurfaceState
     std::optional<int> scale;
     std::optional<geometry::Displacement> offset;
     std::optional<std::optional<std::vector<geometry::Rectangle>>> input_shape;
+    std::optional<bool> tearing_allowed;
+    std::optional<SyncPoint> acquire_point;
+    std::optional<SyncPoint> release_point;
     std::vector<wayland::Weak<Callback>> frame_callbacks;
 
 private:
@@ -111,7 +128,8 @@ public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& wayland_executor,
               std::shared_ptr<mir::Executor> const& frame_callback_executor,
-              std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
+              std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+              ClientMemory& client_memory);
 
     ~WlSurface();
 
@@ -132,6 +150,11 @@ public:
     void set_role(WlSurfaceRole* role_);
     void clear_role();
     void set_pending_offset(std::optional<geometry::Displacement> const& offset);
+    void set_pending_tearing_allowed(bool allowed) { pending.tearing_allowed = allowed; }
+    void set_pending_acquire_point(SyncPoint const& point) { pending.acquire_point = point; }
+    void set_pending_release_point(SyncPoint const& point) { pending.release_point = point; }
+    /// Called with the pending state on each wl_surface.commit, before it is applied. May throw a ProtocolError.
+    void set_commit_validator(std::function<void(WlSurfaceState const&)>&& validator);
     void add_subsurface(WlSubsurface* child);
     void remove_subsurface(WlSubsurface* child);
     void refresh_surface_data_now();
@@ -149,6 +172,7 @@ public:
 
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
+    ClientMemory& client_memory;
     std::shared_ptr<mir::Executor> const wayland_executor;
     std::shared_ptr<mir::Executor> const frame_callback_executor;
 
@@ -163,8 +187,19 @@ private:
     std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
+    std::function<void(WlSurfaceState const&)> commit_validator;
+
+    /// Commits waiting for their acquire point (and any later commits queued behind them)
+    HeldCommitQueue held_commits;
+    /// Changes whenever the role does, so role state held with a commit isn't given to a different role
+    uint64_t role_generation{0};
 
     void send_frame_callbacks();
+    void apply_commit(WlSurfaceState const& state);
+    void apply_held_commit(
+        WlSurfaceState const& state,
+        uint64_t held_role_generation,
+        std::unique_ptr<WlSurfaceRole::PendingState> held_role_state);
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
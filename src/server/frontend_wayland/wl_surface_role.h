@@ -45,6 +45,21 @@ public:
     virtual void commit(WlSurfaceState const& state) = 0;
     virtual void surface_destroyed() = 0;
 
+    /// Role state set by requests since the last commit, which takes effect on the next commit
+    struct PendingState
+    {
+        virtual ~PendingState() = default;
+    };
+
+    /// Remove the role's pending state, leaving nothing pending
+    ///
+    /// A commit that has to wait (for example, for its buffer to be ready) holds on to this so that requests
+    /// made after it don't take effect early, and it isn't affected by them.
+    virtual auto take_pending_state() -> std::unique_ptr<PendingState> { return nullptr; }
+
+    /// Replace the role's pending state with one previously taken (nullptr leaves nothing pending)
+    virtual void set_pending_state(std::unique_ptr<PendingState> /*state*/) {}
+
     WlSurfaceRole() = default;
     virtual ~WlSurfaceRole() = default;
     WlSurfaceRole(WlSurfaceRole const&) = delete;
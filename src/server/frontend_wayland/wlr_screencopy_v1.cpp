@@ -29,8 +29,10 @@
 #include "wayland_wrapper.h"
 #include "wayland_timespec.h"
 #include "output_manager.h"
+#include "resource_lifetime_tracker.h"
 #include "shm.h"
 
+#include <drm_fourcc.h>
 #include <boost/throw_exception.hpp>
 #include <mutex>
 #include <optional>
@@ -120,6 +122,12 @@ public:
 
     void capture_on_damage(WlrScreencopyV1DamageTracker::Frame* frame);
 
+    /// Whether \p buffer still holds the most recent capture made with \p params, so only damage needs copying
+    auto holds_latest_capture(WlrScreencopyV1DamageTracker::FrameParams const& params, ShmBuffer const& buffer) const
+        -> bool;
+    /// Records where the most recent capture with \p params went (null if it failed)
+    void set_latest_capture(WlrScreencopyV1DamageTracker::FrameParams const& params, ShmBuffer* buffer);
+
 private:
     /// From wayland::WlrScreencopyManagerV1
     /// @{
@@ -134,6 +142,7 @@ private:
 
     std::shared_ptr<WlrScreencopyV1Ctx> const ctx;
     WlrScreencopyV1DamageTracker damage_tracker;
+    std::vector<std::pair<WlrScreencopyV1DamageTracker::FrameParams, wayland::Weak<ShmBuffer>>> latest_captures;
 };
 
 class WlrScreencopyFrameV1
@@ -156,6 +165,7 @@ public:
 
 private:
     void prepare_target(wl_resource* buffer);
+    void prepare_gpu_target(wl_resource* buffer);
     void report_result(std::optional<time::Timestamp> captured_time, geom::Rectangle buffer_space_damage);
 
     /// From wayland::WlrScreencopyFrameV1
@@ -174,6 +184,10 @@ private:
     bool copy_has_been_called{false};
     bool should_send_damage{false};
     std::shared_ptr<renderer::software::WriteMappableBuffer> target;
+    /// The wl_shm buffer target maps, if any
+    wayland::Weak<ShmBuffer> shm_target;
+    /// Set instead of target when the client supplies a buffer the GPU can write to (such as a dmabuf)
+    std::shared_ptr<graphics::Buffer> gpu_target;
     /// @}
 };
 }
@@ -370,6 +384,33 @@ void mf::WlrScreencopyManagerV1::capture_on_damage(WlrScreencopyV1DamageTracker:
     damage_tracker.capture_on_damage(frame);
 }
 
+auto mf::WlrScreencopyManagerV1::holds_latest_capture(
+    WlrScreencopyV1DamageTracker::FrameParams const& params,
+    ShmBuffer const& buffer) const -> bool
+{
+    auto const latest = std::find_if(
+        begin(latest_captures),
+        end(latest_captures),
+        [&](auto const& capture){ return capture.first == params; });
+    return latest != end(latest_captures) && latest->second.is(buffer);
+}
+
+void mf::WlrScreencopyManagerV1::set_latest_capture(
+    WlrScreencopyV1DamageTracker::FrameParams const& params,
+    ShmBuffer* buffer)
+{
+    std::erase_if(latest_captures, [&](auto const& capture){ return capture.first == params || !capture.second; });
+    if (buffer)
+    {
+        // As with damage tracking areas, don't get bogged down by a client with unusually many
+        if (latest_captures.size() > 100)
+        {
+            latest_captures.clear();
+        }
+        latest_captures.emplace_back(params, mw::make_weak(buffer));
+    }
+}
+
 void mf::WlrScreencopyManagerV1::capture_output(
     wl_resource* frame,
     int32_t overlay_cursor,
@@ -412,20 +453,24 @@ mf::WlrScreencopyFrameV1::WlrScreencopyFrameV1(
         params.buffer_size.width.as_uint32_t(),
         params.buffer_size.height.as_uint32_t(),
         stride.as_uint32_t());
+    // Clients can only make a dmabuf wl_buffer if linux-dmabuf is available, so this is safe to offer regardless
+    send_linux_dmabuf_event_if_supported(
+        DRM_FORMAT_ARGB8888,
+        params.buffer_size.width.as_uint32_t(),
+        params.buffer_size.height.as_uint32_t());
     send_buffer_done_event_if_supported();
 }
 
 void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
 {
-    if (!target)
+    if (!target && !gpu_target)
     {
         fatal_error(
             "WlrScreencopyFrameV1::capture() called without a target, copy %s been called",
             copy_has_been_called ? "has" : "has not");
     }
-    ctx->screen_shooter->capture(std::move(target), params.output_space_area,
-        [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
-            (std::optional<time::Timestamp> captured_time)
+    auto callback = [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
+        (std::optional<time::Timestamp> captured_time)
         {
             wayland_executor->spawn([self, captured_time, buffer_space_damage]()
                 {
@@ -434,7 +479,29 @@ void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
                         self.value().report_result(captured_time, buffer_space_damage);
                     }
                 });
-        });
+        };
+
+    if (gpu_target)
+    {
+        ctx->screen_shooter->capture_to_gpu_buffer(std::move(gpu_target), params.output_space_area, std::move(callback));
+    }
+    else if (shm_target && manager && manager.value().holds_latest_capture(params, shm_target.value()))
+    {
+        // The client is reusing the buffer it got the last frame in, so only what's changed since needs copying
+        auto const output_space_damage = translate_and_scale(
+            buffer_space_damage,
+            {{}, params.buffer_size},
+            params.output_space_area);
+        ctx->screen_shooter->capture(
+            std::move(target),
+            params.output_space_area,
+            output_space_damage,
+            std::move(callback));
+    }
+    else
+    {
+        ctx->screen_shooter->capture(std::move(target), params.output_space_area, std::move(callback));
+    }
 }
 
 void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
@@ -450,11 +517,10 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
     auto shm_buffer = mf::ShmBuffer::from(buffer);
     if (!shm_buffer)
     {
-        BOOST_THROW_EXCEPTION(mw::ProtocolError(
-            resource,
-            Error::invalid_buffer,
-            "Copy target is not a wl_shm buffer"));
+        prepare_gpu_target(buffer);
+        return;
     }
+    shm_target = mw::make_weak(shm_buffer);
     auto shm_data = shm_buffer->data();
     if (shm_data->format() != mir_pixel_format_argb_8888)
     {
@@ -502,10 +568,68 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
     };
 }
 
+void mf::WlrScreencopyFrameV1::prepare_gpu_target(wl_resource* buffer)
+{
+    mw::Weak<ResourceLifetimeTracker> const weak_buffer{ResourceLifetimeTracker::from(buffer)};
+    std::shared_ptr<graphics::Buffer> imported;
+    try
+    {
+        imported = ctx->allocator->buffer_from_resource(
+            buffer,
+            []() {},
+            [weak_buffer, executor = ctx->wayland_executor]()
+            {
+                executor->spawn([weak_buffer]()
+                    {
+                        if (weak_buffer)
+                        {
+                            wl_resource_post_event(weak_buffer.value(), wayland::Buffer::Opcode::release);
+                        }
+                    });
+            });
+    }
+    catch (std::exception const& err)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Copy target is neither a wl_shm buffer nor an importable GPU buffer: %s",
+            err.what()));
+    }
+
+    if (imported->size() != params.buffer_size)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Invalid buffer size %dx%d, should be %dx%d",
+            imported->size().width.as_int(),
+            imported->size().height.as_int(),
+            params.buffer_size.width.as_int(),
+            params.buffer_size.height.as_int()));
+    }
+    auto const format = imported->pixel_format();
+    if (format != mir_pixel_format_argb_8888 && format != mir_pixel_format_xrgb_8888)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Invalid pixel format %d",
+            format));
+    }
+
+    gpu_target = std::move(imported);
+}
+
 void mf::WlrScreencopyFrameV1::report_result(
     std::optional<time::Timestamp> captured_time,
     geom::Rectangle buffer_space_damage)
 {
+    if (manager && shm_target)
+    {
+        manager.value().set_latest_capture(params, captured_time ? &shm_target.value() : nullptr);
+    }
+
     if (captured_time)
     {
         send_flags_event(Flags::y_invert);
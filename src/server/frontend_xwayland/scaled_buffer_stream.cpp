@@ -51,3 +51,8 @@ auto mf::ScaledBufferStream::has_submitted_buffer() const -> bool
     return inner->has_submitted_buffer();
 }
 
+
+void mf::ScaledBufferStream::set_visible(bool visible)
+{
+    inner->set_visible(visible);
+}
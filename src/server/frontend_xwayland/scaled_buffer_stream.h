@@ -46,6 +46,7 @@ public:
     /// @{
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission>;
     auto has_submitted_buffer() const -> bool;
+    void set_visible(bool visible);
     /// @}
 
 private:
@@ -21,6 +21,7 @@
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/graphics/display.h"
 #include "multiplexing_display.h"
+#include "multiplexing_hw_cursor.h"
 #include "null_cursor.h"
 #include "software_cursor.h"
 #include "platform_probe.h"
@@ -406,7 +407,19 @@ mir::DefaultServerConfiguration::the_cursor()
             else if (cursor_choice != "software" &&
                      (primary_cursor = the_display()->create_hardware_cursor()))
             {
-                mir::log_info("Using hardware cursor");
+                auto const multiplexing = std::dynamic_pointer_cast<mg::MultiplexingCursor>(primary_cursor);
+                if (multiplexing && multiplexing->needs_fallback())
+                {
+                    mir::log_info("Using hardware cursor where available, software cursor elsewhere");
+                    multiplexing->set_fallback(std::make_shared<mg::SoftwareCursor>(
+                        the_buffer_allocator(),
+                        the_main_loop(),
+                        the_input_scene()));
+                }
+                else
+                {
+                    mir::log_info("Using hardware cursor");
+                }
             }
             else
             {
@@ -92,6 +92,7 @@ public:
                     output.gamma = mutable_output.gamma;
                     output.custom_logical_size = mutable_output.custom_logical_size;
                     output.custom_attribute = mutable_output.custom_attribute;
+                    output.vrr_enabled = mutable_output.vrr_enabled;
                 });
         }
     }
@@ -275,6 +276,7 @@ auto mg::MultiplexingDisplay::apply_if_configuration_preserves_display_buffers(
             return false;
         }
     }
+    notify_cursor_of_configuration_change();
     return true;
 }
 
@@ -285,6 +287,27 @@ void mg::MultiplexingDisplay::configure(DisplayConfiguration const& conf)
     {
         displays[i]->configure(*real_conf.components[i]);
     }
+    notify_cursor_of_configuration_change();
+}
+
+void mg::MultiplexingDisplay::configure_incrementally(
+    DisplayConfiguration const& conf,
+    std::function<void(DisplaySyncGroup&)> const& retire)
+{
+    auto const& real_conf = dynamic_cast<CompositeDisplayConfiguration const&>(conf);
+    for (auto i = 0u; i < displays.size(); ++i)
+    {
+        displays[i]->configure_incrementally(*real_conf.components[i], retire);
+    }
+    notify_cursor_of_configuration_change();
+}
+
+void mg::MultiplexingDisplay::notify_cursor_of_configuration_change()
+{
+    if (auto const locked_cursor = cursor.lock())
+    {
+        locked_cursor->configuration_changed();
+    }
 }
 
 void mg::MultiplexingDisplay::register_configuration_change_handler(
@@ -329,7 +352,9 @@ auto mg::MultiplexingDisplay::create_hardware_cursor() -> std::shared_ptr<Cursor
     }
     try
     {
-        return std::make_shared<MultiplexingCursor>(platform_displays);
+        auto const new_cursor = std::make_shared<MultiplexingCursor>(platform_displays);
+        cursor = new_cursor;
+        return new_cursor;
     }
     catch (std::exception const&)
     {
@@ -22,6 +22,8 @@
 
 namespace mir::graphics
 {
+class MultiplexingCursor;
+
 class MultiplexingDisplay : public Display
 {
 public:
@@ -37,6 +39,9 @@ public:
     auto apply_if_configuration_preserves_display_buffers(DisplayConfiguration const& conf) -> bool override;
 
     void configure(DisplayConfiguration const& conf) override;
+    void configure_incrementally(
+        DisplayConfiguration const& conf,
+        std::function<void(DisplaySyncGroup&)> const& retire) override;
 
     void register_configuration_change_handler(
         EventHandlerRegister& handlers,
@@ -48,6 +53,9 @@ public:
 
     auto create_hardware_cursor() -> std::shared_ptr<Cursor> override;
 private:
+    void notify_cursor_of_configuration_change();
+
     std::vector<std::unique_ptr<Display>> const displays;
+    std::weak_ptr<MultiplexingCursor> cursor;
 };
 }
@@ -17,52 +17,185 @@
 #include "multiplexing_hw_cursor.h"
 
 #include "mir/graphics/display.h"
+#include "mir/graphics/display_configuration.h"
+#include "mir/graphics/cursor_image.h"
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace mg = mir::graphics;
+namespace geom = mir::geometry;
 
 namespace
 {
-auto construct_platform_cursors(std::span<mg::Display*> platform_displays) -> std::vector<std::shared_ptr<mg::Cursor>>
+template<typename PlatformCursor>
+auto hardware_areas_of(std::vector<PlatformCursor> const& platform_cursors) -> std::vector<geom::Rectangle>
+{
+    std::vector<geom::Rectangle> areas;
+    for (auto const& platform : platform_cursors)
+    {
+        if (!platform.cursor)
+            continue;
+
+        platform.display->configuration()->for_each_output(
+            [&areas](mg::DisplayConfigurationOutput const& output)
+            {
+                if (output.used)
+                    areas.push_back(output.extents());
+            });
+    }
+    return areas;
+}
+}
+
+/// A copy of a CursorImage, so the fallback can be re-shown after it was hidden
+class mg::MultiplexingCursor::SavedImage : public CursorImage
+{
+public:
+    explicit SavedImage(CursorImage const& image)
+        : size_{image.size()},
+          hotspot_{image.hotspot()},
+          pixels(size_.width.as_uint32_t() * size_.height.as_uint32_t() * 4)
+    {
+        std::memcpy(pixels.data(), image.as_argb_8888(), pixels.size());
+    }
+
+    void const* as_argb_8888() const override { return pixels.data(); }
+    geom::Size size() const override { return size_; }
+    geom::Displacement hotspot() const override { return hotspot_; }
+
+private:
+    geom::Size const size_;
+    geom::Displacement const hotspot_;
+    std::vector<unsigned char> pixels;
+};
+
+auto mg::MultiplexingCursor::construct_platform_cursors(std::span<Display*> platform_displays)
+    -> std::vector<PlatformCursor>
 {
-    std::vector<std::shared_ptr<mg::Cursor>> cursors;
+    std::vector<PlatformCursor> cursors;
+    bool any_hardware_cursor = false;
     for (auto display : platform_displays)
     {
-        cursors.push_back(display->create_hardware_cursor());
-        if (cursors.back() == nullptr)
+        cursors.push_back({display, display->create_hardware_cursor()});
+        if (cursors.back().cursor)
         {
-            BOOST_THROW_EXCEPTION((std::runtime_error{"Platform failed to create hardware cursor"}));
+            any_hardware_cursor = true;
         }
     }
+
+    if (!any_hardware_cursor)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Platform failed to create hardware cursor"}));
+    }
     return cursors;
 }
-}
 
 mg::MultiplexingCursor::MultiplexingCursor(std::span<Display*> platform_displays)
     : platform_cursors{construct_platform_cursors(platform_displays)}
 {
 }
 
+mg::MultiplexingCursor::~MultiplexingCursor() = default;
+
+auto mg::MultiplexingCursor::needs_fallback() const -> bool
+{
+    return std::any_of(
+        platform_cursors.begin(), platform_cursors.end(),
+        [](auto const& platform) { return !platform.cursor; });
+}
+
+void mg::MultiplexingCursor::set_fallback(std::shared_ptr<Cursor> const& fallback)
+{
+    auto areas = hardware_areas_of(platform_cursors);
+
+    std::lock_guard lock{mutex};
+    if (this->fallback && fallback_visible)
+        this->fallback->hide();
+
+    this->fallback = fallback;
+    hardware_areas = std::move(areas);
+    fallback_visible = false;
+    update_fallback_locked(lock);
+}
+
+void mg::MultiplexingCursor::configuration_changed()
+{
+    // Query the displays without holding our lock; they have locks of their own
+    auto areas = hardware_areas_of(platform_cursors);
+
+    std::lock_guard lock{mutex};
+    hardware_areas = std::move(areas);
+    update_fallback_locked(lock);
+}
+
 void mg::MultiplexingCursor::show(CursorImage const& image)
 {
-    for (auto& cursor : platform_cursors)
+    for (auto& platform : platform_cursors)
+    {
+        if (platform.cursor)
+            platform.cursor->show(image);
+    }
+
+    std::lock_guard lock{mutex};
+    visible = true;
+    if (fallback)
     {
-        cursor->show(image);
+        this->image = std::make_unique<SavedImage>(image);
+        if (fallback_visible)
+            fallback->show(*this->image);
+        update_fallback_locked(lock);
     }
 }
 
 void mg::MultiplexingCursor::hide()
 {
-    for (auto& cursor: platform_cursors)
+    for (auto& platform : platform_cursors)
     {
-        cursor->hide();
+        if (platform.cursor)
+            platform.cursor->hide();
     }
+
+    std::lock_guard lock{mutex};
+    visible = false;
+    update_fallback_locked(lock);
 }
 
 void mg::MultiplexingCursor::move_to(geometry::Point position)
 {
-    for (auto& cursor : platform_cursors)
+    for (auto& platform : platform_cursors)
     {
-        cursor->move_to(position);
+        if (platform.cursor)
+            platform.cursor->move_to(position);
     }
+
+    std::lock_guard lock{mutex};
+    this->position = position;
+    update_fallback_locked(lock);
+}
+
+void mg::MultiplexingCursor::update_fallback_locked(std::lock_guard<std::mutex> const&)
+{
+    if (!fallback)
+        return;
+
+    auto const on_hardware_output = std::any_of(
+        hardware_areas.begin(), hardware_areas.end(),
+        [this](geom::Rectangle const& area) { return area.contains(position); });
+
+    auto const want_fallback = visible && image && !on_hardware_output;
+
+    if (want_fallback && !fallback_visible)
+    {
+        fallback->show(*image);
+    }
+    else if (!want_fallback && fallback_visible)
+    {
+        fallback->hide();
+    }
+    fallback_visible = want_fallback;
+
+    if (fallback_visible)
+        fallback->move_to(position);
 }
@@ -16,23 +16,58 @@
 
 #include <vector>
 #include <span>
+#include <mutex>
 
 #include "mir/graphics/cursor.h"
+#include "mir/geometry/rectangle.h"
 
 namespace mir::graphics
 {
 class Display;
 
+/// Drives the hardware cursor of each platform Display that has one.
+///
+/// Platform Displays without a hardware cursor are covered by an optional fallback
+/// (typically a SoftwareCursor), which is only shown while the pointer is outside
+/// every output that has a hardware cursor.
 class MultiplexingCursor : public Cursor
 {
 public:
+    /// \throws std::runtime_error if none of the platform_displays provide a hardware cursor
     explicit MultiplexingCursor(std::span<Display*> platform_displays);
+    ~MultiplexingCursor() override;
+
+    /// Whether some platform Display has no hardware cursor, and so needs set_fallback()
+    auto needs_fallback() const -> bool;
+    void set_fallback(std::shared_ptr<Cursor> const& fallback);
+
+    /// Recalculate the area covered by hardware cursors, after the display configuration changes
+    void configuration_changed();
 
     void show(CursorImage const& image) override;
     void hide() override;
     void move_to(geometry::Point position) override;
 
 private:
-    std::vector<std::shared_ptr<Cursor>> const platform_cursors;
+    class SavedImage;
+
+    struct PlatformCursor
+    {
+        Display* display;
+        std::shared_ptr<Cursor> cursor;     ///< nullptr if the display has no hardware cursor
+    };
+
+    static auto construct_platform_cursors(std::span<Display*> platform_displays) -> std::vector<PlatformCursor>;
+    void update_fallback_locked(std::lock_guard<std::mutex> const&);
+
+    std::vector<PlatformCursor> const platform_cursors;
+
+    std::mutex mutex;
+    std::shared_ptr<Cursor> fallback;
+    std::vector<geometry::Rectangle> hardware_areas;
+    std::unique_ptr<SavedImage> image;
+    geometry::Point position;
+    bool visible{false};
+    bool fallback_visible{false};
 };
 }
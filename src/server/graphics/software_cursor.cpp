@@ -200,15 +200,21 @@ void mg::SoftwareCursor::hide()
 
 void mg::SoftwareCursor::move_to(geometry::Point position)
 {
+    geom::Rectangle old_area, new_area;
     {
         std::lock_guard lg{guard};
 
         if (!renderable)
             return;
 
+        old_area = renderable->screen_position();
         renderable->move_to(position - hotspot);
+        new_area = renderable->screen_position();
     }
 
+    // Only the outputs showing the old or new cursor position need recompositing.
     // This doesn't need to be called in a specific order with other potential calls, so it doesn't go on the executor
-    scene->emit_scene_changed();
+    scene->emit_scene_damaged(old_area);
+    if (new_area != old_area)
+        scene->emit_scene_damaged(new_area);
 }
@@ -22,6 +22,7 @@
 #include "mir/dispatch/threaded_dispatcher.h"
 
 #include "mir/thread_name.h"
+#include "mir/thread_policy.h"
 #include "mir/unwind_helpers.h"
 #include "mir/terminate_with_current_exception.h"
 
@@ -80,6 +81,8 @@ void mi::DefaultInputManager::start()
      */
     queue->enqueue([this,promise = std::move(started_promise)]()
                    {
+                        // This runs on the input thread, which has no other start-up hook
+                        mir::apply_thread_policy(mir::ThreadRole::input);
                         start_platforms();
                         promise->set_value();
                    });
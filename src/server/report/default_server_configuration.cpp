@@ -32,11 +32,15 @@ namespace ms = mir::scene;
 
 std::unique_ptr<mir::report::ReportFactory> mir::DefaultServerConfiguration::report_factory(char const* report_opt)
 {
-    auto opt = the_options()->get<std::string>(report_opt);
+    auto const opts = the_options();
+    auto opt = opts->get<std::string>(report_opt);
 
     if (opt == options::log_opt_value)
     {
-        return std::make_unique<report::LoggingReportFactory>(the_logger(), the_clock());
+        auto const metrics_file = opts->is_set(options::compositor_metrics_file_opt) ?
+            opts->get<std::string>(options::compositor_metrics_file_opt) : std::string{};
+
+        return std::make_unique<report::LoggingReportFactory>(the_logger(), the_clock(), metrics_file);
     }
     else if (opt == options::lttng_opt_value)
     {
@@ -17,6 +17,11 @@
 #include "compositor_report.h"
 #include "mir/logging/logger.h"
 
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
+
 using namespace mir::time;
 namespace ml = mir::logging;
 namespace mrl = mir::report::logging;
@@ -25,13 +30,112 @@ namespace
 {
     const char * const component = "compositor";
     const auto min_report_interval = std::chrono::seconds(1);
+
+    char const* const histogram_names[] =
+    {
+        "scene_snapshot",
+        "occlusion",
+        "render",
+        "commit",
+        "wait_for_flip",
+        "frame",
+        "latency",
+    };
+
+    auto as_usec(std::chrono::microseconds value) -> long
+    {
+        return static_cast<long>(value.count());
+    }
 }
 
+/// Writes the metrics file on an executor, only ever keeping the latest contents pending
+class mrl::CompositorReport::MetricsFile : public std::enable_shared_from_this<MetricsFile>
+{
+public:
+    MetricsFile(std::string path, std::shared_ptr<ml::Logger> logger, mir::Executor& executor)
+        : path{std::move(path)},
+          logger{std::move(logger)},
+          executor{executor}
+    {
+    }
+
+    void update(std::string contents)
+    {
+        {
+            std::lock_guard lock{mutex};
+            pending = std::move(contents);
+            if (writing)
+            {
+                // The writer will pick these contents up when it's done
+                return;
+            }
+            writing = true;
+        }
+
+        executor.spawn(
+            [self = shared_from_this()]()
+            {
+                while (auto contents = self->take_pending())
+                {
+                    self->write(*contents);
+                }
+            });
+    }
+
+private:
+    auto take_pending() -> std::optional<std::string>
+    {
+        std::lock_guard lock{mutex};
+        auto contents = std::move(pending);
+        pending.reset();
+        writing = contents.has_value();
+        return contents;
+    }
+
+    void write(std::string const& contents)
+    {
+        // Write to a temporary and rename so readers never see a partial file
+        auto const tmp_file = path + ".tmp";
+        {
+            std::ofstream out{tmp_file, std::ios::trunc};
+            out << contents;
+
+            if (!out)
+            {
+                if (!failed)
+                    logger->log(ml::Severity::warning, "Failed to write metrics to " + tmp_file, component);
+                failed = true;
+                return;
+            }
+        }
+
+        if (std::rename(tmp_file.c_str(), path.c_str()) != 0)
+        {
+            if (!failed)
+                logger->log(ml::Severity::warning, "Failed to replace metrics file " + path, component);
+            failed = true;
+        }
+    }
+
+    std::string const path;
+    std::shared_ptr<ml::Logger> const logger;
+    mir::Executor& executor;
+    bool failed = false;                    ///< Only touched by the (single) running writer
+
+    std::mutex mutex;
+    std::optional<std::string> pending;
+    bool writing = false;
+};
+
 mrl::CompositorReport::CompositorReport(
     std::shared_ptr<ml::Logger> const& logger,
-    std::shared_ptr<Clock> const& clock)
+    std::shared_ptr<Clock> const& clock,
+    std::string const& metrics_file,
+    Executor& metrics_executor)
     : logger(logger),
       clock(clock),
+      metrics_file(
+          metrics_file.empty() ? nullptr : std::make_shared<MetricsFile>(metrics_file, logger, metrics_executor)),
       last_report(now())
 {
 }
@@ -57,6 +161,7 @@ void mrl::CompositorReport::began_frame(SubCompositorId id)
     auto t = now();
     inst.start_of_frame = t;
     inst.latency_sum += t - last_scheduled;
+    inst.scheduled_for_frame = last_scheduled;
     inst.bypassed = true;
 }
 
@@ -130,12 +235,77 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_bypassed = nbypassed;
 }
 
+void mrl::CompositorReport::Instance::log_timing(ml::Logger& logger, SubCompositorId id) const
+{
+    char msg[512];
+    int len = snprintf(msg, sizeof msg, "Display %p timing p50/p90/p99/max ms:", id);
+
+    for (size_t i = 0; i != histogram_count && len < static_cast<int>(sizeof msg); ++i)
+    {
+        auto const& h = histograms[i];
+        if (!h.count())
+            continue;
+
+        long const p50 = as_usec(h.percentile(50));
+        long const p90 = as_usec(h.percentile(90));
+        long const p99 = as_usec(h.percentile(99));
+        long const max = as_usec(h.max());
+
+        len += snprintf(msg + len, sizeof msg - len,
+                        " %s %ld.%03ld/%ld.%03ld/%ld.%03ld/%ld.%03ld",
+                        histogram_names[i],
+                        p50 / 1000, p50 % 1000,
+                        p90 / 1000, p90 % 1000,
+                        p99 / 1000, p99 % 1000,
+                        max / 1000, max % 1000);
+    }
+
+    logger.log(ml::Severity::informational, msg, component);
+}
+
+auto mrl::CompositorReport::metrics_json() const -> std::string
+{
+    std::ostringstream out;
+
+    out << "{\"outputs\":[";
+    bool first_output = true;
+    for (auto const& [id, inst] : instance)
+    {
+        if (!first_output)
+            out << ',';
+        first_output = false;
+
+        char id_str[32];
+        snprintf(id_str, sizeof id_str, "%p", id);
+        out << "{\"id\":\"" << id_str << "\",\"frames\":" << inst.nframes
+            << ",\"bypassed\":" << inst.nbypassed << ",\"stages\":{";
+
+        for (size_t i = 0; i != histogram_count; ++i)
+        {
+            auto const& h = inst.histograms[i];
+            if (i)
+                out << ',';
+            out << '"' << histogram_names[i] << "\":{"
+                << "\"count\":" << h.count()
+                << ",\"p50_us\":" << h.percentile(50).count()
+                << ",\"p90_us\":" << h.percentile(90).count()
+                << ",\"p99_us\":" << h.percentile(99).count()
+                << ",\"max_us\":" << h.max().count() << '}';
+        }
+        out << "}}";
+    }
+    out << "]}\n";
+
+    return out.str();
+}
+
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
 {
     std::lock_guard lock(mutex);
     auto& inst = instance[id];
 
     auto t = now();
+    inst.histograms[frame_histogram].record(t - inst.start_of_frame);
     inst.total_time_sum += t - inst.end_of_frame;
     inst.end_of_frame = t;
     inst.nframes++;
@@ -151,7 +321,20 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
         last_report = t;
 
         for (auto& i : instance)
+        {
+            i.second.log_timing(*logger, i.first);
             i.second.log(*logger, i.first);
+        }
+
+        if (metrics_file)
+            metrics_file->update(metrics_json());
+
+        // The timing percentiles are per report interval
+        for (auto& i : instance)
+        {
+            for (auto& histogram : i.second.histograms)
+                histogram.reset();
+        }
     }
 
     if (inst.bypassed != inst.prev_bypassed || inst.nframes == 1)
@@ -164,6 +347,26 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::began_stage(SubCompositorId id, FrameStage stage)
+{
+    std::lock_guard lock(mutex);
+    instance[id].stage_start[static_cast<size_t>(stage)] = now();
+}
+
+void mrl::CompositorReport::finished_stage(SubCompositorId id, FrameStage stage)
+{
+    std::lock_guard lock(mutex);
+    auto& inst = instance[id];
+
+    auto t = now();
+    auto const index = static_cast<size_t>(stage);
+    inst.histograms[index].record(t - inst.stage_start[index]);
+
+    // Once the frame is on screen we know how long it took since compositing was requested
+    if (stage == FrameStage::wait_for_flip)
+        inst.histograms[latency_histogram].record(t - inst.scheduled_for_frame);
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
@@ -19,7 +19,11 @@
 
 #include "mir/compositor/compositor_report.h"
 #include "mir/time/clock.h"
+#include "mir/executor.h"
+#include "latency_histogram.h"
+#include <array>
 #include <memory>
+#include <string>
 #include <mutex>
 #include <unordered_map>
 #include <chrono>
@@ -38,13 +42,23 @@ namespace logging
 class CompositorReport : public mir::compositor::CompositorReport
 {
 public:
+    /**
+     * \param metrics_file     If not empty, per-output frame timing histograms are
+     *                         periodically written here as JSON
+     * \param metrics_executor Where the metrics file is written, to keep file I/O
+     *                         off the compositor threads
+     */
     CompositorReport(std::shared_ptr<mir::logging::Logger> const& logger,
-                     std::shared_ptr<time::Clock> const& clock);
+                     std::shared_ptr<time::Clock> const& clock,
+                     std::string const& metrics_file = {},
+                     Executor& metrics_executor = thread_pool_executor);
     void added_display(int width, int height, int x, int y, SubCompositorId id) override;
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void began_stage(SubCompositorId id, FrameStage stage) override;
+    void finished_stage(SubCompositorId id, FrameStage stage) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -53,9 +67,18 @@ private:
     std::shared_ptr<mir::logging::Logger> const logger;
     std::shared_ptr<time::Clock> const clock;
 
+    class MetricsFile;
+    std::shared_ptr<MetricsFile> const metrics_file;    ///< nullptr if there's no metrics file
+
     typedef time::Timestamp TimePoint;
     TimePoint now() const;
 
+    // The explicitly reported FrameStages, followed by the whole frame and
+    // the scheduled-to-presented latency
+    static size_t constexpr frame_histogram = static_cast<size_t>(FrameStage::wait_for_flip) + 1;
+    static size_t constexpr latency_histogram = frame_histogram + 1;
+    static size_t constexpr histogram_count = latency_histogram + 1;
+
     struct Instance
     {
         TimePoint start_of_frame;
@@ -74,9 +97,16 @@ private:
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
 
+        TimePoint scheduled_for_frame;
+        std::array<TimePoint, histogram_count> stage_start;
+        std::array<LatencyHistogram, histogram_count> histograms;
+
         void log(mir::logging::Logger& logger, SubCompositorId id);
+        void log_timing(mir::logging::Logger& logger, SubCompositorId id) const;
     };
 
+    auto metrics_json() const -> std::string;
+
     std::mutex mutex; // Protects the following...
     std::unordered_map<SubCompositorId, Instance> instance;
     TimePoint last_scheduled;
@@ -185,6 +185,14 @@ void mrl::DisplayConfigurationReport::log_configuration(
                             "%sScaling factor: %.2f",
                             indent,
                             out.scale);
+
+                if (out.vrr_capable)
+                {
+                    logger->log(component, severity,
+                                "%sVariable refresh %s",
+                                indent,
+                                out.vrr_enabled ? "enabled" : "disabled");
+                }
             }
         }
     });
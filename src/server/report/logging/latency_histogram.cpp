@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace mrl = mir::report::logging;
+
+auto mrl::LatencyHistogram::bucket_for(uint64_t value) -> int
+{
+    if (value < sub_buckets)
+        return static_cast<int>(value);
+
+    // Clamp outliers into the top bucket rather than overflowing
+    value = std::min<uint64_t>(value, (uint64_t{1} << (max_magnitude + 1)) - 1);
+
+    int const magnitude = std::bit_width(value) - 1;
+    int const shift = magnitude - sub_bucket_bits;
+    int const sub_bucket = static_cast<int>((value >> shift) & (sub_buckets - 1));
+
+    return sub_buckets * (shift + 1) + sub_bucket;
+}
+
+auto mrl::LatencyHistogram::highest_value_in(int bucket) -> uint64_t
+{
+    if (bucket < sub_buckets)
+        return bucket;
+
+    int const shift = bucket / sub_buckets - 1;
+    uint64_t const sub_bucket = bucket % sub_buckets;
+    uint64_t const lowest = (sub_buckets + sub_bucket) << shift;
+
+    return lowest + (uint64_t{1} << shift) - 1;
+}
+
+void mrl::LatencyHistogram::record(std::chrono::nanoseconds value)
+{
+    auto const us = static_cast<uint64_t>(
+        std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(value).count()));
+
+    ++buckets[bucket_for(us)];
+    ++total;
+    max_value = std::max(max_value, us);
+}
+
+void mrl::LatencyHistogram::reset()
+{
+    buckets.fill(0);
+    total = 0;
+    max_value = 0;
+}
+
+auto mrl::LatencyHistogram::count() const -> uint64_t
+{
+    return total;
+}
+
+auto mrl::LatencyHistogram::max() const -> std::chrono::microseconds
+{
+    return std::chrono::microseconds{max_value};
+}
+
+auto mrl::LatencyHistogram::percentile(double percent) const -> std::chrono::microseconds
+{
+    if (total == 0)
+        return std::chrono::microseconds::zero();
+
+    auto const wanted = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(std::clamp(percent, 0.0, 100.0) * total / 100.0)));
+
+    uint64_t seen = 0;
+    for (int i = 0; i != bucket_count; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= wanted)
+            return std::chrono::microseconds{std::min(highest_value_in(i), max_value)};
+    }
+
+    return max();
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_LOGGING_LATENCY_HISTOGRAM_H_
+#define MIR_REPORT_LOGGING_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace mir
+{
+namespace report
+{
+namespace logging
+{
+
+/**
+ * A fixed-size, log-linear histogram of durations in the style of
+ * HdrHistogram.
+ *
+ * Values are recorded with microsecond resolution and a relative error of at
+ * most 1/16 (about 6%), which is plenty for telling a 16ms frame from a 17ms
+ * one while keeping the memory cost constant. Recording is O(1) and never
+ * allocates, so it is safe to do on the compositor thread for every frame.
+ */
+class LatencyHistogram
+{
+public:
+    void record(std::chrono::nanoseconds value);
+    void reset();
+
+    auto count() const -> uint64_t;
+    auto max() const -> std::chrono::microseconds;
+
+    /// The smallest recorded value that at least \a percent % of samples do not exceed
+    auto percentile(double percent) const -> std::chrono::microseconds;
+
+private:
+    static int constexpr sub_bucket_bits = 4;
+    static int constexpr sub_buckets = 1 << sub_bucket_bits;
+    static int constexpr max_magnitude = 36;    // ~19 hours, in µs
+    static int constexpr bucket_count = sub_buckets * (max_magnitude - sub_bucket_bits + 2);
+
+    static auto bucket_for(uint64_t value) -> int;
+    static auto highest_value_in(int bucket) -> uint64_t;
+
+    std::array<uint64_t, bucket_count> buckets{};
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+};
+
+}
+}
+}
+
+#endif // MIR_REPORT_LOGGING_LATENCY_HISTOGRAM_H_
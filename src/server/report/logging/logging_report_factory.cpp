@@ -27,15 +27,17 @@
 namespace mr = mir::report;
 
 mr::LoggingReportFactory::LoggingReportFactory(std::shared_ptr<mir::logging::Logger> const& logger,
-                                               std::shared_ptr<time::Clock> const& clock)
+                                               std::shared_ptr<time::Clock> const& clock,
+                                               std::string const& compositor_metrics_file)
     : logger(logger),
-    clock(clock)
+    clock(clock),
+    compositor_metrics_file(compositor_metrics_file)
 {
 }
 
 std::shared_ptr<mir::compositor::CompositorReport> mr::LoggingReportFactory::create_compositor_report()
 {
-    return std::make_shared<logging::CompositorReport>(logger, clock);
+    return std::make_shared<logging::CompositorReport>(logger, clock, compositor_metrics_file);
 }
 
 std::shared_ptr<mir::graphics::DisplayReport> mr::LoggingReportFactory::create_display_report()
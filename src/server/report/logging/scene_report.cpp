@@ -17,6 +17,7 @@
 #include "scene_report.h"
 
 #include "mir/logging/logger.h"
+#include "mir/scene/session.h"
 
 #include <sstream>
 
@@ -26,6 +27,11 @@ namespace mrl = mir::report::logging;
 namespace
 {
 char const* const component = "scene";
+
+void print(std::ostream& out, mir::scene::SceneReport::SessionMemory const& usage)
+{
+    out << "shm=" << usage.shm << " dmabuf=" << usage.dmabuf << " texture=" << usage.texture;
+}
 }
 
 mrl::SceneReport::SceneReport(std::shared_ptr<ml::Logger> const& logger) :
@@ -115,3 +121,25 @@ void mrl::SceneReport::surface_deleted(BasicSurfaceId id, std::string const& nam
 
     logger->log(ml::Severity::informational, ss.str(), component);
 }
+
+void mrl::SceneReport::session_memory_changed(mir::scene::Session const& session, SessionMemory const& usage)
+{
+    std::stringstream ss;
+    ss << "session_memory_changed(\"" << session.name() << "\" pid=" << session.process_id() << ") ";
+    print(ss, usage);
+
+    logger->log(ml::Severity::debug, ss.str(), component);
+}
+
+void mrl::SceneReport::session_memory_limit_exceeded(
+    mir::scene::Session const& session,
+    SessionMemory const& usage,
+    std::size_t limit)
+{
+    std::stringstream ss;
+    ss << "session_memory_limit_exceeded(\"" << session.name() << "\" pid=" << session.process_id() << ") ";
+    print(ss, usage);
+    ss << " - WARNING limit=" << limit;
+
+    logger->log(ml::Severity::warning, ss.str(), component);
+}
@@ -45,6 +45,12 @@ public:
     void surface_removed(BasicSurfaceId id, std::string const& name);
     void surface_deleted(BasicSurfaceId id, std::string const& name);
 
+    void session_memory_changed(scene::Session const& session, SessionMemory const& usage);
+    void session_memory_limit_exceeded(
+        scene::Session const& session,
+        SessionMemory const& usage,
+        std::size_t limit);
+
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
 
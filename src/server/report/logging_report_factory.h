@@ -19,6 +19,8 @@
 
 #include "report_factory.h"
 
+#include <string>
+
 namespace mir
 {
 namespace logging
@@ -37,7 +39,8 @@ class LoggingReportFactory : public report::ReportFactory
 {
 public:
     LoggingReportFactory(std::shared_ptr<mir::logging::Logger> const& logger,
-                         std::shared_ptr<time::Clock> const& clock);
+                         std::shared_ptr<time::Clock> const& clock,
+                         std::string const& compositor_metrics_file = {});
     std::shared_ptr<compositor::CompositorReport> create_compositor_report() override;
     std::shared_ptr<graphics::DisplayReport> create_display_report() override;
     std::shared_ptr<scene::SceneReport> create_scene_report() override;
@@ -50,6 +53,7 @@ public:
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
     std::shared_ptr<time::Clock> const clock;
+    std::string const compositor_metrics_file;
 };
 }
 }
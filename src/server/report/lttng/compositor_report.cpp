@@ -60,3 +60,13 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::began_stage(SubCompositorId id, FrameStage stage)
+{
+    mir_tracepoint(mir_server_compositor, began_stage, id, static_cast<int>(stage));
+}
+
+void mir::report::lttng::CompositorReport::finished_stage(SubCompositorId id, FrameStage stage)
+{
+    mir_tracepoint(mir_server_compositor, finished_stage, id, static_cast<int>(stage));
+}
@@ -38,6 +38,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void began_stage(SubCompositorId id, FrameStage stage) override;
+    void finished_stage(SubCompositorId id, FrameStage stage) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
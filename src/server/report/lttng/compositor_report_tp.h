@@ -78,6 +78,30 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT_CLASS(
+    mir_server_compositor,
+    subcompositor_stage_event,
+    TP_ARGS(void const*, id, int, stage),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int, stage, stage)
+    )
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_compositor,
+    subcompositor_stage_event,
+    began_stage,
+    TP_ARGS(void const*, id, int, stage)
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_compositor,
+    subcompositor_stage_event,
+    finished_stage,
+    TP_ARGS(void const*, id, int, stage)
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
@@ -16,6 +16,7 @@
 
 #include "scene_report.h"
 #include "mir/report/lttng/mir_tracepoint.h"
+#include "mir/scene/session.h"
 
 #define TRACEPOINT_DEFINE
 #define TRACEPOINT_PROBE_DYNAMIC_LINKAGE
@@ -40,3 +41,24 @@ void mir::report::lttng::SceneReport::surface_deleted(BasicSurfaceId, std::strin
 {
     mir_tracepoint(mir_server_scene, surface_deleted, name.c_str());
 }
+
+void mir::report::lttng::SceneReport::session_memory_changed(
+    mir::scene::Session const& session,
+    SessionMemory const& usage)
+{
+    mir_tracepoint(
+        mir_server_scene,
+        session_memory_changed,
+        session.process_id(),
+        usage.shm,
+        usage.dmabuf,
+        usage.texture);
+}
+
+void mir::report::lttng::SceneReport::session_memory_limit_exceeded(
+    mir::scene::Session const& session,
+    SessionMemory const& usage,
+    std::size_t limit)
+{
+    mir_tracepoint(mir_server_scene, session_memory_limit_exceeded, session.process_id(), usage.total(), limit);
+}
@@ -36,6 +36,11 @@ public:
     void surface_added(BasicSurfaceId id, std::string const& name) override;
     void surface_removed(BasicSurfaceId id, std::string const& name) override;
     void surface_deleted(BasicSurfaceId id, std::string const& name) override;
+    void session_memory_changed(scene::Session const& session, SessionMemory const& usage) override;
+    void session_memory_limit_exceeded(
+        scene::Session const& session,
+        SessionMemory const& usage,
+        std::size_t limit) override;
 private:
     ServerTracepointProvider tp_provider;
 };
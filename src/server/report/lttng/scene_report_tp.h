@@ -65,6 +65,29 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(char const*, name)
 )
 
+TRACEPOINT_EVENT(
+    mir_server_scene,
+    session_memory_changed,
+    TP_ARGS(int, pid, uint64_t, shm, uint64_t, dmabuf, uint64_t, texture),
+    TP_FIELDS(
+        ctf_integer(int, pid, pid)
+        ctf_integer(uint64_t, shm, shm)
+        ctf_integer(uint64_t, dmabuf, dmabuf)
+        ctf_integer(uint64_t, texture, texture)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_scene,
+    session_memory_limit_exceeded,
+    TP_ARGS(int, pid, uint64_t, total, uint64_t, limit),
+    TP_FIELDS(
+        ctf_integer(int, pid, pid)
+        ctf_integer(uint64_t, total, total)
+        ctf_integer(uint64_t, limit, limit)
+    )
+)
+
 #endif /* MIR_LTTNG_SCENE_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
@@ -38,6 +38,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::began_stage(SubCompositorId, FrameStage)
+{
+}
+
+void mrn::CompositorReport::finished_stage(SubCompositorId, FrameStage)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
@@ -30,4 +30,9 @@ void mrn::SceneReport::surface_removed(BasicSurfaceId /*id*/, std::string const&
 void mrn::SceneReport::surface_deleted(BasicSurfaceId /*id*/, std::string const& /*name*/)
 {
 }
-
+void mrn::SceneReport::session_memory_changed(mir::scene::Session const&, SessionMemory const&)
+{
+}
+void mrn::SceneReport::session_memory_limit_exceeded(mir::scene::Session const&, SessionMemory const&, std::size_t)
+{
+}
@@ -36,6 +36,12 @@ public:
     virtual void surface_removed(BasicSurfaceId /*id*/, std::string const& /*name*/) override;
     virtual void surface_deleted(BasicSurfaceId /*id*/, std::string const& /*name*/) override;
 
+    void session_memory_changed(scene::Session const& session, SessionMemory const& usage) override;
+    void session_memory_limit_exceeded(
+        scene::Session const& session,
+        SessionMemory const& usage,
+        std::size_t limit) override;
+
     SceneReport() = default;
     virtual ~SceneReport() noexcept = default;
 
@@ -220,6 +220,7 @@ ms::BasicSurface::BasicSurface(
 {
     auto state = synchronised_state.lock();
     update_frame_posted_callbacks(*state);
+    update_stream_visibility(*state);
     report->surface_created(this, state->surface_name);
     display_config_registrar->register_early_observer(display_config_monitor, immediate_executor);
 }
@@ -290,7 +291,11 @@ void ms::BasicSurface::move_to(geometry::Point const& top_left)
 
 void ms::BasicSurface::set_hidden(bool hide)
 {
-    synchronised_state.lock()->hidden = hide;
+    {
+        auto state = synchronised_state.lock();
+        state->hidden = hide;
+        update_stream_visibility(*state);
+    }
     observers->hidden_set_to(this, hide);
 }
 
@@ -669,6 +674,7 @@ MirWindowVisibility ms::BasicSurface::set_visibility(MirWindowVisibility new_vis
     if (state->visibility != new_visibility)
     {
         state->visibility = new_visibility;
+        update_stream_visibility(*state);
 
         state.drop();
 
@@ -695,6 +701,7 @@ public:
         std::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        bool tearing_allowed,
         mg::Renderable::ID id,
         ms::Surface const* surface)
     : entry{std::move(buffer)},
@@ -702,6 +709,7 @@ public:
       screen_position_{top_left, entry->size()},
       clip_area_{clip_area},
       transformation_{transform},
+      tearing_allowed_{tearing_allowed},
       id_{id},
       surface{surface}
     {
@@ -731,6 +739,9 @@ public:
     bool shaped() const override
     { return entry->pixel_format().has_alpha(); }
 
+    bool tearing_allowed() const override
+    { return tearing_allowed_; }
+
     mg::Renderable::ID id() const override
     { return id_; }
 
@@ -744,6 +755,7 @@ private:
     geom::Rectangle const screen_position_;
     std::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    bool const tearing_allowed_;
     mg::Renderable::ID const id_;
     ms::Surface const* surface;
 };
@@ -775,6 +787,7 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
         clear_frame_posted_callbacks(*state);
         state->layers = s;
         update_frame_posted_callbacks(*state);
+        update_stream_visibility(*state);
         surface_top_left = state->surface_rect.top_left;
     }
     observers->moved_to(this, surface_top_left);
@@ -803,6 +816,7 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
                 state->clip_area,
                 state->transformation_matrix,
                 state->surface_alpha,
+                state->tearing_allowed,
                 info.stream.get(),
                 this));
         }
@@ -944,6 +958,16 @@ void mir::scene::BasicSurface::set_focus_mode(MirFocusMode focus_mode)
     synchronised_state.lock()->focus_mode = focus_mode;
 }
 
+auto mir::scene::BasicSurface::tearing_allowed() const -> bool
+{
+    return synchronised_state.lock()->tearing_allowed;
+}
+
+void mir::scene::BasicSurface::set_tearing_allowed(bool allowed)
+{
+    synchronised_state.lock()->tearing_allowed = allowed;
+}
+
 void mir::scene::BasicSurface::clear_frame_posted_callbacks(State& state)
 {
     for (auto& layer : state.layers)
@@ -952,6 +976,16 @@ void mir::scene::BasicSurface::clear_frame_posted_callbacks(State& state)
     }
 }
 
+void mir::scene::BasicSurface::update_stream_visibility(State const& state)
+{
+    // The scene marks surfaces exposed or occluded as it composites; hidden surfaces aren't composited at all
+    auto const on_screen = !state.hidden && state.visibility == mir_window_visibility_exposed;
+    for (auto const& layer : state.layers)
+    {
+        layer.stream->set_visible(on_screen);
+    }
+}
+
 void mir::scene::BasicSurface::update_frame_posted_callbacks(State& state)
 {
     for (auto& layer : state.layers)
@@ -174,6 +174,9 @@ public:
     auto focus_mode() const -> MirFocusMode override;
     void set_focus_mode(MirFocusMode focus_mode) override;
 
+    auto tearing_allowed() const -> bool override;
+    void set_tearing_allowed(bool allowed) override;
+
 private:
     struct State;
     class DisplayConfigurationEarlyListener;
@@ -187,6 +190,7 @@ private:
     MirOrientationMode set_preferred_orientation(MirOrientationMode mode);
     void clear_frame_posted_callbacks(State& state);
     void update_frame_posted_callbacks(State& state);
+    void update_stream_visibility(State const& state);
     auto content_size(State const& state) const -> geometry::Size;
     auto content_top_left(State const& state) const -> geometry::Point;
     void track_outputs();
@@ -227,6 +231,7 @@ private:
         } margins{};
 
         MirFocusMode focus_mode = mir_focus_mode_focusable;
+        bool tearing_allowed = false;
     };
     mir::Synchronised<State> synchronised_state;
 
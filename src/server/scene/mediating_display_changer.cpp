@@ -81,28 +81,6 @@ public:
         return mir_display_configuration_error_rejected_by_hardware;
     }
 };
-
-class ApplyNowAndRevertOnScopeExit
-{
-public:
-    ApplyNowAndRevertOnScopeExit(std::function<void()> const& apply,
-                                 std::function<void()> const& revert)
-        : revert{revert}
-    {
-        apply();
-    }
-
-    ~ApplyNowAndRevertOnScopeExit()
-    {
-        revert();
-    }
-
-private:
-    ApplyNowAndRevertOnScopeExit(ApplyNowAndRevertOnScopeExit const&) = delete;
-    ApplyNowAndRevertOnScopeExit& operator=(ApplyNowAndRevertOnScopeExit const&) = delete;
-
-    std::function<void()> const revert;
-};
 }
 
 struct ms::MediatingDisplayChanger::SessionObserver : ms::SessionEventSink
@@ -451,17 +429,12 @@ void ms::MediatingDisplayChanger::apply_config(
         if (configuration_has_new_outputs_enabled(*display->configuration(), *conf) ||
             !interruption_free_configuration_successful())
         {
-            ApplyNowAndRevertOnScopeExit comp{
-                [this] { compositor->stop(); },
-                [this] { compositor->start(); }};
-            display->configure(*conf);
+            // Outputs the new configuration leaves alone keep compositing throughout
+            compositor->configure_display(*display, *conf);
         }
         else if (configuration_changes_require_recompositing(*existing_configuration, *conf))
         {
-            // Workaround for #2807: we could do better if Compositor had a `schedule_compositing(damage)` method
-            ApplyNowAndRevertOnScopeExit comp{
-                    [this] { compositor->stop(); },
-                    [this] { compositor->start(); }};
+            compositor->schedule_compositing();
         }
 
         observer->configuration_applied(conf);
@@ -479,10 +452,7 @@ void ms::MediatingDisplayChanger::apply_config(
              * was one that has been successfully display->configure()d, or it was the
              * configuration that existed at Mir startup. Which presumably worked!
              */
-            ApplyNowAndRevertOnScopeExit comp{
-                [this] { compositor->stop(); },
-                [this] { compositor->start(); }};
-            display->configure(*existing_configuration);
+            compositor->configure_display(*display, *existing_configuration);
             throw;
         }
         catch (std::exception const& e)
@@ -94,6 +94,11 @@ void ms::SceneChangeNotification::scene_changed()
     scene_notify_change();
 }
 
+void ms::SceneChangeNotification::scene_damaged(geom::Rectangle const& damage)
+{
+    damage_notify_change(damage);
+}
+
 void ms::SceneChangeNotification::end_observation()
 {
     std::unique_lock lg(surface_observers_guard);
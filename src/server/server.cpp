@@ -30,6 +30,7 @@
 #include "mir/main_loop.h"
 #include "mir/report_exception.h"
 #include "mir/run_mir.h"
+#include "mir/thread_policy.h"
 
 // TODO these are used to frig a stub renderer when running headless
 #include "mir/renderer/renderer.h"
@@ -73,6 +74,21 @@ struct TemporaryCompositeEventFilter : public mi::CompositeEventFilter
     std::vector<std::weak_ptr<mi::EventFilter>> prepend_event_filters;
     std::vector<std::weak_ptr<mi::EventFilter>> append_event_filters;
 };
+
+void set_thread_policies(mo::Option const& options)
+{
+    std::pair<char const*, mir::ThreadRole> const roles[] = {
+        {mo::compositor_thread_policy_opt, mir::ThreadRole::compositor},
+        {mo::input_thread_policy_opt, mir::ThreadRole::input},
+        {mo::page_flip_thread_policy_opt, mir::ThreadRole::page_flip},
+        {mo::workqueue_thread_policy_opt, mir::ThreadRole::workqueue}};
+
+    for (auto const& [opt, role] : roles)
+    {
+        if (options.is_set(opt))
+            mir::set_thread_policy(role, mir::parse_thread_policy(options.get<std::string>(opt)));
+    }
+}
 }
 
 #define FOREACH_WRAPPER(MACRO)\
@@ -384,6 +400,7 @@ void mir::Server::apply_settings()
     self->server_config = config;
 
     mir::logging::set_logger(config->the_logger());
+    set_thread_policies(*config->the_options());
 }
 
 void mir::Server::run()
@@ -24,7 +24,10 @@
 #include <signal.h>
 #include <system_error>
 #include <memory>
+#include <array>
 #include <atomic>
+#include <mutex>
+#include <thread>
 #include <boost/throw_exception.hpp>
 
 namespace
@@ -49,6 +52,7 @@ public:
 
     ~ShmBufferSIGBUSHandler()
     {
+        std::lock_guard lock{install_mutex};
         /* We're going to free previous_handler, so in order for it to be safe
          * to instantiate a ShmBufferSIGBUSHandler, free it, and instantiate a
          * new one we need to ensure previous_handler is nulled by this destructor.
@@ -58,8 +62,51 @@ public:
             sigaction(SIGBUS, last_handler, nullptr);
             delete last_handler;
         }
+        handler_installed = false;
     }
 
+private:
+    /* The registry of protected ranges.
+     *
+     * This is consulted from the SIGBUS handler and updated on every access
+     * to an untrusted SHM mapping, so it is lock-free: a fixed array of slots,
+     * extended (but never shrunk) by further blocks if there are ever more
+     * concurrent accesses than slots.
+     *
+     * Each slot's state carries a generation count, incremented every time the
+     * slot is claimed, so that the handler can't act on a range whose slot has
+     * been released and reused while it was looking at it.
+     */
+    enum SlotState : uint64_t
+    {
+        unused = 0,
+        reserved,       ///< Claimed by a new access, whose range isn't set yet
+        active,         ///< Protecting [start, start + len)
+        replacing,      ///< The SIGBUS handler is replacing the range's mapping
+        faulted,        ///< The range has been replaced with a fallback mapping
+    };
+    static constexpr uint64_t state_bits = 3;
+    static constexpr uint64_t state_mask = (1 << state_bits) - 1;
+
+    static constexpr auto with_state(uint64_t slot_state, SlotState new_state) -> uint64_t
+    {
+        return (slot_state & ~state_mask) | new_state;
+    }
+
+    struct Slot
+    {
+        std::atomic<uint64_t> state{unused};
+        std::atomic<uintptr_t> start{0};
+        std::atomic<size_t> len{0};
+    };
+
+    struct SlotBlock
+    {
+        std::array<Slot, 64> slots;
+        std::atomic<SlotBlock*> next{nullptr};
+    };
+
+public:
     class AccessProtector
     {
         friend class ShmBufferSIGBUSHandler;
@@ -71,51 +118,41 @@ public:
 
         auto invalid_access_prevented() -> bool
         {
-            return used;
-        }
-
-        auto within_protected_region(void* access) -> bool
-        {
-            auto fault_addr = reinterpret_cast<uintptr_t>(access);
-            auto protected_addr = reinterpret_cast<uintptr_t>(addr);
-            return fault_addr > protected_addr &&
-                fault_addr < protected_addr + len;
-        }
-
-        auto provide_fallback_mapping() -> bool
-        {
-            // Replace the existing mapping with a fallback
-            if (mmap(
-                addr, len,
-                PROT_READ | PROT_WRITE,
-                MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS,
-                -1, 0) == addr)
-            {
-                // We've successfully replaced any existing mapping with a new,
-                // all-0, mapping that will not SIGBUS on access.
-                used = true;
-                return true;
-            }
-            return false;
+            return slot.state.load(std::memory_order_acquire) == with_state(claimed, faulted);
         }
 
         ~AccessProtector()
         {
-            if (used)
+            auto expected = with_state(claimed, active);
+            while (!slot.state.compare_exchange_weak(expected, with_state(claimed, unused), std::memory_order_acq_rel))
             {
-                munmap(addr, len);
+                if (expected == with_state(claimed, faulted))
+                {
+                    munmap(addr, len);
+                    slot.state.store(with_state(claimed, unused), std::memory_order_release);
+                    return;
+                }
+                if (expected == with_state(claimed, replacing))
+                {
+                    // The SIGBUS handler is part-way through replacing our mapping; let it finish
+                    std::this_thread::yield();
+                }
+                expected = with_state(claimed, active);
             }
         }
     private:
-        AccessProtector(void* addr, size_t len)
-            : addr{addr},
+        AccessProtector(Slot& slot, uint64_t claimed, void* addr, size_t len)
+            : slot{slot},
+              claimed{claimed},
+              addr{addr},
               len{len}
         {
         }
 
-        void* addr;
-        size_t len;
-        std::atomic<bool> used{false};    // Atomic only to ensure signal-safety
+        Slot& slot;
+        uint64_t const claimed;     ///< The slot's state (and generation) when we claimed it
+        void* const addr;
+        size_t const len;
     };
 
     /**
@@ -127,13 +164,19 @@ public:
      * \returns A handle representing this memory access guard. As long as the guard is
      *          live, accesses within the protected range are safe.
      */
-    auto static protect_access_to(void* addr, size_t len) -> std::shared_ptr<AccessProtector>
+    auto static protect_access_to(void* addr, size_t len) -> std::unique_ptr<AccessProtector>
     {
-        auto protector = std::shared_ptr<AccessProtector>{new AccessProtector{addr, len}};
-        auto locked_list = current_access.lock();
-        install_sigbus_handler();
-        locked_list->push_back(protector);
-        return protector;
+        if (!handler_installed.load(std::memory_order_acquire))
+        {
+            install_sigbus_handler();
+        }
+
+        auto [slot, claimed] = claim_slot();
+        slot.start.store(reinterpret_cast<uintptr_t>(addr), std::memory_order_relaxed);
+        slot.len.store(len, std::memory_order_relaxed);
+        slot.state.store(with_state(claimed, active), std::memory_order_release);
+
+        return std::unique_ptr<AccessProtector>{new AccessProtector{slot, claimed, addr, len}};
     }
 
 private:
@@ -141,8 +184,48 @@ private:
 
     friend class AccessProtector;
 
+    static auto claim_slot() -> std::pair<Slot&, uint64_t>
+    {
+        for (auto block = &first_block; ; )
+        {
+            for (auto& slot : block->slots)
+            {
+                auto current = slot.state.load(std::memory_order_relaxed);
+                if ((current & state_mask) == unused)
+                {
+                    // Bump the generation as we claim the slot
+                    auto const claimed = with_state(current + (1 << state_bits), reserved);
+                    if (slot.state.compare_exchange_strong(current, claimed, std::memory_order_acquire))
+                    {
+                        return {slot, claimed};
+                    }
+                }
+            }
+
+            auto next = block->next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                // Every slot is busy; add another block (these are never freed)
+                std::lock_guard lock{extension_mutex};
+                next = block->next.load(std::memory_order_acquire);
+                if (!next)
+                {
+                    next = new SlotBlock;
+                    block->next.store(next, std::memory_order_release);
+                }
+            }
+            block = next;
+        }
+    }
+
     static void install_sigbus_handler()
     {
+        std::lock_guard lock{install_mutex};
+        if (handler_installed.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
         struct sigaction sig_handler_desc;
         sigfillset(&sig_handler_desc.sa_mask);
         sig_handler_desc.sa_flags = SA_SIGINFO;
@@ -158,7 +241,6 @@ private:
          */
         if (sigaction(SIGBUS, &sig_handler_desc, old_handler))
         {
-            using namespace std::string_literals;
             delete old_handler;
             BOOST_THROW_EXCEPTION((
                 std::system_error{
@@ -167,19 +249,47 @@ private:
                     "Failed to install SIGBUS handler for Wayland SHM"
                 }));
         }
-        if (old_handler->sa_sigaction != &sigbus_handler)
+        delete previous_handler.exchange(old_handler);
+        handler_installed.store(true, std::memory_order_release);
+    }
+
+    /// Try to replace the mapping of the range protected by slot, if it covers fault_addr
+    static auto replace_faulting_range(Slot& slot, uintptr_t fault_addr) -> bool
+    {
+        auto current = slot.state.load(std::memory_order_acquire);
+        if ((current & state_mask) != active)
         {
-            // Because we install the handler every time, we only want
-            // to save the old handler when it's not ours!
-            auto to_delete = previous_handler.exchange(old_handler);
-            delete to_delete;
+            return false;
         }
-        else
+
+        auto const start = slot.start.load(std::memory_order_relaxed);
+        auto const len = slot.len.load(std::memory_order_relaxed);
+        if (fault_addr < start || fault_addr - start >= len)
         {
-            // This is our handler; we don't need to save it, but we *do* need to
-            // delete the struct sigaction we've new'd above.
-            delete old_handler;
+            return false;
         }
+
+        // This fails if the slot has since been released (and perhaps reused)
+        if (!slot.state.compare_exchange_strong(current, with_state(current, replacing), std::memory_order_acq_rel))
+        {
+            return false;
+        }
+
+        // Replace the existing mapping with a fallback
+        auto const addr = reinterpret_cast<void*>(start);
+        if (mmap(
+            addr, len,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS,
+            -1, 0) == addr)
+        {
+            // We've successfully replaced any existing mapping with a new,
+            // all-0, mapping that will not SIGBUS on access.
+            slot.state.store(with_state(current, faulted), std::memory_order_release);
+            return true;
+        }
+        slot.state.store(current, std::memory_order_release);
+        return false;
     }
 
     static void sigbus_handler(int sig, siginfo_t* info, void* ucontext)
@@ -194,25 +304,17 @@ private:
              * signal context: we're interrupting the thread that is performing
              * the read or write to memory *during* that read or write.
              *
-             * That means we *can't* be interrupting an async-signal-unsafe
-             * function. (Under the fairly reasonable assumption that we're
-             * not doing something absolutely bonkers, like trying to store
-             * pthread mutexes in a file-backed mmap()ed region).
-             *
-             * *That* means that we have access to sensible concurrency primitives!
-             * *And* the memory allocator!
-             * What bliss!
-             *
-             * So, even though this is a signal handler, we can use normal
-             * code.
+             * The registry is lock-free, so (unlike a mutex) we can't deadlock
+             * against whatever that thread was doing, and the faulting range
+             * is guaranteed to stay registered until we return, as it's that
+             * thread's AccessProtector that holds it.
              */
-            auto locked_list = current_access.lock();
-            for (auto& weak_protector : *locked_list)
+            auto const fault_addr = reinterpret_cast<uintptr_t>(info->si_addr);
+            for (auto block = &first_block; block; block = block->next.load(std::memory_order_acquire))
             {
-                if (auto protector = weak_protector.lock())
+                for (auto& slot : block->slots)
                 {
-                    if (protector->within_protected_region(info->si_addr) &&
-                        protector->provide_fallback_mapping())
+                    if (replace_faulting_range(slot, fault_addr))
                     {
                         // We've replaced the client-provided mapping with one that will
                         // not fault; it is now safe to continue.
@@ -238,14 +340,19 @@ private:
             (previous_handler.load()->sa_handler)(sig);
         }
     }
-    static mir::Synchronised<std::vector<std::weak_ptr<AccessProtector>>> current_access;
+    static SlotBlock first_block;
+    static std::mutex extension_mutex;
+    static std::mutex install_mutex;
+    static std::atomic<bool> handler_installed;
     static std::atomic<struct sigaction*> previous_handler;
     static std::weak_ptr<ShmBufferSIGBUSHandler> installed_handler;
 };
 std::weak_ptr<ShmBufferSIGBUSHandler> ShmBufferSIGBUSHandler::installed_handler;
 std::atomic<struct sigaction*> ShmBufferSIGBUSHandler::previous_handler;
-mir::Synchronised<std::vector<std::weak_ptr<ShmBufferSIGBUSHandler::AccessProtector>>>
-    ShmBufferSIGBUSHandler::current_access;
+std::atomic<bool> ShmBufferSIGBUSHandler::handler_installed{false};
+std::mutex ShmBufferSIGBUSHandler::install_mutex;
+std::mutex ShmBufferSIGBUSHandler::extension_mutex;
+ShmBufferSIGBUSHandler::SlotBlock ShmBufferSIGBUSHandler::first_block;
 
 
 class ShmBacking
@@ -263,6 +370,9 @@ public:
     auto lock_range(size_t start, size_t len)
         -> std::unique_ptr<mir::shm::Mapping<T>>;
 
+    /// The backing store, if it is a memfd that can't shrink (and can still be written)
+    auto sealed_memfd() const -> std::optional<mir::Fd>;
+
 private:
     std::shared_ptr<ShmBufferSIGBUSHandler> const sigbus_handler;
 
@@ -318,7 +428,7 @@ private:
         Mapping(
             T* data, size_t size,
             std::shared_ptr<void const> lifetime_manager,
-            std::shared_ptr<ShmBufferSIGBUSHandler::AccessProtector> guard)
+            std::unique_ptr<ShmBufferSIGBUSHandler::AccessProtector> guard)
             : ptr{data},
               size{size},
               lifetime_manager{std::move(lifetime_manager)},
@@ -329,7 +439,7 @@ private:
         T* const ptr;
         size_t const size;
         std::shared_ptr<void const> const lifetime_manager;
-        std::shared_ptr<ShmBufferSIGBUSHandler::AccessProtector> const access_guard;
+        std::unique_ptr<ShmBufferSIGBUSHandler::AccessProtector> const access_guard;
     };
 
     // Really we only need std::atomic<std::shared_ptr<>>, but 20.04!
@@ -401,6 +511,17 @@ auto ShmBacking::lock_range(size_t start, size_t len)
                 mapping->size_is_trustworthy ? nullptr : sigbus_handler->protect_access_to(start_addr, len)}};
 }
 
+auto ShmBacking::sealed_memfd() const -> std::optional<mir::Fd>
+{
+    // F_GET_SEALS fails for anything that isn't a memfd
+    int const file_seals = fcntl(backing_store, F_GET_SEALS);
+    if (file_seals != -1 && (file_seals & F_SEAL_SHRINK) && !(file_seals & F_SEAL_WRITE))
+    {
+        return backing_store;
+    }
+    return std::nullopt;
+}
+
 void ShmBacking::resize(size_t new_size)
 {
     void* mapped_address = mmap(nullptr, new_size, prot, MAP_SHARED, backing_store, 0);
@@ -493,6 +614,15 @@ public:
     {
         return parent->lock_range<std::byte>(offset, len);
     }
+
+    auto sealed_memfd_range() const -> std::optional<mir::shm::FileRange> override
+    {
+        if (auto memfd = parent->sealed_memfd())
+        {
+            return mir::shm::FileRange{std::move(*memfd), offset, len};
+        }
+        return std::nullopt;
+    }
 private:
     size_t const offset;
     size_t const len;
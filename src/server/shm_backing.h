@@ -18,6 +18,7 @@
 #include "mir/renderer/sw/pixel_source.h"
 
 #include <cstddef>
+#include <optional>
 #include <sys/mman.h>
 
 namespace mir
@@ -120,12 +121,28 @@ public:
     virtual auto map_wo() -> std::unique_ptr<Mapping<std::byte>> = 0;
 };
 
+/// A byte range of a file
+struct FileRange
+{
+    mir::Fd file;
+    size_t offset;
+    size_t len;
+};
+
 class RWMappableRange : public ReadMappableRange, public WriteMappableRange
 {
 public:
     virtual ~RWMappableRange() = default;
 
     virtual auto map_rw() -> std::unique_ptr<Mapping<std::byte>> = 0;
+
+    /**
+     * The range of the backing memfd, if it is sealed against shrinking
+     *
+     * Only then is it safe to access the range other than through a Mapping<T>,
+     * as the client can no longer truncate the memory out from under us.
+     */
+    virtual auto sealed_memfd_range() const -> std::optional<FileRange> = 0;
 };
 
 class ReadOnlyPool
@@ -79,6 +79,7 @@ struct MockBufferStream : public compositor::BufferStream
         (std::shared_ptr<graphics::Buffer> const&, geometry::Size, geometry::RectangleD),
         (override));
     MOCK_METHOD(bool, has_submitted_buffer, (), (const override));
+    MOCK_METHOD(void, set_visible, (bool), (override));
 };
 }
 }
@@ -18,6 +18,7 @@
 #define MIR_TEST_DOUBLES_MOCK_COMPOSITOR_H_
 
 #include "mir/compositor/compositor.h"
+#include "mir/graphics/display.h"
 
 #include <gmock/gmock.h>
 
@@ -33,6 +34,18 @@ class MockCompositor : public compositor::Compositor
 public:
     MOCK_METHOD(void, start, ());
     MOCK_METHOD(void, stop, ());
+    MOCK_METHOD(void, configure_display, (graphics::Display&, graphics::DisplayConfiguration const&));
+    MOCK_METHOD(void, schedule_compositing, ());
+
+    MockCompositor()
+    {
+        ON_CALL(*this, configure_display(testing::_, testing::_))
+            .WillByDefault(
+                [](graphics::Display& display, graphics::DisplayConfiguration const& conf)
+                {
+                    display.configure(conf);
+                });
+    }
 };
 
 }
@@ -36,6 +36,10 @@ public:
                  (compositor::CompositorReport::SubCompositorId, graphics::RenderableList const&), (override));
     MOCK_METHOD(void, rendered_frame, (compositor::CompositorReport::SubCompositorId), (override));
     MOCK_METHOD(void, finished_frame, (compositor::CompositorReport::SubCompositorId), (override));
+    MOCK_METHOD(void, began_stage,
+                (compositor::CompositorReport::SubCompositorId, compositor::CompositorReport::FrameStage), (override));
+    MOCK_METHOD(void, finished_stage,
+                (compositor::CompositorReport::SubCompositorId, compositor::CompositorReport::FrameStage), (override));
     MOCK_METHOD(void, started, (), (override));
     MOCK_METHOD(void, stopped, (), (override));
     MOCK_METHOD(void, scheduled, (), (override));
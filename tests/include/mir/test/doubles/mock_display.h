@@ -37,6 +37,11 @@ public:
     MOCK_METHOD(std::unique_ptr<graphics::DisplayConfiguration>, configuration, (), (const override));
     MOCK_METHOD(bool, apply_if_configuration_preserves_display_buffers, (graphics::DisplayConfiguration const&), (override));
     MOCK_METHOD(void, configure, (graphics::DisplayConfiguration const&), (override));
+    MOCK_METHOD(
+        void,
+        configure_incrementally,
+        (graphics::DisplayConfiguration const&, std::function<void(graphics::DisplaySyncGroup&)> const&),
+        (override));
     MOCK_METHOD(void, register_configuration_change_handler, (graphics::EventHandlerRegister&, graphics::DisplayConfigurationChangeHandler const&), (override));
     MOCK_METHOD(void, pause, (), (override));
     MOCK_METHOD(void, resume, (), (override));
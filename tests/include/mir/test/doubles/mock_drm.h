@@ -132,6 +132,8 @@ public:
     MOCK_METHOD(drmModePropertyPtr, drmModeGetProperty, (int fd, uint32_t propertyId));
     MOCK_METHOD(void, drmModeFreeProperty, (drmModePropertyPtr));
     MOCK_METHOD(int, drmModeConnectorSetProperty, (int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
+    MOCK_METHOD(int, drmModeObjectSetProperty,
+                (int fd, uint32_t object_id, uint32_t object_type, uint32_t property_id, uint64_t value));
 
     MOCK_METHOD(int, drmGetMagic, (int fd, drm_magic_t *magic));
     MOCK_METHOD(int, drmAuthMagic, (int fd, drm_magic_t magic));
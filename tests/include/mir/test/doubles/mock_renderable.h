@@ -53,6 +53,7 @@ struct MockRenderable : public graphics::Renderable
     MOCK_CONST_METHOD0(transformation, glm::mat4());
     MOCK_CONST_METHOD0(visible, bool());
     MOCK_CONST_METHOD0(shaped, bool());
+    MOCK_CONST_METHOD0(tearing_allowed, bool());
     MOCK_CONST_METHOD0(surface_if_any, std::optional<mir::scene::Surface const*>());
 };
 }
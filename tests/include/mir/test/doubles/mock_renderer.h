@@ -34,6 +34,7 @@ struct MockRenderer : public renderer::Renderer
     MOCK_METHOD(void, set_output_transform, (glm::mat2 const&));
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, render, (graphics::RenderableList const&), (const override));
     MOCK_METHOD(void, suspend, ());
+    MOCK_METHOD(void, capture_next_frame, (std::vector<renderer::Renderer::FrameCapture>&&));
 
     ~MockRenderer() noexcept {}
 };
@@ -48,6 +48,13 @@ class NullDisplay : public graphics::Display
         return false;
     }
     void configure(graphics::DisplayConfiguration const&)  override{}
+    void configure_incrementally(
+        graphics::DisplayConfiguration const& conf,
+        std::function<void(graphics::DisplaySyncGroup&)> const& retire) override
+    {
+        for_each_display_sync_group(retire);
+        configure(conf);
+    }
     void register_configuration_change_handler(
         graphics::EventHandlerRegister&,
         graphics::DisplayConfigurationChangeHandler const&) override
@@ -45,6 +45,8 @@ public:
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<graphics::Buffer>;
+
+    auto drm_syncobj_device() -> std::optional<Fd> override;
 };
 
 }
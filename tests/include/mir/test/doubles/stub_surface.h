@@ -90,6 +90,8 @@ struct StubSurface : scene::Surface
         geometry::DeltaX) override {}
     auto focus_mode() const -> MirFocusMode override { return mir_focus_mode_focusable; }
     void set_focus_mode(MirFocusMode) override {}
+    auto tearing_allowed() const -> bool override { return false; }
+    void set_tearing_allowed(bool) override {}
 };
 }
 }
@@ -380,9 +380,8 @@ struct DisplayServerMainLoopEvents : testing::Test
 
     void expect_change_configuration()
     {
-        EXPECT_CALL(*mock_compositor, stop()).Times(1);
+        EXPECT_CALL(*mock_compositor, configure_display(testing::_, testing::_)).Times(1);
         EXPECT_CALL(*mock_display, configure(testing::_)).Times(1);
-        EXPECT_CALL(*mock_compositor, start()).Times(1);
     }
 
     template<typename Functor>
@@ -22,6 +22,8 @@
 #include "src/server/scene/basic_surface.h"
 #include "src/server/compositor/default_display_buffer_compositor_factory.h"
 #include "src/server/compositor/multi_threaded_compositor.h"
+#include "src/server/compositor/capture_queue.h"
+#include "src/server/compositor/output_mirroring.h"
 #include "mir/compositor/stream.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/fake_display_configuration_observer_registrar.h"
@@ -209,7 +211,9 @@ struct SurfaceStackCompositor : public Test
         std::make_shared<mtd::NullGLConfig>(),
         mt::fake_shared(renderer_factory),
         std::make_shared<mtd::StubBufferAllocator>(),
-        null_comp_report};
+        null_comp_report,
+        std::make_shared<mc::CaptureQueue>([]{}),
+        std::make_shared<mc::OutputMirroring>([]{}, std::make_shared<mtd::StubBufferAllocator>())};
 };
 
 std::chrono::milliseconds const default_delay{-1};
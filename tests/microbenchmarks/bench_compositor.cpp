@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/rectangle.h"
+#include "src/server/compositor/occlusion.h"
+#include "src/server/compositor/multi_monitor_arbiter.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_scene_element.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const output_area{{0, 0}, {1920, 1080}};
+
+/// A cascade of overlapping windows, much as a busy desktop accumulates
+auto cascade_of(int count) -> mc::SceneElementSequence
+{
+    mc::SceneElementSequence elements;
+    for (auto i = 0; i != count; ++i)
+    {
+        elements.push_back(std::make_shared<mtd::StubSceneElement>(
+            std::make_shared<mtd::FakeRenderable>((i * 37) % 1600, (i * 23) % 840, 320, 240)));
+    }
+    return elements;
+}
+
+void filter_occlusions_from(benchmark::State& state)
+{
+    auto const scene = cascade_of(state.range(0));
+
+    for (auto _ : state)
+    {
+        // filter_occlusions_from() edits the list in place, so each pass needs a fresh copy
+        auto elements = scene;
+        auto occluded = mc::filter_occlusions_from(elements, output_area);
+        benchmark::DoNotOptimize(occluded);
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(filter_occlusions_from)->RangeMultiplier(4)->Range(1, 1024)->Complexity();
+
+/// A new buffer is submitted each frame and acquired by every output showing the stream
+void multi_monitor_arbiter_compositor_acquire(benchmark::State& state)
+{
+    auto const arbiter = std::make_shared<mc::MultiMonitorArbiter>();
+    std::vector<std::shared_ptr<mg::Buffer>> const buffers{
+        std::make_shared<mtd::StubBuffer>(),
+        std::make_shared<mtd::StubBuffer>(),
+        std::make_shared<mtd::StubBuffer>()};
+    std::vector<char> const outputs(state.range(0));
+    size_t frame{0};
+
+    for (auto _ : state)
+    {
+        auto const& buffer = buffers[frame++ % buffers.size()];
+        arbiter->submit_buffer(buffer, buffer->size(), geom::RectangleD{{0, 0}, geom::SizeD{buffer->size()}});
+
+        for (auto const& output : outputs)
+        {
+            auto submission = arbiter->compositor_acquire(&output);
+            benchmark::DoNotOptimize(submission);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(multi_monitor_arbiter_compositor_acquire)->Arg(1)->Arg(2)->Arg(4);
+}
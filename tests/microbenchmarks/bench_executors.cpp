@@ -0,0 +1,159 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/wayland_executor.h"
+#include "mir/executor.h"
+#include "mir/observer_multiplexer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <wayland-server-core.h>
+
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <vector>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+/// Spawn a burst of trivial work and wait for all of it to have run
+void spawn_burst(mir::Executor& executor, int burst_size)
+{
+    std::latch done{burst_size};
+    for (auto i = 0; i != burst_size; ++i)
+    {
+        executor.spawn([&done] { done.count_down(); });
+    }
+    done.wait();
+}
+
+void thread_pool_executor_spawn(benchmark::State& state)
+{
+    auto const burst_size = static_cast<int>(state.range(0));
+
+    for (auto _ : state)
+    {
+        spawn_burst(mir::thread_pool_executor, burst_size);
+    }
+
+    state.SetItemsProcessed(state.iterations() * burst_size);
+}
+BENCHMARK(thread_pool_executor_spawn)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+void linearising_executor_spawn(benchmark::State& state)
+{
+    auto const burst_size = static_cast<int>(state.range(0));
+
+    for (auto _ : state)
+    {
+        spawn_burst(mir::linearising_executor, burst_size);
+    }
+
+    state.SetItemsProcessed(state.iterations() * burst_size);
+}
+BENCHMARK(linearising_executor_spawn)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+/// Work is spawned from the benchmark thread and run by dispatching the Wayland event loop
+void wayland_executor_spawn_and_dispatch(benchmark::State& state)
+{
+    auto const burst_size = static_cast<int>(state.range(0));
+    std::unique_ptr<wl_event_loop, decltype(&wl_event_loop_destroy)> const loop{
+        wl_event_loop_create(),
+        &wl_event_loop_destroy};
+
+    {
+        mf::WaylandExecutor executor{loop.get()};
+
+        for (auto _ : state)
+        {
+            int remaining{burst_size};
+            for (auto i = 0; i != burst_size; ++i)
+            {
+                executor.spawn([&remaining] { --remaining; });
+            }
+
+            while (remaining > 0)
+            {
+                wl_event_loop_dispatch(loop.get(), 0);
+                wl_event_loop_dispatch_idle(loop.get());
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * burst_size);
+}
+BENCHMARK(wayland_executor_spawn_and_dispatch)->Arg(1)->Arg(16)->Arg(256);
+
+class Observer
+{
+public:
+    virtual ~Observer() = default;
+
+    virtual void changed(int value) = 0;
+};
+
+class CountingObserver : public Observer
+{
+public:
+    void changed(int value) override
+    {
+        benchmark::DoNotOptimize(total += value);
+    }
+
+    int total{0};
+};
+
+class Multiplexer : public mir::ObserverMultiplexer<Observer>
+{
+public:
+    Multiplexer()
+        : ObserverMultiplexer{mir::immediate_executor}
+    {
+    }
+
+    void changed(int value) override
+    {
+        for_each_observer(&Observer::changed, value);
+    }
+};
+
+/// The cost of fanning out one observation, excluding the work of the observers themselves
+void observer_multiplexer_dispatch(benchmark::State& state)
+{
+    Multiplexer multiplexer;
+    std::vector<std::shared_ptr<CountingObserver>> observers;
+    for (auto i = 0; i != state.range(0); ++i)
+    {
+        observers.push_back(std::make_shared<CountingObserver>());
+        multiplexer.register_interest(observers.back());
+    }
+
+    for (auto _ : state)
+    {
+        multiplexer.changed(1);
+    }
+
+    for (auto const& observer : observers)
+    {
+        multiplexer.unregister_interest(*observer);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(observer_multiplexer_dispatch)->Arg(1)->Arg(4)->Arg(16);
+}
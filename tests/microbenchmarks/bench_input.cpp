@@ -0,0 +1,112 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_builders.h"
+#include "mir/events/scroll_axis.h"
+#include "mir/input/xkb_mapper.h"
+#include "mir/input/parameter_keymap.h"
+#include "mir/geometry/point.h"
+#include "mir/geometry/displacement.h"
+
+#include <benchmark/benchmark.h>
+
+#include <linux/input.h>
+#include <xkbcommon/xkbcommon-keysyms.h>
+
+#include <chrono>
+#include <memory>
+
+namespace mev = mir::events;
+namespace mi = mir::input;
+namespace mircv = mir::input::receiver;
+namespace geom = mir::geometry;
+
+namespace
+{
+MirInputDeviceId const device_id{7};
+std::chrono::nanoseconds const timestamp{39};
+
+void make_key_event(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto event = mev::make_key_event(
+            device_id, timestamp, mir_keyboard_action_down, XKB_KEY_a, KEY_A, mir_input_event_modifier_none);
+        benchmark::DoNotOptimize(event);
+    }
+}
+BENCHMARK(make_key_event);
+
+void make_pointer_event(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto event = mev::make_pointer_event(
+            device_id,
+            timestamp,
+            mir_input_event_modifier_none,
+            mir_pointer_action_motion,
+            0,
+            geom::PointF{100.0f, 200.0f},
+            geom::DisplacementF{1.0f, -1.0f},
+            mir_pointer_axis_source_none,
+            mev::ScrollAxisH{},
+            mev::ScrollAxisV{});
+        benchmark::DoNotOptimize(event);
+    }
+}
+BENCHMARK(make_pointer_event);
+
+void make_touch_event(benchmark::State& state)
+{
+    auto const touches = static_cast<MirTouchId>(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto event = mev::make_touch_event(device_id, timestamp, mir_input_event_modifier_none);
+        for (MirTouchId id = 0; id != touches; ++id)
+        {
+            mev::add_touch(
+                *event, id, mir_touch_action_change, mir_touch_tooltype_finger,
+                10.0f * id, 20.0f * id, 1.0f, 5.0f, 5.0f, 5.0f);
+        }
+        benchmark::DoNotOptimize(event);
+    }
+}
+BENCHMARK(make_touch_event)->Arg(1)->Arg(5)->Arg(10);
+
+/// A key press and release through the default keymap
+void xkb_mapper_map_event(benchmark::State& state)
+{
+    mircv::XKBMapper mapper;
+    mapper.set_keymap_for_all_devices(std::make_shared<mi::ParameterKeymap>());
+
+    auto const press = mev::make_key_event(
+        device_id, timestamp, mir_keyboard_action_down, 0, KEY_A, mir_input_event_modifier_none);
+    auto const release = mev::make_key_event(
+        device_id, timestamp, mir_keyboard_action_up, 0, KEY_A, mir_input_event_modifier_none);
+
+    for (auto _ : state)
+    {
+        mapper.map_event(*press);
+        mapper.map_event(*release);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(2 * state.iterations());
+}
+BENCHMARK(xkb_mapper_map_event);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/scene/basic_surface.h"
+#include "src/server/report/null_report_factory.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+#include "mir/test/doubles/fake_display_configuration_observer_registrar.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace ms = mir::scene;
+namespace mi = mir::input;
+namespace mr = mir::report;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// A SurfaceStack holding a cascade of overlapping surfaces, the first of them at the origin
+struct PopulatedStack
+{
+    explicit PopulatedStack(int count)
+    {
+        for (auto i = 0; i != count; ++i)
+        {
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                nullptr,
+                mir::wayland::Weak<mir::frontend::WlSurface>{},
+                "bench",
+                geom::Rectangle{{(i * 37) % 1600, (i * 23) % 840}, {320, 240}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{std::make_shared<mtd::StubBufferStream>(), {}}},
+                nullptr,
+                report,
+                display_config_registrar);
+            stack->add_surface(surface, mi::InputReceptionMode::normal);
+            surfaces.push_back(surface);
+        }
+    }
+
+    ~PopulatedStack()
+    {
+        for (auto const& surface : surfaces)
+            stack->remove_surface(surface);
+    }
+
+    std::shared_ptr<ms::SceneReport> const report = mr::null_scene_report();
+    std::shared_ptr<mtd::FakeDisplayConfigurationObserverRegistrar> const display_config_registrar =
+        std::make_shared<mtd::FakeDisplayConfigurationObserverRegistrar>();
+    // The surface stack must be a shared pointer so shared_from_this() works
+    std::shared_ptr<ms::SurfaceStack> const stack = std::make_shared<ms::SurfaceStack>(report);
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+};
+
+void surface_stack_scene_elements_for(benchmark::State& state)
+{
+    PopulatedStack populated{static_cast<int>(state.range(0))};
+    mc::CompositorID const compositor_id{&populated};
+
+    for (auto _ : state)
+    {
+        auto elements = populated.stack->scene_elements_for(compositor_id);
+        benchmark::DoNotOptimize(elements);
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(surface_stack_scene_elements_for)->RangeMultiplier(4)->Range(1, 1024)->Complexity();
+
+/// The worst case for a hit: only the bottom-most surface contains the point
+void surface_stack_surface_at(benchmark::State& state)
+{
+    PopulatedStack populated{static_cast<int>(state.range(0))};
+    geom::Point const origin{0, 0};
+
+    for (auto _ : state)
+    {
+        auto surface = populated.stack->surface_at(origin);
+        benchmark::DoNotOptimize(surface);
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(surface_stack_surface_at)->RangeMultiplier(4)->Range(1, 1024)->Complexity();
+}
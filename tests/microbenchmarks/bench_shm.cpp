@@ -0,0 +1,84 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shm_backing.h"
+
+#include <benchmark/benchmark.h>
+#include <boost/throw_exception.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+auto make_shm_fd(size_t size) -> mir::Fd
+{
+    mir::Fd fd{memfd_create("mir-shm-benchmark", MFD_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create shm fd"}));
+    }
+    if (ftruncate(fd, size) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to resize shm fd"}));
+    }
+    return fd;
+}
+
+/// The size of a buffer of WxH XRGB8888 pixels
+auto frame_size(benchmark::State const& state) -> size_t
+{
+    return state.range(0) * state.range(1) * 4;
+}
+
+/// What each frame of a wl_shm client costs before any pixels are read
+void shm_map_ro(benchmark::State& state)
+{
+    auto const size = frame_size(state);
+    auto const pool = mir::shm::rw_pool_from_fd(make_shm_fd(size), size);
+    auto const range = pool->get_ro_range(0, size);
+
+    for (auto _ : state)
+    {
+        auto mapping = range->map_ro();
+        benchmark::DoNotOptimize(mapping->data());
+    }
+}
+BENCHMARK(shm_map_ro)->Args({256, 256})->Args({1920, 1080})->Args({3840, 2160});
+
+/// Mapping a frame and copying all of it out, as an upload to the GPU does
+void shm_map_ro_and_read(benchmark::State& state)
+{
+    auto const size = frame_size(state);
+    auto const pool = mir::shm::rw_pool_from_fd(make_shm_fd(size), size);
+    auto const range = pool->get_ro_range(0, size);
+    std::vector<std::byte> destination(size);
+
+    for (auto _ : state)
+    {
+        auto mapping = range->map_ro();
+        std::memcpy(destination.data(), mapping->data(), mapping->len());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(shm_map_ro_and_read)->Args({256, 256})->Args({1920, 1080})->Args({3840, 2160});
+}
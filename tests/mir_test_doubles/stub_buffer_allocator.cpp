@@ -94,6 +94,7 @@ auto mtd::StubBufferAllocator::buffer_from_shm(
     auto buffer = std::make_shared<mg::common::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         std::make_shared<mg::common::EGLContextExecutor>(std::make_unique<mtd::NullGLContext>()),
+        std::make_shared<mg::common::TextureBudget>(0),
         std::move(on_consumed),
         std::move(on_release));
 
@@ -104,3 +105,8 @@ auto mtd::StubBufferAllocator::buffer_from_shm(
 
     return buffer;
 }
+
+auto mtd::StubBufferAllocator::drm_syncobj_device() -> std::optional<mir::Fd>
+{
+    return std::nullopt;
+}
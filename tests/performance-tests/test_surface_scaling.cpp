@@ -0,0 +1,91 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system_performance_test.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace std::literals::chrono_literals;
+using namespace mir::test;
+
+namespace
+{
+/// Runs mir_demo_client_load_generator with a number of surfaces against mir_demo_server
+struct SurfaceScaling : SystemPerformanceTest, testing::WithParamInterface<int>
+{
+    void SetUp() override
+    {
+        auto const test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+        results_filename = std::string{"/tmp/"} + test_info->test_suite_name() + "_" + std::to_string(GetParam()) + "_load.json";
+        unlink(results_filename.c_str());
+
+        SystemPerformanceTest::set_up_with("");
+    }
+
+    /// The load generator writes its results once it has finished
+    auto wait_for_results(std::chrono::seconds timeout) -> std::string
+    {
+        for (auto const deadline = std::chrono::steady_clock::now() + timeout;
+             std::chrono::steady_clock::now() < deadline;
+             std::this_thread::sleep_for(100ms))
+        {
+            if (std::ifstream in{results_filename}; in.good())
+            {
+                std::stringstream contents;
+                contents << in.rdbuf();
+                return contents.str();
+            }
+        }
+        return {};
+    }
+
+    /// The first value of \p key in \p json, after \p within if given
+    static auto value_of(std::string const& json, std::string const& key, std::string const& within = {}) -> double
+    {
+        auto const start = within.empty() ? 0 : json.find("\"" + within + "\"");
+        auto const pos = json.find("\"" + key + "\": ", start == std::string::npos ? json.size() : start);
+        return pos == std::string::npos ? -1 : std::stod(json.substr(pos + key.size() + 4));
+    }
+
+    std::string results_filename;
+};
+}
+
+TEST_P(SurfaceScaling, mixed_rate_shm_surfaces)
+{
+    auto const surfaces = GetParam();
+    spawn_clients({
+        "mir_demo_client_load_generator --surfaces " + std::to_string(surfaces) +
+        " --rates 60,30,10 --damage partial --duration 10 --output " + results_filename});
+
+    auto const results = wait_for_results(60s);
+    ASSERT_FALSE(results.empty()) << "No results in " << results_filename;
+
+    RecordProperty("frames_per_second", std::to_string(value_of(results, "frames_per_second")));
+    RecordProperty("commits_per_second", std::to_string(value_of(results, "commits_per_second")));
+    RecordProperty("stalled_surfaces", std::to_string(value_of(results, "stalled_surfaces")));
+    RecordProperty("frame_interval_p99_ms", std::to_string(value_of(results, "p99", "frame_interval_ms")));
+    RecordProperty("latency_p50_ms", std::to_string(value_of(results, "p50", "latency_ms")));
+    RecordProperty("latency_p99_ms", std::to_string(value_of(results, "p99", "latency_ms")));
+
+    EXPECT_GT(value_of(results, "frames_per_second"), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(SurfaceCounts, SurfaceScaling, testing::Values(50, 200, 1000));
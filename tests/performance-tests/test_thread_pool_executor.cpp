@@ -0,0 +1,149 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/**
+ * The scheduling model the ThreadPoolExecutor used to have: each item of work
+ * on a thread of its own, with a new thread whenever none was idle. Under a burst
+ * (the case being measured here) that is a thread per item.
+ */
+struct ThreadPerSpawnExecutor : mir::NonBlockingExecutor
+{
+    ~ThreadPerSpawnExecutor()
+    {
+        std::lock_guard lock{mutex};
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void spawn(std::function<void()>&& work) override
+    {
+        std::lock_guard lock{mutex};
+        if (threads.size() == max_unjoined_threads)
+        {
+            // Finished threads still hold their resources until joined
+            for (auto& thread : threads)
+                thread.join();
+            threads.clear();
+        }
+        threads.emplace_back(std::move(work));
+    }
+
+    static constexpr size_t max_unjoined_threads = 256;
+
+    std::mutex mutex;
+    std::vector<std::thread> threads;
+};
+
+struct Result
+{
+    double spawns_per_second;
+    std::chrono::microseconds p50;
+    std::chrono::microseconds p99;
+};
+
+/// Spawn bursts of trivial work, timing from spawn() to the work starting
+auto measure(mir::Executor& executor) -> Result
+{
+    constexpr int bursts = 50;
+    constexpr int burst_size = 200;
+
+    std::vector<Clock::duration> latencies(bursts * burst_size);
+    std::mutex mutex;
+    std::condition_variable cv;
+    int remaining{0};
+
+    auto const start = Clock::now();
+    for (auto burst = 0; burst != bursts; ++burst)
+    {
+        {
+            std::lock_guard lock{mutex};
+            remaining = burst_size;
+        }
+
+        for (auto i = 0; i != burst_size; ++i)
+        {
+            auto const spawned = Clock::now();
+            executor.spawn(
+                [&, spawned, slot = &latencies[burst * burst_size + i]]
+                {
+                    *slot = Clock::now() - spawned;
+                    std::lock_guard lock{mutex};
+                    if (--remaining == 0)
+                        cv.notify_all();
+                });
+        }
+
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&] { return remaining == 0; });
+    }
+    auto const elapsed = std::chrono::duration<double>(Clock::now() - start);
+
+    std::sort(latencies.begin(), latencies.end());
+    auto const at = [&](double fraction)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                latencies[static_cast<size_t>(fraction * (latencies.size() - 1))]);
+        };
+
+    return {latencies.size() / elapsed.count(), at(0.5), at(0.99)};
+}
+
+void report(std::string const& name, Result const& result)
+{
+    std::cout << name << ": " << static_cast<long>(result.spawns_per_second) << " spawns/s, "
+              << "start latency p50 " << result.p50.count() << "us, p99 " << result.p99.count() << "us"
+              << std::endl;
+
+    testing::Test::RecordProperty(name + "_spawns_per_second", static_cast<int>(result.spawns_per_second));
+    testing::Test::RecordProperty(name + "_p50_us", static_cast<int>(result.p50.count()));
+    testing::Test::RecordProperty(name + "_p99_us", static_cast<int>(result.p99.count()));
+}
+}
+
+TEST(ThreadPoolExecutorPerformance, spawn_throughput_and_latency)
+{
+    Result thread_per_spawn;
+    {
+        ThreadPerSpawnExecutor executor;
+        thread_per_spawn = measure(executor);
+    }
+    auto const thread_pool = measure(mir::thread_pool_executor);
+    mir::ThreadPoolExecutor::quiesce();
+
+    report("thread_per_spawn", thread_per_spawn);
+    report("thread_pool", thread_pool);
+}
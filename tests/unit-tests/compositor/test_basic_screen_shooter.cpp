@@ -31,6 +31,7 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/doubles/stub_scene_element.h"
 #include "mir/test/doubles/stub_renderable.h"
+#include "mir/test/doubles/stub_display_sink.h"
 
 #include <gtest/gtest.h>
 
@@ -105,7 +106,17 @@ struct BasicScreenShooter : Test
             clock,
             executor,
             gl_providers,
-            renderer_factory);
+            renderer_factory,
+            capture_queue);
+    }
+
+    /// Stands in for the compositor drawing a frame, completing any captures it covers
+    void composite_captures(bool copied)
+    {
+        for (auto& capture : capture_queue->take_within(output.view_area()))
+        {
+            capture.done(copied);
+        }
     }
 
     std::unique_ptr<mtd::MockRenderer> next_renderer{std::make_unique<testing::NiceMock<mtd::MockRenderer>>()};
@@ -135,6 +146,10 @@ struct BasicScreenShooter : Test
     std::shared_ptr<MockRendererFactory> renderer_factory{std::make_shared<testing::NiceMock<MockRendererFactory>>()};
     std::shared_ptr<mtd::AdvanceableClock> clock{std::make_shared<mtd::AdvanceableClock>()};
     mtd::ExplicitExecutor executor;
+    std::function<void()> on_schedule_compositing{[]{}};
+    std::shared_ptr<mc::CaptureQueue> capture_queue{
+        std::make_shared<mc::CaptureQueue>([this]() { on_schedule_compositing(); })};
+    mtd::StubDisplaySink output{{{0, 0}, {1920, 1080}}};
     std::unique_ptr<mc::BasicScreenShooter> shooter;
     std::shared_ptr<mtd::StubBuffer> buffer{std::make_shared<mtd::StubBuffer>(geom::Size{800, 600})};
     geom::Rectangle const viewport_rect{{20, 30}, {40, 50}};
@@ -246,7 +261,8 @@ TEST_F(BasicScreenShooter, ensures_renderer_is_current_on_only_one_thread)
         clock,
         mir::thread_pool_executor,
         gl_providers,
-        renderer_factory);
+        renderer_factory,
+        capture_queue);
 
     ON_CALL(*next_renderer, render(_))
         .WillByDefault(
@@ -288,3 +304,95 @@ TEST_F(BasicScreenShooter, ensures_renderer_is_current_on_only_one_thread)
     mir::ThreadPoolExecutor::quiesce();
     EXPECT_THAT(call_count, Eq(expected_call_count));
 }
+
+TEST_F(BasicScreenShooter, copies_from_the_composited_frame_when_an_output_covers_the_area)
+{
+    capture_queue->add_output(output);
+    on_schedule_compositing = [this]() { composite_captures(true); };
+
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(*renderer_factory, create_renderer_for(_, _)).Times(0);
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+
+    capture_queue->remove_output(output);
+}
+
+TEST_F(BasicScreenShooter, renders_itself_when_the_composited_frame_cannot_be_copied)
+{
+    capture_queue->add_output(output);
+    on_schedule_compositing = [this]() { composite_captures(false); };
+
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    InSequence seq;
+    EXPECT_CALL(*next_renderer, render(Eq(renderables)));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+
+    capture_queue->remove_output(output);
+}
+
+TEST_F(BasicScreenShooter, renders_itself_when_no_output_covers_the_area)
+{
+    capture_queue->add_output(output);
+    on_schedule_compositing = []() { FAIL() << "No compositor should have been asked for a frame"; };
+
+    geom::Rectangle const straddling{{1900, 0}, {40, 50}};
+    shooter->capture(buffer, straddling, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(*next_renderer, render(_));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+
+    capture_queue->remove_output(output);
+}
+
+TEST_F(BasicScreenShooter, renders_into_gpu_buffer_when_no_output_covers_the_area)
+{
+    auto const gpu_buffer = std::make_shared<mtd::StubBuffer>(viewport_rect.size);
+    shooter->capture_to_gpu_buffer(gpu_buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+
+    InSequence seq;
+    EXPECT_CALL(*next_renderer, capture_next_frame(_))
+        .WillOnce([&](std::vector<mr::Renderer::FrameCapture>&& captures)
+            {
+                ASSERT_THAT(captures.size(), Eq(1u));
+                EXPECT_THAT(captures[0].gpu_target, Eq(gpu_buffer));
+                EXPECT_THAT(captures[0].area, Eq(viewport_rect));
+                captures[0].done(true);
+            });
+    EXPECT_CALL(*next_renderer, render(_));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, capture_to_gpu_buffer_fails_if_the_renderer_cannot_copy)
+{
+    auto const gpu_buffer = std::make_shared<mtd::StubBuffer>(viewport_rect.size);
+    shooter->capture_to_gpu_buffer(gpu_buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+
+    ON_CALL(*next_renderer, capture_next_frame(_))
+        .WillByDefault([](std::vector<mr::Renderer::FrameCapture>&& captures)
+            {
+                for (auto& capture : captures)
+                {
+                    capture.done(false);
+                }
+            });
+    EXPECT_CALL(callback, Call(nullopt_time));
+    executor.execute();
+}
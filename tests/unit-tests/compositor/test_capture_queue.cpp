@@ -0,0 +1,99 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/capture_queue.h"
+#include "mir/test/doubles/stub_display_sink.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+auto capture_of(geom::Rectangle const& area) -> std::shared_ptr<mc::CaptureQueue::Capture>
+{
+    return std::make_shared<mc::CaptureQueue::Capture>(
+        mc::CaptureQueue::Capture{area, area, nullptr, nullptr, [](bool) {}});
+}
+
+struct CaptureQueue : Test
+{
+    MockFunction<void()> schedule_compositing;
+    mc::CaptureQueue queue{schedule_compositing.AsStdFunction()};
+    mtd::StubDisplaySink left{{{0, 0}, {1920, 1080}}};
+    mtd::StubDisplaySink right{{{1920, 0}, {1280, 1024}}};
+};
+}
+
+TEST_F(CaptureQueue, area_is_composited_only_if_a_single_output_covers_it)
+{
+    queue.add_output(left);
+    queue.add_output(right);
+
+    EXPECT_TRUE(queue.is_composited({{100, 100}, {200, 200}}));
+    EXPECT_TRUE(queue.is_composited({{2000, 100}, {200, 200}}));
+    EXPECT_FALSE(queue.is_composited({{1800, 100}, {200, 200}}));
+    EXPECT_FALSE(queue.is_composited({{100, 1000}, {200, 200}}));
+}
+
+TEST_F(CaptureQueue, removed_outputs_are_not_composited)
+{
+    queue.add_output(left);
+    queue.remove_output(left);
+
+    EXPECT_FALSE(queue.is_composited({{100, 100}, {200, 200}}));
+}
+
+TEST_F(CaptureQueue, enqueueing_schedules_compositing)
+{
+    EXPECT_CALL(schedule_compositing, Call());
+
+    queue.enqueue(capture_of({{100, 100}, {200, 200}}));
+}
+
+TEST_F(CaptureQueue, takes_only_captures_within_the_view_area)
+{
+    EXPECT_CALL(schedule_compositing, Call()).Times(AnyNumber());
+    geom::Rectangle const on_left{{100, 100}, {200, 200}};
+    geom::Rectangle const on_right{{2000, 100}, {200, 200}};
+    queue.enqueue(capture_of(on_left));
+    queue.enqueue(capture_of(on_right));
+
+    auto const taken = queue.take_within(left.view_area());
+
+    ASSERT_THAT(taken.size(), Eq(1u));
+    EXPECT_THAT(taken[0].area, Eq(on_left));
+    EXPECT_THAT(queue.take_within(left.view_area()).size(), Eq(0u));
+    EXPECT_THAT(queue.take_within(right.view_area()).size(), Eq(1u));
+}
+
+TEST_F(CaptureQueue, withdraw_succeeds_only_before_the_capture_is_taken)
+{
+    EXPECT_CALL(schedule_compositing, Call()).Times(AnyNumber());
+    auto const waiting = capture_of({{100, 100}, {200, 200}});
+    auto const taken = capture_of({{300, 100}, {200, 200}});
+    queue.enqueue(waiting);
+    queue.enqueue(taken);
+
+    EXPECT_TRUE(queue.withdraw(waiting));
+    queue.take_within(left.view_area());
+    EXPECT_FALSE(queue.withdraw(taken));
+}
@@ -15,6 +15,8 @@
  */
 
 #include "src/server/compositor/default_display_buffer_compositor.h"
+#include "src/server/compositor/capture_queue.h"
+#include "src/server/compositor/output_mirroring.h"
 #include "src/server/report/null_report_factory.h"
 #include "mir/compositor/scene.h"
 #include "mir/renderer/renderer.h"
@@ -26,6 +28,7 @@
 #include "mir/test/doubles/mock_compositor_report.h"
 #include "mir/test/doubles/stub_scene_element.h"
 #include "mir/test/doubles/stub_gl_rendering_provider.h"
+#include "mir/test/doubles/stub_buffer_allocator.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -77,6 +80,30 @@ auto make_scene_elements(std::initializer_list<std::shared_ptr<mg::Renderable>>
     return elements;
 }
 
+auto capture_of(geom::Rectangle const& area) -> std::shared_ptr<mc::CaptureQueue::Capture>
+{
+    return std::make_shared<mc::CaptureQueue::Capture>(
+        mc::CaptureQueue::Capture{area, area, nullptr, nullptr, [](bool) {}});
+}
+
+/// Offers every buffer for overlay, as a sink that can show client buffers itself would
+class OverlayEverything : public mg::RenderingProvider::FramebufferProvider
+{
+public:
+    auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer> buffer) -> std::unique_ptr<mg::Framebuffer> override
+    {
+        class StubFramebuffer : public mg::Framebuffer
+        {
+        public:
+            explicit StubFramebuffer(geom::Size size) : size_{size} {}
+            auto size() const -> geom::Size override { return size_; }
+        private:
+            geom::Size const size_;
+        };
+        return std::make_unique<StubFramebuffer>(buffer->size());
+    }
+};
+
 struct DefaultDisplayBufferCompositor : public testing::Test
 {
     DefaultDisplayBufferCompositor()
@@ -100,6 +127,9 @@ struct DefaultDisplayBufferCompositor : public testing::Test
     std::shared_ptr<mtd::FakeRenderable> small;
     std::shared_ptr<mtd::FakeRenderable> big;
     std::shared_ptr<mtd::FakeRenderable> fullscreen;
+    std::shared_ptr<mc::CaptureQueue> const capture_queue{std::make_shared<mc::CaptureQueue>([]{})};
+    std::shared_ptr<mc::OutputMirroring> const mirroring{
+        std::make_shared<mc::OutputMirroring>([]{}, std::make_shared<mtd::StubBufferAllocator>())};
 };
 }
 
@@ -111,7 +141,9 @@ TEST_F(DefaultDisplayBufferCompositor, composite_returns_false_when_scene_elemen
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
     EXPECT_FALSE(compositor.composite(make_scene_elements({})));
 }
 
@@ -123,7 +155,9 @@ TEST_F(DefaultDisplayBufferCompositor, composite_returns_true_when_scene_element
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
     EXPECT_TRUE(compositor.composite(make_scene_elements({big})));
 }
 
@@ -135,9 +169,10 @@ TEST_F(DefaultDisplayBufferCompositor, renderer_is_suspended_when_we_have_compos
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
     compositor.composite(make_scene_elements({big}));
-    compositor.composite(make_scene_elements({}));
 
     EXPECT_CALL(display_sink, overlay(_))
         .WillOnce(Return(true));
@@ -165,7 +200,9 @@ TEST_F(DefaultDisplayBufferCompositor, all_expected_reports_are_received_during_
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        report);
+        report,
+        capture_queue,
+        mirroring);
     compositor.composite(make_scene_elements({big}));
 }
 
@@ -179,7 +216,9 @@ TEST_F(DefaultDisplayBufferCompositor, elements_provided_to_composite_are_render
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
 
     compositor.composite(make_scene_elements({
         big,
@@ -205,7 +244,9 @@ TEST_F(DefaultDisplayBufferCompositor, viewport_is_rotated_when_display_sink_vie
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
 
     Sequence render_seq;
     EXPECT_CALL(display_sink, transformation())
@@ -225,10 +266,11 @@ TEST_F(DefaultDisplayBufferCompositor, renderer_is_suspended_when_we_have_compos
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
 
     compositor.composite(make_scene_elements({big}));
-    compositor.composite(make_scene_elements({}));
 
     EXPECT_CALL(display_sink, overlay(_))
         .WillRepeatedly(Return(true));
@@ -237,6 +279,9 @@ TEST_F(DefaultDisplayBufferCompositor, renderer_is_suspended_when_we_have_compos
 
     compositor.composite(make_scene_elements({}));
 
+    // Something needs to change, or there would be nothing to composite
+    compositor.composite(make_scene_elements({big}));
+
     EXPECT_CALL(mock_renderer, suspend())
         .Times(1);
     compositor.composite(make_scene_elements({}));
@@ -261,7 +306,9 @@ TEST_F(DefaultDisplayBufferCompositor, occluded_surfaces_are_not_rendered)
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
     compositor.composite(make_scene_elements({
         window0, //not occluded
         window1, //occluded
@@ -302,7 +349,9 @@ TEST_F(DefaultDisplayBufferCompositor, marks_rendered_scene_elements)
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
 
     compositor.composite({element0_rendered, element1_rendered});
 }
@@ -326,8 +375,356 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
 
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+TEST_F(DefaultDisplayBufferCompositor, skips_frame_when_nothing_visible_changed)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    EXPECT_CALL(mock_renderer, render(_)).Times(1);
+    EXPECT_CALL(display_sink, set_next_image(_)).Times(1);
+
+    EXPECT_TRUE(compositor.composite(make_scene_elements({big, small})));
+    EXPECT_FALSE(compositor.composite(make_scene_elements({big, small})));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, skipped_frames_are_not_reported)
+{
+    using namespace testing;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        report,
+        capture_queue,
+        mirroring);
+
+    EXPECT_CALL(*report, began_frame(_)).Times(1);
+    EXPECT_CALL(*report, finished_frame(_)).Times(1);
+
+    compositor.composite(make_scene_elements({big}));
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, composites_when_a_renderable_has_a_new_buffer)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big}));
+
+    big->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_CALL(mock_renderer, render(_)).Times(1);
+    EXPECT_TRUE(compositor.composite(make_scene_elements({big})));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, composites_when_the_visible_renderables_change)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big}));
+
+    EXPECT_CALL(mock_renderer, render(_)).Times(2);
+    EXPECT_TRUE(compositor.composite(make_scene_elements({big, small})));
+    EXPECT_TRUE(compositor.composite(make_scene_elements({small, big})));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, composites_when_the_output_is_reconfigured)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big}));
+
+    ON_CALL(display_sink, view_area())
+        .WillByDefault(Return(geom::Rectangle{{0, 0}, {1920, 1080}}));
+
+    EXPECT_CALL(mock_renderer, render(_)).Times(1);
+    EXPECT_TRUE(compositor.composite(make_scene_elements({big})));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, hands_waiting_captures_to_the_renderer)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    geom::Rectangle const inside{{10, 10}, {100, 100}};
+    geom::Rectangle const outside{{2000, 10}, {100, 100}};
+    capture_queue->enqueue(capture_of(inside));
+    capture_queue->enqueue(capture_of(outside));
+
+    InSequence seq;
+    EXPECT_CALL(mock_renderer, capture_next_frame(ElementsAre(Field(&mc::CaptureQueue::Capture::area, Eq(inside)))));
+    EXPECT_CALL(mock_renderer, render(_));
+
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renders_unchanged_frame_when_a_capture_is_waiting)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big}));
+
+    capture_queue->enqueue(capture_of(screen));
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(mock_renderer, capture_next_frame(SizeIs(1)));
+    EXPECT_CALL(mock_renderer, render(_));
+    EXPECT_TRUE(compositor.composite(make_scene_elements({big})));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, first_frame_is_damaged_everywhere)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    EXPECT_CALL(display_sink, set_next_image_damage(IsEmpty()));
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, damages_only_renderables_with_new_buffers)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_CALL(display_sink, set_next_image_damage(ElementsAre(small->screen_position())));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, damages_where_renderables_appear_and_disappear)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big}));
+
+    EXPECT_CALL(display_sink, set_next_image_damage(ElementsAre(small->screen_position())));
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_CALL(display_sink, set_next_image_damage(ElementsAre(big->screen_position())));
+    compositor.composite(make_scene_elements({small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, restacking_damages_everything)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_CALL(display_sink, set_next_image_damage(IsEmpty()));
+    compositor.composite(make_scene_elements({small, big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, offers_opaque_renderables_for_overlay)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        std::make_unique<OverlayEverything>(),
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    EXPECT_CALL(display_sink, overlay(SizeIs(2)))
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_renderer, render(_)).Times(0);
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, does_not_offer_translucent_renderables_for_overlay)
+{
+    using namespace testing;
+
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{10, 20},{30, 40}}, 0.5f);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        std::make_unique<OverlayEverything>(),
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(mock_renderer, render(_));
+    compositor.composite(make_scene_elements({big, translucent}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, mirrored_output_draws_the_frame_copied_from_its_source)
+{
+    using namespace testing;
+
+    NiceMock<mtd::MockDisplaySink> mirror_sink;
+    ON_CALL(mirror_sink, transformation()).WillByDefault(Return(no_transformation));
+    ON_CALL(mirror_sink, view_area()).WillByDefault(Return(screen));
+    NiceMock<mtd::MockRenderer> mirror_renderer;
+
+    mc::DefaultDisplayBufferCompositor source(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+    mc::DefaultDisplayBufferCompositor mirror(
+        mirror_sink,
+        gl_provider,
+        mt::fake_shared(mirror_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    std::shared_ptr<mg::Buffer> copied_frame;
+    EXPECT_CALL(mock_renderer, capture_next_frame(_))
+        .WillOnce(Invoke(
+            [&](std::vector<mc::OutputMirroring::Capture>&& captures)
+            {
+                ASSERT_THAT(captures, SizeIs(1));
+                copied_frame = captures.front().gpu_target;
+                captures.front().done(true);
+            }));
+    source.composite(make_scene_elements({small, big}));
+
+    ASSERT_THAT(copied_frame, NotNull());
+    EXPECT_CALL(mirror_renderer, render(ElementsAre(Pointee(
+        AllOf(
+            Property(&mg::Renderable::buffer, Eq(copied_frame)),
+            Property(&mg::Renderable::screen_position, Eq(screen)))))));
+    mirror.composite(make_scene_elements({small, big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, mirrored_output_redraws_a_new_frame_copied_into_a_reused_buffer)
+{
+    using namespace testing;
+
+    NiceMock<mtd::MockDisplaySink> mirror_sink;
+    ON_CALL(mirror_sink, transformation()).WillByDefault(Return(no_transformation));
+    ON_CALL(mirror_sink, view_area()).WillByDefault(Return(screen));
+    NiceMock<mtd::MockRenderer> mirror_renderer;
+
+    mc::DefaultDisplayBufferCompositor source(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+    mc::DefaultDisplayBufferCompositor mirror(
+        mirror_sink,
+        gl_provider,
+        mt::fake_shared(mirror_renderer),
+        mr::null_compositor_report(),
+        capture_queue,
+        mirroring);
+
+    std::vector<mg::Buffer const*> copied_frames;
+    ON_CALL(mock_renderer, capture_next_frame(_))
+        .WillByDefault(Invoke(
+            [&](std::vector<mc::OutputMirroring::Capture>&& captures)
+            {
+                ASSERT_THAT(captures, SizeIs(1));
+                copied_frames.push_back(captures.front().gpu_target.get());
+                captures.front().done(true);
+            }));
+
+    source.composite(make_scene_elements({small}));
+    mirror.composite(make_scene_elements({small}));
+
+    // The mirror doesn't composite while the source draws twice more, so the first buffer is reused
+    source.composite(make_scene_elements({big}));
+    source.composite(make_scene_elements({big, small}));
+    ASSERT_THAT(copied_frames, SizeIs(3));
+    ASSERT_THAT(copied_frames[2], Eq(copied_frames[0]));
+
+    EXPECT_CALL(mirror_renderer, render(_));
+    EXPECT_TRUE(mirror.composite(make_scene_elements({big, small})));
+}
@@ -32,6 +32,8 @@
 #include "mir/test/doubles/mock_scene.h"
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_display.h"
+#include "mir/test/doubles/null_display_configuration.h"
+#include "mir/test/doubles/mock_display.h"
 #include "mir/test/doubles/null_display_buffer_compositor_factory.h"
 
 #include <boost/throw_exception.hpp>
@@ -90,6 +92,48 @@ private:
     std::vector<StubDisplaySyncGroup> buffers;
 };
 
+/// Replaces only its first sync group when reconfigured; the rest carry on untouched
+class IncrementallyConfiguredDisplay : public mtd::NullDisplay
+{
+public:
+    IncrementallyConfiguredDisplay(unsigned int ngroups)
+    {
+        for (auto i = 0u; i != ngroups; ++i)
+            groups.push_back(std::make_unique<StubDisplaySyncGroup>());
+    }
+
+    void for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f) override
+    {
+        for (auto& group : groups)
+            f(*group);
+    }
+
+    void configure_incrementally(
+        mg::DisplayConfiguration const&,
+        std::function<void(mg::DisplaySyncGroup&)> const& retire) override
+    {
+        retire(*groups.front());
+        groups.front() = std::make_unique<StubDisplaySyncGroup>();
+    }
+
+private:
+    struct StubDisplaySyncGroup : mg::DisplaySyncGroup
+    {
+        void for_each_display_sink(std::function<void(mg::DisplaySink&)> const& f) override
+        {
+            f(sink);
+        }
+        void post() override {}
+        std::chrono::milliseconds recommended_sleep() const override
+        {
+            return std::chrono::milliseconds::zero();
+        }
+        testing::NiceMock<mtd::MockDisplaySink> sink;
+    };
+
+    std::vector<std::unique_ptr<StubDisplaySyncGroup>> groups;
+};
+
 class StubScene : public mtd::StubScene
 {
 public:
@@ -886,3 +930,47 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
     compositor.start();
 }
+
+TEST(MultiThreadedCompositor, configuring_display_only_restarts_compositing_for_replaced_groups)
+{
+    using namespace testing;
+    unsigned int const ngroups{3};
+    auto display = std::make_shared<IncrementallyConfiguredDisplay>(ngroups);
+    auto mock_scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
+    mtd::NullDisplayConfiguration conf;
+
+    mc::MultiThreadedCompositor compositor{
+        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+
+    compositor.start();
+
+    EXPECT_CALL(*mock_scene, unregister_compositor(_)).Times(1);
+    EXPECT_CALL(*mock_scene, register_compositor(_)).Times(1);
+
+    compositor.configure_display(*display, conf);
+
+    Mock::VerifyAndClearExpectations(mock_scene.get());
+
+    EXPECT_CALL(*mock_scene, unregister_compositor(_)).Times(ngroups);
+
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, configuring_display_when_stopped_configures_directly)
+{
+    using namespace testing;
+    auto display = std::make_shared<NiceMock<mtd::MockDisplay>>();
+    auto stub_scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    mtd::NullDisplayConfiguration conf;
+
+    mc::MultiThreadedCompositor compositor{
+        display, stub_scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+
+    EXPECT_CALL(*display, configure(Ref(conf)));
+    EXPECT_CALL(*display, configure_incrementally(_, _)).Times(0);
+
+    compositor.configure_display(*display, conf);
+}
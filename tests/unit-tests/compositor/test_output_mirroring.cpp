@@ -0,0 +1,188 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/compositor/output_mirroring.h"
+#include "mir/test/doubles/stub_display_sink.h"
+#include "mir/test/doubles/stub_buffer_allocator.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+struct RotatedDisplaySink : mtd::StubDisplaySink
+{
+    using mtd::StubDisplaySink::StubDisplaySink;
+    glm::mat2 transformation() const override { return glm::mat2{0, 1, -1, 0}; }
+};
+
+struct OutputMirroring : Test
+{
+    NiceMock<MockFunction<void()>> schedule_compositing;
+    mc::OutputMirroring mirroring{
+        schedule_compositing.AsStdFunction(),
+        std::make_shared<mtd::StubBufferAllocator>()};
+    geom::Rectangle const area{{0, 0}, {1920, 1080}};
+    mtd::StubDisplaySink first{area};
+    mtd::StubDisplaySink second{area};
+    mtd::StubDisplaySink elsewhere{{{1920, 0}, {1280, 1024}}};
+};
+}
+
+TEST_F(OutputMirroring, output_without_mirrors_has_no_capture)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(elsewhere);
+
+    EXPECT_THAT(mirroring.capture_for(first), Eq(std::nullopt));
+    EXPECT_THAT(mirroring.capture_for(elsewhere), Eq(std::nullopt));
+}
+
+TEST_F(OutputMirroring, first_of_outputs_showing_the_same_area_draws_for_the_others)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    EXPECT_THAT(mirroring.capture_for(second), Eq(std::nullopt));
+
+    auto const capture = mirroring.capture_for(first);
+    ASSERT_THAT(capture, Ne(std::nullopt));
+    EXPECT_THAT(capture->area, Eq(area));
+    ASSERT_THAT(capture->gpu_target, NotNull());
+    EXPECT_THAT(capture->gpu_target->size(), Eq(area.size));
+}
+
+TEST_F(OutputMirroring, mirror_draws_the_scene_itself_until_a_frame_is_copied)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    auto const capture = mirroring.capture_for(first);
+    ASSERT_THAT(capture, Ne(std::nullopt));
+    EXPECT_THAT(mirroring.mirrored_frame(second), Eq(std::nullopt));
+
+    EXPECT_CALL(schedule_compositing, Call());
+    capture->done(true);
+
+    auto const frame = mirroring.mirrored_frame(second);
+    ASSERT_THAT(frame, Ne(std::nullopt));
+    EXPECT_THAT(frame->buffer, Eq(capture->gpu_target));
+    EXPECT_THAT(mirroring.mirrored_frame(first), Eq(std::nullopt));
+}
+
+TEST_F(OutputMirroring, published_frames_are_not_drawn_over)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    auto const capture = mirroring.capture_for(first);
+    ASSERT_THAT(capture, Ne(std::nullopt));
+    capture->done(true);
+    auto const published = mirroring.mirrored_frame(second);
+    ASSERT_THAT(published, Ne(std::nullopt));
+
+    auto const next = mirroring.capture_for(first);
+    ASSERT_THAT(next, Ne(std::nullopt));
+    EXPECT_THAT(next->gpu_target, Ne(published->buffer));
+}
+
+TEST_F(OutputMirroring, frame_published_in_a_reused_buffer_is_a_new_publication)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    auto const publish_next = [&]
+        {
+            auto capture = mirroring.capture_for(first);
+            EXPECT_THAT(capture, Ne(std::nullopt));
+            capture->done(true);
+            return *mirroring.mirrored_frame(second);
+        };
+
+    mg::Buffer const* earlier_buffer;
+    std::uint64_t earlier_publication;
+    {
+        auto const earlier = publish_next();
+        earlier_buffer = earlier.buffer.get();
+        earlier_publication = earlier.publication;
+    }
+    publish_next();
+
+    // The earlier buffer is free once a later frame is published
+    auto const recycled = publish_next();
+
+    EXPECT_THAT(recycled.buffer.get(), Eq(earlier_buffer));
+    EXPECT_THAT(recycled.publication, Ne(earlier_publication));
+}
+
+TEST_F(OutputMirroring, output_whose_frames_cannot_be_copied_hands_over_to_the_next)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    auto const capture = mirroring.capture_for(first);
+    ASSERT_THAT(capture, Ne(std::nullopt));
+    capture->done(false);
+
+    EXPECT_THAT(mirroring.capture_for(first), Eq(std::nullopt));
+    EXPECT_THAT(mirroring.capture_for(second), Ne(std::nullopt));
+}
+
+TEST_F(OutputMirroring, rotated_output_does_not_draw_for_others)
+{
+    RotatedDisplaySink rotated{area};
+    mirroring.add_output(rotated);
+    mirroring.add_output(first);
+
+    EXPECT_THAT(mirroring.capture_for(rotated), Eq(std::nullopt));
+    EXPECT_THAT(mirroring.capture_for(first), Ne(std::nullopt));
+}
+
+TEST_F(OutputMirroring, withdrawn_frame_is_not_mirrored)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    auto const capture = mirroring.capture_for(first);
+    ASSERT_THAT(capture, Ne(std::nullopt));
+    capture->done(true);
+
+    EXPECT_CALL(schedule_compositing, Call());
+    mirroring.withdraw_frame(first);
+
+    EXPECT_THAT(mirroring.mirrored_frame(second), Eq(std::nullopt));
+}
+
+TEST_F(OutputMirroring, frames_of_removed_output_are_not_mirrored)
+{
+    mirroring.add_output(first);
+    mirroring.add_output(second);
+
+    auto const capture = mirroring.capture_for(first);
+    ASSERT_THAT(capture, Ne(std::nullopt));
+    capture->done(true);
+    mirroring.remove_output(first);
+
+    EXPECT_THAT(mirroring.mirrored_frame(second), Eq(std::nullopt));
+}
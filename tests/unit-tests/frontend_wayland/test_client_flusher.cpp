@@ -0,0 +1,169 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/frontend_wayland/client_flusher.h"
+#include "src/server/frontend_wayland/wl_client.h"
+#include "mir/test/doubles/stub_shell.h"
+#include "mir/test/doubles/stub_session_authorizer.h"
+#include "mir/fd.h"
+
+#include <wayland-server-core.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/socket.h>
+
+#include <array>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+struct ClientFlusherTest : Test
+{
+    ClientFlusherTest()
+    {
+        mf::WlClient::setup_new_client_handler(
+            display.get(),
+            std::make_shared<mtd::StubShell>(),
+            std::make_shared<mtd::StubSessionAuthorizer>(),
+            [this](mf::WlClient& created)
+            {
+                client = &created;
+                flusher->add(created);
+            });
+
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create socketpair"};
+        }
+        client_end = mir::Fd{fds[1]};
+        raw_client = wl_client_create(display.get(), fds[0]);
+    }
+
+    /// Fill the client's socket with data the client does not read
+    void fall_behind()
+    {
+        std::array<char, 4096> const junk{};
+        for (auto written = 0u; written < 128 * 1024; written += junk.size())
+        {
+            if (send(wl_client_get_fd(raw_client), junk.data(), junk.size(), MSG_DONTWAIT) < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    /// Read everything sent to the client
+    void catch_up()
+    {
+        std::array<char, 4096> buffer;
+        while (recv(client_end, buffer.data(), buffer.size(), MSG_DONTWAIT) > 0)
+        {
+        }
+    }
+
+    std::unique_ptr<wl_display, void(*)(wl_display*)> const display{wl_display_create(), &wl_display_destroy};
+    std::unique_ptr<mf::ClientFlusher> flusher{std::make_unique<mf::ClientFlusher>(display.get())};
+    mir::Fd client_end;
+    wl_client* raw_client{nullptr};
+    mf::WlClient* client{nullptr};
+};
+}
+
+TEST_F(ClientFlusherTest, client_is_not_congested_initially)
+{
+    ASSERT_THAT(client, NotNull());
+    client->sample_outgoing_queue();
+
+    EXPECT_FALSE(client->is_congested());
+}
+
+TEST_F(ClientFlusherTest, work_for_an_uncongested_client_runs_immediately)
+{
+    bool ran{false};
+    client->when_uncongested([&ran]() { ran = true; });
+
+    EXPECT_TRUE(ran);
+}
+
+TEST_F(ClientFlusherTest, client_that_is_not_reading_is_congested)
+{
+    fall_behind();
+    client->sample_outgoing_queue();
+
+    EXPECT_TRUE(client->is_congested());
+    EXPECT_THAT(client->outgoing_queue_depth(), Gt(64u * 1024u));
+}
+
+TEST_F(ClientFlusherTest, work_for_a_congested_client_runs_in_order_once_it_catches_up)
+{
+    fall_behind();
+    client->sample_outgoing_queue();
+
+    std::vector<int> ran;
+    client->when_uncongested([&ran]() { ran.push_back(1); });
+    client->when_uncongested([&ran]() { ran.push_back(2); });
+    EXPECT_THAT(ran, IsEmpty());
+
+    catch_up();
+    client->sample_outgoing_queue();
+
+    EXPECT_FALSE(client->is_congested());
+    EXPECT_THAT(ran, ElementsAre(1, 2));
+}
+
+TEST_F(ClientFlusherTest, work_for_a_congested_client_is_dropped_if_the_client_is_destroyed)
+{
+    fall_behind();
+    client->sample_outgoing_queue();
+
+    auto const tracker = std::make_shared<int>();
+    client->when_uncongested([tracker]() {});
+
+    wl_client_destroy(raw_client);
+
+    EXPECT_THAT(tracker.use_count(), Eq(1));
+}
+
+TEST_F(ClientFlusherTest, idle_event_loop_notices_a_congested_client_catching_up)
+{
+    fall_behind();
+    flusher->dispatch_and_flush(0);
+    ASSERT_TRUE(client->is_congested());
+
+    bool ran{false};
+    client->when_uncongested([&ran]() { ran = true; });
+    catch_up();
+
+    // Nothing else wakes the event loop; the backlog has to be sampled on a timer
+    for (auto i = 0; i != 10 && !ran; ++i)
+    {
+        flusher->dispatch_and_flush(1000);
+    }
+
+    EXPECT_TRUE(ran);
+    EXPECT_FALSE(client->is_congested());
+}
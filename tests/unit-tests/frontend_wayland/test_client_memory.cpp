@@ -0,0 +1,309 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/client_memory.h"
+#include "src/server/frontend_wayland/wl_client.h"
+#include "mir/scene/scene_report.h"
+#include "mir/test/doubles/stub_shell.h"
+#include "mir/test/doubles/stub_session_authorizer.h"
+#include "mir/fd.h"
+
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/socket.h>
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace ms = mir::scene;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using Kind = mf::ClientMemory::Kind;
+
+namespace
+{
+struct MockSceneReport : ms::SceneReport
+{
+    MOCK_METHOD(void, surface_created, (BasicSurfaceId, std::string const&), (override));
+    MOCK_METHOD(void, surface_added, (BasicSurfaceId, std::string const&), (override));
+    MOCK_METHOD(void, surface_removed, (BasicSurfaceId, std::string const&), (override));
+    MOCK_METHOD(void, surface_deleted, (BasicSurfaceId, std::string const&), (override));
+    MOCK_METHOD(void, session_memory_changed, (ms::Session const&, SessionMemory const&), (override));
+    MOCK_METHOD(
+        void,
+        session_memory_limit_exceeded,
+        (ms::Session const&, SessionMemory const&, std::size_t),
+        (override));
+};
+
+struct ClientMemoryTest : Test
+{
+    ClientMemoryTest()
+    {
+        mf::WlClient::setup_new_client_handler(
+            display.get(),
+            std::make_shared<mtd::StubShell>(),
+            std::make_shared<mtd::StubSessionAuthorizer>(),
+            [](mf::WlClient&) {});
+
+        client = connect_client();
+    }
+
+    auto connect_client() -> wl_client*
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create socketpair"};
+        }
+        auto const connected = wl_client_create(display.get(), fds[0]);
+        client_ends[connected] = mir::Fd{fds[1]};
+        return connected;
+    }
+
+    auto memory_with(mf::ClientMemory::Limits const& limits) -> std::unique_ptr<mf::ClientMemory>
+    {
+        return std::make_unique<mf::ClientMemory>(limits, report);
+    }
+
+    /// The code of the wl_display.error event sent to client, if any
+    auto error_sent(wl_client* client) -> std::optional<uint32_t>
+    {
+        wl_client_flush(client);
+
+        // wl_display.error: sender id, size and opcode, then the object, the code and the message
+        std::array<uint32_t, 64> message{};
+        auto const received = recv(client_ends.at(client), message.data(), sizeof(message), MSG_DONTWAIT);
+        if (received < static_cast<ssize_t>(4 * sizeof(uint32_t)) || message[0] != 1 || (message[1] & 0xffff) != 0)
+        {
+            return std::nullopt;
+        }
+        return message[3];
+    }
+
+    std::unique_ptr<wl_display, void(*)(wl_display*)> const display{wl_display_create(), &wl_display_destroy};
+    std::unordered_map<wl_client*, mir::Fd> client_ends;
+    std::shared_ptr<NiceMock<MockSceneReport>> const report{std::make_shared<NiceMock<MockSceneReport>>()};
+    wl_client* client{nullptr};
+};
+}
+
+TEST_F(ClientMemoryTest, client_with_no_charges_uses_nothing)
+{
+    auto const memory = memory_with({});
+
+    EXPECT_THAT(memory->usage_of(client).total(), Eq(0u));
+}
+
+TEST_F(ClientMemoryTest, charges_are_counted_by_kind)
+{
+    auto const memory = memory_with({});
+
+    auto const shm = memory->charge(client, Kind::shm, 100);
+    auto const dmabuf = memory->charge(client, Kind::dmabuf, 20);
+    auto const texture = memory->charge(client, Kind::texture, 3);
+
+    auto const usage = memory->usage_of(client);
+    EXPECT_THAT(usage.shm, Eq(100u));
+    EXPECT_THAT(usage.dmabuf, Eq(20u));
+    EXPECT_THAT(usage.texture, Eq(3u));
+    EXPECT_THAT(usage.total(), Eq(123u));
+}
+
+TEST_F(ClientMemoryTest, resizing_a_charge_replaces_its_bytes)
+{
+    auto const memory = memory_with({});
+    auto const shm = memory->charge(client, Kind::shm, 100);
+
+    shm->resize(250);
+
+    EXPECT_THAT(memory->usage_of(client).shm, Eq(250u));
+}
+
+TEST_F(ClientMemoryTest, destroying_a_charge_releases_its_bytes)
+{
+    auto const memory = memory_with({});
+    auto const kept = memory->charge(client, Kind::shm, 100);
+    auto released = memory->charge(client, Kind::shm, 40);
+
+    released.reset();
+
+    EXPECT_THAT(memory->usage_of(client).shm, Eq(100u));
+}
+
+TEST_F(ClientMemoryTest, clients_are_charged_separately)
+{
+    auto const memory = memory_with({});
+    auto const other_client = connect_client();
+
+    auto const first = memory->charge(client, Kind::shm, 100);
+    auto const second = memory->charge(other_client, Kind::shm, 7);
+
+    EXPECT_THAT(memory->usage_of(client).shm, Eq(100u));
+    EXPECT_THAT(memory->usage_of(other_client).shm, Eq(7u));
+}
+
+TEST_F(ClientMemoryTest, changes_in_usage_are_reported)
+{
+    auto const memory = memory_with({});
+
+    EXPECT_CALL(*report, session_memory_changed(_, Field(&ms::SceneReport::SessionMemory::shm, 100u)));
+    auto const shm = memory->charge(client, Kind::shm, 100);
+}
+
+TEST_F(ClientMemoryTest, charges_that_change_nothing_are_not_reported)
+{
+    auto const memory = memory_with({});
+
+    EXPECT_CALL(*report, session_memory_changed(_, _)).Times(0);
+    auto const texture = memory->charge(client, Kind::texture, 0);
+    texture->resize(0);
+}
+
+TEST_F(ClientMemoryTest, usage_within_limits_is_not_reported_as_exceeding_them)
+{
+    auto const memory = memory_with({.soft = 100, .hard = 200});
+
+    EXPECT_CALL(*report, session_memory_limit_exceeded(_, _, _)).Times(0);
+    auto const shm = memory->charge(client, Kind::shm, 100);
+
+    EXPECT_THAT(error_sent(client), Eq(std::nullopt));
+}
+
+TEST_F(ClientMemoryTest, soft_limit_is_reported_once_each_time_it_is_crossed)
+{
+    auto const memory = memory_with({.soft = 100});
+
+    EXPECT_CALL(*report, session_memory_limit_exceeded(_, _, 100u)).Times(2);
+
+    auto const shm = memory->charge(client, Kind::shm, 101);
+    shm->resize(150);
+    auto const texture = memory->charge(client, Kind::texture, 10);
+
+    shm->resize(10);
+    shm->resize(150);
+
+    // Only the hard limit disconnects the client
+    EXPECT_THAT(error_sent(client), Eq(std::nullopt));
+}
+
+TEST_F(ClientMemoryTest, growing_over_soft_limit_reclaims_from_that_clients_charges)
+{
+    auto const memory = memory_with({.soft = 100});
+    auto const other_client = connect_client();
+    NiceMock<MockFunction<void()>> reclaim_texture, reclaim_other_client;
+
+    auto const texture = memory->charge(client, Kind::texture, 50);
+    texture->reclaim_with(reclaim_texture.AsStdFunction());
+    auto const other = memory->charge(other_client, Kind::texture, 50);
+    other->reclaim_with(reclaim_other_client.AsStdFunction());
+
+    EXPECT_CALL(reclaim_texture, Call()).Times(2);
+    EXPECT_CALL(reclaim_other_client, Call()).Times(0);
+
+    auto const shm = memory->charge(client, Kind::shm, 60);
+    shm->resize(70);
+}
+
+TEST_F(ClientMemoryTest, shrinking_usage_does_not_reclaim)
+{
+    auto const memory = memory_with({.soft = 100});
+    NiceMock<MockFunction<void()>> reclaim_texture;
+
+    auto const shm = memory->charge(client, Kind::shm, 200);
+    auto const texture = memory->charge(client, Kind::texture, 0);
+    texture->reclaim_with(reclaim_texture.AsStdFunction());
+
+    EXPECT_CALL(reclaim_texture, Call()).Times(0);
+    shm->resize(150);
+    shm->resize(50);
+}
+
+TEST_F(ClientMemoryTest, crossing_hard_limit_posts_no_memory)
+{
+    auto const memory = memory_with({.soft = 50, .hard = 100});
+
+    EXPECT_CALL(*report, session_memory_limit_exceeded(_, _, 50u));
+    EXPECT_CALL(*report, session_memory_limit_exceeded(_, _, 100u));
+
+    auto const shm = memory->charge(client, Kind::shm, 60);
+    auto const dmabuf = memory->charge(client, Kind::dmabuf, 60);
+    dmabuf->resize(80);
+
+    EXPECT_THAT(error_sent(client), Eq(WL_DISPLAY_ERROR_NO_MEMORY));
+}
+
+TEST_F(ClientMemoryTest, buffer_is_charged_once_until_it_is_destroyed)
+{
+    auto const memory = memory_with({});
+    auto const buffer = wl_resource_create(client, &wl_buffer_interface, 1, 0);
+
+    memory->charge_for_buffer(buffer, Kind::dmabuf, 4096);
+    memory->charge_for_buffer(buffer, Kind::dmabuf, 4096);
+
+    EXPECT_THAT(memory->usage_of(client).dmabuf, Eq(4096u));
+
+    wl_resource_destroy(buffer);
+
+    EXPECT_THAT(memory->usage_of(client).dmabuf, Eq(0u));
+}
+
+TEST_F(ClientMemoryTest, client_reusing_a_destroyed_clients_wl_client_starts_with_nothing)
+{
+    auto const memory = memory_with({.soft = 150});
+    auto const old_client = connect_client();
+
+    // Outlives its client, as a buffer's charge might while the compositor holds the buffer
+    auto const old_charge = memory->charge(old_client, Kind::shm, 100);
+    wl_client_destroy(old_client);
+
+    // libwayland allocates a wl_client the same size each time, so its address is soon reused
+    std::vector<wl_client*> others;
+    wl_client* new_client{nullptr};
+    for (auto i = 0; i != 16 && !new_client; ++i)
+    {
+        if (auto const connected = connect_client(); connected == old_client)
+        {
+            new_client = connected;
+        }
+        else
+        {
+            others.push_back(connected);
+        }
+    }
+    if (!new_client)
+    {
+        GTEST_SKIP() << "wl_client address was not reused";
+    }
+
+    EXPECT_THAT(memory->usage_of(new_client).total(), Eq(0u));
+
+    // Nor does the new client inherit the old one's usage towards its limits
+    EXPECT_CALL(*report, session_memory_limit_exceeded(_, _, _)).Times(0);
+    auto const new_charge = memory->charge(new_client, Kind::shm, 100);
+
+    EXPECT_THAT(memory->usage_of(new_client).shm, Eq(100u));
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/held_commit_queue.h"
+#include "mir/fd.h"
+
+#include <wayland-server-core.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace mf = mir::frontend;
+
+using namespace testing;
+
+namespace
+{
+/// Stands in for an acquire point; becomes readable once signalled
+struct Fence
+{
+    Fence()
+        : fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
+    {
+        if (fd < 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create eventfd"};
+        }
+    }
+
+    void signal() const
+    {
+        uint64_t const one{1};
+        if (write(fd, &one, sizeof(one)) != sizeof(one))
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to signal eventfd"};
+        }
+    }
+
+    mir::Fd const fd;
+};
+
+struct HeldCommitQueueTest : Test
+{
+    /// Push a commit that records its id when applied or discarded
+    void push(int id, std::optional<mir::Fd> ready = std::nullopt)
+    {
+        queue->push(
+            std::move(ready),
+            [this, id]() { applied.push_back(id); },
+            [this, id]() { discarded.push_back(id); });
+    }
+
+    void dispatch()
+    {
+        wl_event_loop_dispatch(loop.get(), 0);
+    }
+
+    std::unique_ptr<wl_event_loop, void(*)(wl_event_loop*)> const loop{wl_event_loop_create(), &wl_event_loop_destroy};
+    std::unique_ptr<mf::HeldCommitQueue> queue{std::make_unique<mf::HeldCommitQueue>(loop.get(), nullptr)};
+    std::vector<int> applied;
+    std::vector<int> discarded;
+};
+}
+
+TEST_F(HeldCommitQueueTest, commit_with_nothing_to_wait_for_is_applied_immediately)
+{
+    push(1);
+
+    EXPECT_THAT(applied, ElementsAre(1));
+    EXPECT_TRUE(queue->empty());
+}
+
+TEST_F(HeldCommitQueueTest, commit_is_held_until_it_is_ready)
+{
+    Fence const fence;
+    push(1, fence.fd);
+
+    dispatch();
+    EXPECT_THAT(applied, IsEmpty());
+    EXPECT_FALSE(queue->empty());
+
+    fence.signal();
+    dispatch();
+    EXPECT_THAT(applied, ElementsAre(1));
+    EXPECT_TRUE(queue->empty());
+}
+
+TEST_F(HeldCommitQueueTest, later_commits_wait_behind_a_held_commit)
+{
+    Fence const fence;
+    push(1, fence.fd);
+    push(2);
+    push(3);
+
+    EXPECT_THAT(applied, IsEmpty());
+
+    fence.signal();
+    dispatch();
+    EXPECT_THAT(applied, ElementsAre(1, 2, 3));
+}
+
+TEST_F(HeldCommitQueueTest, commits_are_applied_in_order_even_if_ready_out_of_order)
+{
+    Fence const first, second;
+    push(1, first.fd);
+    push(2, second.fd);
+    push(3);
+
+    second.signal();
+    dispatch();
+    EXPECT_THAT(applied, IsEmpty());
+
+    first.signal();
+    dispatch();
+    EXPECT_THAT(applied, ElementsAre(1));
+
+    dispatch();
+    EXPECT_THAT(applied, ElementsAre(1, 2, 3));
+}
+
+TEST_F(HeldCommitQueueTest, commits_not_applied_when_destroyed_are_discarded)
+{
+    Fence const fence;
+    push(1);
+    push(2, fence.fd);
+    push(3);
+
+    queue.reset();
+
+    EXPECT_THAT(applied, ElementsAre(1));
+    EXPECT_THAT(discarded, ElementsAre(2, 3));
+}
+
+TEST_F(HeldCommitQueueTest, applied_commits_are_not_discarded)
+{
+    Fence const fence;
+    push(1, fence.fd);
+    fence.signal();
+    dispatch();
+
+    queue.reset();
+
+    EXPECT_THAT(discarded, IsEmpty());
+}
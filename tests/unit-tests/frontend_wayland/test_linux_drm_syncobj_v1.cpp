@@ -0,0 +1,151 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/linux_drm_syncobj_v1.h"
+#include "src/server/frontend_wayland/wl_surface.h"
+#include "src/server/frontend_wayland/resource_lifetime_tracker.h"
+#include "mir/wayland/protocol_error.h"
+#include "mir/graphics/drm_syncobj.h"
+#include "mir/fd.h"
+
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <system_error>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+using namespace testing;
+using Error = mw::LinuxDrmSyncobjSurfaceV1::Error;
+
+namespace
+{
+/// Commits are only checked for which timelines their points are on, so these needn't be real syncobjs
+auto fake_timeline() -> std::shared_ptr<mg::drm::Syncobj const>
+{
+    auto const storage = std::make_shared<std::byte>();
+    return {storage, reinterpret_cast<mg::drm::Syncobj const*>(storage.get())};
+}
+
+struct LinuxDrmSyncobjV1Test : Test
+{
+    LinuxDrmSyncobjV1Test()
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create socketpair"};
+        }
+        client_end = mir::Fd{fds[1]};
+        client = wl_client_create(display.get(), fds[0]);
+        buffer = wl_resource_create(client, &wl_buffer_interface, 1, 0);
+    }
+
+    /// A commit with a buffer attached
+    auto commit_with_buffer() -> mf::WlSurfaceState
+    {
+        mf::WlSurfaceState state;
+        state.buffer = mw::Weak<mf::ResourceLifetimeTracker>{mf::ResourceLifetimeTracker::from(buffer)};
+        return state;
+    }
+
+    /// The error check_explicit_sync_commit() raises for state, if any
+    auto error_for(mf::WlSurfaceState const& state) -> std::optional<uint32_t>
+    {
+        try
+        {
+            mf::check_explicit_sync_commit(nullptr, state);
+        }
+        catch (mw::ProtocolError const& error)
+        {
+            return error.code();
+        }
+        return std::nullopt;
+    }
+
+    std::unique_ptr<wl_display, void(*)(wl_display*)> const display{wl_display_create(), &wl_display_destroy};
+    mir::Fd client_end;
+    wl_client* client{nullptr};
+    wl_resource* buffer{nullptr};
+    std::shared_ptr<mg::drm::Syncobj const> const timeline{fake_timeline()};
+};
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, commit_without_buffer_or_points_is_accepted)
+{
+    EXPECT_THAT(error_for(mf::WlSurfaceState{}), Eq(std::nullopt));
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, commit_with_buffer_and_ordered_points_is_accepted)
+{
+    auto state = commit_with_buffer();
+    state.acquire_point = mf::SyncPoint{timeline, 1};
+    state.release_point = mf::SyncPoint{timeline, 2};
+
+    EXPECT_THAT(error_for(state), Eq(std::nullopt));
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, points_on_different_timelines_are_not_compared)
+{
+    auto state = commit_with_buffer();
+    state.acquire_point = mf::SyncPoint{timeline, 2};
+    state.release_point = mf::SyncPoint{fake_timeline(), 1};
+
+    EXPECT_THAT(error_for(state), Eq(std::nullopt));
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, point_without_buffer_is_no_buffer_error)
+{
+    mf::WlSurfaceState state;
+    state.acquire_point = mf::SyncPoint{timeline, 1};
+
+    EXPECT_THAT(error_for(state), Eq(Error::no_buffer));
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, buffer_without_acquire_point_is_no_acquire_point_error)
+{
+    auto state = commit_with_buffer();
+    state.release_point = mf::SyncPoint{timeline, 1};
+
+    EXPECT_THAT(error_for(state), Eq(Error::no_acquire_point));
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, buffer_without_release_point_is_no_release_point_error)
+{
+    auto state = commit_with_buffer();
+    state.acquire_point = mf::SyncPoint{timeline, 1};
+
+    EXPECT_THAT(error_for(state), Eq(Error::no_release_point));
+}
+
+TEST_F(LinuxDrmSyncobjV1Test, release_point_not_after_acquire_point_is_conflicting_points_error)
+{
+    auto state = commit_with_buffer();
+    state.acquire_point = mf::SyncPoint{timeline, 2};
+    state.release_point = mf::SyncPoint{timeline, 2};
+
+    EXPECT_THAT(error_for(state), Eq(Error::conflicting_points));
+}
@@ -73,3 +73,43 @@ TEST_F(EGLExtensions, success_has_sane_function_hooks)
     EXPECT_NE(nullptr, extensions.base(dpy).eglDestroyImageKHR);
     EXPECT_NE(nullptr, extensions.base(dpy).glEGLImageTargetTexture2DOES);
 }
+
+namespace
+{
+EGLint stub_dup_native_fence_fd(EGLDisplay, EGLSyncKHR)
+{
+    return EGL_NO_NATIVE_FENCE_FD_ANDROID;
+}
+}
+
+TEST_F(EGLExtensions, native_fence_sync_is_not_supported_without_the_extension)
+{
+    EGLDisplay dpy = eglGetDisplay(nullptr);
+
+    EXPECT_FALSE(mg::EGLExtensions::ANDROIDNativeFenceSync::extension_if_supported(dpy));
+}
+
+TEST_F(EGLExtensions, native_fence_sync_is_not_supported_without_fence_export)
+{
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_fence_sync EGL_ANDROID_native_fence_sync"));
+    EGLDisplay dpy = eglGetDisplay(nullptr);
+
+    EXPECT_FALSE(mg::EGLExtensions::ANDROIDNativeFenceSync::extension_if_supported(dpy));
+}
+
+TEST_F(EGLExtensions, native_fence_sync_has_sane_function_hooks)
+{
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_fence_sync EGL_ANDROID_native_fence_sync"));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("eglDupNativeFenceFDANDROID")))
+        .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&stub_dup_native_fence_fd)));
+    EGLDisplay dpy = eglGetDisplay(nullptr);
+
+    auto const ext = mg::EGLExtensions::ANDROIDNativeFenceSync::extension_if_supported(dpy);
+
+    ASSERT_TRUE(ext);
+    EXPECT_NE(nullptr, ext->eglCreateSyncKHR);
+    EXPECT_NE(nullptr, ext->eglDestroySyncKHR);
+    EXPECT_NE(nullptr, ext->eglDupNativeFenceFDANDROID);
+}
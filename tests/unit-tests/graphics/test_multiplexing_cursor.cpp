@@ -0,0 +1,120 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/graphics/multiplexing_hw_cursor.h"
+
+#include "mir/graphics/cursor_image.h"
+#include "mir/test/doubles/mock_display.h"
+#include "mir/test/doubles/stub_display_configuration.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct MockCursor : mg::Cursor
+{
+    MOCK_METHOD(void, show, (mg::CursorImage const&), (override));
+    MOCK_METHOD(void, hide, (), (override));
+    MOCK_METHOD(void, move_to, (geom::Point), (override));
+};
+
+struct StubCursorImage : mg::CursorImage
+{
+    void const* as_argb_8888() const override { return pixels.data(); }
+    geom::Size size() const override { return {4, 4}; }
+    geom::Displacement hotspot() const override { return {0, 0}; }
+
+    std::array<unsigned char, 4 * 4 * 4> pixels{};
+};
+
+struct MultiplexingCursor : Test
+{
+    MultiplexingCursor()
+    {
+        ON_CALL(hardware_display, create_hardware_cursor()).WillByDefault(Return(hardware_cursor));
+        ON_CALL(hardware_display, configuration()).WillByDefault(
+            Invoke([]
+                {
+                    return std::make_unique<mtd::StubDisplayConfig>(
+                        std::vector<geom::Rectangle>{{{0, 0}, {100, 100}}});
+                }));
+        ON_CALL(software_display, create_hardware_cursor()).WillByDefault(Return(nullptr));
+    }
+
+    std::shared_ptr<NiceMock<MockCursor>> const hardware_cursor = std::make_shared<NiceMock<MockCursor>>();
+    std::shared_ptr<NiceMock<MockCursor>> const fallback = std::make_shared<NiceMock<MockCursor>>();
+    NiceMock<mtd::MockDisplay> hardware_display;
+    NiceMock<mtd::MockDisplay> software_display;
+    StubCursorImage const image;
+};
+}
+
+TEST_F(MultiplexingCursor, throws_when_no_display_has_a_hardware_cursor)
+{
+    std::array<mg::Display*, 1> displays{&software_display};
+
+    EXPECT_THROW(mg::MultiplexingCursor{displays}, std::runtime_error);
+}
+
+TEST_F(MultiplexingCursor, needs_fallback_only_when_some_display_lacks_hardware_cursor)
+{
+    std::array<mg::Display*, 1> hardware_only{&hardware_display};
+    std::array<mg::Display*, 2> mixed{&hardware_display, &software_display};
+
+    EXPECT_FALSE(mg::MultiplexingCursor{hardware_only}.needs_fallback());
+    EXPECT_TRUE(mg::MultiplexingCursor{mixed}.needs_fallback());
+}
+
+TEST_F(MultiplexingCursor, fallback_is_hidden_over_outputs_with_hardware_cursor)
+{
+    std::array<mg::Display*, 2> displays{&hardware_display, &software_display};
+    mg::MultiplexingCursor cursor{displays};
+    cursor.set_fallback(fallback);
+
+    EXPECT_CALL(*hardware_cursor, move_to(geom::Point{10, 10}));
+    EXPECT_CALL(*fallback, show(_)).Times(0);
+
+    cursor.show(image);
+    cursor.move_to({10, 10});
+}
+
+TEST_F(MultiplexingCursor, fallback_is_shown_over_outputs_without_hardware_cursor)
+{
+    std::array<mg::Display*, 2> displays{&hardware_display, &software_display};
+    mg::MultiplexingCursor cursor{displays};
+    cursor.set_fallback(fallback);
+    cursor.show(image);
+    cursor.move_to({10, 10});
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*fallback, show(_));
+        EXPECT_CALL(*fallback, move_to(geom::Point{200, 10}));
+        EXPECT_CALL(*fallback, hide());
+    }
+
+    cursor.move_to({200, 10});
+    cursor.move_to({50, 50});
+}
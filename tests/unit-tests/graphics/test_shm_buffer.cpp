@@ -70,16 +70,18 @@ private:
     EGLContext const ctx;
 };
 
-struct PlatformlessShmBuffer : mgc::MemoryBackedShmBuffer
+/// A client's buffer, whose texture the budget may evict: its pixels live in memory the GPU doesn't write
+struct PlatformlessShmBuffer : mgc::MappableBackedShmBuffer
 {
     PlatformlessShmBuffer(
         geom::Size const& size,
         MirPixelFormat const& pixel_format,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
-        : MemoryBackedShmBuffer(
-            size,
-            pixel_format,
-            std::move(egl_delegate))
+        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        std::shared_ptr<mgc::TextureBudget> texture_budget)
+        : MappableBackedShmBuffer(
+            std::make_shared<mgc::MemoryBackedShmBuffer>(size, pixel_format, egl_delegate),
+            egl_delegate,
+            std::move(texture_budget))
     {
     }
 
@@ -103,7 +105,8 @@ struct ShmBufferTest : public testing::Test
             size,
             pixel_format,
             std::make_shared<mgc::EGLContextExecutor>(
-                std::make_unique<DumbGLContext>(dummy))}
+                std::make_unique<DumbGLContext>(dummy)),
+            texture_budget}
     {
     }
 
@@ -114,6 +117,8 @@ struct ShmBufferTest : public testing::Test
     MirPixelFormat const pixel_format;
     EGLContext const dummy{reinterpret_cast<void*>(0x0011223344)};
     std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<mgc::TextureBudget> const texture_budget{
+        std::make_shared<mgc::TextureBudget>(0)};
 
     PlatformlessShmBuffer shm_buffer;
 };
@@ -132,7 +137,7 @@ TEST_F(ShmBufferTest, has_correct_properties)
 
 TEST_F(ShmBufferTest, cant_upload_bgr_888)
 {
-    PlatformlessShmBuffer buf(size, mir_pixel_format_bgr_888, egl_delegate);
+    PlatformlessShmBuffer buf(size, mir_pixel_format_bgr_888, egl_delegate, texture_budget);
     EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _,
                                       size.width.as_int(), size.height.as_int(),
                                       0, _, _,
@@ -163,7 +168,7 @@ TEST_P(UploadTest, uploads_correctly)
     auto const desc = GetParam();
 
     PlatformlessShmBuffer buf(
-        desc.size, desc.format, egl_delegate);
+        desc.size, desc.format, egl_delegate, texture_budget);
 
     ExpectationSet gl_setup;
     gl_setup +=
@@ -343,7 +348,7 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         // Ensure we have a “context” current for creation and bind
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, dummy_ctx);
 
-        PlatformlessShmBuffer buffer{size, pixel_format, egl_delegate};
+        PlatformlessShmBuffer buffer{size, pixel_format, egl_delegate, texture_budget};
 
         buffer.bind();
 
@@ -351,3 +356,156 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+TEST_F(ShmBufferTest, bound_texture_is_accounted_in_budget_until_destroyed)
+{
+    {
+        PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, egl_delegate, texture_budget};
+
+        buffer.bind();
+
+        EXPECT_THAT(texture_budget->resident_bytes(), Eq(size.width.as_uint32_t() * size.height.as_uint32_t() * 4));
+    }
+
+    EXPECT_THAT(texture_budget->resident_bytes(), Eq(0u));
+}
+
+TEST_F(ShmBufferTest, evicted_texture_is_uploaded_again_when_next_bound)
+{
+    GLuint const first_id{0x8086}, second_id{0x8087};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(first_id))
+        .WillOnce(SetArgPointee<1>(second_id));
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, _, _, 0, _, _, _))
+        .Times(2);
+
+    {
+        auto const local_delegate = std::make_shared<mgc::EGLContextExecutor>(
+            std::make_unique<DumbGLContext>(reinterpret_cast<EGLContext>(42)));
+        PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, local_delegate, texture_budget};
+
+        buffer.bind();
+
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(first_id))));
+        buffer.evict();
+        wait_for_egl_thread(*local_delegate);
+
+        EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, second_id));
+        buffer.bind();
+
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(second_id))));
+    }
+}
+
+TEST_F(ShmBufferTest, texture_size_is_reported_when_uploaded_and_when_evicted)
+{
+    ON_CALL(mock_gl, glGenTextures(1,_))
+        .WillByDefault(SetArgPointee<1>(0x8086));
+    std::vector<size_t> reported;
+
+    PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, egl_delegate, texture_budget};
+    buffer.on_texture_resized([&reported](size_t bytes) { reported.push_back(bytes); });
+
+    buffer.bind();
+    buffer.bind();
+    buffer.evict();
+    buffer.bind();
+
+    size_t const texture_bytes{size.width.as_uint32_t() * size.height.as_uint32_t() * 4};
+    EXPECT_THAT(reported, ElementsAre(texture_bytes, 0u, texture_bytes));
+}
+
+TEST_F(ShmBufferTest, budget_evicts_textures_of_buffers_that_are_not_visible)
+{
+    geom::Size const small{16, 16};
+    auto const budget = std::make_shared<mgc::TextureBudget>(16 * 16 * 4);
+
+    GLuint const first_id{0x8086}, second_id{0x8087};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(first_id))
+        .WillOnce(SetArgPointee<1>(second_id));
+
+    {
+        auto const local_delegate = std::make_shared<mgc::EGLContextExecutor>(
+            std::make_unique<DumbGLContext>(reinterpret_cast<EGLContext>(42)));
+        PlatformlessShmBuffer first{small, mir_pixel_format_argb_8888, local_delegate, budget};
+        PlatformlessShmBuffer second{small, mir_pixel_format_argb_8888, local_delegate, budget};
+
+        first.bind();
+        first.set_visible(false);
+
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(first_id))));
+        second.bind();
+        wait_for_egl_thread(*local_delegate);
+
+        EXPECT_THAT(budget->resident_bytes(), Eq(16u * 16u * 4u));
+
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(second_id))));
+    }
+}
+
+TEST_F(ShmBufferTest, budget_keeps_textures_of_visible_buffers_even_when_exceeded)
+{
+    geom::Size const small{16, 16};
+    auto const budget = std::make_shared<mgc::TextureBudget>(16 * 16 * 4);
+
+    ON_CALL(mock_gl, glGenTextures(1,_))
+        .WillByDefault(SetArgPointee<1>(0x8086));
+
+    PlatformlessShmBuffer first{small, mir_pixel_format_argb_8888, egl_delegate, budget};
+    PlatformlessShmBuffer second{small, mir_pixel_format_argb_8888, egl_delegate, budget};
+
+    first.bind();
+    second.bind();
+
+    EXPECT_THAT(budget->resident_bytes(), Eq(2u * 16u * 16u * 4u));
+}
+
+TEST_F(ShmBufferTest, exceeded_budget_is_enforced_when_a_buffer_stops_being_visible)
+{
+    geom::Size const small{16, 16};
+    auto const budget = std::make_shared<mgc::TextureBudget>(16 * 16 * 4);
+
+    GLuint const first_id{0x8086}, second_id{0x8087};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(first_id))
+        .WillOnce(SetArgPointee<1>(second_id));
+
+    {
+        auto const local_delegate = std::make_shared<mgc::EGLContextExecutor>(
+            std::make_unique<DumbGLContext>(reinterpret_cast<EGLContext>(42)));
+        PlatformlessShmBuffer first{small, mir_pixel_format_argb_8888, local_delegate, budget};
+        PlatformlessShmBuffer second{small, mir_pixel_format_argb_8888, local_delegate, budget};
+
+        first.bind();
+        second.bind();
+
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(first_id))));
+        first.set_visible(false);
+        wait_for_egl_thread(*local_delegate);
+
+        EXPECT_THAT(budget->resident_bytes(), Eq(16u * 16u * 4u));
+
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(second_id))));
+    }
+}
+
+TEST_F(ShmBufferTest, released_texture_of_a_hidden_buffer_is_reported_and_no_longer_accounted)
+{
+    ON_CALL(mock_gl, glGenTextures(1,_))
+        .WillByDefault(SetArgPointee<1>(0x8086));
+    std::vector<size_t> reported;
+
+    PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, egl_delegate, texture_budget};
+    buffer.on_texture_resized([&reported](size_t bytes) { reported.push_back(bytes); });
+
+    buffer.bind();
+    buffer.release_texture();
+    ASSERT_THAT(reported, ElementsAre(Ne(0u)));
+
+    buffer.set_visible(false);
+    buffer.release_texture();
+
+    EXPECT_THAT(reported, ElementsAre(Ne(0u), Eq(0u)));
+    EXPECT_THAT(texture_budget->resident_bytes(), Eq(0u));
+}
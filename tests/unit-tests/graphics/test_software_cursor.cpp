@@ -46,6 +46,7 @@ struct MockInputScene : mtd::StubInputScene
                  void(std::weak_ptr<mg::Renderable> const&));
 
     MOCK_METHOD0(emit_scene_changed, void());
+    MOCK_METHOD1(emit_scene_damaged, void(geom::Rectangle const&));
 
     MOCK_CONST_METHOD0(screen_is_locked, bool());
 };
@@ -288,15 +289,21 @@ TEST_F(SoftwareCursor, moves_scene_renderable_offset_by_hotspot_when_moved)
                 Eq(new_position - stub_cursor_image.hotspot()));
 }
 
-TEST_F(SoftwareCursor, notifies_scene_when_moving)
+TEST_F(SoftwareCursor, notifies_scene_of_old_and_new_area_when_moving)
 {
     using namespace testing;
 
-    EXPECT_CALL(mock_input_scene, emit_scene_changed());
+    geom::Point const new_position{22,23};
+    auto const size = stub_cursor_image.size();
+    auto const hotspot = stub_cursor_image.hotspot();
+
+    EXPECT_CALL(mock_input_scene, emit_scene_changed()).Times(0);
+    EXPECT_CALL(mock_input_scene, emit_scene_damaged(Eq(geom::Rectangle{geom::Point{0,0} - hotspot, size})));
+    EXPECT_CALL(mock_input_scene, emit_scene_damaged(Eq(geom::Rectangle{new_position - hotspot, size})));
 
     cursor.show(stub_cursor_image);
     executor.execute();
-    cursor.move_to({22,23});
+    cursor.move_to(new_position);
 }
 
 TEST_F(SoftwareCursor, creates_renderable_with_filled_buffer)
@@ -328,6 +335,7 @@ TEST_F(SoftwareCursor, does_not_hide_or_move_when_already_hidden)
 
     EXPECT_CALL(mock_input_scene, remove_input_visualization(_)).Times(0);
     EXPECT_CALL(mock_input_scene, emit_scene_changed()).Times(0);
+    EXPECT_CALL(mock_input_scene, emit_scene_damaged(_)).Times(0);
 
     // Already hidden, nothing should happen
     cursor.hide();
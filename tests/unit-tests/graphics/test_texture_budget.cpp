@@ -0,0 +1,217 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/platforms/common/server/texture_budget.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mgc = mir::graphics::common;
+using namespace testing;
+
+namespace
+{
+struct StubTexture : mgc::TextureBudget::Texture
+{
+    void evict() override
+    {
+        ++evictions;
+    }
+
+    auto visible() const -> bool override
+    {
+        return shown;
+    }
+
+    int evictions{0};
+    bool shown{false};
+};
+
+struct TextureBudget : Test
+{
+    std::size_t const texture_bytes{1024};
+    StubTexture first, second, third;
+};
+}
+
+TEST_F(TextureBudget, without_a_limit_never_evicts)
+{
+    mgc::TextureBudget budget{0};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    budget.drawn(third, texture_bytes);
+
+    EXPECT_THAT(first.evictions + second.evictions + third.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(3 * texture_bytes));
+    EXPECT_THAT(budget.current_limit(), Eq(std::nullopt));
+}
+
+TEST_F(TextureBudget, evicts_least_recently_drawn_texture_when_over_limit)
+{
+    mgc::TextureBudget budget{2 * texture_bytes};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    budget.drawn(first, texture_bytes);
+    budget.drawn(third, texture_bytes);
+
+    EXPECT_THAT(first.evictions, Eq(0));
+    EXPECT_THAT(second.evictions, Eq(1));
+    EXPECT_THAT(third.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(2 * texture_bytes));
+}
+
+TEST_F(TextureBudget, evicted_texture_is_accounted_again_when_redrawn)
+{
+    mgc::TextureBudget budget{texture_bytes};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    ASSERT_THAT(first.evictions, Eq(1));
+
+    budget.drawn(first, texture_bytes);
+
+    EXPECT_THAT(second.evictions, Eq(1));
+    EXPECT_THAT(budget.resident_bytes(), Eq(texture_bytes));
+}
+
+TEST_F(TextureBudget, does_not_evict_texture_being_drawn)
+{
+    mgc::TextureBudget budget{texture_bytes};
+
+    budget.drawn(first, 2 * texture_bytes);
+
+    EXPECT_THAT(first.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(2 * texture_bytes));
+}
+
+TEST_F(TextureBudget, does_not_evict_visible_textures)
+{
+    mgc::TextureBudget budget{texture_bytes};
+    first.shown = true;
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+
+    EXPECT_THAT(first.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(2 * texture_bytes));
+}
+
+TEST_F(TextureBudget, skips_visible_textures_to_evict_hidden_ones)
+{
+    mgc::TextureBudget budget{2 * texture_bytes};
+    first.shown = true;
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    budget.drawn(third, texture_bytes);
+
+    EXPECT_THAT(first.evictions, Eq(0));
+    EXPECT_THAT(second.evictions, Eq(1));
+    EXPECT_THAT(budget.resident_bytes(), Eq(2 * texture_bytes));
+}
+
+TEST_F(TextureBudget, trim_evicts_textures_that_stopped_being_visible)
+{
+    mgc::TextureBudget budget{texture_bytes};
+    first.shown = true;
+    second.shown = true;
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    ASSERT_THAT(budget.resident_bytes(), Eq(2 * texture_bytes));
+
+    first.shown = false;
+    budget.trim();
+
+    EXPECT_THAT(first.evictions, Eq(1));
+    EXPECT_THAT(second.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(texture_bytes));
+}
+
+TEST_F(TextureBudget, evicting_a_texture_releases_it_even_within_budget)
+{
+    mgc::TextureBudget budget{0};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    budget.evict(first);
+
+    EXPECT_THAT(first.evictions, Eq(1));
+    EXPECT_THAT(second.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(texture_bytes));
+}
+
+TEST_F(TextureBudget, evicting_a_visible_or_absent_texture_does_nothing)
+{
+    mgc::TextureBudget budget{0};
+    first.shown = true;
+
+    budget.drawn(first, texture_bytes);
+    budget.evict(first);
+    budget.evict(second);
+
+    EXPECT_THAT(first.evictions + second.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(texture_bytes));
+}
+
+TEST_F(TextureBudget, forgotten_texture_is_no_longer_accounted_or_evicted)
+{
+    mgc::TextureBudget budget{2 * texture_bytes};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    budget.forget(first);
+    budget.drawn(third, texture_bytes);
+
+    EXPECT_THAT(first.evictions, Eq(0));
+    EXPECT_THAT(second.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(2 * texture_bytes));
+}
+
+TEST_F(TextureBudget, memory_pressure_halves_budget_and_evicts)
+{
+    mgc::TextureBudget budget{0};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+    budget.drawn(third, texture_bytes);
+    budget.drawn(first, texture_bytes);
+
+    budget.apply_pressure();
+
+    EXPECT_THAT(budget.current_limit(), Eq(3 * texture_bytes / 2));
+    EXPECT_THAT(second.evictions, Eq(1));
+    EXPECT_THAT(third.evictions, Eq(1));
+    EXPECT_THAT(first.evictions, Eq(0));
+    EXPECT_THAT(budget.resident_bytes(), Eq(texture_bytes));
+}
+
+TEST_F(TextureBudget, relieving_pressure_restores_configured_budget)
+{
+    mgc::TextureBudget budget{4 * texture_bytes};
+
+    budget.drawn(first, texture_bytes);
+    budget.drawn(second, texture_bytes);
+
+    budget.apply_pressure();
+    EXPECT_THAT(budget.current_limit(), Eq(texture_bytes));
+
+    budget.relieve_pressure();
+    EXPECT_THAT(budget.current_limit(), Eq(4 * texture_bytes));
+}
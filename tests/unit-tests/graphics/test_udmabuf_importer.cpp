@@ -0,0 +1,279 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/udmabuf_importer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+#include "mir/graphics/egl_error.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mrs = mir::renderer::software;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+size_t const page_size = sysconf(_SC_PAGESIZE);
+
+struct StubPixels : mrs::RWMappableBuffer
+{
+    auto format() const -> MirPixelFormat override
+    {
+        return pixel_format;
+    }
+
+    auto stride() const -> geom::Stride override
+    {
+        return geom::Stride{size_.width.as_int() * 4};
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+    auto map_readable() -> std::unique_ptr<mrs::Mapping<unsigned char const>> override
+    {
+        return nullptr;
+    }
+
+    auto map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        return nullptr;
+    }
+
+    auto map_rw() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        return nullptr;
+    }
+
+    MirPixelFormat pixel_format{mir_pixel_format_argb_8888};
+    geom::Size size_{64, 32};
+};
+
+struct StubMemfdPixels : StubPixels, mrs::MemfdBackedBuffer
+{
+    explicit StubMemfdPixels(size_t offset)
+        : offset{offset}
+    {
+    }
+
+    auto memfd_range() const -> std::optional<Range> override
+    {
+        if (!sealed)
+        {
+            return std::nullopt;
+        }
+        return Range{memfd, offset, size_t(stride().as_int() * size().height.as_int()), owner};
+    }
+
+    size_t const offset;
+    bool sealed{true};
+    mir::Fd const memfd{memfd_create("udmabuf importer test", MFD_CLOEXEC)};
+    std::shared_ptr<void const> owner{std::make_shared<int>()};
+};
+
+struct UDMABufImporter : Test
+{
+    UDMABufImporter()
+    {
+        ON_CALL(create_dmabuf, Call(_, _, _))
+            .WillByDefault([](auto&&...)
+                {
+                    int fds[2];
+                    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0)
+                    {
+                        throw std::system_error{errno, std::system_category(), "Failed to create pipe"};
+                    }
+                    close(fds[0]);
+                    return std::optional<mir::Fd>{mir::Fd{fds[1]}};
+                });
+        ON_CALL(import_dmabuf, Call(_, _, _))
+            .WillByDefault([](auto&&...) { return std::make_shared<mtd::StubBuffer>(); });
+    }
+
+    auto import(mrs::RWMappableBuffer const& pixels) -> std::shared_ptr<mg::Buffer>
+    {
+        return importer.import(pixels, []{}, []{});
+    }
+
+    static auto egl_failure(EGLint error) -> std::system_error
+    {
+        return std::system_error{error, mg::egl_category(), "Failed to import dmabuf"};
+    }
+
+    NiceMock<MockFunction<std::optional<mir::Fd>(mir::Fd const&, size_t, size_t)>> create_dmabuf;
+    NiceMock<MockFunction<std::shared_ptr<mg::Buffer>(
+        mg::DMABufBuffer const&,
+        std::function<void()>&&,
+        std::function<void()>&&)>> import_dmabuf;
+
+    mgc::UDMABufImporter importer{create_dmabuf.AsStdFunction(), import_dmabuf.AsStdFunction()};
+};
+}
+
+TEST_F(UDMABufImporter, does_not_import_buffer_outside_a_memfd)
+{
+    StubPixels const pixels;
+
+    EXPECT_CALL(create_dmabuf, Call(_, _, _)).Times(0);
+
+    EXPECT_THAT(import(pixels), IsNull());
+}
+
+TEST_F(UDMABufImporter, does_not_import_buffer_whose_memfd_is_not_sealed)
+{
+    StubMemfdPixels pixels{0};
+    pixels.sealed = false;
+
+    EXPECT_CALL(create_dmabuf, Call(_, _, _)).Times(0);
+
+    EXPECT_THAT(import(pixels), IsNull());
+}
+
+TEST_F(UDMABufImporter, udmabuf_covers_whole_pages_and_plane_starts_at_first_pixel)
+{
+    StubMemfdPixels const pixels{page_size + 100};
+    auto const len = size_t(pixels.stride().as_int() * pixels.size().height.as_int());
+    auto const pages = (100 + len + page_size - 1) / page_size;
+
+    EXPECT_CALL(create_dmabuf, Call(_, page_size, pages * page_size));
+    EXPECT_CALL(import_dmabuf, Call(_, _, _))
+        .WillOnce([&](mg::DMABufBuffer const& dmabuf, auto&&, auto&&)
+            {
+                EXPECT_THAT(dmabuf.size(), Eq(pixels.size()));
+                EXPECT_THAT(dmabuf.format(), Eq(mg::DRMFormat::from_mir_format(pixels.format())));
+                EXPECT_THAT(dmabuf.modifier(), Eq(std::nullopt));
+                EXPECT_THAT(dmabuf.planes(), SizeIs(1));
+                EXPECT_THAT(dmabuf.planes()[0].offset, Eq(100u));
+                EXPECT_THAT(dmabuf.planes()[0].stride, Eq(pixels.stride().as_uint32_t()));
+                return std::make_shared<mtd::StubBuffer>();
+            });
+
+    EXPECT_THAT(import(pixels), NotNull());
+}
+
+TEST_F(UDMABufImporter, client_buffer_gets_one_udmabuf_however_often_it_is_imported)
+{
+    StubMemfdPixels const pixels{0};
+
+    EXPECT_CALL(create_dmabuf, Call(_, _, _)).Times(1);
+    EXPECT_CALL(import_dmabuf, Call(_, _, _)).Times(3);
+
+    import(pixels);
+    import(pixels);
+    import(pixels);
+}
+
+TEST_F(UDMABufImporter, each_client_buffer_gets_its_own_udmabuf)
+{
+    StubMemfdPixels const first{0}, second{0};
+
+    EXPECT_CALL(create_dmabuf, Call(_, _, _)).Times(2);
+
+    import(first);
+    import(second);
+    import(first);
+    import(second);
+}
+
+TEST_F(UDMABufImporter, udmabuf_is_closed_once_its_client_buffer_is_gone)
+{
+    int read_end{-1};
+    EXPECT_CALL(create_dmabuf, Call(_, _, _))
+        .WillOnce([&](auto&&...)
+            {
+                int fds[2];
+                if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0)
+                {
+                    throw std::system_error{errno, std::system_category(), "Failed to create pipe"};
+                }
+                read_end = fds[0];
+                return std::optional<mir::Fd>{mir::Fd{fds[1]}};
+            })
+        .WillRepeatedly(DoDefault());
+    auto pixels = std::make_unique<StubMemfdPixels>(0);
+    import(*pixels);
+    mir::Fd const read_end_owner{read_end};
+
+    char byte;
+    ASSERT_THAT(read(read_end_owner, &byte, 1), Eq(-1)) << "udmabuf closed while its client buffer exists";
+
+    pixels.reset();
+    // Client buffers that have gone are forgotten on the next import
+    StubMemfdPixels const other{0};
+    import(other);
+
+    EXPECT_THAT(read(read_end_owner, &byte, 1), Eq(0));
+}
+
+TEST_F(UDMABufImporter, client_buffer_whose_udmabuf_cannot_be_created_is_not_retried)
+{
+    StubMemfdPixels const pixels{0};
+
+    EXPECT_CALL(create_dmabuf, Call(_, _, _))
+        .WillOnce(Return(std::nullopt));
+    EXPECT_CALL(import_dmabuf, Call(_, _, _)).Times(0);
+
+    EXPECT_THAT(import(pixels), IsNull());
+    EXPECT_THAT(import(pixels), IsNull());
+}
+
+TEST_F(UDMABufImporter, format_the_gpu_does_not_support_is_not_tried_again)
+{
+    StubMemfdPixels const first{0}, second{0};
+    StubMemfdPixels other_format{0};
+    other_format.pixel_format = mir_pixel_format_xrgb_8888;
+
+    auto const has_format = [](MirPixelFormat format)
+        {
+            return Property(&mg::DMABufBuffer::format, Eq(mg::DRMFormat::from_mir_format(format)));
+        };
+    EXPECT_CALL(import_dmabuf, Call(has_format(mir_pixel_format_argb_8888), _, _))
+        .WillOnce(Throw(egl_failure(EGL_BAD_MATCH)));
+    EXPECT_CALL(import_dmabuf, Call(has_format(mir_pixel_format_xrgb_8888), _, _));
+
+    EXPECT_THAT(import(first), IsNull());
+    EXPECT_THAT(import(second), IsNull());
+    EXPECT_THAT(import(other_format), NotNull());
+}
+
+TEST_F(UDMABufImporter, buffer_the_gpu_cannot_import_does_not_rule_out_its_format)
+{
+    StubMemfdPixels const rejected{0}, accepted{0};
+
+    EXPECT_CALL(import_dmabuf, Call(_, _, _))
+        .WillOnce(Throw(egl_failure(EGL_BAD_ACCESS)))
+        .WillOnce(Return(std::make_shared<mtd::StubBuffer>()));
+
+    EXPECT_THAT(import(rejected), IsNull());
+    EXPECT_THAT(import(accepted), NotNull());
+
+    // But the rejected buffer is copied from now on
+    EXPECT_THAT(import(rejected), IsNull());
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/keymap_cache.h"
+#include "mir/input/parameter_keymap.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace mi = mir::input;
+
+using namespace ::testing;
+
+TEST(KeymapCache, matching_keymaps_share_one_compilation)
+{
+    auto const keymap_a = std::make_shared<mi::ParameterKeymap>();
+    auto const keymap_b = std::make_shared<mi::ParameterKeymap>();
+
+    auto const compiled_a = mi::compile_keymap(keymap_a);
+    auto const compiled_b = mi::compile_keymap(keymap_b);
+
+    EXPECT_THAT(compiled_b, Eq(compiled_a));
+    EXPECT_THAT(compiled_b->xkb_keymap(), Eq(compiled_a->xkb_keymap()));
+    EXPECT_THAT(static_cast<int>(compiled_b->fd()), Eq(static_cast<int>(compiled_a->fd())));
+}
+
+TEST(KeymapCache, different_keymaps_are_compiled_separately)
+{
+    auto const compiled_us = mi::compile_keymap(std::make_shared<mi::ParameterKeymap>("pc105", "us", "", ""));
+    auto const compiled_gb = mi::compile_keymap(std::make_shared<mi::ParameterKeymap>("pc105", "gb", "", ""));
+
+    EXPECT_THAT(compiled_gb, Ne(compiled_us));
+    EXPECT_THAT(compiled_gb->xkb_keymap(), Ne(compiled_us->xkb_keymap()));
+}
+
+TEST(KeymapCache, keymap_is_recompiled_once_unused)
+{
+    auto const keymap = std::make_shared<mi::ParameterKeymap>("pc105", "de", "", "");
+
+    std::weak_ptr<mi::CompiledKeymap const> const first = mi::compile_keymap(keymap);
+
+    EXPECT_TRUE(first.expired());
+    EXPECT_THAT(mi::compile_keymap(keymap), NotNull());
+}
+
+TEST(KeymapCache, fd_holds_null_terminated_keymap_text)
+{
+    auto const compiled = mi::compile_keymap(std::make_shared<mi::ParameterKeymap>());
+
+    auto const mapping = mmap(nullptr, compiled->size(), PROT_READ, MAP_PRIVATE, compiled->fd(), 0);
+    ASSERT_THAT(mapping, Ne(MAP_FAILED));
+
+    auto const text = static_cast<char const*>(mapping);
+    EXPECT_THAT(text[compiled->size() - 1], Eq('\0'));
+    EXPECT_THAT(std::string(text), StartsWith("xkb_keymap"));
+
+    munmap(mapping, compiled->size());
+}
+
+TEST(KeymapCache, fd_cannot_be_written_or_resized)
+{
+    auto const compiled = mi::compile_keymap(std::make_shared<mi::ParameterKeymap>());
+
+    char const junk[] = "junk";
+    EXPECT_THAT(pwrite(compiled->fd(), junk, sizeof junk, 0), Eq(-1));
+    EXPECT_THAT(ftruncate(compiled->fd(), 0), Eq(-1));
+    EXPECT_THAT(
+        mmap(nullptr, compiled->size(), PROT_READ | PROT_WRITE, MAP_SHARED, compiled->fd(), 0),
+        Eq(MAP_FAILED));
+}
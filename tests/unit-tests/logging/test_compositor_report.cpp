@@ -19,8 +19,12 @@
 #include "mir/test/doubles/advanceable_clock.h"
 
 #include <gtest/gtest.h>
+#include <gmock/gmock.h>
 #include <string>
+#include <vector>
 #include <cstdio>
+#include <fstream>
+#include <iterator>
 
 using namespace std;
 
@@ -37,6 +41,20 @@ public:
     void log(ml::Severity, string const& message, string const&)
     {
         last = message;
+        all.push_back(message);
+    }
+    void clear()
+    {
+        all.clear();
+    }
+    string message_containing(char const* substr) const
+    {
+        for (auto const& message : all)
+        {
+            if (message.find(substr) != string::npos)
+                return message;
+        }
+        return {};
     }
     string const& last_message() const
     {
@@ -53,6 +71,7 @@ public:
     }
 private:
     string last;
+    vector<string> all;
 };
 
 struct LoggingCompositorReport : ::testing::Test
@@ -187,3 +206,117 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, logs_stage_timing_percentiles)
+{
+    const void* const id = "My Screen";
+    using Stage = mir::compositor::CompositorReport::FrameStage;
+
+    report.started();
+
+    for (int f = 0; f < 100; ++f)
+    {
+        report.scheduled();
+        report.began_frame(id);
+        report.began_stage(id, Stage::render);
+        clock->advance_by(chrono::microseconds(f == 99 ? 50000 : 4000));
+        report.finished_stage(id, Stage::render);
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        report.began_stage(id, Stage::wait_for_flip);
+        clock->advance_by(chrono::microseconds(5000));
+        report.finished_stage(id, Stage::wait_for_flip);
+    }
+
+    // All of that fits within one report interval...
+    EXPECT_THAT(recorder->message_containing("timing"), testing::IsEmpty());
+
+    recorder->clear();
+    clock->advance_by(chrono::seconds(1));
+    report.began_frame(id);
+    report.finished_frame(id);
+
+    auto const timing = recorder->message_containing("timing");
+    EXPECT_NE(string::npos, timing.find("render 4.095/4.095/4.095/50.000"))
+        << timing;
+    EXPECT_NE(string::npos, timing.find("wait_for_flip 5.000/"))
+        << timing;
+    EXPECT_NE(string::npos, timing.find("latency 9.215/"))
+        << timing;
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, stage_timing_percentiles_are_per_report_interval)
+{
+    const void* const id = "My Screen";
+    using Stage = mir::compositor::CompositorReport::FrameStage;
+
+    report.started();
+
+    auto const render_frames_taking = [&](chrono::microseconds render_time)
+        {
+            for (int f = 0; f < 10; ++f)
+            {
+                report.began_frame(id);
+                report.began_stage(id, Stage::render);
+                clock->advance_by(render_time);
+                report.finished_stage(id, Stage::render);
+                report.rendered_frame(id);
+                report.finished_frame(id);
+            }
+            clock->advance_by(chrono::seconds(1));
+            report.began_frame(id);
+            report.finished_frame(id);
+        };
+
+    render_frames_taking(chrono::microseconds(50000));
+    recorder->clear();
+    render_frames_taking(chrono::microseconds(4000));
+
+    auto const timing = recorder->message_containing("timing");
+    EXPECT_NE(string::npos, timing.find("render 4.000/4.000/4.000/4.000"))
+        << timing;
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, writes_metrics_file_through_the_metrics_executor)
+{
+    struct QueuingExecutor : mir::Executor
+    {
+        void spawn(std::function<void()>&& work) override
+        {
+            queued.push_back(std::move(work));
+        }
+        std::vector<std::function<void()>> queued;
+    } executor;
+
+    auto const path = testing::TempDir() + "compositor-metrics-test.json";
+    std::remove(path.c_str());
+    mrl::CompositorReport report{recorder, clock, path, executor};
+    const void* const id = "My Screen";
+
+    report.started();
+    for (int interval = 0; interval != 3; ++interval)
+    {
+        report.began_frame(id);
+        report.finished_frame(id);
+        clock->advance_by(chrono::seconds(1));
+    }
+    report.began_frame(id);
+    report.finished_frame(id);
+
+    // Nothing is written on the compositor thread, and pending contents are coalesced
+    EXPECT_FALSE(std::ifstream{path}.good());
+    ASSERT_THAT(executor.queued.size(), testing::Eq(1u));
+
+    executor.queued.front()();
+
+    std::ifstream written{path};
+    std::string const contents{std::istreambuf_iterator<char>{written}, std::istreambuf_iterator<char>{}};
+    EXPECT_NE(string::npos, contents.find("\"frames\":4")) << contents;
+
+    std::remove(path.c_str());
+    report.stopped();
+}
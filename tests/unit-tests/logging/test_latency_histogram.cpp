@@ -0,0 +1,101 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+namespace mrl = mir::report::logging;
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+TEST(LatencyHistogram, empty_histogram_reports_zero)
+{
+    mrl::LatencyHistogram histogram;
+
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0us, histogram.percentile(50));
+    EXPECT_EQ(0us, histogram.max());
+}
+
+TEST(LatencyHistogram, small_values_are_exact)
+{
+    mrl::LatencyHistogram histogram;
+
+    for (int i = 1; i <= 10; ++i)
+        histogram.record(std::chrono::microseconds{i});
+
+    EXPECT_EQ(10u, histogram.count());
+    EXPECT_EQ(5us, histogram.percentile(50));
+    EXPECT_EQ(9us, histogram.percentile(90));
+    EXPECT_EQ(10us, histogram.max());
+}
+
+TEST(LatencyHistogram, percentiles_are_within_relative_precision)
+{
+    mrl::LatencyHistogram histogram;
+
+    for (int i = 1; i <= 10000; ++i)
+        histogram.record(std::chrono::microseconds{i});
+
+    for (auto const percent : {50.0, 90.0, 99.0})
+    {
+        auto const expected = percent * 100;
+        auto const actual = histogram.percentile(percent).count();
+
+        EXPECT_GE(actual, expected) << "p" << percent;
+        EXPECT_LE(actual, expected * 17 / 16) << "p" << percent;
+    }
+    EXPECT_EQ(10000us, histogram.max());
+}
+
+TEST(LatencyHistogram, rare_outliers_show_in_the_tail_only)
+{
+    mrl::LatencyHistogram histogram;
+
+    for (int i = 0; i != 990; ++i)
+        histogram.record(16ms);
+    for (int i = 0; i != 10; ++i)
+        histogram.record(100ms);
+
+    EXPECT_LE(histogram.percentile(50), 17ms);
+    EXPECT_LE(histogram.percentile(99), 17ms);
+    EXPECT_GE(histogram.percentile(99.9), 100ms);
+    EXPECT_EQ(100ms, histogram.max());
+}
+
+TEST(LatencyHistogram, huge_values_do_not_overflow)
+{
+    mrl::LatencyHistogram histogram;
+
+    histogram.record(std::chrono::hours{1000});
+    histogram.record(-1ms);
+
+    EXPECT_EQ(2u, histogram.count());
+    EXPECT_EQ(std::chrono::hours{1000}, histogram.max());
+}
+
+TEST(LatencyHistogram, reset_forgets_samples)
+{
+    mrl::LatencyHistogram histogram;
+    histogram.record(5ms);
+
+    histogram.reset();
+
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0us, histogram.max());
+}
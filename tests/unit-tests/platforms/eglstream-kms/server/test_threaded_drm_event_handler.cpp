@@ -139,15 +139,15 @@ TEST_F(ThreadedDRMEventHandlerTest, calls_frame_callback_on_flip_completion)
     mge::ThreadedDRMEventHandler handler{mock_drm_fd};
     mge::ThreadedDRMEventHandler::KMSCrtcId const crtc_id{55};
     int constexpr frame_sec{10};
-    int constexpr frame_usec{400};
+    int constexpr frame_usec{400123};
     unsigned int constexpr expected_frame_no{3441};
 
     auto completion_handle = handler.expect_flip_event(
         crtc_id,
-        [frame_sec, frame_usec](unsigned int frame_no, std::chrono::milliseconds frame_time)
+        [frame_sec](unsigned int frame_no, std::chrono::milliseconds frame_time)
         {
             EXPECT_THAT(frame_no, Eq(expected_frame_no));
-            EXPECT_THAT(frame_time, Eq(std::chrono::seconds{frame_sec} + std::chrono::milliseconds{frame_usec}));
+            EXPECT_THAT(frame_time, Eq(std::chrono::seconds{frame_sec} + std::chrono::milliseconds{400}));
         });
 
     add_flip_event(expected_frame_no, frame_sec, frame_usec, crtc_id, handler.drm_event_data());
@@ -161,15 +161,15 @@ TEST_F(ThreadedDRMEventHandlerTest, handles_spurious_drm_events)
     mge::ThreadedDRMEventHandler handler{mock_drm_fd};
     mge::ThreadedDRMEventHandler::KMSCrtcId const crtc_id{55};
     int constexpr frame_sec{10};
-    int constexpr frame_usec{400};
+    int constexpr frame_usec{400123};
     unsigned int constexpr expected_frame_no{3441};
 
     auto completion_handle = handler.expect_flip_event(
         crtc_id,
-        [frame_sec, frame_usec](unsigned int frame_no, std::chrono::milliseconds frame_time)
+        [frame_sec](unsigned int frame_no, std::chrono::milliseconds frame_time)
         {
             EXPECT_THAT(frame_no, Eq(expected_frame_no));
-            EXPECT_THAT(frame_time, Eq(std::chrono::seconds{frame_sec} + std::chrono::milliseconds{frame_usec}));
+            EXPECT_THAT(frame_time, Eq(std::chrono::seconds{frame_sec} + std::chrono::milliseconds{400}));
         });
 
     add_flip_event(23, 10, 10, 5, handler.drm_event_data());
@@ -207,3 +207,22 @@ TEST_F(ThreadedDRMEventHandlerTest, dispatches_event_for_correct_crtc)
     EXPECT_THAT(first_handle.wait_for(30s), Eq(std::future_status::ready));
     EXPECT_TRUE(first_flip_done);
 }
+
+TEST_F(ThreadedDRMEventHandlerTest, cancelled_flip_completes_without_calling_frame_callback)
+{
+    using namespace std::literals::chrono_literals;
+
+    mge::ThreadedDRMEventHandler handler{mock_drm_fd};
+    mge::ThreadedDRMEventHandler::KMSCrtcId const crtc_id{55};
+
+    std::atomic<bool> flip_callback_called{false};
+
+    auto completion_handle = handler.expect_flip_event(
+        crtc_id,
+        [&flip_callback_called](auto, auto){ flip_callback_called = true; });
+
+    handler.cancel_flip_events(crtc_id);
+
+    EXPECT_THAT(completion_handle.wait_for(0ms), Eq(std::future_status::ready));
+    EXPECT_FALSE(flip_callback_called);
+}
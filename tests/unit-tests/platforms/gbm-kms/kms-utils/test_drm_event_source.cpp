@@ -0,0 +1,179 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "kms-utils/drm_event_source.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace mtd = mir::test::doubles;
+namespace mgk = mir::graphics::kms;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+ACTION_P5(InvokePageFlipHandler, sequence, sec, usec, crtc_id, user_data)
+{
+    char dummy;
+
+    arg1->page_flip_handler2(arg0, sequence, sec, usec, crtc_id, user_data);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
+class DRMEventSourceTest : public Test
+{
+public:
+    DRMEventSourceTest()
+        : drm_fd{mock_drm.open(drm_device, 0)},
+          events{mir::Fd{mir::IntOwnedFd{drm_fd}}}
+    {
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    char const* const drm_device = "/dev/dri/card0";
+    int const drm_fd;
+
+    mgk::DRMEventSource events;
+};
+}
+
+TEST_F(DRMEventSourceTest, delivers_vblank_sequence_and_timestamp_to_handler_for_crtc)
+{
+    uint32_t const crtc_id{21};
+    std::optional<mgk::DRMEventSource::FlipEvent> received;
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler(3441, 10, 400123, crtc_id, events.event_data()), Return(0)));
+
+    events.expect_flip(
+        crtc_id,
+        [&](auto const& event)
+        {
+            received = event;
+        });
+    mock_drm.generate_event_on(drm_device);
+
+    EXPECT_TRUE(events.dispatch());
+    ASSERT_TRUE(received);
+    EXPECT_THAT(received->sequence, Eq(3441u));
+    EXPECT_THAT(received->timestamp, Eq(10s + 400123us));
+}
+
+TEST_F(DRMEventSourceTest, ignores_events_for_other_crtcs)
+{
+    uint32_t const crtc_id{21};
+    uint32_t const other_crtc_id{25};
+    std::vector<uint32_t> received;
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler(1, 0, 0, other_crtc_id, events.event_data()), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(2, 0, 0, crtc_id, events.event_data()), Return(0)));
+
+    events.expect_flip(
+        crtc_id,
+        [&](auto const& event)
+        {
+            received.push_back(event->sequence);
+        });
+    mock_drm.generate_event_on(drm_device);
+    mock_drm.generate_event_on(drm_device);
+
+    EXPECT_TRUE(events.dispatch());
+    EXPECT_THAT(received, IsEmpty());
+    EXPECT_TRUE(events.dispatch());
+    EXPECT_THAT(received, ElementsAre(2u));
+}
+
+TEST_F(DRMEventSourceTest, expecting_a_second_flip_on_a_crtc_throws)
+{
+    uint32_t const crtc_id{21};
+
+    events.expect_flip(crtc_id, [](auto const&) {});
+
+    EXPECT_THROW(
+        events.expect_flip(crtc_id, [](auto const&) {}),
+        std::logic_error);
+}
+
+TEST_F(DRMEventSourceTest, cancelled_flip_does_not_call_handler)
+{
+    uint32_t const crtc_id{21};
+    bool called{false};
+
+    events.expect_flip(crtc_id, [&](auto const&) { called = true; });
+
+    EXPECT_TRUE(events.cancel_flip(crtc_id));
+    EXPECT_FALSE(events.cancel_flip(crtc_id));
+    EXPECT_FALSE(called);
+}
+
+TEST_F(DRMEventSourceTest, read_failure_fails_pending_flips)
+{
+    uint32_t const crtc_id{21};
+    bool failed{false};
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(SetErrnoAndReturn(EIO, -1));
+
+    events.expect_flip(crtc_id, [&](auto const& event) { failed = !event; });
+    mock_drm.generate_event_on(drm_device);
+
+    events.dispatch();
+    EXPECT_TRUE(failed);
+}
+
+TEST_F(DRMEventSourceTest, handler_is_called_on_dispatching_thread)
+{
+    uint32_t const crtc_id{21};
+    std::thread::id handler_thread;
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler(1, 0, 0, crtc_id, events.event_data()), Return(0)));
+
+    events.expect_flip(crtc_id, [&](auto const&) { handler_thread = std::this_thread::get_id(); });
+    mock_drm.generate_event_on(drm_device);
+
+    std::thread{[this] { events.dispatch(); }}.join();
+
+    EXPECT_THAT(handler_thread, Ne(std::this_thread::get_id()));
+    EXPECT_THAT(handler_thread, Ne(std::thread::id{}));
+}
+
+TEST_F(DRMEventSourceTest, interrupt_wakes_blocked_dispatch)
+{
+    events.expect_flip(21, [](auto const&) {});
+
+    std::promise<bool> dispatched;
+    std::thread dispatcher{[&] { dispatched.set_value(events.dispatch()); }};
+
+    events.interrupt();
+    auto result = dispatched.get_future();
+    ASSERT_THAT(result.wait_for(30s), Eq(std::future_status::ready));
+    dispatcher.join();
+
+    EXPECT_FALSE(result.get());
+    EXPECT_FALSE(events.dispatch());
+}
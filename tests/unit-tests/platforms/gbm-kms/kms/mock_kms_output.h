@@ -33,6 +33,8 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_METHOD2(configure, void(geometry::Displacement, size_t));
     MOCK_CONST_METHOD0(size, geometry::Size());
     MOCK_CONST_METHOD0(max_refresh_rate, int());
+    MOCK_METHOD1(set_vrr_enabled, void(bool));
+    MOCK_CONST_METHOD0(vrr_active, bool());
 
     bool set_crtc(graphics::FBHandle const& fb) override
     {
@@ -48,6 +50,11 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::FBHandle const*));
+    bool schedule_async_page_flip(graphics::FBHandle const& fb) override
+    {
+        return schedule_async_page_flip_thunk(&fb);
+    }
+    MOCK_METHOD1(schedule_async_page_flip_thunk, bool(graphics::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
 
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
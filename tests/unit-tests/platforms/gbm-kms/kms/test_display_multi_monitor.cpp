@@ -41,6 +41,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <deque>
+#include <mutex>
 #include <unordered_set>
 #include <fcntl.h>
 
@@ -319,12 +321,40 @@ TEST_F(MesaDisplayMultiMonitorTest, create_display_sets_all_connected_crtcs)
 namespace
 {
 
-ACTION_P(InvokePageFlipHandler, param)
+/* Flips complete in the order they were submitted, like the kernel would */
+struct FlippedCrtcs
+{
+    void push(uint32_t crtc_id, void* user_data)
+    {
+        std::lock_guard lock{mutex};
+        flips.emplace_back(crtc_id, user_data);
+    }
+
+    auto pop() -> std::pair<uint32_t, void*>
+    {
+        std::lock_guard lock{mutex};
+        auto const flip = flips.front();
+        flips.pop_front();
+        return flip;
+    }
+
+    std::mutex mutex;
+    std::deque<std::pair<uint32_t, void*>> flips;
+};
+
+ACTION_P2(SubmitPageFlip, flipped, generate_event)
+{
+    flipped->push(arg1, arg4);
+    generate_event();
+}
+
+ACTION_P(InvokePageFlipHandler, flipped)
 {
     int const dont_care{0};
     char dummy;
 
-    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, *param);
+    auto const [crtc_id, user_data] = flipped->pop();
+    arg1->page_flip_handler2(arg0, dont_care, dont_care, dont_care, crtc_id, user_data);
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
@@ -337,7 +367,7 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
     int const num_connected_outputs{3};
     int const num_disconnected_outputs{2};
     uint32_t const fb_id{66};
-    std::vector<void*> user_data(num_connected_outputs, nullptr);
+    FlippedCrtcs flipped;
 
     setup_outputs(num_connected_outputs, num_disconnected_outputs);
 
@@ -349,25 +379,24 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
                                                      _, _, _, _, _, _, _, _, _))
         .WillRepeatedly(DoAll(SetArgPointee<8>(fb_id), Return(0)));
 
-    /* All crtcs are flipped */
+    /* All crtcs are flipped; the first round of flips emits fake DRM page-flip events */
     for (int i = 0; i < num_connected_outputs; i++)
     {
         EXPECT_CALL(mock_drm, drmModePageFlip(mtd::IsFdOfDevice(drm_device),
                                               crtc_ids[i], fb_id,
                                               _, _))
             .Times(2)
-            .WillRepeatedly(DoAll(SaveArg<4>(&user_data[i]), Return(0)));
-
-        /* Emit fake DRM page-flip events */
-        mock_drm.generate_event_on(drm_device);
+            .WillOnce(
+                DoAll(
+                    SubmitPageFlip(&flipped, [this]() { mock_drm.generate_event_on(drm_device); }),
+                    Return(0)))
+            .WillOnce(Return(0));
     }
 
     /* Handle the events properly */
     EXPECT_CALL(mock_drm, drmHandleEvent(mtd::IsFdOfDevice(drm_device), _))
         .Times(num_connected_outputs)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[2]), Return(0)));
+        .WillRepeatedly(DoAll(InvokePageFlipHandler(&flipped), Return(0)));
 
     auto platform = create_platform();
     auto display = create_display_cloned(platform);
@@ -258,3 +258,85 @@ TEST_F(MesaDisplaySinkTest, transformation_not_implemented_internally)
     EXPECT_EQ(rotate_left, sink.transformation());
 }
 
+
+TEST_F(MesaDisplaySinkTest, bypass_frames_are_paced_to_the_fixed_refresh_rate_without_vrr)
+{
+    ON_CALL(*mock_kms_output, vrr_active())
+        .WillByDefault(Return(false));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    EXPECT_THAT(sink.recommended_sleep().count(), Gt(0));
+}
+
+TEST_F(MesaDisplaySinkTest, bypass_frames_follow_client_commits_with_vrr)
+{
+    ON_CALL(*mock_kms_output, vrr_active())
+        .WillByDefault(Return(true));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        ASSERT_TRUE(sink.overlay(bypassable_list));
+        sink.post();
+
+        EXPECT_THAT(sink.recommended_sleep().count(), Eq(0));
+    }
+}
+
+TEST_F(MesaDisplaySinkTest, composited_frames_keep_the_fixed_refresh_rate_with_vrr)
+{
+    ON_CALL(*mock_kms_output, vrr_active())
+        .WillByDefault(Return(true));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    EXPECT_THAT(sink.recommended_sleep().count(), Gt(0));
+}
+
+TEST_F(MesaDisplaySinkTest, posting_frames_does_not_change_variable_refresh)
+{
+    EXPECT_CALL(*mock_kms_output, set_vrr_enabled(_)).Times(0);
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+}
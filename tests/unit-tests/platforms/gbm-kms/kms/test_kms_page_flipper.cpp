@@ -45,7 +45,7 @@ class KMSPageFlipperTest : public ::testing::Test
 public:
     KMSPageFlipperTest()
     : drm_fd{open(drm_device, 0, 0)},
-      page_flipper{drm_fd, mt::fake_shared(report)}
+      page_flipper{mir::Fd{mir::IntOwnedFd{drm_fd}}, mt::fake_shared(report)}
     {
     }
 
@@ -58,12 +58,12 @@ public:
     mgg::KMSPageFlipper page_flipper;
 };
 
-ACTION_P(InvokePageFlipHandler, param)
+ACTION_P2(InvokePageFlipHandler, param, crtc_id)
 {
     int const dont_care{0};
     char dummy;
 
-    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, *param);
+    arg1->page_flip_handler2(arg0, dont_care, dont_care, dont_care, crtc_id, *param);
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
@@ -116,7 +116,7 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
 
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
         .Times(1)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data, crtc_id), Return(0)));
 
     page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
 
@@ -126,6 +126,33 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
     page_flipper.wait_for_flip(crtc_id);
 }
 
+TEST_F(KMSPageFlipperTest, waiting_thread_reads_its_own_flip_event)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    std::thread::id reader;
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(
+            Invoke([&reader](auto, auto) { reader = std::this_thread::get_id(); }),
+            InvokePageFlipHandler(&user_data, crtc_id),
+            Return(0)));
+
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    mock_drm.generate_event_on(drm_device);
+
+    page_flipper.wait_for_flip(crtc_id);
+
+    EXPECT_THAT(reader, Eq(std::this_thread::get_id()));
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
 {
     using namespace testing;
@@ -136,7 +163,7 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
     ON_CALL(mock_drm, drmModePageFlip(_, _, _, _, _))
         .WillByDefault(DoAll(SaveArg<4>(&user_data), Return(0)));
     ON_CALL(mock_drm, drmHandleEvent(_, _))
-        .WillByDefault(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+        .WillByDefault(DoAll(InvokePageFlipHandler(&user_data, crtc_id), Return(0)));
 
     // Regression test for LP: #1621352
     ASSERT_NE(crtc_id, connector_id);
@@ -175,13 +202,14 @@ TEST_F(KMSPageFlipperTest, failure_in_wait_for_flip_throws)
         .Times(1)
         .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
 
-    EXPECT_CALL(mock_drm, drmHandleEvent(_, _))
-        .Times(0);
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .Times(1)
+        .WillOnce(SetErrnoAndReturn(EIO, -1));
 
     page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
 
     /* Cause a failure in wait_for_flip */
-    close(drm_fd);
+    mock_drm.generate_event_on(drm_device);
 
     EXPECT_THROW({
         page_flipper.wait_for_flip(crtc_id);
@@ -206,9 +234,9 @@ TEST_F(KMSPageFlipperTest, wait_for_flips_interleaved)
 
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
         .Times(3)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[2]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)));
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1], crtc_ids[1]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[2], crtc_ids[2]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0], crtc_ids[0]), Return(0)));
 
     for (int i = 0; i < flips; ++i)
         page_flipper.schedule_flip(crtc_ids[i], fb_id, connector_ids[i]);
@@ -272,134 +300,49 @@ private:
 
 }
 
-TEST_F(KMSPageFlipperTest, threads_switch_worker)
-{
-    using namespace testing;
-
-    size_t const worker_index{0};
-    size_t const other_index{1};
-    std::vector<uint32_t> const crtc_ids{10, 11};
-    std::vector<void*> user_data{nullptr, nullptr};
-    std::vector<std::unique_ptr<PageFlippingFunctor>> page_flipping_functors;
-    std::vector<std::thread> page_flipping_threads;
-    std::thread::id tid;
-
-    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, _, _, _))
-        .Times(2)
-        .WillOnce(DoAll(SaveArg<4>(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(SaveArg<4>(&user_data[other_index]), Return(0)));
-
-    /*
-     * The first event releases the original worker, hence we expect that
-     * then the other thread will become the worker.
-     */
-    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
-        .Times(2)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]), Return(0)));
-
-    /* Start the page-flipping threads */
-    for (auto crtc_id : crtc_ids)
-    {
-        auto pf = std::unique_ptr<PageFlippingFunctor>(new PageFlippingFunctor{page_flipper, crtc_id});
-        page_flipping_functors.push_back(std::move(pf));
-        page_flipping_threads.push_back(std::thread{std::ref(*page_flipping_functors.back())});
-
-        /* Wait for page-flip request and tell flipper to stop after this iteration */
-        while (page_flipping_functors.back()->page_flip_count() == 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        page_flipping_functors.back()->stop();
-
-        /* Wait until the (first) thread has become the worker */
-        while (tid == std::thread::id())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-            tid = page_flipper.debug_get_worker_tid();
-        }
-    }
-
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(), tid);
-
-    /* Fake a DRM event */
-    mock_drm.generate_event_on(drm_device);
-
-    page_flipping_threads[worker_index].join();
-
-    /* Wait for the worker to switch */
-    while (tid != page_flipping_threads[other_index].get_id())
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        tid = page_flipper.debug_get_worker_tid();
-    }
-
-    /* Fake another DRM event to unblock the remaining thread */
-    mock_drm.generate_event_on(drm_device);
-
-    page_flipping_threads[other_index].join();
-}
-
-TEST_F(KMSPageFlipperTest, threads_worker_notifies_non_worker)
+TEST_F(KMSPageFlipperTest, flip_event_wakes_only_its_own_crtc)
 {
     using namespace testing;
 
-    size_t const worker_index{0};
-    size_t const other_index{1};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{987};
     std::vector<uint32_t> const crtc_ids{10, 11};
-    std::vector<void*> user_data{nullptr, nullptr};
-    std::vector<std::unique_ptr<PageFlippingFunctor>> page_flipping_functors;
-    std::vector<std::thread> page_flipping_threads;
-    std::thread::id tid;
+    void* user_data{nullptr};
+    std::vector<std::atomic<bool>> flipped(crtc_ids.size());
 
-    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, _, _, _))
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, fb_id, _, _))
         .Times(2)
-        .WillOnce(DoAll(SaveArg<4>(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(SaveArg<4>(&user_data[other_index]), Return(0)));
+        .WillRepeatedly(DoAll(SaveArg<4>(&user_data), Return(0)));
 
-    /*
-     * The first event releases the non-worker thread, hence we expect that
-     * original worker not change.
-     */
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
         .Times(2)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[worker_index]), Return(0)));
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data, crtc_ids[1]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data, crtc_ids[0]), Return(0)));
 
-    /* Start the page-flipping threads */
-    for (auto crtc_id : crtc_ids)
+    std::vector<std::thread> waiters;
+    for (size_t i = 0; i != crtc_ids.size(); ++i)
     {
-        auto pf = std::unique_ptr<PageFlippingFunctor>(new PageFlippingFunctor{page_flipper, crtc_id});
-        page_flipping_functors.push_back(std::move(pf));
-        page_flipping_threads.push_back(std::thread{std::ref(*page_flipping_functors.back())});
-
-        /* Wait for page-flip request and tell flipper to stop after this iteration */
-        while (page_flipping_functors.back()->page_flip_count() == 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        page_flipping_functors.back()->stop();
-
-        /* Wait until the (first) thread has become the worker */
-        while (tid == std::thread::id())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-            tid = page_flipper.debug_get_worker_tid();
-        }
+        page_flipper.schedule_flip(crtc_ids[i], fb_id, connector_id);
+        waiters.emplace_back(
+            [this, &crtc_ids, &flipped, i]()
+            {
+                page_flipper.wait_for_flip(crtc_ids[i]);
+                flipped[i] = true;
+            });
     }
 
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(), tid);
-
-    /* Fake a DRM event */
+    /* Complete the second flip; only its waiter should return */
     mock_drm.generate_event_on(drm_device);
+    waiters[1].join();
 
-    /* Wait for the non-worker thread to exit */
-    page_flipping_threads[other_index].join();
-
-    /* Check that the worker hasn't changed */
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(),
-              page_flipper.debug_get_worker_tid());
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_FALSE(flipped[0]);
 
-    /* Fake another DRM event to unblock the remaining thread */
     mock_drm.generate_event_on(drm_device);
+    waiters[0].join();
 
-    page_flipping_threads[worker_index].join();
+    EXPECT_TRUE(flipped[0]);
+    EXPECT_TRUE(flipped[1]);
 }
 
 namespace
@@ -413,7 +356,8 @@ public:
         std::lock_guard lock{data_mutex};
 
         data.push_back({CountType::flip, crtc_id});
-        pending_flips.insert(user_data);
+        pending_flips.insert(crtc_id);
+        event_data = user_data;
     }
 
     void add_handle_event(uint32_t crtc_id)
@@ -469,20 +413,20 @@ public:
         return true;
     }
 
-    void* get_pending_flip_data()
+    std::pair<uint32_t, void*> get_pending_flip()
     {
         std::lock_guard lock{data_mutex};
 
         auto iter = pending_flips.begin();
         if (iter == pending_flips.end())
         {
-            return 0;
+            return {0, nullptr};
         }
         else
         {
-            auto d = *iter;
+            auto crtc_id = *iter;
             pending_flips.erase(iter);
-            return d;
+            return {crtc_id, event_data};
         }
     }
 
@@ -495,7 +439,8 @@ private:
     };
 
     std::vector<CountElement> data;
-    std::unordered_set<void*> pending_flips;
+    std::unordered_set<uint32_t> pending_flips;
+    void* event_data{nullptr};
     std::mutex data_mutex;
 };
 
@@ -505,13 +450,12 @@ ACTION_P(InvokePageFlipHandlerWithPendingData, counter)
     int const drm_fd{arg0};
     char dummy;
 
-    auto user_data = static_cast<mgg::PageFlipEventData*>(counter->get_pending_flip_data());
-    uint32_t const crtc_id{user_data->crtc_id};
+    auto const [crtc_id, user_data] = counter->get_pending_flip();
 
     /* Remove the event from the drm event queue */
     ASSERT_EQ(1, read(drm_fd, &dummy, 1));
     /* Call the page flip handler */
-    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, user_data);
+    arg1->page_flip_handler2(drm_fd, dont_care, dont_care, dont_care, crtc_id, user_data);
     /* Record this call */
     counter->add_handle_event(crtc_id);
 }
@@ -25,6 +25,7 @@
 #include "mir/test/doubles/mock_gbm.h"
 
 #include <stdexcept>
+#include <cstring>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -45,6 +46,7 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_async_flip(uint32_t,uint32_t,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -52,6 +54,7 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_async_flip, bool(uint32_t,uint32_t,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
@@ -274,6 +277,29 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
     output.wait_for_page_flip();
 }
 
+TEST_F(RealKMSOutputTest, async_page_flip_uses_current_crtc)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    uint32_t const fb_id{42};
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+
+    EXPECT_CALL(mock_page_flipper, schedule_async_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_page_flipper, schedule_flip(_, _, _))
+        .Times(0);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_TRUE(output.schedule_async_page_flip(*fb));
+}
+
 TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
 {
     mir::FatalErrorStrategy on_error{mir::fatal_error_except};
@@ -555,3 +581,144 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+namespace
+{
+struct FakeProperty
+{
+    FakeProperty(uint32_t id, char const* name)
+    {
+        res.prop_id = id;
+        strncpy(res.name, name, sizeof res.name - 1);
+    }
+
+    drmModePropertyRes res{};
+};
+}
+
+struct RealKMSOutputVrrTest : RealKMSOutputTest
+{
+    RealKMSOutputVrrTest()
+    {
+        using namespace testing;
+
+        setup_outputs_connected_crtc();
+
+        ON_CALL(mock_drm, drmModeObjectGetProperties(_, connector_ids[0], DRM_MODE_OBJECT_CONNECTOR))
+            .WillByDefault(Return(&connector_props));
+        ON_CALL(mock_drm, drmModeObjectGetProperties(_, crtc_ids[0], DRM_MODE_OBJECT_CRTC))
+            .WillByDefault(Return(&crtc_props));
+        ON_CALL(mock_drm, drmModeGetProperty(_, vrr_capable.res.prop_id))
+            .WillByDefault(Return(&vrr_capable.res));
+        ON_CALL(mock_drm, drmModeGetProperty(_, vrr_enabled.res.prop_id))
+            .WillByDefault(Return(&vrr_enabled.res));
+    }
+
+    void expect_crtc_vrr(uint64_t value)
+    {
+        EXPECT_CALL(mock_drm, drmModeObjectSetProperty(
+            drm_fd, crtc_ids[0], DRM_MODE_OBJECT_CRTC, vrr_enabled.res.prop_id, value));
+    }
+
+    FakeProperty vrr_capable{40, "vrr_capable"};
+    FakeProperty vrr_enabled{41, "VRR_ENABLED"};
+    uint32_t connector_prop_ids[1]{vrr_capable.res.prop_id};
+    uint64_t connector_prop_values[1]{1};
+    drmModeObjectProperties connector_props{1, connector_prop_ids, connector_prop_values};
+    uint32_t crtc_prop_ids[1]{vrr_enabled.res.prop_id};
+    uint64_t crtc_prop_values[1]{0};
+    drmModeObjectProperties crtc_props{1, crtc_prop_ids, crtc_prop_values};
+    std::shared_ptr<MockKMSFramebuffer> const fb{std::make_shared<MockKMSFramebuffer>(67)};
+};
+
+TEST_F(RealKMSOutputVrrTest, variable_refresh_is_switched_when_the_output_is_configured)
+{
+    using namespace testing;
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+
+    {
+        InSequence seq;
+        expect_crtc_vrr(1);
+        expect_crtc_vrr(0);
+    }
+
+    output.set_vrr_enabled(true);
+    EXPECT_TRUE(output.vrr_active());
+
+    output.set_vrr_enabled(true);
+    EXPECT_TRUE(output.vrr_active());
+
+    output.set_vrr_enabled(false);
+    EXPECT_FALSE(output.vrr_active());
+}
+
+TEST_F(RealKMSOutputVrrTest, variable_refresh_is_switched_on_when_the_output_gets_a_crtc)
+{
+    using namespace testing;
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    output.set_vrr_enabled(true);
+    EXPECT_FALSE(output.vrr_active());
+
+    {
+        InSequence seq;
+        expect_crtc_vrr(1);
+        EXPECT_CALL(mock_drm, drmModeSetCrtc(drm_fd, crtc_ids[0], _, _, _, _, _, _));
+    }
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_TRUE(output.vrr_active());
+}
+
+TEST_F(RealKMSOutputVrrTest, variable_refresh_is_switched_off_when_the_output_is_reset)
+{
+    using namespace testing;
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    output.set_vrr_enabled(true);
+    ASSERT_TRUE(output.vrr_active());
+
+    expect_crtc_vrr(0);
+
+    output.reset();
+    EXPECT_FALSE(output.vrr_active());
+}
+
+TEST_F(RealKMSOutputTest, variable_refresh_is_not_activated_unless_supported)
+{
+    using namespace testing;
+
+    uint32_t const fb_id{67};
+
+    setup_outputs_connected_crtc();
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+    EXPECT_TRUE(output.set_crtc(*fb));
+
+    EXPECT_CALL(mock_drm, drmModeObjectSetProperty(_, _, _, _, _)).Times(0);
+
+    // The connector doesn't report "vrr_capable", so this is refused
+    output.set_vrr_enabled(true);
+
+    EXPECT_FALSE(output.vrr_active());
+}
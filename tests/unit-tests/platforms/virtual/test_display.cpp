@@ -18,15 +18,22 @@
 #include <gmock/gmock.h>
 
 #include "src/platforms/virtual/display.h"
+#include "src/platforms/virtual/display_sink.h"
 #include "src/platforms/virtual/platform.h"
 
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/default_display_configuration_policy.h"
 
+#include "mir/graphics/display_sink.h"
+#include "mir/renderer/sw/pixel_source.h"
+
 #include "mir/test/doubles/null_display_configuration_policy.h"
+#include "mir/test/doubles/mock_display_report.h"
 #include "mir/test/doubles/mock_egl.h"
 #include "mir/test/fake_shared.h"
 
+#include <cstring>
+
 
 namespace mg = mir::graphics;
 namespace mgv = mg::virt;
@@ -48,9 +55,24 @@ public:
 
     std::shared_ptr<mgv::Display> create_display(std::vector<mgv::VirtualOutputConfig> sizes)
     {
-        return std::make_shared<mgv::Display>(sizes);
+        return std::make_shared<mgv::Display>(sizes, mt::fake_shared(report));
+    }
+
+    auto sync_groups_of(mgv::Display& display) -> std::vector<mg::DisplaySyncGroup*>
+    {
+        std::vector<mg::DisplaySyncGroup*> groups;
+        display.for_each_display_sync_group([&](auto& group) { groups.push_back(&group); });
+        return groups;
+    }
+
+    auto sink_of(mg::DisplaySyncGroup& group) -> mg::DisplaySink&
+    {
+        mg::DisplaySink* result = nullptr;
+        group.for_each_display_sink([&](auto& sink) { result = &sink; });
+        return *result;
     }
 
+    NiceMock<mtd::MockDisplayReport> report;
     mtd::NullDisplayConfigurationPolicy null_display_configuration_policy;
     ::testing::NiceMock<mtd::MockEGL> mock_egl;
 };
@@ -106,7 +128,7 @@ TEST_F(VirtualDisplayTest, reports_multiple_outputs_when_provided_multiple_outpu
     EXPECT_THAT(output_count, Eq(2));
 }
 
-TEST_F(VirtualDisplayTest, for_each_display_group_iterates_no_display_groups)
+TEST_F(VirtualDisplayTest, for_each_display_group_iterates_a_group_per_output)
 {
     auto display = create_display({
         mgv::VirtualOutputConfig({Size{1280, 1024}}),
@@ -119,7 +141,105 @@ TEST_F(VirtualDisplayTest, for_each_display_group_iterates_no_display_groups)
         count++;
     });
 
-    EXPECT_THAT(count, Eq(0));
+    EXPECT_THAT(count, Eq(2));
+}
+
+TEST_F(VirtualDisplayTest, sinks_provide_cpu_addressable_framebuffers_of_the_output_size)
+{
+    auto display = create_display({mgv::VirtualOutputConfig({Size{640, 480}})});
+    auto& sink = sink_of(*sync_groups_of(*display).at(0));
+
+    auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>();
+
+    ASSERT_THAT(allocator, NotNull());
+    EXPECT_THAT(allocator->output_size(), Eq(Size{640, 480}));
+    EXPECT_THAT(sink.view_area(), Eq(Rectangle{{0, 0}, {640, 480}}));
+}
+
+TEST_F(VirtualDisplayTest, posted_image_becomes_the_last_image)
+{
+    auto display = create_display({mgv::VirtualOutputConfig({Size{4, 4}}, 1000.0)});
+    auto& group = *sync_groups_of(*display).at(0);
+    auto& sink = dynamic_cast<mgv::DisplaySink&>(sink_of(group));
+    auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>();
+
+    auto fb = allocator->alloc_fb(allocator->supported_formats().front());
+    {
+        auto const mapping = fb->map_writeable();
+        std::memset(mapping->data(), 0x42, mapping->len());
+    }
+    sink.set_next_image(std::move(fb));
+    group.post();
+
+    ASSERT_THAT(sink.last_image(), NotNull());
+    EXPECT_THAT(sink.last_image()->pixels(), Each(Eq(0x42)));
+}
+
+TEST_F(VirtualDisplayTest, post_completes_on_successive_vblanks_of_the_refresh_rate)
+{
+    auto display = create_display({mgv::VirtualOutputConfig({Size{4, 4}}, 200.0)});
+    auto& group = *sync_groups_of(*display).at(0);
+    auto& sink = dynamic_cast<mgv::DisplaySink&>(sink_of(group));
+    std::chrono::nanoseconds const period{5'000'000};
+
+    std::vector<mg::Frame> frames;
+    EXPECT_CALL(report, report_vsync(_, _)).Times(3).WillRepeatedly(
+        [&](unsigned, mg::Frame const& frame) { frames.push_back(frame); });
+
+    for (int i = 0; i != 3; ++i)
+    {
+        group.post();
+        EXPECT_THAT(sink.last_frame().msc, Eq(frames.back().msc));
+        EXPECT_THAT(mir::time::PosixTimestamp::now(CLOCK_MONOTONIC).nanoseconds, Ge(frames.back().ust.nanoseconds));
+    }
+
+    for (size_t i = 1; i != frames.size(); ++i)
+    {
+        EXPECT_THAT(frames[i].msc, Gt(frames[i - 1].msc));
+        EXPECT_THAT(
+            frames[i].ust - frames[i - 1].ust,
+            Eq((frames[i].msc - frames[i - 1].msc) * period));
+    }
+}
+
+TEST_F(VirtualDisplayTest, disabling_an_output_does_not_preserve_display_buffers)
+{
+    auto display = create_display({
+        mgv::VirtualOutputConfig({Size{1280, 1024}}),
+        mgv::VirtualOutputConfig({Size{1280, 1024}})
+    });
+    auto const conf = display->configuration();
+    bool first = true;
+    conf->for_each_output([&](mg::UserDisplayConfigurationOutput& output)
+        {
+            output.used = !first;
+            first = false;
+        });
+
+    EXPECT_THAT(display->apply_if_configuration_preserves_display_buffers(*conf), IsFalse());
+    EXPECT_THAT(sync_groups_of(*display).size(), Eq(2u));
+}
+
+TEST_F(VirtualDisplayTest, configure_incrementally_retires_only_the_disabled_output)
+{
+    auto display = create_display({
+        mgv::VirtualOutputConfig({Size{1280, 1024}}),
+        mgv::VirtualOutputConfig({Size{1280, 1024}})
+    });
+    auto const before = sync_groups_of(*display);
+    auto const conf = display->configuration();
+    bool first = true;
+    conf->for_each_output([&](mg::UserDisplayConfigurationOutput& output)
+        {
+            output.used = !first;
+            first = false;
+        });
+
+    std::vector<mg::DisplaySyncGroup*> retired;
+    display->configure_incrementally(*conf, [&](auto& group) { retired.push_back(&group); });
+
+    EXPECT_THAT(retired, ElementsAre(before[0]));
+    EXPECT_THAT(sync_groups_of(*display), ElementsAre(before[1]));
 }
 
 }
@@ -68,6 +68,21 @@ TEST_F(VirtualGraphicsPlatformTest, multiple_output_sizes_are_set_correctly_when
         mgv::VirtualOutputConfig(std::vector<geom::Size>{geom::Size{1280, 1024}, geom::Size{800, 600}})));
 }
 
+TEST_F(VirtualGraphicsPlatformTest, refresh_rate_can_follow_the_output_sizes)
+{
+    auto config = mgv::Platform::parse_output_sizes({"1280x1024:800x600@144", "640x480"});
+    EXPECT_THAT(config, ElementsAre(
+        mgv::VirtualOutputConfig(std::vector<geom::Size>{geom::Size{1280, 1024}, geom::Size{800, 600}}, 144.0),
+        mgv::VirtualOutputConfig(std::vector<geom::Size>{geom::Size{640, 480}}, 60.0)));
+}
+
+TEST_F(VirtualGraphicsPlatformTest, refresh_rate_parsing_throws_on_bad_input)
+{
+    EXPECT_THROW(mgv::Platform::parse_output_sizes({"1280x1024@"}), std::runtime_error) << "No rate";
+    EXPECT_THROW(mgv::Platform::parse_output_sizes({"1280x1024@0"}), std::runtime_error) << "Zero rate";
+    EXPECT_THROW(mgv::Platform::parse_output_sizes({"1280x1024@fast"}), std::runtime_error) << "Not a number";
+}
+
 TEST_F(VirtualGraphicsPlatformTest, can_acquire_interface_for_cpu_addressable_display_provider)
 {
     auto platform = create_platform();
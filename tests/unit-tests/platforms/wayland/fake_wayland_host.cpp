@@ -0,0 +1,260 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fake_wayland_host.h"
+
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace mt = mir::test;
+
+struct mt::FakeWaylandHost::Self
+{
+    Self();
+    ~Self();
+
+    static auto from(wl_resource* resource) -> Self*
+    {
+        return static_cast<Self*>(wl_resource_get_user_data(resource));
+    }
+
+    static void destroy(wl_client*, wl_resource* resource)
+    {
+        wl_resource_destroy(resource);
+    }
+
+    static void bind_compositor(wl_client* client, void* data, uint32_t version, uint32_t id);
+    static void bind_subcompositor(wl_client* client, void* data, uint32_t version, uint32_t id);
+    static void create_surface(wl_client* client, wl_resource* compositor, uint32_t id);
+    static void create_region(wl_client* client, wl_resource* compositor, uint32_t id);
+    static void get_subsurface(wl_client* client, wl_resource* subcompositor, uint32_t id, wl_resource*, wl_resource*);
+    static void resource_created(wl_listener* listener, void* data);
+
+    /// Standard layout, so that resource_created() can get from the listener to the count
+    struct BufferCounter
+    {
+        wl_listener listener;
+        std::atomic<int>* buffers_created;
+    };
+
+    wl_display* const display;
+    int client_fd{-1};
+
+    std::atomic<int> surfaces_created{0};
+    std::atomic<int> subsurfaces_created{0};
+    std::atomic<int> buffers_created{0};
+    std::atomic<int> buffers_attached{0};
+    BufferCounter buffer_counter{{}, &buffers_created};
+
+    std::atomic<bool> running{true};
+    std::thread dispatcher;
+};
+
+static_assert(
+    std::is_standard_layout<mt::FakeWaylandHost::Self::BufferCounter>::value,
+    "BufferCounter must be Standard Layout for wl_container_of to be defined behaviour");
+
+mt::FakeWaylandHost::Self::Self()
+    : display{wl_display_create()}
+{
+    wl_display_init_shm(display);
+    wl_global_create(display, &wl_compositor_interface, 4, this, &bind_compositor);
+    wl_global_create(display, &wl_subcompositor_interface, 1, this, &bind_subcompositor);
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+    {
+        throw std::system_error{errno, std::system_category(), "Failed to create socketpair"};
+    }
+    client_fd = fds[1];
+    auto const client = wl_client_create(display, fds[0]);
+    buffer_counter.listener.notify = &resource_created;
+    wl_client_add_resource_created_listener(client, &buffer_counter.listener);
+
+    dispatcher = std::thread{[this]()
+        {
+            auto const loop = wl_display_get_event_loop(display);
+            while (running)
+            {
+                wl_event_loop_dispatch(loop, 10);
+                wl_display_flush_clients(display);
+            }
+        }};
+}
+
+mt::FakeWaylandHost::Self::~Self()
+{
+    running = false;
+    dispatcher.join();
+    if (client_fd >= 0)
+    {
+        close(client_fd);
+    }
+    wl_display_destroy_clients(display);
+    wl_display_destroy(display);
+}
+
+void mt::FakeWaylandHost::Self::bind_compositor(wl_client* client, void* data, uint32_t version, uint32_t id)
+{
+    static auto const implementation = []()
+        {
+            struct wl_compositor_interface implementation{};
+            implementation.create_surface = &create_surface;
+            implementation.create_region = &create_region;
+            return implementation;
+        }();
+
+    auto const resource = wl_resource_create(client, &wl_compositor_interface, version, id);
+    wl_resource_set_implementation(resource, &implementation, data, nullptr);
+}
+
+void mt::FakeWaylandHost::Self::bind_subcompositor(wl_client* client, void* data, uint32_t version, uint32_t id)
+{
+    static auto const implementation = []()
+        {
+            struct wl_subcompositor_interface implementation{};
+            implementation.destroy = &destroy;
+            implementation.get_subsurface = &get_subsurface;
+            return implementation;
+        }();
+
+    auto const resource = wl_resource_create(client, &wl_subcompositor_interface, version, id);
+    wl_resource_set_implementation(resource, &implementation, data, nullptr);
+}
+
+void mt::FakeWaylandHost::Self::create_surface(wl_client* client, wl_resource* compositor, uint32_t id)
+{
+    static auto const implementation = []()
+        {
+            struct wl_surface_interface implementation{};
+            implementation.destroy = &destroy;
+            implementation.attach = [](wl_client*, wl_resource* surface, wl_resource* buffer, int32_t, int32_t)
+                {
+                    if (buffer)
+                    {
+                        from(surface)->buffers_attached++;
+                    }
+                };
+            implementation.damage = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {};
+            implementation.frame = [](wl_client* client, wl_resource*, uint32_t callback)
+                {
+                    wl_resource_create(client, &wl_callback_interface, 1, callback);
+                };
+            implementation.set_opaque_region = [](wl_client*, wl_resource*, wl_resource*) {};
+            implementation.set_input_region = [](wl_client*, wl_resource*, wl_resource*) {};
+            implementation.commit = [](wl_client*, wl_resource*) {};
+            implementation.set_buffer_transform = [](wl_client*, wl_resource*, int32_t) {};
+            implementation.set_buffer_scale = [](wl_client*, wl_resource*, int32_t) {};
+            implementation.damage_buffer = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {};
+            return implementation;
+        }();
+
+    auto const self = from(compositor);
+    auto const resource = wl_resource_create(client, &wl_surface_interface, wl_resource_get_version(compositor), id);
+    wl_resource_set_implementation(resource, &implementation, self, nullptr);
+    self->surfaces_created++;
+}
+
+void mt::FakeWaylandHost::Self::create_region(wl_client* client, wl_resource* compositor, uint32_t id)
+{
+    static auto const implementation = []()
+        {
+            struct wl_region_interface implementation{};
+            implementation.destroy = &destroy;
+            implementation.add = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {};
+            implementation.subtract = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {};
+            return implementation;
+        }();
+
+    auto const resource = wl_resource_create(client, &wl_region_interface, 1, id);
+    wl_resource_set_implementation(resource, &implementation, from(compositor), nullptr);
+}
+
+void mt::FakeWaylandHost::Self::get_subsurface(
+    wl_client* client,
+    wl_resource* subcompositor,
+    uint32_t id,
+    wl_resource*,
+    wl_resource*)
+{
+    static auto const implementation = []()
+        {
+            struct wl_subsurface_interface implementation{};
+            implementation.destroy = &destroy;
+            implementation.set_position = [](wl_client*, wl_resource*, int32_t, int32_t) {};
+            implementation.place_above = [](wl_client*, wl_resource*, wl_resource*) {};
+            implementation.place_below = [](wl_client*, wl_resource*, wl_resource*) {};
+            implementation.set_sync = [](wl_client*, wl_resource*) {};
+            implementation.set_desync = [](wl_client*, wl_resource*) {};
+            return implementation;
+        }();
+
+    auto const self = from(subcompositor);
+    auto const resource = wl_resource_create(client, &wl_subsurface_interface, 1, id);
+    wl_resource_set_implementation(resource, &implementation, self, nullptr);
+    self->subsurfaces_created++;
+}
+
+void mt::FakeWaylandHost::Self::resource_created(wl_listener* listener, void* data)
+{
+    BufferCounter* counter = wl_container_of(listener, counter, listener);
+    if (strcmp(wl_resource_get_class(static_cast<wl_resource*>(data)), "wl_buffer") == 0)
+    {
+        (*counter->buffers_created)++;
+    }
+}
+
+mt::FakeWaylandHost::FakeWaylandHost()
+    : self{std::make_unique<Self>()}
+{
+}
+
+mt::FakeWaylandHost::~FakeWaylandHost() = default;
+
+auto mt::FakeWaylandHost::take_client_fd() -> int
+{
+    return std::exchange(self->client_fd, -1);
+}
+
+auto mt::FakeWaylandHost::surfaces_created() const -> int
+{
+    return self->surfaces_created;
+}
+
+auto mt::FakeWaylandHost::subsurfaces_created() const -> int
+{
+    return self->subsurfaces_created;
+}
+
+auto mt::FakeWaylandHost::buffers_created() const -> int
+{
+    return self->buffers_created;
+}
+
+auto mt::FakeWaylandHost::buffers_attached() const -> int
+{
+    return self->buffers_attached;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TEST_FAKE_WAYLAND_HOST_H_
+#define MIR_TEST_FAKE_WAYLAND_HOST_H_
+
+#include <memory>
+
+namespace mir
+{
+namespace test
+{
+/**
+ * A Wayland server with just enough wl_compositor, wl_subcompositor and wl_shm for the wayland
+ * platform to show buffers on, which counts what it is asked to do
+ *
+ * It is kept apart from the tests so that they needn't include the server and client protocol
+ * headers together.
+ */
+class FakeWaylandHost
+{
+public:
+    FakeWaylandHost();
+    ~FakeWaylandHost();
+
+    FakeWaylandHost(FakeWaylandHost const&) = delete;
+    FakeWaylandHost& operator=(FakeWaylandHost const&) = delete;
+
+    /// The client end of the host's one connection (the caller takes ownership)
+    auto take_client_fd() -> int;
+
+    auto surfaces_created() const -> int;
+    auto subsurfaces_created() const -> int;
+    auto buffers_created() const -> int;
+    /// How many times a (non-null) buffer has been attached to any surface
+    auto buffers_attached() const -> int;
+
+private:
+    struct Self;
+    std::unique_ptr<Self> const self;
+};
+}
+}
+
+#endif // MIR_TEST_FAKE_WAYLAND_HOST_H_
@@ -0,0 +1,239 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/wayland/subsurface_passthrough.h"
+#include "fake_wayland_host.h"
+
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/platform.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <wayland-client.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mgw = mir::graphics::wayland;
+namespace geom = mir::geometry;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+geom::Size const output_size{640, 480};
+
+class TestDisplayClient : public mgw::DisplayClient
+{
+public:
+    explicit TestDisplayClient(wl_display* display)
+        : DisplayClient{display, nullptr, true}
+    {
+    }
+
+    using DisplayClient::SubsurfacePassthrough;
+
+    auto create_passthrough() -> std::unique_ptr<SubsurfacePassthrough>
+    {
+        parent = wl_compositor_create_surface(compositor);
+        return std::make_unique<SubsurfacePassthrough>(this, parent, output_size);
+    }
+
+    ~TestDisplayClient()
+    {
+        if (parent)
+        {
+            wl_surface_destroy(parent);
+        }
+    }
+
+    void spawn(std::function<void()>&& work) override
+    {
+        work();
+    }
+
+private:
+    wl_surface* parent{nullptr};
+};
+
+/// A framebuffer the passthrough didn't make, as the renderer would produce
+struct RenderedFramebuffer : mg::Framebuffer
+{
+    auto size() const -> geom::Size override
+    {
+        return output_size;
+    }
+};
+
+struct SubsurfacePassthroughTest : Test
+{
+    SubsurfacePassthroughTest()
+        : display{wl_display_connect_to_fd(host.take_client_fd()), &wl_display_disconnect},
+          client{std::make_unique<TestDisplayClient>(display.get())},
+          passthrough{client->create_passthrough()}
+    {
+    }
+
+    ~SubsurfacePassthroughTest()
+    {
+        passthrough.reset();
+        client.reset();
+    }
+
+    static auto client_buffer(geom::Size size) -> std::shared_ptr<mg::Buffer>
+    {
+        return std::make_shared<mtd::StubBuffer>(
+            mg::BufferProperties{size, mir_pixel_format_argb_8888, mg::BufferUsage::software});
+    }
+
+    /// An element showing framebuffer unscaled at top_left
+    static auto element_for(std::shared_ptr<mg::Framebuffer> framebuffer, geom::Point top_left) -> mg::DisplayElement
+    {
+        auto const size = framebuffer->size();
+        return mg::DisplayElement{{top_left, size}, {{0, 0}, geom::SizeF{size}}, std::move(framebuffer)};
+    }
+
+    auto show(std::vector<mg::DisplayElement> const& renderlist) -> bool
+    {
+        auto const shown = passthrough->show(renderlist, {{0, 0}, output_size}, 1);
+        wl_display_roundtrip(display.get());
+        return shown;
+    }
+
+    mt::FakeWaylandHost host;
+    std::unique_ptr<wl_display, decltype(&wl_display_disconnect)> const display;
+    std::unique_ptr<TestDisplayClient> client;
+    std::unique_ptr<TestDisplayClient::SubsurfacePassthrough> passthrough;
+};
+}
+
+TEST_F(SubsurfacePassthroughTest, unchanged_buffer_is_only_sent_to_host_once)
+{
+    auto const buffer = client_buffer({100, 100});
+
+    auto const first = passthrough->framebuffer_for(buffer);
+    auto const second = passthrough->framebuffer_for(buffer);
+    wl_display_roundtrip(display.get());
+
+    EXPECT_THAT(first, NotNull());
+    EXPECT_THAT(second, NotNull());
+    EXPECT_THAT(host.buffers_created(), Eq(1));
+}
+
+TEST_F(SubsurfacePassthroughTest, different_buffers_are_each_sent_to_host)
+{
+    passthrough->framebuffer_for(client_buffer({100, 100}));
+    passthrough->framebuffer_for(client_buffer({100, 100}));
+    wl_display_roundtrip(display.get());
+
+    EXPECT_THAT(host.buffers_created(), Eq(2));
+}
+
+TEST_F(SubsurfacePassthroughTest, buffer_in_unsupported_format_cannot_be_passed_through)
+{
+    auto const buffer = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{{100, 100}, mir_pixel_format_rgb_565, mg::BufferUsage::software});
+
+    EXPECT_THAT(passthrough->framebuffer_for(buffer), IsNull());
+}
+
+TEST_F(SubsurfacePassthroughTest, renderlist_of_passed_through_buffers_is_shown_on_subsurfaces)
+{
+    std::shared_ptr<mg::Framebuffer> const a = passthrough->framebuffer_for(client_buffer({100, 100}));
+    std::shared_ptr<mg::Framebuffer> const b = passthrough->framebuffer_for(client_buffer({50, 50}));
+
+    EXPECT_TRUE(show({element_for(a, {0, 0}), element_for(b, {200, 100})}));
+    EXPECT_THAT(host.subsurfaces_created(), Eq(2));
+    EXPECT_THAT(host.buffers_attached(), Eq(2));
+}
+
+TEST_F(SubsurfacePassthroughTest, renderlist_with_rendered_framebuffer_falls_back_to_rendering)
+{
+    std::shared_ptr<mg::Framebuffer> const passed = passthrough->framebuffer_for(client_buffer({100, 100}));
+    auto const rendered = std::make_shared<RenderedFramebuffer>();
+
+    EXPECT_FALSE(show({element_for(passed, {0, 0}), element_for(rendered, {0, 0})}));
+    EXPECT_THAT(host.subsurfaces_created(), Eq(0));
+    EXPECT_THAT(host.buffers_attached(), Eq(0));
+}
+
+TEST_F(SubsurfacePassthroughTest, scaled_element_falls_back_to_rendering)
+{
+    std::shared_ptr<mg::Framebuffer> const framebuffer = passthrough->framebuffer_for(client_buffer({100, 100}));
+    auto element = element_for(framebuffer, {0, 0});
+    element.screen_positon.size = {200, 200};
+
+    EXPECT_FALSE(show({element}));
+    EXPECT_THAT(host.subsurfaces_created(), Eq(0));
+}
+
+TEST_F(SubsurfacePassthroughTest, element_outside_the_output_falls_back_to_rendering)
+{
+    std::shared_ptr<mg::Framebuffer> const framebuffer = passthrough->framebuffer_for(client_buffer({100, 100}));
+
+    EXPECT_FALSE(show({element_for(framebuffer, {600, 0})}));
+    EXPECT_THAT(host.subsurfaces_created(), Eq(0));
+}
+
+TEST_F(SubsurfacePassthroughTest, failed_show_leaves_what_is_shown_alone)
+{
+    std::shared_ptr<mg::Framebuffer> const framebuffer = passthrough->framebuffer_for(client_buffer({100, 100}));
+    ASSERT_TRUE(show({element_for(framebuffer, {0, 0})}));
+    auto const attached = host.buffers_attached();
+
+    EXPECT_FALSE(show({element_for(std::make_shared<RenderedFramebuffer>(), {0, 0})}));
+    EXPECT_THAT(host.buffers_attached(), Eq(attached));
+}
+
+TEST_F(SubsurfacePassthroughTest, buffer_shown_again_is_not_attached_again)
+{
+    auto const buffer = client_buffer({100, 100});
+    std::shared_ptr<mg::Framebuffer> const first = passthrough->framebuffer_for(buffer);
+    ASSERT_TRUE(show({element_for(first, {0, 0})}));
+
+    std::shared_ptr<mg::Framebuffer> const second = passthrough->framebuffer_for(buffer);
+    ASSERT_TRUE(show({element_for(second, {10, 10})}));
+
+    EXPECT_THAT(host.subsurfaces_created(), Eq(1));
+    EXPECT_THAT(host.buffers_attached(), Eq(1));
+}
+
+TEST_F(SubsurfacePassthroughTest, subsurfaces_are_reused_for_new_buffers)
+{
+    std::shared_ptr<mg::Framebuffer> const first = passthrough->framebuffer_for(client_buffer({100, 100}));
+    ASSERT_TRUE(show({element_for(first, {0, 0})}));
+
+    std::shared_ptr<mg::Framebuffer> const second = passthrough->framebuffer_for(client_buffer({100, 100}));
+    ASSERT_TRUE(show({element_for(second, {0, 0})}));
+
+    EXPECT_THAT(host.subsurfaces_created(), Eq(1));
+    EXPECT_THAT(host.buffers_attached(), Eq(2));
+}
+
+TEST_F(SubsurfacePassthroughTest, subsurfaces_are_reused_after_hide)
+{
+    std::shared_ptr<mg::Framebuffer> const framebuffer = passthrough->framebuffer_for(client_buffer({100, 100}));
+    ASSERT_TRUE(show({element_for(framebuffer, {0, 0})}));
+    passthrough->hide();
+    ASSERT_TRUE(show({element_for(framebuffer, {0, 0})}));
+
+    EXPECT_THAT(host.subsurfaces_created(), Eq(1));
+}
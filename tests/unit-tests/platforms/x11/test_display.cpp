@@ -23,6 +23,7 @@
 #include "src/server/report/null/display_report.h"
 
 #include "mir/graphics/display_configuration.h"
+#include "mir/graphics/display_sink.h"
 
 #include "mir/test/doubles/null_display_configuration_policy.h"
 #include "mir/test/doubles/mock_egl.h"
@@ -267,3 +268,45 @@ TEST_F(X11DisplayTest, updates_scale_property_correctly)
 
     EXPECT_THAT(new_scale, Eq(scale));
 }
+
+TEST_F(X11DisplayTest, incremental_configuration_retires_sync_group_before_moving_it)
+{
+    auto display = create_display();
+    auto config = display->configuration();
+    config->for_each_output([](mg::UserDisplayConfigurationOutput& conf_output)
+    {
+        conf_output.top_left = {100, 100};
+    });
+
+    std::optional<geom::Rectangle> area_when_retired;
+    display->configure_incrementally(*config, [&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_sink([&](mg::DisplaySink& sink) { area_when_retired = sink.view_area(); });
+        });
+
+    ASSERT_THAT(area_when_retired, Ne(std::nullopt));
+    EXPECT_THAT(area_when_retired->top_left, Eq(geom::Point{0, 0}));
+
+    display->for_each_display_sync_group([](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_sink([](mg::DisplaySink& sink)
+                {
+                    EXPECT_THAT(sink.view_area().top_left, Eq(geom::Point{100, 100}));
+                });
+        });
+}
+
+TEST_F(X11DisplayTest, incremental_configuration_keeps_sync_group_it_does_not_change)
+{
+    auto display = create_display();
+    auto config = display->configuration();
+    config->for_each_output([](mg::UserDisplayConfigurationOutput& conf_output)
+    {
+        conf_output.scale = 2.0f;
+    });
+
+    int retired{0};
+    display->configure_incrementally(*config, [&](mg::DisplaySyncGroup&) { ++retired; });
+
+    EXPECT_THAT(retired, Eq(0));
+}
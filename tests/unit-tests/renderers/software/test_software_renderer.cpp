@@ -0,0 +1,443 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/software/renderer.h"
+#include "src/renderers/software/kernels.h"
+#include "src/renderers/software/tile_workers.h"
+#include "mir/graphics/platform.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <random>
+
+namespace mg = mir::graphics;
+namespace mr = mir::renderer;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+uint32_t const black = 0xff000000;
+uint32_t const red = 0xffff0000;
+uint32_t const blue = 0xff0000ff;
+
+class FakeFB : public mg::CPUAddressableDisplayAllocator::MappableFB
+{
+public:
+    FakeFB(MirPixelFormat format, geom::Size size) :
+        pixel_format{format},
+        extents{size},
+        pixels(size.width.as_uint32_t() * size.height.as_uint32_t(), 0)
+    {
+    }
+
+    auto map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        class Mapping : public mrs::Mapping<unsigned char>
+        {
+        public:
+            explicit Mapping(FakeFB* fb) : fb{fb} {}
+
+            auto format() const -> MirPixelFormat override { return fb->format(); }
+            auto stride() const -> geom::Stride override { return fb->stride(); }
+            auto size() const -> geom::Size override { return fb->size(); }
+            auto data() -> unsigned char* override { return reinterpret_cast<unsigned char*>(fb->pixels.data()); }
+            auto len() const -> size_t override { return fb->pixels.size() * 4; }
+
+        private:
+            FakeFB* const fb;
+        };
+        return std::make_unique<Mapping>(this);
+    }
+
+    auto format() const -> MirPixelFormat override { return pixel_format; }
+    auto stride() const -> geom::Stride override { return geom::Stride{extents.width.as_int() * 4}; }
+    auto size() const -> geom::Size override { return extents; }
+
+    auto at(int x, int y) const -> uint32_t { return pixels[y * extents.width.as_int() + x]; }
+
+    MirPixelFormat const pixel_format;
+    geom::Size const extents;
+    std::vector<uint32_t> pixels;
+};
+
+class FakeAllocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    explicit FakeAllocator(geom::Size size, MirPixelFormat format = mir_pixel_format_xrgb_8888) :
+        size{size},
+        format{format}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<mg::DRMFormat> override
+    {
+        return {mg::DRMFormat::from_mir_format(format)};
+    }
+
+    auto alloc_fb(mg::DRMFormat format) -> std::unique_ptr<MappableFB> override
+    {
+        return std::make_unique<FakeFB>(format.as_mir_format().value(), size);
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        return size;
+    }
+
+    geom::Size size;
+    MirPixelFormat const format;
+};
+
+void fill_buffer(mtd::StubBuffer& buffer, uint32_t pixel)
+{
+    for (size_t i = 0; i + 4 <= buffer.written_pixels.size(); i += 4)
+    {
+        std::memcpy(buffer.written_pixels.data() + i, &pixel, 4);
+    }
+}
+
+auto filled_buffer(geom::Size size, MirPixelFormat format, uint32_t pixel) -> std::shared_ptr<mtd::StubBuffer>
+{
+    auto const buffer = std::make_shared<mtd::StubBuffer>(mg::BufferProperties{size, format, mg::BufferUsage::software});
+    fill_buffer(*buffer, pixel);
+    return buffer;
+}
+
+struct TranslucentRenderable : mtd::StubRenderable
+{
+    TranslucentRenderable(std::shared_ptr<mg::Buffer> const& buffer, geom::Rectangle const& rect, float alpha) :
+        StubRenderable{buffer, rect},
+        translucency{alpha}
+    {
+    }
+
+    auto alpha() const -> float override
+    {
+        return translucency;
+    }
+
+    float const translucency;
+};
+
+auto as_fake_fb(std::unique_ptr<mg::Framebuffer> const& fb) -> FakeFB const&
+{
+    return dynamic_cast<FakeFB const&>(*fb);
+}
+
+struct SoftwareRenderer : Test
+{
+    auto make_renderer(geom::Size size, MirPixelFormat format = mir_pixel_format_xrgb_8888) -> std::unique_ptr<mrs::Renderer>
+    {
+        allocator = std::make_unique<FakeAllocator>(size, format);
+        auto renderer = std::make_unique<mrs::Renderer>(*allocator, workers, mrs::scalar_kernels());
+        renderer->set_viewport({{0, 0}, size});
+        return renderer;
+    }
+
+    std::shared_ptr<mrs::TileWorkers> const workers{std::make_shared<mrs::TileWorkers>(2)};
+    std::unique_ptr<FakeAllocator> allocator;
+};
+
+auto random_pixels(std::mt19937& generator, size_t count) -> std::vector<uint32_t>
+{
+    // Premultiplied: no colour channel exceeds alpha
+    std::uniform_int_distribution<uint32_t> byte{0, 255};
+    std::vector<uint32_t> pixels(count);
+    for (auto& pixel : pixels)
+    {
+        auto const alpha = byte(generator);
+        auto const channel = [&] { return byte(generator) * alpha / 255; };
+        pixel = alpha << 24 | channel() << 16 | channel() << 8 | channel();
+    }
+    return pixels;
+}
+}
+
+TEST(SoftwareRendererKernels, every_supported_set_matches_the_scalar_kernels)
+{
+    auto const& reference = mrs::scalar_kernels();
+    std::mt19937 generator{42};
+
+    for (auto const kernels : mrs::supported_kernels())
+    {
+        SCOPED_TRACE(kernels->name);
+        for (size_t count : {1u, 3u, 7u, 8u, 15u, 16u, 33u, 100u})
+        {
+            auto const src = random_pixels(generator, count * 2);
+            auto const dst = random_pixels(generator, count);
+
+            for (uint32_t alpha : {0u, 1u, 127u, 128u, 254u, 255u})
+            {
+                auto expected = dst, actual = dst;
+                reference.blend(expected.data(), src.data(), count, alpha);
+                kernels->blend(actual.data(), src.data(), count, alpha);
+                EXPECT_THAT(actual, ContainerEq(expected)) << "blend, alpha " << alpha;
+
+                reference.fade(expected.data(), src.data(), count, alpha);
+                kernels->fade(actual.data(), src.data(), count, alpha);
+                EXPECT_THAT(actual, ContainerEq(expected)) << "fade, alpha " << alpha;
+            }
+
+            for (uint32_t step : {0x8000u, 0x10000u, 0x18000u, 0x1ffffu})
+            {
+                auto expected = dst, actual = dst;
+                reference.scale(expected.data(), src.data(), count, step / 2, step);
+                kernels->scale(actual.data(), src.data(), count, step / 2, step);
+                EXPECT_THAT(actual, ContainerEq(expected)) << "scale, step " << step;
+            }
+
+            auto expected = src, actual = src;
+            reference.make_opaque(expected.data(), expected.size());
+            kernels->make_opaque(actual.data(), actual.size());
+            EXPECT_THAT(actual, ContainerEq(expected)) << "make_opaque";
+
+            reference.swap_red_blue(expected.data(), expected.size());
+            kernels->swap_red_blue(actual.data(), actual.size());
+            EXPECT_THAT(actual, ContainerEq(expected)) << "swap_red_blue";
+        }
+    }
+}
+
+TEST(SoftwareRendererKernels, blend_is_source_over_with_premultiplied_alpha)
+{
+    auto const& kernels = mrs::scalar_kernels();
+    uint32_t dst[] = {0xff0000ff, 0xff0000ff, 0xff0000ff};
+    uint32_t const src[] = {0xffff0000, 0x80800000, 0x00000000};
+
+    kernels.blend(dst, src, 3, 255);
+
+    EXPECT_THAT(dst, ElementsAre(0xffff0000, 0xff80007f, 0xff0000ff));
+}
+
+TEST(SoftwareRendererTileWorkers, calls_work_once_for_each_index)
+{
+    mrs::TileWorkers workers{3};
+    std::vector<std::atomic<int>> calls(1000);
+
+    workers.for_each(calls.size(), [&](size_t i) { ++calls[i]; });
+
+    for (auto const& count : calls)
+    {
+        EXPECT_THAT(count.load(), Eq(1));
+    }
+}
+
+TEST(SoftwareRendererTileWorkers, rethrows_exceptions_from_work)
+{
+    mrs::TileWorkers workers{3};
+
+    EXPECT_THROW(
+        workers.for_each(100, [](size_t i) { if (i == 42) throw std::runtime_error{"boom"}; }),
+        std::runtime_error);
+
+    // ...and is still usable afterwards
+    std::atomic<int> calls{0};
+    workers.for_each(100, [&](size_t) { ++calls; });
+    EXPECT_THAT(calls.load(), Eq(100));
+}
+
+TEST_F(SoftwareRenderer, clears_to_opaque_black)
+{
+    auto const renderer = make_renderer({8, 8});
+
+    auto const fb = renderer->render({});
+
+    EXPECT_THAT(as_fake_fb(fb).pixels, Each(Eq(black)));
+}
+
+TEST_F(SoftwareRenderer, draws_renderables_at_their_positions)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const renderable = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({2, 2}, mir_pixel_format_argb_8888, red), geom::Rectangle{{3, 4}, {2, 2}});
+
+    auto const fb = renderer->render({renderable});
+    auto const& frame = as_fake_fb(fb);
+
+    EXPECT_THAT(frame.at(3, 4), Eq(red));
+    EXPECT_THAT(frame.at(4, 5), Eq(red));
+    EXPECT_THAT(frame.at(2, 4), Eq(black));
+    EXPECT_THAT(frame.at(5, 5), Eq(black));
+    EXPECT_THAT(frame.at(3, 6), Eq(black));
+}
+
+TEST_F(SoftwareRenderer, later_renderables_are_drawn_over_earlier_ones)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const below = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({4, 4}, mir_pixel_format_argb_8888, red), geom::Rectangle{{0, 0}, {4, 4}});
+    auto const above = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({4, 4}, mir_pixel_format_argb_8888, 0x80000080), geom::Rectangle{{2, 2}, {4, 4}});
+
+    auto const fb = renderer->render({below, above});
+    auto const& frame = as_fake_fb(fb);
+
+    EXPECT_THAT(frame.at(1, 1), Eq(red));
+    EXPECT_THAT(frame.at(3, 3), Eq(0xff7f0080u));
+    EXPECT_THAT(frame.at(5, 5), Eq(0xff000080u));
+}
+
+TEST_F(SoftwareRenderer, applies_renderable_alpha)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const renderable = std::make_shared<TranslucentRenderable>(
+        filled_buffer({8, 8}, mir_pixel_format_xrgb_8888, 0x00ffffff), geom::Rectangle{{0, 0}, {8, 8}}, 0.5f);
+
+    auto const fb = renderer->render({renderable});
+
+    EXPECT_THAT(as_fake_fb(fb).pixels, Each(Eq(0xff808080u)));
+}
+
+TEST_F(SoftwareRenderer, treats_padding_of_x_formats_as_opaque)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const renderable = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({8, 8}, mir_pixel_format_xrgb_8888, 0x00123456), geom::Rectangle{{0, 0}, {8, 8}});
+
+    auto const fb = renderer->render({renderable});
+
+    EXPECT_THAT(as_fake_fb(fb).pixels, Each(Eq(0xff123456u)));
+}
+
+TEST_F(SoftwareRenderer, converts_abgr_buffers)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const renderable = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({8, 8}, mir_pixel_format_abgr_8888, 0xff0000ff), geom::Rectangle{{0, 0}, {8, 8}});
+
+    auto const fb = renderer->render({renderable});
+
+    EXPECT_THAT(as_fake_fb(fb).pixels, Each(Eq(red)));
+}
+
+TEST_F(SoftwareRenderer, scales_buffers_to_their_screen_position)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const buffer = filled_buffer({2, 1}, mir_pixel_format_argb_8888, red);
+    std::memcpy(buffer->written_pixels.data() + 4, &blue, 4);
+    auto const renderable = std::make_shared<mtd::StubRenderable>(buffer, geom::Rectangle{{0, 0}, {8, 8}});
+
+    auto const fb = renderer->render({renderable});
+    auto const& frame = as_fake_fb(fb);
+
+    EXPECT_THAT(frame.at(0, 0), Eq(red));
+    EXPECT_THAT(frame.at(3, 7), Eq(red));
+    EXPECT_THAT(frame.at(4, 0), Eq(blue));
+    EXPECT_THAT(frame.at(7, 7), Eq(blue));
+}
+
+TEST_F(SoftwareRenderer, writes_abgr_framebuffers)
+{
+    auto const renderer = make_renderer({8, 8}, mir_pixel_format_abgr_8888);
+    auto const renderable = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({8, 8}, mir_pixel_format_argb_8888, red), geom::Rectangle{{0, 0}, {8, 8}});
+
+    auto const fb = renderer->render({renderable});
+
+    EXPECT_THAT(as_fake_fb(fb).pixels, Each(Eq(0xff0000ffu)));
+}
+
+TEST_F(SoftwareRenderer, rotates_the_frame_for_the_output_transform)
+{
+    // A 4×2 viewport shown on an output rotated to be 2×4
+    auto const renderer = make_renderer({2, 4});
+    renderer->set_viewport({{0, 0}, {4, 2}});
+    renderer->set_output_transform(glm::mat2{0, 1, -1, 0});
+    auto const renderable = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({1, 1}, mir_pixel_format_argb_8888, red), geom::Rectangle{{0, 0}, {1, 1}});
+
+    auto const fb = renderer->render({renderable});
+    auto const& frame = as_fake_fb(fb);
+
+    // The top-left of the viewport ends up at the bottom-left of the output
+    EXPECT_THAT(frame.at(0, 3), Eq(red));
+    EXPECT_THAT(std::count(frame.pixels.begin(), frame.pixels.end(), red), Eq(1));
+}
+
+TEST_F(SoftwareRenderer, redraws_only_what_changed)
+{
+    int const size = 4 * mrs::Renderer::tile_size;
+    auto const renderer = make_renderer({size, size});
+    auto const left_buffer = filled_buffer({10, 10}, mir_pixel_format_argb_8888, red);
+    auto const right_buffer = filled_buffer({10, 10}, mir_pixel_format_argb_8888, red);
+    auto const left = std::make_shared<mtd::StubRenderable>(left_buffer, geom::Rectangle{{0, 0}, {10, 10}});
+    auto const right_before = std::make_shared<mtd::StubRenderable>(right_buffer, geom::Rectangle{{size - 10, 0}, {10, 10}});
+    renderer->render({left, right_before});
+
+    // Change both buffers' content behind the renderer's back, but only move one of them
+    fill_buffer(*left_buffer, blue);
+    fill_buffer(*right_buffer, blue);
+    auto const right_after = std::make_shared<mtd::StubRenderable>(right_buffer, geom::Rectangle{{size - 10, 10}, {10, 10}});
+
+    auto const fb = renderer->render({left, right_after});
+    auto const& frame = as_fake_fb(fb);
+
+    EXPECT_THAT(frame.at(5, 5), Eq(red));
+    EXPECT_THAT(frame.at(size - 5, 15), Eq(blue));
+    EXPECT_THAT(frame.at(size - 5, 5), Eq(black));
+}
+
+TEST_F(SoftwareRenderer, copies_the_frame_into_cpu_captures)
+{
+    auto const renderer = make_renderer({8, 8});
+    auto const renderable = std::make_shared<mtd::StubRenderable>(
+        filled_buffer({1, 1}, mir_pixel_format_argb_8888, red), geom::Rectangle{{2, 2}, {1, 1}});
+    auto const target = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{{4, 4}, mir_pixel_format_argb_8888, mg::BufferUsage::software});
+    MockFunction<void(bool)> done;
+    geom::Rectangle const area{{2, 2}, {4, 4}};
+
+    std::vector<mr::Renderer::FrameCapture> captures;
+    captures.push_back({area, area, target, nullptr, done.AsStdFunction()});
+    renderer->capture_next_frame(std::move(captures));
+
+    EXPECT_CALL(done, Call(true));
+    renderer->render({renderable});
+
+    // Capture rows run bottom to top, so the area's top-left is the start of the last row
+    uint32_t pixel;
+    std::memcpy(&pixel, target->written_pixels.data() + 3 * 16, 4);
+    EXPECT_THAT(pixel, Eq(red));
+    std::memcpy(&pixel, target->written_pixels.data(), 4);
+    EXPECT_THAT(pixel, Eq(black));
+}
+
+TEST_F(SoftwareRenderer, fails_captures_of_rotated_frames)
+{
+    auto const renderer = make_renderer({8, 8});
+    renderer->set_output_transform(glm::mat2{-1, 0, 0, -1});
+    auto const target = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{{8, 8}, mir_pixel_format_argb_8888, mg::BufferUsage::software});
+    MockFunction<void(bool)> done;
+    geom::Rectangle const area{{0, 0}, {8, 8}};
+
+    std::vector<mr::Renderer::FrameCapture> captures;
+    captures.push_back({area, area, target, nullptr, done.AsStdFunction()});
+    renderer->capture_next_frame(std::move(captures));
+
+    EXPECT_CALL(done, Call(false));
+    renderer->render({});
+}
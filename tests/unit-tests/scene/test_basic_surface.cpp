@@ -486,6 +486,21 @@ TEST_F(BasicSurfaceTest, test_surface_hidden_notifies_changes)
     surface.set_hidden(true);
 }
 
+TEST_F(BasicSurfaceTest, streams_are_visible_only_while_surface_is_exposed_and_not_hidden)
+{
+    using namespace testing;
+    InSequence seq;
+    EXPECT_CALL(*mock_buffer_stream, set_visible(true));
+    EXPECT_CALL(*mock_buffer_stream, set_visible(false));
+    EXPECT_CALL(*mock_buffer_stream, set_visible(true));
+    EXPECT_CALL(*mock_buffer_stream, set_visible(false));
+
+    surface.configure(mir_window_attrib_visibility, mir_window_visibility_exposed);
+    surface.set_hidden(true);
+    surface.set_hidden(false);
+    surface.configure(mir_window_attrib_visibility, mir_window_visibility_occluded);
+}
+
 // a 1x1 window at (1,1) will get events at (1,1)
 TEST_F(BasicSurfaceTest, default_region_is_surface_rectangle)
 {
@@ -1495,6 +1510,21 @@ TEST_F(BasicSurfaceTest, renderables_of_transparent_buffer_streams_are_shaped)
     EXPECT_THAT(renderables[1]->shaped(), true);
 }
 
+TEST_F(BasicSurfaceTest, renderables_carry_the_tearing_hint)
+{
+    using namespace testing;
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_FALSE(renderables[0]->tearing_allowed());
+
+    surface.set_tearing_allowed(true);
+
+    renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_TRUE(renderables[0]->tearing_allowed());
+}
+
 namespace
 {
 struct VisibilityObserver : ms::NullSurfaceObserver
@@ -177,12 +177,10 @@ TEST_F(MediatingDisplayChangerTest, pauses_system_when_applying_new_configuratio
         .WillByDefault(Return(false));
 
     InSequence s;
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
 
     EXPECT_CALL(mock_display, configure(Ref(conf)));
 
-    EXPECT_CALL(mock_compositor, start());
-
     session_event_sink.handle_focus_change(session);
     changer->configure(session,
                        mt::fake_shared(conf));
@@ -196,8 +194,7 @@ TEST_F(MediatingDisplayChangerTest, does_not_pause_system_when_applying_new_conf
     EXPECT_CALL(mock_display, apply_if_configuration_preserves_display_buffers(Ref(conf)))
         .WillOnce(Return(true));
 
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
 
     session_event_sink.handle_focus_change(session);
@@ -215,9 +212,8 @@ TEST_F(MediatingDisplayChangerTest, does_full_stop_start_configuration_if_preser
     EXPECT_CALL(mock_display, apply_if_configuration_preserves_display_buffers(Ref(conf)))
         .WillOnce(Throw(mg::Display::IncompleteConfigurationApplied{"Quack!"}));
 
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(Ref(conf)));
-    EXPECT_CALL(mock_compositor, start());
 
     session_event_sink.handle_focus_change(session);
     changer->configure(session,
@@ -235,19 +231,17 @@ TEST_F(MediatingDisplayChangerTest, sends_error_when_incomplete_fallback_configu
     EXPECT_CALL(mock_display, apply_if_configuration_preserves_display_buffers(Ref(conf)))
         .WillOnce(Throw(mg::Display::IncompleteConfigurationApplied{"Quack!"}));
 
-    // …then we go through the full tear-down-and-rebuild configuration path…
-    EXPECT_CALL(mock_compositor, stop());
+    // …then we go through the full reconfiguration path…
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(Ref(conf)))
         .WillOnce(Throw(std::runtime_error{"Oooof"}));    //… which also fails! Awkward!
-    EXPECT_CALL(mock_compositor, start());
 
     // So we notify of error, and then…
     EXPECT_CALL(display_configuration_observer, configuration_failed(Pointee(Ref(conf)), _));
 
     // …we revert to the previous configuration
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(_));
-    EXPECT_CALL(mock_compositor, start());
 
     session_event_sink.handle_focus_change(session);
     changer->configure(session,
@@ -288,9 +282,8 @@ TEST_F(MediatingDisplayChangerTest, doesnt_apply_config_for_unfocused_session)
 {
     mtd::NullDisplayConfiguration conf;
 
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(Ref(conf))).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     changer->configure(std::make_shared<mtd::StubSession>(),
                        mt::fake_shared(conf));
@@ -318,9 +311,8 @@ TEST_F(MediatingDisplayChangerTest, handles_hardware_change_when_display_buffers
     InSequence s;
     EXPECT_CALL(mock_conf_policy, apply_to(Ref(conf)));
 
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(Ref(conf)));
-    EXPECT_CALL(mock_compositor, start());
 
     changer->configure(mt::fake_shared(conf));
 }
@@ -355,9 +347,8 @@ TEST_F(MediatingDisplayChangerTest, handles_hardware_change_when_display_buffers
             .WillOnce(Return(true));
     }
 
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     changer->configure(mt::fake_shared(conf));
 }
@@ -385,12 +376,11 @@ TEST_F(MediatingDisplayChangerTest, handles_hardware_change_when_display_buffers
     EXPECT_CALL(mock_conf_policy, apply_to(Ref(*conf)));
 
     /*
-     * Currently we have to tear down and recreate the compositor in order to add
-     * a new output. This is not an inherent limitation, and we might do better later.
+     * Adding an output needs new sync groups, so the compositor has to be involved;
+     * it keeps compositing on the outputs that were already there.
      */
-    EXPECT_CALL(mock_compositor, stop()).Times(1);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(1);
     EXPECT_CALL(mock_display, configure(Ref(*conf)));
-    EXPECT_CALL(mock_compositor, start()).Times(1);
 
     changer->configure(conf);
 }
@@ -409,9 +399,8 @@ TEST_F(MediatingDisplayChangerTest, hardware_change_doesnt_apply_base_config_if_
     Mock::VerifyAndClearExpectations(&mock_display);
 
     InSequence s;
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     changer->configure(conf);
 }
@@ -475,9 +464,8 @@ TEST_F(MediatingDisplayChangerTest, focusing_a_session_with_db_preserving_attach
     EXPECT_CALL(mock_display, apply_if_configuration_preserves_display_buffers(Ref(*conf)))
         .WillOnce(Return(true));
 
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     session_event_sink.handle_focus_change(session1);
 }
@@ -507,13 +495,12 @@ TEST_F(MediatingDisplayChangerTest, focusing_a_session_with_db_preserving_but_ou
     changer->configure(session1, conf);
 
     /*
-     * Currently we have to tear down and recreate the compositor in order to add
-     * a new output. This is not an inherent limitation, and we might do better later.
+     * Adding an output needs new sync groups, so the compositor has to be involved;
+     * it keeps compositing on the outputs that were already there.
      */
     InSequence s;
-    EXPECT_CALL(mock_compositor, stop()).Times(1);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(1);
     EXPECT_CALL(mock_display, configure(Ref(*conf)));
-    EXPECT_CALL(mock_compositor, start()).Times(1);
 
     session_event_sink.handle_focus_change(session1);
 }
@@ -530,9 +517,8 @@ TEST_F(MediatingDisplayChangerTest, focusing_a_session_with_db_invalidating_atta
     changer->configure(session1, conf);
 
     InSequence s;
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(Ref(*conf)));
-    EXPECT_CALL(mock_compositor, start());
 
     session_event_sink.handle_focus_change(session1);
 }
@@ -576,9 +562,8 @@ TEST_F(MediatingDisplayChangerTest, focusing_a_session_without_attached_config_a
     Mock::VerifyAndClearExpectations(&mock_display);
 
     InSequence s;
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(mt::DisplayConfigMatches(std::cref(base_config))));
-    EXPECT_CALL(mock_compositor, start());
 
     session_event_sink.handle_focus_change(session2);
 }
@@ -612,9 +597,9 @@ TEST_F(MediatingDisplayChangerTest, focusing_a_session_without_attached_config_a
         apply_if_configuration_preserves_display_buffers(mt::DisplayConfigMatches(std::cref(base_config))))
             .WillOnce(Return(true));
 
-    EXPECT_CALL(mock_compositor, stop()).Times(1);
+    EXPECT_CALL(mock_compositor, schedule_compositing()).Times(1);
+    EXPECT_CALL(mock_compositor, configure_display(_, _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(1);
 
     session_event_sink.handle_focus_change(session2);
 }
@@ -648,9 +633,8 @@ TEST_F(MediatingDisplayChangerTest, focusing_a_session_without_attached_config_a
         apply_if_configuration_preserves_display_buffers(mt::DisplayConfigMatches(std::cref(base_config))))
             .WillOnce(Return(true));
 
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     session_event_sink.handle_focus_change(session2);
 }
@@ -669,9 +653,8 @@ TEST_F(MediatingDisplayChangerTest, losing_focus_applies_base_config)
     Mock::VerifyAndClearExpectations(&mock_display);
 
     InSequence s;
-    EXPECT_CALL(mock_compositor, stop());
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _));
     EXPECT_CALL(mock_display, configure(mt::DisplayConfigMatches(std::cref(base_config))));
-    EXPECT_CALL(mock_compositor, start());
 
     session_event_sink.handle_no_focus();
 }
@@ -682,9 +665,8 @@ TEST_F(MediatingDisplayChangerTest, base_config_is_not_applied_if_already_active
     auto session1 = std::make_shared<mtd::StubSession>();
     auto session2 = std::make_shared<mtd::StubSession>();
 
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     session_container.insert_session(session1);
     session_container.insert_session(session2);
@@ -711,9 +693,8 @@ TEST_F(MediatingDisplayChangerTest, hardware_change_invalidates_session_configs)
      * Session1 had a config, but it should have been invalidated by the hardware
      * change, so expect no reconfiguration.
      */
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     session_event_sink.handle_focus_change(session1);
 }
@@ -735,9 +716,8 @@ TEST_F(MediatingDisplayChangerTest, session_stopping_invalidates_session_config)
      * Session1 had a config, but it should have been invalidated by the
      * session stopping event, so expect no reconfiguration.
      */
-    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_compositor, configure_display(Ref(mock_display), _)).Times(0);
     EXPECT_CALL(mock_display, configure(_)).Times(0);
-    EXPECT_CALL(mock_compositor, start()).Times(0);
 
     session_event_sink.handle_focus_change(session1);
 }
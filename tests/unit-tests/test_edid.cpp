@@ -69,3 +69,12 @@ TEST(EDID, can_get_product_code)
     auto edid = reinterpret_cast<Edid const*>(dell_u2413_edid);
     EXPECT_EQ(61510u, edid->product_code());
 }
+
+TEST(EDID, can_get_vertical_refresh_range)
+{
+    auto edid = reinterpret_cast<Edid const*>(dell_u2413_edid);
+    int min_hz = 0, max_hz = 0;
+    ASSERT_TRUE(edid->get_vertical_refresh_range(min_hz, max_hz));
+    EXPECT_EQ(56, min_hz);
+    EXPECT_EQ(76, max_hz);
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/mpsc_work_queue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+TEST(InlineTask, invokes_callable)
+{
+    int called{0};
+    mir::InlineTask task{[&called]() { ++called; }};
+
+    ASSERT_TRUE(task);
+    task();
+
+    EXPECT_THAT(called, Eq(1));
+}
+
+TEST(InlineTask, destroys_callable_exactly_once)
+{
+    auto const tracker = std::make_shared<int>();
+    {
+        mir::InlineTask task{[tracker]() {}};
+        mir::InlineTask moved{std::move(task)};
+        mir::InlineTask assigned;
+        assigned = std::move(moved);
+
+        EXPECT_THAT(tracker.use_count(), Eq(2));
+    }
+    EXPECT_THAT(tracker.use_count(), Eq(1));
+}
+
+TEST(InlineTask, holds_callables_too_large_to_store_inline)
+{
+    std::array<int, mir::InlineTask::inline_size> big{};
+    big.back() = 42;
+    int result{0};
+
+    mir::InlineTask task{[big, &result]() { result = big.back(); }};
+    mir::InlineTask moved{std::move(task)};
+    moved();
+
+    EXPECT_THAT(result, Eq(42));
+}
+
+TEST(MPSCWorkQueue, pops_work_in_push_order)
+{
+    mir::MPSCWorkQueue queue;
+    std::vector<int> order;
+
+    for (auto i = 0; i != 5; ++i)
+    {
+        queue.push([i, &order]() { order.push_back(i); });
+    }
+
+    mir::InlineTask task;
+    while (queue.try_pop(task))
+    {
+        task();
+    }
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(MPSCWorkQueue, only_first_push_after_consumer_goes_idle_requests_wakeup)
+{
+    mir::MPSCWorkQueue queue;
+
+    EXPECT_TRUE(queue.push([]() {}));
+    EXPECT_FALSE(queue.push([]() {}));
+
+    mir::InlineTask task;
+    while (queue.try_pop(task))
+    {
+    }
+
+    EXPECT_TRUE(queue.push([]() {}));
+}
+
+TEST(MPSCWorkQueue, destroys_unprocessed_work)
+{
+    auto const tracker = std::make_shared<int>();
+    {
+        mir::MPSCWorkQueue queue;
+        queue.push([tracker]() {});
+        queue.push([tracker]() {});
+    }
+    EXPECT_THAT(tracker.use_count(), Eq(1));
+}
+
+TEST(MPSCWorkQueue, work_taken_from_a_recycled_node_is_not_run_again)
+{
+    mir::MPSCWorkQueue queue;
+    auto const tracker = std::make_shared<int>();
+    std::vector<int> order;
+
+    mir::InlineTask task;
+    for (auto i = 0; i != 3 * static_cast<int>(mir::MPSCWorkQueue::max_spare_nodes); ++i)
+    {
+        queue.push([i, &order, tracker]() { order.push_back(i); });
+        queue.push([i, &order, tracker]() { order.push_back(-i); });
+
+        while (queue.try_pop(task))
+        {
+            task();
+            task.reset();
+        }
+        // Popped work is released even though its node is kept for reuse
+        ASSERT_THAT(tracker.use_count(), Eq(1));
+    }
+
+    ASSERT_THAT(order.size(), Eq(6 * mir::MPSCWorkQueue::max_spare_nodes));
+    for (auto i = 0u; i != order.size() / 2; ++i)
+    {
+        EXPECT_THAT(order[2 * i], Eq(static_cast<int>(i)));
+        EXPECT_THAT(order[2 * i + 1], Eq(-static_cast<int>(i)));
+    }
+}
+
+TEST(MPSCWorkQueue, delivers_all_work_from_concurrent_producers)
+{
+    constexpr int producers = 4;
+    constexpr int items_per_producer = 10000;
+
+    mir::MPSCWorkQueue queue;
+    std::array<int, producers> last_seen;
+    last_seen.fill(-1);
+    bool in_order{true};
+    std::atomic<int> wakeups{0};
+
+    std::vector<std::thread> threads;
+    for (auto p = 0; p != producers; ++p)
+    {
+        threads.emplace_back(
+            [&, p]()
+            {
+                for (auto i = 0; i != items_per_producer; ++i)
+                {
+                    auto const wake = queue.push(
+                        [&, p, i]()
+                        {
+                            in_order = in_order && last_seen[p] == i - 1;
+                            last_seen[p] = i;
+                        });
+                    if (wake)
+                    {
+                        ++wakeups;
+                        wakeups.notify_one();
+                    }
+                }
+            });
+    }
+
+    int processed{0};
+    mir::InlineTask task;
+    while (processed != producers * items_per_producer)
+    {
+        auto const seen_wakeups = wakeups.load();
+        while (queue.try_pop(task))
+        {
+            task();
+            ++processed;
+        }
+        if (processed != producers * items_per_producer)
+        {
+            // Every push that finds us idle wakes us, so this can not sleep forever
+            wakeups.wait(seen_wakeups);
+        }
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_TRUE(in_order);
+    EXPECT_THAT(last_seen, Each(Eq(items_per_producer - 1)));
+}
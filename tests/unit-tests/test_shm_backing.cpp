@@ -20,6 +20,7 @@
 
 #include <linux/memfd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
 #include <fcntl.h>
 #include <boost/throw_exception.hpp>
@@ -588,3 +589,73 @@ TEST(ShmBacking, resize_doesnt_install_sigbus_handler_when_safe)
     sigaction(SIGBUS, nullptr, &new_sigbus_handler);
     EXPECT_THAT(new_sigbus_handler, SignalHandlerIsEqual(initial_sigbus_handler));
 }
+
+TEST(ShmBacking, range_of_shrink_sealed_memfd_exposes_its_memfd)
+{
+    using namespace testing;
+
+    constexpr size_t const shm_size = 8000;
+    mir::Fd shm_fd;
+    try
+    {
+        shm_fd = make_shm_fd_with_seals(shm_size, F_SEAL_SHRINK);
+    }
+    catch (std::system_error const&)
+    {
+        GTEST_SKIP();    // We can't allocate a memfd, so we can't test F_SEAL
+    }
+
+    auto backing = mir::shm::rw_pool_from_fd(shm_fd, shm_size);
+    auto range = backing->get_rw_range(1000, 2000);
+
+    auto const memfd_range = range->sealed_memfd_range();
+    ASSERT_THAT(memfd_range, Ne(std::nullopt));
+    EXPECT_THAT(memfd_range->offset, Eq(1000u));
+    EXPECT_THAT(memfd_range->len, Eq(2000u));
+
+    struct stat shm_stat, range_stat;
+    ASSERT_THAT(fstat(shm_fd, &shm_stat), Eq(0));
+    ASSERT_THAT(fstat(memfd_range->file, &range_stat), Eq(0));
+    EXPECT_THAT(range_stat.st_ino, Eq(shm_stat.st_ino));
+}
+
+TEST(ShmBacking, range_of_unsealed_file_has_no_memfd)
+{
+    using namespace testing;
+
+    constexpr size_t const shm_size = 4000;
+    auto shm_fd = make_shm_fd(shm_size);
+    auto backing = mir::shm::rw_pool_from_fd(shm_fd, shm_size);
+
+    EXPECT_THAT(backing->get_rw_range(0, shm_size)->sealed_memfd_range(), Eq(std::nullopt));
+}
+
+TEST(ShmBacking, invalid_read_is_caught_while_many_other_mappings_are_live)
+{
+    using namespace testing;
+
+    size_t const shm_size = sysconf(_SC_PAGE_SIZE);
+    size_t const claimed_size = shm_size + 1;    // Lie about our backing size
+
+    // Plenty of live mappings of a valid, but not provably-valid, pool
+    auto valid_fd = make_shm_fd(shm_size);
+    auto valid_backing = mir::shm::rw_pool_from_fd(valid_fd, shm_size);
+    auto valid_range = valid_backing->get_rw_range(0, shm_size);
+    std::vector<std::unique_ptr<mir::shm::Mapping<std::byte const>>> live_maps;
+    for (auto i = 0; i < 200; ++i)
+    {
+        live_maps.push_back(valid_range->map_ro());
+    }
+
+    auto shm_fd = make_shm_fd(shm_size);
+    auto backing = mir::shm::rw_pool_from_fd(shm_fd, claimed_size);
+    auto range = backing->get_rw_range(0, claimed_size);
+    auto map = range->map_ro();
+
+    EXPECT_THAT((*map)[claimed_size - 1], Eq(std::byte{0}));
+    EXPECT_TRUE(map->access_fault());
+    for (auto const& live_map : live_maps)
+    {
+        EXPECT_FALSE(live_map->access_fault());
+    }
+}
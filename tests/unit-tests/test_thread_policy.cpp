@@ -0,0 +1,93 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/thread_policy.h"
+
+#include <thread>
+#include <sched.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+TEST(ThreadPolicy, parses_real_time_scheduler_and_priority)
+{
+    auto const fifo = mir::parse_thread_policy("fifo:10");
+    EXPECT_THAT(fifo.scheduler, Eq(mir::ThreadPolicy::Scheduler::fifo));
+    EXPECT_THAT(fifo.priority, Eq(10));
+    EXPECT_THAT(fifo.cpus, IsEmpty());
+
+    auto const rr = mir::parse_thread_policy("rr:3");
+    EXPECT_THAT(rr.scheduler, Eq(mir::ThreadPolicy::Scheduler::round_robin));
+    EXPECT_THAT(rr.priority, Eq(3));
+}
+
+TEST(ThreadPolicy, parses_nice_value)
+{
+    auto const policy = mir::parse_thread_policy("nice:-5");
+
+    EXPECT_THAT(policy.scheduler, Eq(mir::ThreadPolicy::Scheduler::normal));
+    EXPECT_THAT(policy.nice, Optional(-5));
+}
+
+TEST(ThreadPolicy, parses_cpu_list)
+{
+    auto const policy = mir::parse_thread_policy("fifo:2@0-2,5");
+
+    EXPECT_THAT(policy.scheduler, Eq(mir::ThreadPolicy::Scheduler::fifo));
+    EXPECT_THAT(policy.cpus, ElementsAre(0, 1, 2, 5));
+
+    auto const affinity_only = mir::parse_thread_policy("@3");
+    EXPECT_THAT(affinity_only.scheduler, Eq(mir::ThreadPolicy::Scheduler::normal));
+    EXPECT_THAT(affinity_only.nice, Eq(std::nullopt));
+    EXPECT_THAT(affinity_only.cpus, ElementsAre(3));
+}
+
+TEST(ThreadPolicy, rejects_malformed_policies)
+{
+    for (auto const spec : {"fifo", "fifo:", "fifo:0", "fifo:100", "batch:1", "nice:20", "nice:x", "@", "@3-1", "@1,,2", "fifo:1@-1"})
+    {
+        EXPECT_THROW(mir::parse_thread_policy(spec), std::invalid_argument) << "spec: " << spec;
+    }
+}
+
+TEST(ThreadPolicy, applies_cpu_affinity_to_calling_thread)
+{
+    cpu_set_t allowed;
+    ASSERT_THAT(sched_getaffinity(0, sizeof(allowed), &allowed), Eq(0));
+
+    int cpu{0};
+    while (!CPU_ISSET(cpu, &allowed))
+        ++cpu;
+
+    mir::ThreadPolicy policy;
+    policy.cpus = {cpu};
+    mir::set_thread_policy(mir::ThreadRole::workqueue, policy);
+
+    cpu_set_t applied;
+    std::thread{
+        [&applied]
+        {
+            mir::apply_thread_policy(mir::ThreadRole::workqueue);
+            sched_getaffinity(0, sizeof(applied), &applied);
+        }}.join();
+
+    mir::set_thread_policy(mir::ThreadRole::workqueue, mir::ThreadPolicy{});
+
+    EXPECT_THAT(CPU_COUNT(&applied), Eq(1));
+    EXPECT_TRUE(CPU_ISSET(cpu, &applied));
+}
@@ -22,7 +22,10 @@
 #include <thread>
 #include <future>
 
+#include <sched.h>
+
 #include "mir/executor.h"
+#include "mir/thread_policy.h"
 #include "mir/test/signal.h"
 #include "mir/test/current_thread_name.h"
 
@@ -215,3 +218,145 @@ TEST(ThreadPoolExecutor, quiesce_waits_until_work_completes)
     mir::ThreadPoolExecutor::quiesce();
     EXPECT_THAT(std::chrono::steady_clock::now(), Gt(expected_end));
 }
+
+TEST(ThreadPoolExecutor, blocking_work_does_not_prevent_other_work)
+{
+    auto const release = std::make_shared<mt::Signal>();
+    auto const done = std::make_shared<mt::Signal>();
+    auto const blocking_done = std::make_shared<mt::Signal>();
+
+    for (auto i = 0u; i < 2 * std::max(4u, std::thread::hardware_concurrency()); ++i)
+    {
+        mir::ThreadPoolExecutor::spawn_blocking(
+            [release, blocking_done]()
+            {
+                release->wait_for(60s);
+                blocking_done->raise();
+            });
+    }
+
+    mir::thread_pool_executor.spawn([done]() { done->raise(); });
+
+    EXPECT_TRUE(done->wait_for(60s));
+    release->raise();
+    EXPECT_TRUE(blocking_done->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+}
+
+TEST(ThreadPoolExecutor, high_priority_work_runs_before_queued_normal_work)
+{
+    auto const worker_count = std::max(4u, std::thread::hardware_concurrency());
+    auto const release = std::make_shared<mt::Signal>();
+    std::atomic<unsigned> started{0};
+
+    // Occupy every worker...
+    for (auto i = 0u; i < worker_count; ++i)
+    {
+        mir::thread_pool_executor.spawn(
+            [release, &started]()
+            {
+                ++started;
+                release->wait_for(60s);
+            });
+    }
+    while (started < worker_count)
+    {
+        std::this_thread::yield();
+    }
+
+    // ...so that these are queued
+    std::mutex mutex;
+    std::vector<std::string> order;
+    mir::thread_pool_executor.spawn(
+        [&]()
+        {
+            std::lock_guard lock{mutex};
+            order.push_back("normal");
+        });
+    mir::ThreadPoolExecutor::spawn_with_priority(
+        [&]()
+        {
+            std::lock_guard lock{mutex};
+            order.push_back("high");
+        },
+        mir::ThreadPoolExecutor::Priority::high);
+
+    release->raise();
+    mir::ThreadPoolExecutor::quiesce();
+
+    EXPECT_THAT(order, ElementsAre("high", "normal"));
+}
+
+TEST(ThreadPoolExecutor, can_be_stopped_from_within_work)
+{
+    auto const stopped = std::make_shared<mt::Signal>();
+    auto const done = std::make_shared<mt::Signal>();
+
+    // Give the stopping thread's neighbours something to steal, and to be doing, as it stops
+    for (auto i = 0; i < 20; ++i)
+    {
+        mir::thread_pool_executor.spawn([]() { std::this_thread::sleep_for(1ms); });
+    }
+    mir::thread_pool_executor.spawn(
+        [stopped, done]()
+        {
+            mir::ThreadPoolExecutor::quiesce();
+            stopped->raise();
+
+            // The pool starts again for work spawned from here
+            mir::thread_pool_executor.spawn([done]() { done->raise(); });
+        });
+
+    ASSERT_TRUE(stopped->wait_for(60s));
+    EXPECT_TRUE(done->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+}
+
+TEST(ThreadPoolExecutor, blocking_work_is_not_given_the_workqueue_policy)
+{
+    cpu_set_t allowed;
+    ASSERT_THAT(sched_getaffinity(0, sizeof(allowed), &allowed), Eq(0));
+    if (CPU_COUNT(&allowed) < 2)
+    {
+        GTEST_SKIP() << "Needs more than one CPU to tell a restricted affinity apart";
+    }
+
+    int cpu{0};
+    while (!CPU_ISSET(cpu, &allowed))
+        ++cpu;
+
+    mir::ThreadPolicy policy;
+    policy.cpus = {cpu};
+    mir::set_thread_policy(mir::ThreadRole::workqueue, policy);
+
+    auto const done = std::make_shared<mt::Signal>();
+    cpu_set_t applied;
+    CPU_ZERO(&applied);
+    mir::ThreadPoolExecutor::spawn_blocking(
+        [done, &applied]()
+        {
+            sched_getaffinity(0, sizeof(applied), &applied);
+            done->raise();
+        });
+
+    EXPECT_TRUE(done->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+    mir::set_thread_policy(mir::ThreadRole::workqueue, mir::ThreadPolicy{});
+
+    EXPECT_TRUE(CPU_EQUAL(&applied, &allowed));
+}
+
+TEST(ThreadPoolExecutor, can_be_stopped_from_within_blocking_work)
+{
+    auto const done = std::make_shared<mt::Signal>();
+
+    mir::ThreadPoolExecutor::spawn_blocking(
+        [done]()
+        {
+            mir::ThreadPoolExecutor::quiesce();
+            done->raise();
+        });
+
+    EXPECT_TRUE(done->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+}